@@ -17,6 +17,8 @@ struct VSInterpolants
     float4 PositionCS : SV_Position; // SV_Position - float4
     float3 PositionWS : POSITION;      // Arbitrary semantic names used to align data between VS & PS
     float3 NormalWS   : NORMAL;
+
+    nointerpolation float3 Color : COLOR0;    // The instance's tint of the material color
 };
 
 
@@ -27,16 +29,10 @@ struct VSInterpolants
 //       So we use float4 instead of float3 for alignment's sake
 //       Otherwise we may incur cruel and inexplicable behavior
 
-cbuffer Constants : register(b0)
-{
-    // Space Transformations - these can't be reused by other objects since its world transform is baked in
-    float4x4 World;               // Transform from object to world space
-    float4x4 WorldViewProjection; // Transform from object to clip space
-
-    // Object materials
-    float3 ObjectColor;
-    float  ObjectShininess;
+// Split by how often they change, so each is only uploaded when it does (see AppFrameConstants & AppMaterialConstants)
 
+cbuffer FrameConstants : register(b0)
+{
     // Light properties
     float4 LightPositionWS;
     float4 LightColor;
@@ -45,6 +41,12 @@ cbuffer Constants : register(b0)
     float4 CameraPositionWS;
 };
 
+cbuffer MaterialConstants : register(b1)
+{
+    float3 ObjectColor;
+    float  ObjectShininess;
+};
+
 
 ////
 // Pixel shader entrypoint
@@ -71,7 +73,7 @@ float4 PSMain(VSInterpolants pin) : SV_Target0
     float specularIntensity = pow(saturate(NdotH), ObjectShininess);
 
 
-    float3 color = (diffuseIntensity + specularIntensity) * LightColor.rgb * ObjectColor.rgb / (Ldist * Ldist);
+    float3 color = (diffuseIntensity + specularIntensity) * LightColor.rgb * ObjectColor * pin.Color / (Ldist * Ldist);
 
     // Just pass the color through directly to the output merger
     return float4(color, 1);
@@ -25,6 +25,8 @@ struct VSInterpolants
     float4 PositionCS : SV_Position;  // SV_Position - float4 - Required; specifies vertex position in NDC space
     float3 PositionWS : POSITION;     // Arbitrary semantic names used to align data between VS & PS
     float3 NormalWS   : NORMAL;
+
+    nointerpolation float3 Color : COLOR0;    // The instance's tint of the material color - same for every pixel
 };
 
 
@@ -35,36 +37,48 @@ struct VSInterpolants
 //       So we use float4 instead of float3 for alignment's sake
 //       Otherwise we may incur cruel and inexplicable behavior
 
-cbuffer Constants : register(b0)
+// Split by how often they change, so each is only uploaded when it does - only the per-object block is read here
+// (see BasicPS.hlsl for the per-frame & per-material blocks)
+
+cbuffer ObjectConstants : register(b2)
 {
-    // Space Transformations - these can't be reused by other objects since its world transform is baked in
-    float4x4 World;               // Transform from object to world space
-    float4x4 WorldViewProjection; // Transform from object to clip space
+    uint FirstInstance; // Of this draw's instances, as SV_InstanceID counts from 0 in every draw
+};
+
 
-    // Object materials
-    float3 ObjectColor;
-    float  ObjectShininess;
+////
+// Per-instance data - one element for each copy of the mesh drawn by a single DrawIndexedInstanced call
+//
+// Mirrors AppInstanceData, packed by PackInstances on the CPU. Structured buffer elements are tightly packed rather
+// than following the constant buffer rules, so their order & sizes alone must match.
 
-    // Light properties
-    float4 LightPositionWS;
-    float4 LightColor;
+struct InstanceData
+{
+    float4x4 World;               // Transform from object to world space
+    float4x4 WorldViewProjection; // Transform from object to clip space
 
-    // Camera properties
-    float4 CameraPositionWS;
+    float3 Color;                 // Multiplies the material's ObjectColor
+    float  Padding;
 };
 
+StructuredBuffer<InstanceData> Instances : register(t0);
+
 
 // Vertex shader entrypoint
-VSInterpolants VSMain(VSInput vin)
+VSInterpolants VSMain(VSInput vin, uint instanceID : SV_InstanceID)
 {
+    InstanceData instance = Instances[FirstInstance + instanceID];
+
     VSInterpolants vout;
 
     // Transform the vertex position into clip space
-    vout.PositionCS = mul(float4(vin.Position, 1), WorldViewProjection);
+    vout.PositionCS = mul(float4(vin.Position, 1), instance.WorldViewProjection);
 
     // Transform position and normal to world space for pixel shader lighting calculations
-    vout.PositionWS = mul(float4(vin.Position, 1), World).xyz;
-    vout.NormalWS   = mul(float4(vin.Normal, 0), World).xyz;
+    vout.PositionWS = mul(float4(vin.Position, 1), instance.World).xyz;
+    vout.NormalWS   = mul(float4(vin.Normal, 0), instance.World).xyz;
+
+    vout.Color = instance.Color;
 
     return vout;
 }
\ No newline at end of file
@@ -0,0 +1,457 @@
+//
+// BlinnPhongKernel.cpp
+//
+
+#include "pch.h"
+#include "BlinnPhongKernel.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    const float Sqrt2 = 1.41421356f;
+
+    // 2 / ((2k + 1) ln 2) - log2(m) = 2 atanh(t) / ln 2 with t = (m - 1) / (m + 1), an odd series in t
+    const float Log2Series[] = { 2.88539008f, 0.961796694f, 0.577078016f, 0.412198583f };
+
+    // ln(2)^k / k! - the Taylor series of 2^f
+    const float Exp2Series[] = { 1.0f, 0.693147181f, 0.240226507f, 0.0555041087f, 0.00961812911f, 0.00133335581f, 0.000154035304f };
+
+    // Terms of each series an approximation sums
+    struct PowTerms
+    {
+        int Log2;
+        int Exp2;
+    };
+
+    PowTerms GetPowTerms(SpecularPow pow)
+    {
+        return (pow == SpecularPow::Accurate) ? PowTerms{ 4, 7 } : PowTerms{ 2, 4 };
+    }
+
+    // The constants PSMain reads, as arrays the kernels can index by component
+    struct PixelConstants
+    {
+        float CameraPositionWS[3];
+        float LightPositionWS[3];
+        float LightColor[3];
+        float ObjectColor[3];
+        float ObjectShininess;
+    };
+
+    PixelConstants GetPixelConstants(const AppShaderConstants& constants)
+    {
+        return
+        {
+            { constants.CameraPositionWS.x, constants.CameraPositionWS.y, constants.CameraPositionWS.z },
+            { constants.LightPositionWS.x, constants.LightPositionWS.y, constants.LightPositionWS.z },
+            { constants.LightColor.x, constants.LightColor.y, constants.LightColor.z },
+            { constants.ObjectColor.x, constants.ObjectColor.y, constants.ObjectColor.z },
+            constants.ObjectShininess,
+        };
+    }
+
+
+    ////
+    // Scalar
+
+    float Saturate(float x)
+    {
+        // Also maps NaN to 0, as HLSL's saturate does
+        return (x > 0.0f) ? std::min(x, 1.0f) : 0.0f;
+    }
+
+    void Normalize(float* v)
+    {
+        float invLength = 1.0f / std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+        v[0] *= invLength;
+        v[1] *= invLength;
+        v[2] *= invLength;
+    }
+
+    float Dot(const float* a, const float* b)
+    {
+        return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    }
+
+    // exp2(exponent * log2(x)) - x is split into 2^e * m with m in [sqrt(1/2), sqrt(2)), which keeps |t| under 0.172,
+    // & the product into an integer & a fraction in [-1/2, 1/2]. Results under 2^-125 flush to zero.
+    float PowPolynomial(float x, float exponent, PowTerms terms)
+    {
+        if (!(x >= FLT_MIN))
+        {
+            return 0.0f;
+        }
+
+        uint32_t bits;
+        memcpy(&bits, &x, sizeof(bits));
+
+        float    e     = static_cast<float>(static_cast<int32_t>(bits >> 23) - 127);
+        uint32_t mBits = (bits & 0x007FFFFF) | 0x3F800000;
+        float    m;
+        memcpy(&m, &mBits, sizeof(m));
+
+        if (m > Sqrt2)
+        {
+            m *= 0.5f;
+            e += 1.0f;
+        }
+
+        float t  = (m - 1.0f) / (m + 1.0f);
+        float t2 = t * t;
+
+        float series = Log2Series[terms.Log2 - 1];
+        for (int k = terms.Log2 - 2; k >= 0; --k)
+        {
+            series = series * t2 + Log2Series[k];
+        }
+
+        float y = exponent * (e + t * series);
+        if (!(y >= -125.0f))
+        {
+            return 0.0f;
+        }
+        y = std::min(y, 127.0f);
+
+        float i = std::nearbyint(y);
+        float f = y - i;
+
+        float p = Exp2Series[terms.Exp2 - 1];
+        for (int k = terms.Exp2 - 2; k >= 0; --k)
+        {
+            p = p * f + Exp2Series[k];
+        }
+
+        // Scales by 2^i through the exponent field
+        uint32_t pBits;
+        memcpy(&pBits, &p, sizeof(pBits));
+        pBits += static_cast<uint32_t>(static_cast<int32_t>(i)) << 23;
+        memcpy(&p, &pBits, sizeof(p));
+        return p;
+    }
+
+    // Lambertian diffuse & Blinn-Phong specular from one point light, with inverse square falloff
+    void ShadeFragment(const float* positionWS, const float* normalWS, const PixelConstants& constants, SpecularPow pow, float* color)
+    {
+        float V[3] = { constants.CameraPositionWS[0] - positionWS[0], constants.CameraPositionWS[1] - positionWS[1], constants.CameraPositionWS[2] - positionWS[2] };
+        Normalize(V);
+
+        float L[3] = { constants.LightPositionWS[0] - positionWS[0], constants.LightPositionWS[1] - positionWS[1], constants.LightPositionWS[2] - positionWS[2] };
+        float Ldist = std::sqrt(Dot(L, L));
+        L[0] /= Ldist;
+        L[1] /= Ldist;
+        L[2] /= Ldist;
+
+        float N[3] = { normalWS[0], normalWS[1], normalWS[2] };
+        Normalize(N);
+
+        float diffuseIntensity = Saturate(Dot(L, N));
+
+        float H[3] = { V[0] + L[0], V[1] + L[1], V[2] + L[2] };
+        Normalize(H);
+        float specularIntensity = SpecularPower(Saturate(Dot(N, H)), constants.ObjectShininess, pow);
+
+        float intensity = (diffuseIntensity + specularIntensity) / (Ldist * Ldist);
+        for (int c = 0; c < 3; ++c)
+        {
+            color[c] = intensity * constants.LightColor[c] * constants.ObjectColor[c];
+        }
+    }
+
+
+#if SIMD_X86
+    ////
+    // AVX2 - each step mirrors the scalar code's operations in the same order
+
+    SIMD_TARGET_AVX2 __m256 SaturateAvx2(__m256 x)
+    {
+        // max returns its second operand for NaN, so NaN becomes 0
+        return _mm256_min_ps(_mm256_max_ps(x, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+    }
+
+    SIMD_TARGET_AVX2 __m256 DotAvx2(const __m256* a, const __m256* b)
+    {
+        return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a[0], b[0]), _mm256_mul_ps(a[1], b[1])), _mm256_mul_ps(a[2], b[2]));
+    }
+
+    SIMD_TARGET_AVX2 void NormalizeAvx2(__m256* v)
+    {
+        __m256 invLength = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(DotAvx2(v, v)));
+        for (int c = 0; c < 3; ++c)
+        {
+            v[c] = _mm256_mul_ps(v[c], invLength);
+        }
+    }
+
+    SIMD_TARGET_AVX2 __m256 PowPolynomialAvx2(__m256 x, float exponent, PowTerms terms)
+    {
+        const __m256 one = _mm256_set1_ps(1.0f);
+
+        __m256  valid = _mm256_cmp_ps(x, _mm256_set1_ps(FLT_MIN), _CMP_GE_OQ);
+        __m256i bits  = _mm256_castps_si256(x);
+        __m256  e     = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127)));
+        __m256  m     = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007FFFFF)), _mm256_set1_epi32(0x3F800000)));
+
+        __m256 high = _mm256_cmp_ps(m, _mm256_set1_ps(Sqrt2), _CMP_GT_OQ);
+        m = _mm256_blendv_ps(m, _mm256_mul_ps(m, _mm256_set1_ps(0.5f)), high);
+        e = _mm256_blendv_ps(e, _mm256_add_ps(e, one), high);
+
+        __m256 t  = _mm256_div_ps(_mm256_sub_ps(m, one), _mm256_add_ps(m, one));
+        __m256 t2 = _mm256_mul_ps(t, t);
+
+        __m256 series = _mm256_set1_ps(Log2Series[terms.Log2 - 1]);
+        for (int k = terms.Log2 - 2; k >= 0; --k)
+        {
+            series = _mm256_add_ps(_mm256_mul_ps(series, t2), _mm256_set1_ps(Log2Series[k]));
+        }
+
+        __m256 y = _mm256_mul_ps(_mm256_set1_ps(exponent), _mm256_add_ps(e, _mm256_mul_ps(t, series)));
+        valid = _mm256_and_ps(valid, _mm256_cmp_ps(y, _mm256_set1_ps(-125.0f), _CMP_GE_OQ));
+        y = _mm256_min_ps(y, _mm256_set1_ps(127.0f));
+
+        __m256 i = _mm256_round_ps(y, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m256 f = _mm256_sub_ps(y, i);
+
+        __m256 p = _mm256_set1_ps(Exp2Series[terms.Exp2 - 1]);
+        for (int k = terms.Exp2 - 2; k >= 0; --k)
+        {
+            p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(Exp2Series[k]));
+        }
+
+        __m256i scaled = _mm256_add_epi32(_mm256_castps_si256(p), _mm256_slli_epi32(_mm256_cvtps_epi32(i), 23));
+        return _mm256_and_ps(_mm256_castsi256_ps(scaled), valid);
+    }
+
+    // Only the first count lanes hold fragments
+    SIMD_TARGET_AVX2 __m256 PowExactAvx2(__m256 x, float exponent, size_t count)
+    {
+        alignas(32) float lanes[8];
+        _mm256_store_ps(lanes, x);
+        for (size_t lane = 0; lane < count; ++lane)
+        {
+            lanes[lane] = std::pow(lanes[lane], exponent);
+        }
+        return _mm256_load_ps(lanes);
+    }
+
+    // Shades count fragments from first - mask has their lanes set
+    SIMD_TARGET_AVX2 void ShadeAvx2(const FragmentBatch& fragments, size_t first, size_t count, __m256i mask, const PixelConstants& constants, SpecularPow pow, float* const* outColor)
+    {
+        __m256 V[3], L[3], N[3], H[3];
+        for (int c = 0; c < 3; ++c)
+        {
+            __m256 position = _mm256_maskload_ps(fragments.PositionWS[c] + first, mask);
+            V[c] = _mm256_sub_ps(_mm256_set1_ps(constants.CameraPositionWS[c]), position);
+            L[c] = _mm256_sub_ps(_mm256_set1_ps(constants.LightPositionWS[c]), position);
+            N[c] = _mm256_maskload_ps(fragments.NormalWS[c] + first, mask);
+        }
+
+        NormalizeAvx2(V);
+
+        __m256 Ldist = _mm256_sqrt_ps(DotAvx2(L, L));
+        for (int c = 0; c < 3; ++c)
+        {
+            L[c] = _mm256_div_ps(L[c], Ldist);
+        }
+
+        NormalizeAvx2(N);
+
+        __m256 diffuseIntensity = SaturateAvx2(DotAvx2(L, N));
+
+        for (int c = 0; c < 3; ++c)
+        {
+            H[c] = _mm256_add_ps(V[c], L[c]);
+        }
+        NormalizeAvx2(H);
+
+        __m256 NdotH             = SaturateAvx2(DotAvx2(N, H));
+        __m256 specularIntensity = (pow == SpecularPow::Exact) ? PowExactAvx2(NdotH, constants.ObjectShininess, count) : PowPolynomialAvx2(NdotH, constants.ObjectShininess, GetPowTerms(pow));
+
+        __m256 intensity = _mm256_div_ps(_mm256_add_ps(diffuseIntensity, specularIntensity), _mm256_mul_ps(Ldist, Ldist));
+        for (int c = 0; c < 3; ++c)
+        {
+            __m256 color = _mm256_mul_ps(_mm256_mul_ps(intensity, _mm256_set1_ps(constants.LightColor[c])), _mm256_set1_ps(constants.ObjectColor[c]));
+            _mm256_maskstore_ps(outColor[c] + first, mask, color);
+        }
+    }
+
+    SIMD_TARGET_AVX2 void ShadeFragmentsAvx2(const FragmentBatch& fragments, const PixelConstants& constants, SpecularPow pow, float* const* outColor)
+    {
+        for (size_t first = 0; first < fragments.Count; first += 8)
+        {
+            size_t  count = std::min<size_t>(fragments.Count - first, 8);
+            __m256i mask  = _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(count)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+            ShadeAvx2(fragments, first, count, mask, constants, pow, outColor);
+        }
+    }
+
+
+    ////
+    // AVX-512 - as AVX2, with explicitly rounded arithmetic so nothing is fused into FMAs
+
+    SIMD_TARGET_AVX512 __m512 SaturateAvx512(__m512 x)
+    {
+        return _mm512_min_ps(_mm512_max_ps(x, _mm512_setzero_ps()), _mm512_set1_ps(1.0f));
+    }
+
+    SIMD_TARGET_AVX512 __m512 DotAvx512(const __m512* a, const __m512* b)
+    {
+        return AddRounded(AddRounded(MultiplyRounded(a[0], b[0]), MultiplyRounded(a[1], b[1])), MultiplyRounded(a[2], b[2]));
+    }
+
+    SIMD_TARGET_AVX512 void NormalizeAvx512(__m512* v)
+    {
+        __m512 invLength = _mm512_div_ps(_mm512_set1_ps(1.0f), _mm512_sqrt_ps(DotAvx512(v, v)));
+        for (int c = 0; c < 3; ++c)
+        {
+            v[c] = MultiplyRounded(v[c], invLength);
+        }
+    }
+
+    SIMD_TARGET_AVX512 __m512 PowPolynomialAvx512(__m512 x, float exponent, PowTerms terms)
+    {
+        const __m512 one = _mm512_set1_ps(1.0f);
+
+        __mmask16 valid = _mm512_cmp_ps_mask(x, _mm512_set1_ps(FLT_MIN), _CMP_GE_OQ);
+        __m512i   bits  = _mm512_castps_si512(x);
+        __m512    e     = _mm512_cvtepi32_ps(_mm512_sub_epi32(_mm512_srli_epi32(bits, 23), _mm512_set1_epi32(127)));
+        __m512    m     = _mm512_castsi512_ps(_mm512_or_si512(_mm512_and_si512(bits, _mm512_set1_epi32(0x007FFFFF)), _mm512_set1_epi32(0x3F800000)));
+
+        __mmask16 high = _mm512_cmp_ps_mask(m, _mm512_set1_ps(Sqrt2), _CMP_GT_OQ);
+        m = _mm512_mask_blend_ps(high, m, MultiplyRounded(m, _mm512_set1_ps(0.5f)));
+        e = _mm512_mask_blend_ps(high, e, AddRounded(e, one));
+
+        __m512 t  = _mm512_div_ps(SubtractRounded(m, one), AddRounded(m, one));
+        __m512 t2 = MultiplyRounded(t, t);
+
+        __m512 series = _mm512_set1_ps(Log2Series[terms.Log2 - 1]);
+        for (int k = terms.Log2 - 2; k >= 0; --k)
+        {
+            series = AddRounded(MultiplyRounded(series, t2), _mm512_set1_ps(Log2Series[k]));
+        }
+
+        __m512 y = MultiplyRounded(_mm512_set1_ps(exponent), AddRounded(e, MultiplyRounded(t, series)));
+        valid &= _mm512_cmp_ps_mask(y, _mm512_set1_ps(-125.0f), _CMP_GE_OQ);
+        y = _mm512_min_ps(y, _mm512_set1_ps(127.0f));
+
+        __m512 i = _mm512_roundscale_ps(y, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m512 f = SubtractRounded(y, i);
+
+        __m512 p = _mm512_set1_ps(Exp2Series[terms.Exp2 - 1]);
+        for (int k = terms.Exp2 - 2; k >= 0; --k)
+        {
+            p = AddRounded(MultiplyRounded(p, f), _mm512_set1_ps(Exp2Series[k]));
+        }
+
+        __m512i scaled = _mm512_add_epi32(_mm512_castps_si512(p), _mm512_slli_epi32(_mm512_cvtps_epi32(i), 23));
+        return _mm512_maskz_mov_ps(valid, _mm512_castsi512_ps(scaled));
+    }
+
+    SIMD_TARGET_AVX512 __m512 PowExactAvx512(__m512 x, float exponent, size_t count)
+    {
+        alignas(64) float lanes[16];
+        _mm512_store_ps(lanes, x);
+        for (size_t lane = 0; lane < count; ++lane)
+        {
+            lanes[lane] = std::pow(lanes[lane], exponent);
+        }
+        return _mm512_load_ps(lanes);
+    }
+
+    SIMD_TARGET_AVX512 void ShadeAvx512(const FragmentBatch& fragments, size_t first, size_t count, __mmask16 mask, const PixelConstants& constants, SpecularPow pow, float* const* outColor)
+    {
+        __m512 V[3], L[3], N[3], H[3];
+        for (int c = 0; c < 3; ++c)
+        {
+            __m512 position = _mm512_maskz_loadu_ps(mask, fragments.PositionWS[c] + first);
+            V[c] = SubtractRounded(_mm512_set1_ps(constants.CameraPositionWS[c]), position);
+            L[c] = SubtractRounded(_mm512_set1_ps(constants.LightPositionWS[c]), position);
+            N[c] = _mm512_maskz_loadu_ps(mask, fragments.NormalWS[c] + first);
+        }
+
+        NormalizeAvx512(V);
+
+        __m512 Ldist = _mm512_sqrt_ps(DotAvx512(L, L));
+        for (int c = 0; c < 3; ++c)
+        {
+            L[c] = _mm512_div_ps(L[c], Ldist);
+        }
+
+        NormalizeAvx512(N);
+
+        __m512 diffuseIntensity = SaturateAvx512(DotAvx512(L, N));
+
+        for (int c = 0; c < 3; ++c)
+        {
+            H[c] = AddRounded(V[c], L[c]);
+        }
+        NormalizeAvx512(H);
+
+        __m512 NdotH             = SaturateAvx512(DotAvx512(N, H));
+        __m512 specularIntensity = (pow == SpecularPow::Exact) ? PowExactAvx512(NdotH, constants.ObjectShininess, count) : PowPolynomialAvx512(NdotH, constants.ObjectShininess, GetPowTerms(pow));
+
+        __m512 intensity = _mm512_div_ps(AddRounded(diffuseIntensity, specularIntensity), MultiplyRounded(Ldist, Ldist));
+        for (int c = 0; c < 3; ++c)
+        {
+            __m512 color = MultiplyRounded(MultiplyRounded(intensity, _mm512_set1_ps(constants.LightColor[c])), _mm512_set1_ps(constants.ObjectColor[c]));
+            _mm512_mask_storeu_ps(outColor[c] + first, mask, color);
+        }
+    }
+
+    SIMD_TARGET_AVX512 void ShadeFragmentsAvx512(const FragmentBatch& fragments, const PixelConstants& constants, SpecularPow pow, float* const* outColor)
+    {
+        for (size_t first = 0; first < fragments.Count; first += 16)
+        {
+            size_t    count = std::min<size_t>(fragments.Count - first, 16);
+            __mmask16 mask  = static_cast<__mmask16>((1u << count) - 1);
+            ShadeAvx512(fragments, first, count, mask, constants, pow, outColor);
+        }
+    }
+#endif
+}
+
+void ShadeFragmentReference(const float* positionWS, const float* normalWS, const AppShaderConstants& constants, float* outColor)
+{
+    ShadeFragment(positionWS, normalWS, GetPixelConstants(constants), SpecularPow::Exact, outColor);
+}
+
+void ShadeFragments(const FragmentBatch& fragments, const AppShaderConstants& constants, float* const outColor[3], const ShadingOptions& options)
+{
+    const PixelConstants pixelConstants = GetPixelConstants(constants);
+    const SimdLevel      level          = std::min(options.MaxSimdLevel, GetSupportedSimdLevel());
+
+#if SIMD_X86
+    if (level >= SimdLevel::Avx512)
+    {
+        ShadeFragmentsAvx512(fragments, pixelConstants, options.Pow, outColor);
+        return;
+    }
+
+    if (level >= SimdLevel::Avx2)
+    {
+        ShadeFragmentsAvx2(fragments, pixelConstants, options.Pow, outColor);
+        return;
+    }
+#endif
+
+    for (size_t i = 0; i < fragments.Count; ++i)
+    {
+        const float positionWS[3] = { fragments.PositionWS[0][i], fragments.PositionWS[1][i], fragments.PositionWS[2][i] };
+        const float normalWS[3]   = { fragments.NormalWS[0][i], fragments.NormalWS[1][i], fragments.NormalWS[2][i] };
+
+        float color[3];
+        ShadeFragment(positionWS, normalWS, pixelConstants, options.Pow, color);
+
+        outColor[0][i] = color[0];
+        outColor[1][i] = color[1];
+        outColor[2][i] = color[2];
+    }
+}
+
+float SpecularPower(float x, float exponent, SpecularPow pow)
+{
+    return (pow == SpecularPow::Exact) ? std::pow(x, exponent) : PowPolynomial(x, exponent, GetPowTerms(pow));
+}
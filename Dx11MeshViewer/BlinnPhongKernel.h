@@ -0,0 +1,49 @@
+//
+// BlinnPhongKernel.h
+//
+
+#pragma once
+
+#include "SceneConstants.h"
+#include "Simd.h"
+
+#include <cstddef>
+
+// How the specular term is raised to ObjectShininess
+//
+// The approximations compute exp2(shininess * log2(x)) from short polynomials. Where the result is large enough to
+// show, the product stays small, so their relative error hardly depends on shininess - about 2e-6 for Accurate and
+// 1e-3 for Fast, which moves an sRGB8 highlight by at most one step.
+enum class SpecularPow
+{
+    Exact,      // std::pow per fragment, as the reference does
+    Accurate,   // Degree 7 log2 & degree 6 exp2
+    Fast,       // Degree 3 log2 & degree 3 exp2
+};
+
+struct ShadingOptions
+{
+    SpecularPow Pow          = SpecularPow::Exact;
+    SimdLevel   MaxSimdLevel = SimdLevel::Avx512;  // Clamped to GetSupportedSimdLevel()
+};
+
+// Fragments in structure-of-arrays form - element i of each array belongs to fragment i
+struct FragmentBatch
+{
+    const float* PositionWS[3];  // x, y & z arrays
+    const float* NormalWS[3];    // Interpolated, so needn't be unit length
+    size_t       Count = 0;
+};
+
+// BasicPS.hlsl PSMain for one fragment, as written - the reference the kernel is checked against
+void  ShadeFragmentReference(const float* positionWS, const float* normalWS, const AppShaderConstants& constants, float* outColor);
+
+// PSMain for a batch of fragments, writing linear RGB to outColor[0..2][i]
+//
+// Shades 8 fragments per instruction at AVX2 & 16 at AVX-512, masking off the remainder, & one at a time below
+// that. Every level rounds exactly as the scalar code does, so a SpecularPow gives identical colors at any level,
+// and with SpecularPow::Exact those match ShadeFragmentReference bit for bit.
+void  ShadeFragments(const FragmentBatch& fragments, const AppShaderConstants& constants, float* const outColor[3], const ShadingOptions& options = {});
+
+// x^exponent for x in [0, 1] as the kernel computes it, for error reports
+float SpecularPower(float x, float exponent, SpecularPow pow);
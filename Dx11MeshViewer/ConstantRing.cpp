@@ -0,0 +1,79 @@
+//
+// ConstantRing.cpp
+//
+
+#include "pch.h"
+#include "ConstantRing.h"
+
+void ConstantRing::Reset(uint32_t capacity)
+{
+    m_capacity   = capacity & ~(Alignment - 1);
+    m_head       = 0;
+    m_tail       = 0;
+    m_used       = 0;
+    m_frameBytes = 0;
+    m_frames.clear();
+}
+
+bool ConstantRing::Allocate(uint32_t size, uint32_t& outOffset)
+{
+    const uint64_t aligned = (static_cast<uint64_t>(size) + Alignment - 1) & ~static_cast<uint64_t>(Alignment - 1);
+    if (size == 0 || aligned > m_capacity - m_used)
+    {
+        return false;
+    }
+
+    // Nothing in flight - start over from the front rather than wrap
+    if (m_used == 0 && m_frames.empty())
+    {
+        m_head = 0;
+        m_tail = 0;
+    }
+
+    uint32_t offset  = m_head;
+    uint32_t skipped = 0;
+
+    if (m_head >= m_tail)
+    {
+        // Free space runs from the head to the end, then from the start to the tail
+        if (aligned > m_capacity - m_head)
+        {
+            if (aligned > m_tail)
+            {
+                return false;
+            }
+
+            skipped = m_capacity - m_head;
+            offset  = 0;
+        }
+    }
+    else if (aligned > m_tail - m_head)
+    {
+        return false;
+    }
+
+    const uint32_t bytes = static_cast<uint32_t>(aligned) + skipped;
+
+    m_head        = (offset + static_cast<uint32_t>(aligned) == m_capacity) ? 0 : offset + static_cast<uint32_t>(aligned);
+    m_used       += bytes;
+    m_frameBytes += bytes;
+
+    outOffset = offset;
+    return true;
+}
+
+void ConstantRing::EndFrame(uint64_t frame)
+{
+    m_frames.push_back({ frame, m_head, m_frameBytes });
+    m_frameBytes = 0;
+}
+
+void ConstantRing::Retire(uint64_t completedFrame)
+{
+    while (!m_frames.empty() && m_frames.front().Frame <= completedFrame)
+    {
+        m_tail  = m_frames.front().End;
+        m_used -= m_frames.front().Bytes;
+        m_frames.pop_front();
+    }
+}
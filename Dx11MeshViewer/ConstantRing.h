@@ -0,0 +1,61 @@
+//
+// ConstantRing.h
+//
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+
+// Sub-allocates constant blocks for the draws of each frame from one buffer, used as a ring
+//
+// Blocks are handed out front to back, & a frame's blocks are only reused once the GPU has finished that frame -
+// the caller tracks that with its own fences & reports it through Retire. A block that doesn't fit before the end of
+// the buffer starts again at offset 0, leaving the tail unused until its frame retires. Offsets are aligned for
+// binding with VSSetConstantBuffers1, whose ranges start at multiples of 16 constants.
+class ConstantRing
+{
+public:
+    static const uint32_t Alignment = 256;
+
+    ConstantRing()
+        : m_capacity{}
+        , m_head{}
+        , m_tail{}
+        , m_used{}
+        , m_frameBytes{}
+    { }
+
+    // Empties the ring & sizes it to capacity bytes, rounded down to the alignment
+    void     Reset(uint32_t capacity);
+
+    // Reserves size bytes, rounded up to the alignment, & returns false if frames still in flight hold the space -
+    // retiring them makes room
+    bool     Allocate(uint32_t size, uint32_t& outOffset);
+
+    // The blocks allocated since the last call belong to frame
+    void     EndFrame(uint64_t frame);
+
+    // Frees the blocks of every frame up to & including completedFrame, which the GPU has finished with
+    void     Retire(uint64_t completedFrame);
+
+    uint32_t Capacity() const        { return m_capacity; }
+    uint32_t UsedBytes() const       { return m_used; }     // Including tails skipped by wrapping around
+    size_t   FramesInFlight() const  { return m_frames.size(); }
+
+private:
+    // Where a frame's blocks end, & the bytes they took since the frame before
+    struct FrameMark
+    {
+        uint64_t Frame;
+        uint32_t End;
+        uint32_t Bytes;
+    };
+
+    uint32_t              m_capacity;
+    uint32_t              m_head;        // Next free byte
+    uint32_t              m_tail;        // Oldest byte in use - equal to m_head when the ring is empty or full
+    uint32_t              m_used;
+    uint32_t              m_frameBytes;  // Allocated since the last EndFrame
+    std::deque<FrameMark> m_frames;      // Oldest first
+};
@@ -0,0 +1,26 @@
+//
+// ConstantShadow.cpp
+//
+
+#include "pch.h"
+#include "ConstantShadow.h"
+
+#include <cstring>
+
+bool ConstantShadow::Update(const void* data, size_t size, UploadStats& stats)
+{
+    // Blocks are a few dozen bytes, so comparing costs less than the upload it saves
+    if (m_valid && m_bytes.size() == size && std::memcmp(m_bytes.data(), data, size) == 0)
+    {
+        ++stats.BlocksSkipped;
+        return false;
+    }
+
+    m_bytes.resize(size);
+    std::memcpy(m_bytes.data(), data, size);
+    m_valid = true;
+
+    ++stats.BlocksUploaded;
+    stats.ConstantBytes += size;
+    return true;
+}
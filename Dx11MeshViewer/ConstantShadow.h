@@ -0,0 +1,41 @@
+//
+// ConstantShadow.h
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// What one frame handed to the GPU
+struct UploadStats
+{
+    uint64_t ConstantBytes  = 0;
+    uint64_t InstanceBytes  = 0;
+    uint32_t BlocksUploaded = 0;
+    uint32_t BlocksSkipped  = 0;  // Unchanged since their last upload
+};
+
+// CPU copy of a constant buffer's last uploaded contents, so a block is only uploaded again once it changes
+class ConstantShadow
+{
+public:
+    ConstantShadow()
+        : m_valid(false)
+    { }
+
+    // Returns true, recording data as uploaded, if it differs from the last upload or there's been none - counting
+    // the block in stats either way
+    bool     Update(const void* data, size_t size, UploadStats& stats);
+
+    template <typename Block>
+    bool     Update(const Block& block, UploadStats& stats) { return Update(&block, sizeof(Block), stats); }
+
+    // Forces the next Update to upload, as after the buffer is recreated
+    void     Invalidate() { m_valid = false; }
+
+private:
+    std::vector<uint8_t> m_bytes;
+    bool                 m_valid;
+};
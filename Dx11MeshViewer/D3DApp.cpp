@@ -5,9 +5,15 @@
 #include "pch.h"
 #include "D3DApp.h"
 
+#include <algorithm>
 #include <DirectXMath.h>
 #include <d3dcompiler.h>
 #include "MeshLoader.h"
+#include "FrustumCuller.h"
+#include "InstancePacker.h"
+#include "LodSelector.h"
+#include "OcclusionCuller.h"
+#include "VertexBounds.h"
 
 
 using namespace DirectX;
@@ -26,25 +32,6 @@ struct PosNormalVertex
     XMFLOAT3 Normal;
 };
 
-// Shader constant buffer
-struct AppShaderConstants
-{
-    // Transforms
-    XMFLOAT4X4 World;
-    XMFLOAT4X4 WorldViewProjection;
-
-    // Object material properties
-    XMFLOAT3 ObjectColor;
-    float    ObjectShininess;
-
-    // Light properties
-    XMFLOAT4 LightPositionWS;
-    XMFLOAT4 LightColor;
-
-    // Camera properties
-    XMFLOAT4 CameraPositionWS;
-};
-
 
 void D3DApp::Init(HWND hwnd)
 {
@@ -161,15 +148,33 @@ void D3DApp::InitResources()
     ////
     // Load the mesh from file and upload vertex & index buffers to the GPU
 
+    MeshLoadOptions loadOptions;
+    loadOptions.Optimize = true; // Triangle & vertex order tuned for the post-transform cache, overdraw & fetch
+    loadOptions.BuildLods = true; // Coarser levels for when the object covers fewer pixels
+    loadOptions.UseCache = true; // Later starts reload teapot.obj.meshcache instead of re-parsing - see MeshTool cache
+
     Mesh loadedMesh;
-    ThrowIfFailed(LoadMesh("teapot.obj", loadedMesh));
+    ThrowIfFailed(LoadMesh("teapot.obj", loadedMesh, loadOptions));
+
+    m_indexCount  = static_cast<UINT>(loadedMesh.IndexCount());
+    m_indexFormat = (loadedMesh.IndexSize == sizeof(uint16_t)) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+    m_submeshes   = loadedMesh.Submeshes;
+    m_lods        = loadedMesh.Lods;
+
+    FocusCamera(m_scene, loadedMesh.BoundsMin, loadedMesh.BoundsMax);
 
-    m_indexCount = static_cast<UINT>(loadedMesh.IndexBuffer.size());
+    // A tight sphere keeps the LOD distance from erring toward full detail
+    VertexBounds bounds;
+    ComputeVertexBounds(loadedMesh.VertexBuffer.data(), loadedMesh.VertexBuffer.size() / 6, 6, bounds);
 
-    XMVECTOR min = DirectX::XMLoadFloat3(&loadedMesh.BoundsMin);
-    XMVECTOR max = DirectX::XMLoadFloat3(&loadedMesh.BoundsMax);
- 
-    DirectX::XMStoreFloat3(&m_cameraFocus, (max + min) / 2 * m_objectScale);
+    m_boundsCenter = bounds.SphereCenter;
+    m_boundsRadius = bounds.SphereRadius;
+
+    // Placed where the scene puts it each frame
+    m_objects.Add(XMMatrixIdentity(), loadedMesh.BoundsMin, loadedMesh.BoundsMax);
+    m_objectColors.assign(m_objects.Count(), XMFLOAT3(1.0f, 1.0f, 1.0f));
+    m_visibleObjects.resize(m_objects.Count());
+    m_objectVisible.assign(m_objects.Count(), 1);
 
 
     D3D11_BUFFER_DESC vertexBufferDesc {};
@@ -184,35 +189,52 @@ void D3DApp::InitResources()
 
 
     D3D11_BUFFER_DESC indexBufferDesc {};
-    indexBufferDesc.ByteWidth = m_indexCount * sizeof(uint32_t);
+    indexBufferDesc.ByteWidth = m_indexCount * loadedMesh.IndexSize;
     indexBufferDesc.Usage     = D3D11_USAGE_IMMUTABLE;
     indexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
 
     D3D11_SUBRESOURCE_DATA indexData {};
-    indexData.pSysMem = loadedMesh.IndexBuffer.data();
+    indexData.pSysMem = loadedMesh.IndexData();
 
     ThrowIfFailed(m_device->CreateBuffer(&indexBufferDesc, &indexData, m_indexBuffer.ReleaseAndGetAddressOf()));
 
+    m_meshData = std::move(loadedMesh);
+
 
     ////
-    // Create the constant buffer(s) and the staging buffer resources
+    // Create the constant buffers - one per update frequency, each sized to its block
 
     D3D11_BUFFER_DESC cbDesc {};
-    cbDesc.ByteWidth = (sizeof(AppShaderConstants) + 255) & ~255; // Force up to next multiple of 256
     cbDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-    cbDesc.Usage     = D3D11_USAGE_DEFAULT;
+    cbDesc.Usage     = D3D11_USAGE_DEFAULT; // Updated in place - the driver versions it while the GPU reads the last contents
 
-    for (int i = 0; i < 2; ++i)
-    {
-        ThrowIfFailed(m_device->CreateBuffer(&cbDesc, nullptr, m_constantBuffer[i].ReleaseAndGetAddressOf()));
-    }
+    cbDesc.ByteWidth = sizeof(AppFrameConstants);
+    ThrowIfFailed(m_device->CreateBuffer(&cbDesc, nullptr, m_frameConstants.ReleaseAndGetAddressOf()));
+
+    cbDesc.ByteWidth = sizeof(AppMaterialConstants);
+    ThrowIfFailed(m_device->CreateBuffer(&cbDesc, nullptr, m_materialConstants.ReleaseAndGetAddressOf()));
+
+    cbDesc.ByteWidth = sizeof(AppObjectConstants);
+    ThrowIfFailed(m_device->CreateBuffer(&cbDesc, nullptr, m_objectConstants.ReleaseAndGetAddressOf()));
+
+    m_frameShadow.Invalidate();
+    m_materialShadow.Invalidate();
+    m_objectShadow.Invalidate();
 
-    D3D11_BUFFER_DESC uploadDesc {};
-    uploadDesc.ByteWidth      = cbDesc.ByteWidth;
-    uploadDesc.Usage          = D3D11_USAGE_STAGING;
-    uploadDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
 
-    ThrowIfFailed(m_device->CreateBuffer(&uploadDesc, nullptr, m_uploadBuffer.ReleaseAndGetAddressOf()));
+    ////
+    // Create the instance buffer - room for every object, as all may be visible at once
+
+    D3D11_BUFFER_DESC instanceDesc {};
+    instanceDesc.ByteWidth           = static_cast<UINT>(m_objects.Count() * sizeof(AppInstanceData));
+    instanceDesc.Usage               = D3D11_USAGE_DYNAMIC;
+    instanceDesc.BindFlags           = D3D11_BIND_SHADER_RESOURCE;
+    instanceDesc.CPUAccessFlags      = D3D11_CPU_ACCESS_WRITE;
+    instanceDesc.MiscFlags           = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+    instanceDesc.StructureByteStride = sizeof(AppInstanceData);
+
+    ThrowIfFailed(m_device->CreateBuffer(&instanceDesc, nullptr, m_instanceBuffer.ReleaseAndGetAddressOf()));
+    ThrowIfFailed(m_device->CreateShaderResourceView(m_instanceBuffer.Get(), nullptr, m_instanceBufferSRV.ReleaseAndGetAddressOf())); // Whole buffer, element by element
 
 
     ////
@@ -276,87 +298,157 @@ void D3DApp::Update(float dt)
     // Update the app state
 
     // Gently auto-rotate the object about the Y-axis
-    m_objectRotation += m_objectRotationSpeed * dt;
+    m_scene.ObjectRotation += m_objectRotationSpeed * dt;
 
     // Determine change in mouse position (when the left mouse button is held down)
     XMVECTOR deltaPos = XMLoadFloat2(&m_currPos) - XMLoadFloat2(&m_prevPos);
     m_prevPos = m_currPos;
 
-    m_cameraPhi   -= XMVectorGetY(deltaPos) * m_cameraRotateRate * dt;
-    m_cameraTheta += XMVectorGetX(deltaPos) * m_cameraRotateRate * dt;
+    m_scene.CameraPhi   -= XMVectorGetY(deltaPos) * m_cameraRotateRate * dt;
+    m_scene.CameraTheta += XMVectorGetX(deltaPos) * m_cameraRotateRate * dt;
 
-    m_cameraPhi = std::min(std::max(m_cameraPhi, 5.0f), 175.0f);
+    m_scene.CameraPhi = std::min(std::max(m_scene.CameraPhi, 5.0f), 175.0f);
 
 
     ////
     // Recompute constant buffer data each frame
 
-    const float degToRads = XM_PI / 180.0f;
-	XMVECTOR yAxis = DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
-
-    // Compute our object's world-space transform
-	XMMATRIX worldMat = XMMatrixAffineTransformation(
-		XMVectorReplicate(m_objectScale), 
-		XMQuaternionIdentity(), 
-		XMQuaternionRotationAxis(yAxis, m_objectRotation * degToRads), 
-		XMLoadFloat3(&m_objectPosition)
-	);
-
-    // Compute camera position
-    float phi   = m_cameraPhi * degToRads;
-    float theta = m_cameraTheta * degToRads;
-
-    // Spherical to Cartesian Coordinates
-    XMVECTOR cameraPosition = XMVectorSet(
-        m_cameraDistance * sinf(phi) * cosf(theta),
-        m_cameraDistance * cosf(phi),
-        m_cameraDistance * sinf(phi) * sinf(theta),
-        1.0f
-    );
+    m_uploadStats = {};
 
     float aspectRatio = static_cast<float>(m_width) / static_cast<float>(m_height);
 
-    XMMATRIX viewMat         = XMMatrixLookAtRH(cameraPosition, DirectX::XMLoadFloat3(&m_cameraFocus), yAxis);
-    XMMATRIX projMat         = XMMatrixPerspectiveFovRH(60.0f * degToRads, aspectRatio, 0.25f, 1000.0f); // FOVY, Aspect ratio, Near Plane Z, Far Plane Z
-    XMMATRIX worldViewProjMat = worldMat * viewMat * projMat;
+    AppShaderConstants constants;
+    ComputeShaderConstants(m_scene, aspectRatio, constants);
+
+
+    ////
+    // Pick the coarsest level of detail whose error stays under a pixel
+
+    XMMATRIX worldMat       = XMMatrixTranspose(XMLoadFloat4x4(&constants.World));
+    XMVECTOR cameraPosition = XMLoadFloat4(&constants.CameraPositionWS);
+    XMVECTOR boundsCenterWS = XMVector3Transform(XMLoadFloat3(&m_boundsCenter), worldMat);
+
+    LodView lodView {};
+    lodView.Distance       = XMVectorGetX(XMVector3Length(cameraPosition - boundsCenterWS)) - m_boundsRadius * m_scene.ObjectScale;
+    lodView.FieldOfViewY   = m_scene.FieldOfViewY * XM_PI / 180.0f;
+    lodView.ViewportHeight = static_cast<float>(m_height);
+
+    m_lodLevel = SelectLod(m_lods, m_scene.ObjectScale, lodView, m_lodMaxErrorPixels);
+
+
+    ////
+    // Cull the scene's objects to the view frustum, planes taken from the view-projection transform
+
+    m_objects.SetWorld(0, worldMat);
+
+    XMFLOAT4X4 viewProjection;
+    ComputeViewProjection(m_scene, aspectRatio, viewProjection);
+
+    FrustumPlanes frustumPlanes;
+    ExtractFrustumPlanes(viewProjection, frustumPlanes);
+
+    FrustumCullOptions cullOptions;
+    cullOptions.Pool = &m_cullingPool;
+
+    m_visibleObjectCount = CullFrustum(frustumPlanes, m_objects.Boxes(), m_visibleObjects.data(), cullOptions);
+
+
+    ////
+    // Cull the visible objects hidden behind the others - every one is drawn into the occluder depth at the level of
+    // detail it's drawn at, as its own triangles lie within its box & so can't hide it. A lone object has nothing to
+    // be hidden by, so the pass is skipped
+
+    if (m_visibleObjectCount > 1)
+    {
+        const std::vector<Submesh>& drawnSubmeshes = (m_lodLevel == 0) ? m_submeshes : m_lods[m_lodLevel - 1].Submeshes;
+
+        m_occluders.VertexBuffer.clear();
+        m_occluders.IndexBuffer.clear();
+        m_occluders.Submeshes.clear();
+
+        for (size_t i = 0; i < m_visibleObjectCount; ++i)
+        {
+            AppendOccluder(m_meshData, drawnSubmeshes, XMLoadFloat4x4(&m_objects.World(m_visibleObjects[i])), m_occluders);
+        }
+
+        OcclusionOptions occlusionOptions;
+        occlusionOptions.Height = std::max(1u, occlusionOptions.Width * m_height / std::max(m_width, 1u));
+        occlusionOptions.Pool   = &m_cullingPool;
+
+        if (SUCCEEDED(RenderOccluders(m_occluders, m_occluders.Submeshes, viewProjection, m_occlusionBuffer, occlusionOptions)))
+        {
+            TestOcclusion(m_occlusionBuffer, m_objects.Boxes(), viewProjection, m_objectVisible.data(), occlusionOptions);
+
+            m_visibleObjectCount = std::remove_if(m_visibleObjects.begin(), m_visibleObjects.begin() + m_visibleObjectCount, [&](uint32_t index)
+            {
+                return !m_objectVisible[index];
+            }) - m_visibleObjects.begin();
+        }
+    }
 
 
     ////
-    // Populate our staging buffer
+    // Pack the visible objects into the instance buffer, straight into its mapped memory
 
-    AppShaderConstants constants {};
-    XMStoreFloat4x4(&constants.World, XMMatrixTranspose(worldMat)); // Want to keep consistent
-    XMStoreFloat4x4(&constants.WorldViewProjection, XMMatrixTranspose(worldViewProjMat));
+    if (m_visibleObjectCount > 0)
+    {
+        // Discarding hands back fresh memory while the GPU may still read last frame's instances
+        D3D11_MAPPED_SUBRESOURCE instances;
+        ThrowIfFailed(m_deviceContext->Map(m_instanceBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &instances));
 
-    XMStoreFloat3(&constants.ObjectColor, XMLoadFloat3(&m_objectColor));
-    constants.ObjectShininess = m_objectShininess;
+        InstancePackOptions packOptions;
+        packOptions.Pool = &m_cullingPool;
 
-    XMStoreFloat4(&constants.LightPositionWS, XMLoadFloat3(&m_lightPosition));
-    XMStoreFloat4(&constants.LightColor, XMLoadFloat3(&m_lightColor));
+        PackInstances(m_objects, m_visibleObjects.data(), m_visibleObjectCount, viewProjection, m_objectColors.data(),
+                      static_cast<AppInstanceData*>(instances.pData), packOptions);
 
-    XMStoreFloat4(&constants.CameraPositionWS, cameraPosition);
+        m_deviceContext->Unmap(m_instanceBuffer.Get(), 0);
+
+        m_uploadStats.InstanceBytes += m_visibleObjectCount * sizeof(AppInstanceData);
+    }
 
 
     ////
-    // Copy the constants to the upload buffer
+    // Upload the constant blocks that changed - the material block only when first set, the frame block when the camera
+    // or light moves
 
-    // 'Mapping' a resource means the resource memory is mapped to the client's address space to allow application data emplacement
-    // Once unmapped it's copied to the GPU-side memory of the upload buffer
-    D3D11_MAPPED_SUBRESOURCE subresource;
-    ThrowIfFailed(m_deviceContext->Map(m_uploadBuffer.Get(), 0, D3D11_MAP_WRITE, 0, &subresource));
+    AppFrameConstants    frameConstants;
+    AppMaterialConstants materialConstants;
+    SplitShaderConstants(constants, frameConstants, materialConstants);
 
-    std::memcpy(subresource.pData, &constants, sizeof(constants));
+    if (m_frameShadow.Update(frameConstants, m_uploadStats))
+    {
+        m_deviceContext->UpdateSubresource(m_frameConstants.Get(), 0, nullptr, &frameConstants, 0, 0);
+    }
+
+    if (m_materialShadow.Update(materialConstants, m_uploadStats))
+    {
+        m_deviceContext->UpdateSubresource(m_materialConstants.Get(), 0, nullptr, &materialConstants, 0, 0);
+    }
+
+
+    ////
+    // List the draws - every visible object at once, one instanced call per submesh - & whether each one updates the
+    // per-object block
+
+    const std::vector<Submesh>& submeshes = (m_lodLevel == 0) ? m_submeshes : m_lods[m_lodLevel - 1].Submeshes;
+
+    m_drawCalls.clear();
+    for (size_t i = 0; i < submeshes.size() && m_visibleObjectCount > 0; ++i)
+    {
+        // Every draw's instances start at the front of the instance buffer, so only the first can find the block changed
+        DrawCall draw = { submeshes[i].IndexCount, submeshes[i].FirstIndex, static_cast<UINT>(m_visibleObjectCount), 0, false };
 
-    m_deviceContext->Unmap(m_uploadBuffer.Get(), 0);
+        AppObjectConstants objectConstants = {};
+        objectConstants.FirstInstance = draw.FirstInstance;
+
+        draw.UpdateObject = m_objectShadow.Update(objectConstants, m_uploadStats);
+        m_drawCalls.push_back(draw);
+    }
 }
 
 void D3DApp::Draw()
 {
-    // Schedule a copy from the upload buffer to the GPU constant buffer
-    // Need to cycle between different constant buffers each frame to avoid writing to one being read by the GPU
-    UINT bufferIndex = m_frameIndex & 0x1;
-    m_deviceContext->CopyResource(m_constantBuffer[bufferIndex].Get(), m_uploadBuffer.Get());
-
     // Clear the render target to dark grey
     FLOAT backgroundColor[4] = { 0.025f, 0.025f, 0.025f, 1.0f };
     m_deviceContext->ClearRenderTargetView(m_backBufferRTV.Get(), backgroundColor);
@@ -384,30 +476,45 @@ void D3DApp::Draw()
     ID3D11Buffer* vbuffers[] = { m_vertexBuffer.Get() };
 
     m_deviceContext->IASetVertexBuffers(0, 1, vbuffers, &stride, &offset);
-    m_deviceContext->IASetIndexBuffer(m_indexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0); // Assuming the format of the index data is 32-bit
+    m_deviceContext->IASetIndexBuffer(m_indexBuffer.Get(), m_indexFormat, 0);
 
     // Set the vertex & pixel shader programs
     m_deviceContext->VSSetShader(m_vertexShader.Get(), nullptr, 0);
     m_deviceContext->PSSetShader(m_pixelShader.Get(), nullptr, 0);
 
-    // Same constant buffer for both shader stages
-    ID3D11Buffer* constantBuffers[] = { m_constantBuffer[bufferIndex].Get() };
-    m_deviceContext->VSSetConstantBuffers(0, 1, constantBuffers);
-    m_deviceContext->PSSetConstantBuffers(0, 1, constantBuffers);
+    // The pixel shader reads the per-frame & per-material blocks - the vertex shader's per-object block is bound by draw
+    ID3D11Buffer* pixelBuffers[] = { m_frameConstants.Get(), m_materialConstants.Get() };
+    m_deviceContext->PSSetConstantBuffers(0, 2, pixelBuffers);
+
+    // The vertex shader fetches each copy's transforms & color by SV_InstanceID
+    ID3D11ShaderResourceView* instanceViews[] = { m_instanceBufferSRV.Get() };
+    m_deviceContext->VSSetShaderResources(0, 1, instanceViews);
 
     // Set the fixed-function graphics pipeline state
     m_deviceContext->RSSetState(m_rasterizerState.Get());
     m_deviceContext->OMSetDepthStencilState(m_depthStencilState.Get(), 0);
     m_deviceContext->OMSetBlendState(m_blendState.Get(), nullptr, 0xffffffff);
 
-    // Draw the mesh
-    m_deviceContext->DrawIndexed(m_indexCount, 0, 0);
+    // Draw the listed calls, updating the per-object block first where Update found the draw's block differs
+    ID3D11Buffer* objectBuffers[] = { m_objectConstants.Get() };
+    m_deviceContext->VSSetConstantBuffers(2, 1, objectBuffers);
+
+    for (const DrawCall& draw : m_drawCalls)
+    {
+        if (draw.UpdateObject)
+        {
+            AppObjectConstants objectConstants = {};
+            objectConstants.FirstInstance = draw.FirstInstance;
+            m_deviceContext->UpdateSubresource(m_objectConstants.Get(), 0, nullptr, &objectConstants, 0, 0);
+        }
+
+        m_deviceContext->DrawIndexedInstanced(draw.IndexCount, draw.InstanceCount, draw.FirstIndex, 0, 0);
+    }
 }
 
 void D3DApp::Present()
 {
     ThrowIfFailed(m_swapChain->Present(1, 0)); // Flip on VBlank (vsync refresh rate interval)
-    ++m_frameIndex;
 }
 
 LRESULT D3DApp::HandleInput(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
@@ -433,6 +540,27 @@ LRESULT D3DApp::HandleInput(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
         return 0;
     }
 
+    case WM_MOUSEWHEEL:
+    {
+        // Dolly the camera in & out, which is also what brings the coarser levels of detail in
+        float notches = static_cast<float>(GET_WHEEL_DELTA_WPARAM(wParam)) / WHEEL_DELTA;
+
+        // Out to where the coarsest level switches in, with some margin, but never past the far plane
+        float objectRadius = m_boundsRadius * m_scene.ObjectScale;
+        float maxDistance  = m_scene.FarZ - objectRadius;
+
+        if (!m_lods.empty())
+        {
+            float coarsestDistance = ErrorSwitchDistance(m_lods.back().Error * m_scene.ObjectScale, m_scene.FieldOfViewY * XM_PI / 180.0f,
+                                                         static_cast<float>(m_height), m_lodMaxErrorPixels);
+            maxDistance = std::min(maxDistance, coarsestDistance * 1.25f + objectRadius);
+        }
+
+        m_scene.CameraDistance = std::min(std::max(m_scene.CameraDistance * powf(0.9f, notches), 1.0f), std::max(maxDistance, 1.0f));
+
+        return 0;
+    }
+
     case WM_SIZE:
     {
         UINT width = (lParam & 0x0000ffff) >> 0;
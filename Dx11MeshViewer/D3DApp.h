@@ -8,7 +8,14 @@
 #include <DirectXMath.h>
 #include <wrl.h>
 
+#include "ConstantShadow.h"
+#include "FrustumCuller.h"
+#include "InstancePacker.h"
 #include "MeshLoader.h"
+#include "OcclusionCuller.h"
+#include "SceneConstants.h"
+#include "SceneObjects.h"
+#include "ThreadPool.h"
 
 using Microsoft::WRL::ComPtr;
 
@@ -19,23 +26,17 @@ public:
         : m_isRunning(true)
         , m_width{}
         , m_height{}
-        , m_frameIndex{}
-        , m_objectPosition{}
-        , m_objectRotation{}
-        , m_objectScale(0.7f)
         , m_objectRotationSpeed(10.0f)
-        , m_objectColor(0.6f, 0.7f, 0.1f)
-        , m_objectShininess(256.0f)
-        , m_cameraFocus{}
-        , m_cameraDistance(5.0f)
-        , m_cameraPhi(60.0f)
-        , m_cameraTheta{}
         , m_cameraRotateRate(7.0f)
-        , m_lightPosition(1.0f, 3.0f, 0.0f)
-        , m_lightColor(1.0f, 1.0f, 1.0f)
+        , m_visibleObjectCount{}
         , m_currPos{}
         , m_prevPos{}
         , m_indexCount{}
+        , m_indexFormat(DXGI_FORMAT_R32_UINT)
+        , m_boundsCenter{}
+        , m_boundsRadius{}
+        , m_lodLevel{}
+        , m_lodMaxErrorPixels(1.0f)
     { }
 
     ~D3DApp()
@@ -45,6 +46,9 @@ public:
 
     bool    IsRunning() const { return m_isRunning; }
 
+    // What the last Update handed to the GPU
+    const UploadStats& LastUploadStats() const { return m_uploadStats; }
+
     void    Init(HWND hwnd);
     LRESULT HandleInput(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
     void    Update(float dt);
@@ -57,34 +61,37 @@ private:
     void    ResizeResources(UINT width, UINT height);
     void    InitResources();
 
+private:
+    // One instanced draw of a submesh & whether the per-object block needs updating first
+    struct DrawCall
+    {
+        UINT IndexCount;
+        UINT FirstIndex;
+        UINT InstanceCount;
+        UINT FirstInstance;
+        bool UpdateObject; // The block is updated to this draw's before it
+    };
+
 private:
     bool                            m_isRunning;
     UINT                            m_width;
     UINT                            m_height;
-    UINT                            m_frameIndex;
 
     ////
     // Application state
 
-    // Object properties
-    DirectX::XMFLOAT3               m_objectPosition;
-    float                           m_objectRotation;
-    float                           m_objectScale;
+    // Object, orbital camera & light properties (see SceneConstants.h)
+    SceneState                      m_scene;
     float                           m_objectRotationSpeed;
-    DirectX::XMFLOAT3               m_objectColor;
-    float                           m_objectShininess;
-
-    Mesh                            m_meshData;
-
-    // Orbital camera properties (spherical coordinates)
-    DirectX::XMFLOAT3               m_cameraFocus;
-    float                           m_cameraDistance;
-    float                           m_cameraPhi;
-    float                           m_cameraTheta;
     float                           m_cameraRotateRate;
 
-    DirectX::XMFLOAT3               m_lightPosition;
-    DirectX::XMFLOAT3               m_lightColor;
+    Mesh                            m_meshData; // CPU copy, drawn into the occluders
+
+    // Placed meshes with world space bounds, culled to the view frustum each frame - so far only the one object
+    SceneObjectList                 m_objects;
+    std::vector<DirectX::XMFLOAT3>  m_objectColors; // Tints of the material color, per object
+    std::vector<uint32_t>           m_visibleObjects; // Indices of the objects to draw, in increasing order
+    size_t                          m_visibleObjectCount;
 
     // User interaction
     DirectX::XMFLOAT2                m_currPos;
@@ -110,14 +117,44 @@ private:
     ComPtr<ID3D11Buffer>            m_vertexBuffer;
     ComPtr<ID3D11Buffer>            m_indexBuffer;
     UINT                            m_indexCount;
+    DXGI_FORMAT                     m_indexFormat; // 16-bit whenever every vertex fits
+    std::vector<Submesh>            m_submeshes; // One draw each, out of the shared vertex & index buffers
+
+    // Level of detail, picked each frame by projected screen space error (see LodSelector.h)
+    std::vector<MeshLod>            m_lods;
+    DirectX::XMFLOAT3               m_boundsCenter; // Object space bounding sphere
+    float                           m_boundsRadius;
+    UINT                            m_lodLevel; // 0 draws m_submeshes, otherwise m_lods[m_lodLevel - 1]
+    float                           m_lodMaxErrorPixels;
+
+    // Occlusion culling on the CPU - objects hidden behind the others are skipped (see OcclusionCuller.h)
+    ThreadPool                      m_cullingPool;
+    OcclusionBuffer                 m_occlusionBuffer;
+    Mesh                            m_occluders;     // The visible objects at the drawn level of detail, in world space
+    std::vector<uint8_t>            m_objectVisible; // Per object, from the last occlusion test
 
     // Input layout & shaders
     ComPtr<ID3D11InputLayout>       m_inputLayout;
     ComPtr<ID3D11VertexShader>      m_vertexShader;
     ComPtr<ID3D11PixelShader>       m_pixelShader;
 
-    ComPtr<ID3D11Buffer>            m_uploadBuffer;
-    ComPtr<ID3D11Buffer>            m_constantBuffer[2]; // Double-buffered - one for each frame
+    // Constant buffers by update frequency - b0 per frame, b1 per material & b2 per object (see SceneConstants.h)
+    // The first two are only updated when their contents change, which the shadows tell
+    ComPtr<ID3D11Buffer>            m_frameConstants;
+    ComPtr<ID3D11Buffer>            m_materialConstants;
+    ConstantShadow                  m_frameShadow;
+    ConstantShadow                  m_materialShadow;
+    UploadStats                     m_uploadStats; // This frame's - reset each Update
+
+    // The per-object block - one b2 buffer, updated like the others only between draws whose blocks differ. While
+    // every draw's instances start at the front of the instance buffer that's at most once
+    ComPtr<ID3D11Buffer>            m_objectConstants;
+    ConstantShadow                  m_objectShadow;
+    std::vector<DrawCall>           m_drawCalls; // This frame's
+
+    // The visible objects' transforms & colors, one AppInstanceData each, read by BasicVS through SV_InstanceID
+    ComPtr<ID3D11Buffer>            m_instanceBuffer; // Dynamic - discarded & refilled each frame
+    ComPtr<ID3D11ShaderResourceView> m_instanceBufferSRV;
 
     // Graphics state
     ComPtr<ID3D11RasterizerState>   m_rasterizerState;
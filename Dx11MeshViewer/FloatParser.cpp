@@ -0,0 +1,348 @@
+//
+// FloatParser.cpp
+//
+
+#include "pch.h"
+#include "FloatParser.h"
+
+#include <cmath>
+
+namespace
+{
+    SimdLevel s_level = GetSupportedSimdLevel();
+
+    const double s_signs[] = { 1.0, -1.0 };
+
+    inline bool IsSpace(char c) { return c == ' ' || c == '\t'; }
+    inline bool IsDigit(char c) { return static_cast<unsigned int>(c - '0') < 10u; }
+
+    // Weight of the digit 'read' places after the decimal point - same lookup & fallback as tinyobjloader
+    inline double FractionScale(int read)
+    {
+        static const double pow_lut[] =
+        {
+            1.0, 0.1, 0.01, 0.001, 0.0001, 0.00001, 0.000001, 0.0000001,
+        };
+        const int lut_entries = sizeof pow_lut / sizeof pow_lut[0];
+
+        // NOTE: Don't use powf here, it will absolutely murder precision
+        return read < lut_entries ? pow_lut[read] : std::pow(10.0, -read);
+    }
+
+    float ParseRealScalar(const char*& p, const char* lineEnd)
+    {
+        const char* tokenEnd = p;
+        while (tokenEnd < lineEnd && !IsSpace(*tokenEnd))
+        {
+            ++tokenEnd;
+        }
+
+        double value = 0.0;
+        TryParseDouble(p, tokenEnd, &value);
+
+        p = tokenEnd;
+        return static_cast<float>(value);
+    }
+
+#if SIMD_X86
+    // Converts the 'length' (1 to 16) bytes at p - ASCII digits with a '.' at 'dot', or none if dot is negative - into
+    // the integer their up to 15 digits spell, in a handful of multiply-adds. 16 bytes must be readable at p
+    SIMD_TARGET_SSE42 uint64_t ParseDigitsSse(const char* p, unsigned length, int dot)
+    {
+        __m128i digits = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), _mm_set1_epi8('0'));
+
+        // Right-align the digits, closing the gap the dot leaves - shuffle indices with the high bit set (the negative
+        // ones) produce zeros
+        __m128i iota    = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+        __m128i shuffle = _mm_add_epi8(iota, _mm_set1_epi8(static_cast<char>(static_cast<int>(length) - 16)));
+        shuffle = _mm_add_epi8(shuffle, _mm_cmpgt_epi8(_mm_set1_epi8(static_cast<char>(dot + 1)), shuffle));
+        digits  = _mm_shuffle_epi8(digits, shuffle);
+
+        // Combine neighbours: 16 digits -> 8 x 2-digit -> 4 x 4-digit -> 2 x 8-digit values
+        __m128i pairs  = _mm_maddubs_epi16(digits, _mm_setr_epi8(10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1));
+        __m128i quads  = _mm_madd_epi16(pairs, _mm_setr_epi16(100, 1, 100, 1, 100, 1, 100, 1));
+        __m128i packed = _mm_packus_epi32(quads, quads);
+        __m128i octs   = _mm_madd_epi16(packed, _mm_setr_epi16(10000, 1, 10000, 1, 10000, 1, 10000, 1));
+
+        uint64_t high = static_cast<uint32_t>(_mm_cvtsi128_si32(octs));
+        uint64_t low  = static_cast<uint32_t>(_mm_extract_epi32(octs, 1));
+
+        return high * 100000000 + low;
+    }
+
+    // Second half of ParseRealSse42 - validates the token shape from per-byte class masks and assembles the value
+    //
+    // Only [sign] digits [. digits] tokens with up to 15 integer digits take this path. Up to 15 digits in all convert
+    // as one integer; longer fractions, & the rare values too near a float rounding boundary, are accumulated digit
+    // by digit in tryParseDouble's order so the rounding matches. Anything else (exponents, junk, long tokens) goes to
+    // the scalar parser.
+    SIMD_TARGET_SSE42 float AssembleReal(const char*& p, const char* lineEnd, uint32_t delims, uint32_t digits, uint32_t dots, uint32_t signs)
+    {
+        size_t lineLeft = lineEnd - p;
+        if (lineLeft < 16)
+        {
+            delims |= 1u << lineLeft;
+        }
+
+        if (delims == 0)
+        {
+            return ParseRealScalar(p, lineEnd); // Token is wider than the vector
+        }
+
+        unsigned length = CountTrailingZeros(delims);
+        uint32_t token  = (1u << length) - 1;
+
+        digits &= token;
+        dots   &= token;
+        signs  &= token;
+
+        unsigned start = signs & 1;
+        if ((signs >> 1) != 0 || (dots & (dots - 1)) != 0 || (digits | dots | signs) != token)
+        {
+            return ParseRealScalar(p, lineEnd);
+        }
+
+        unsigned dotPos    = dots ? CountTrailingZeros(dots) : length;
+        unsigned intDigits = dotPos - start;
+
+        if (intDigits == 0 || intDigits > 15)
+        {
+            return ParseRealScalar(p, lineEnd);
+        }
+
+        unsigned fracDigits = length > dotPos ? length - dotPos - 1 : 0;
+        double   sign       = s_signs[start & (p[0] == '-')]; // Looked up - the signs in a file are too random to branch on
+
+        if (intDigits + fracDigits <= 15)
+        {
+            // Every digit converts in one vector pass & one multiply, within 2^-52 of the true value - the digit by
+            // digit sum below stays within 2^-47 of it, so wherever a +-2^-40 band around the product rounds to a
+            // single float both agree
+            static const double inversePow10[] =
+            {
+                1e0, 1e-1, 1e-2, 1e-3, 1e-4, 1e-5, 1e-6, 1e-7, 1e-8, 1e-9, 1e-10, 1e-11, 1e-12, 1e-13, 1e-14, 1e-15,
+            };
+
+            int    dot   = dots ? static_cast<int>(dotPos - start) : -1;
+            double value = static_cast<double>(ParseDigitsSse(p + start, length - start, dot)) * inversePow10[fracDigits];
+
+            const double band = 1.0 / (1ull << 40);
+            float low  = static_cast<float>(value - value * band);
+            float high = static_cast<float>(value + value * band);
+
+            if (low == high)
+            {
+                p += length;
+                return static_cast<float>(sign * low);
+            }
+        }
+
+        double mantissa = static_cast<double>(ParseDigitsSse(p + start, intDigits, -1));
+
+        int read = 1;
+        for (unsigned i = dotPos + 1; i < length; ++i, ++read)
+        {
+            mantissa += static_cast<int>(p[i] - '0') * FractionScale(read);
+        }
+
+        p += length;
+
+        return static_cast<float>(sign * mantissa);
+    }
+
+    SIMD_TARGET_SSE42 float ParseRealSse42(const char*& p, const char* lineEnd, const char* safeEnd)
+    {
+        // One byte of slack lets the digit conversion start after a sign
+        if (safeEnd - p < 17)
+        {
+            return ParseRealScalar(p, lineEnd);
+        }
+
+        __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+
+        // String instructions find the delimiter & classify digits directly (a NUL byte ends the scan early,
+        // which simply sends the token to the scalar path)
+        const int mode = _SIDD_UBYTE_OPS | _SIDD_LEAST_SIGNIFICANT;
+
+        int delimIndex = _mm_cmpistri(_mm_setr_epi8(' ', '\t', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0), chars, mode | _SIDD_CMP_EQUAL_ANY);
+        uint32_t delims = delimIndex < 16 ? 1u << delimIndex : 0;
+
+        __m128i digitMask = _mm_cmpistrm(_mm_setr_epi8('0', '9', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0), chars, mode | _SIDD_CMP_RANGES | _SIDD_BIT_MASK);
+        uint32_t digits = static_cast<uint32_t>(_mm_cvtsi128_si32(digitMask));
+
+        uint32_t dots  = _mm_movemask_epi8(_mm_cmpeq_epi8(chars, _mm_set1_epi8('.')));
+        uint32_t signs = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chars, _mm_set1_epi8('-')), _mm_cmpeq_epi8(chars, _mm_set1_epi8('+'))));
+
+        return AssembleReal(p, lineEnd, delims, digits, dots, signs);
+    }
+#endif
+}
+
+
+SimdLevel GetFloatParserLevel()
+{
+    return s_level;
+}
+
+void SetFloatParserLevel(SimdLevel level)
+{
+    s_level = std::min(level, GetSupportedSimdLevel());
+}
+
+float ParseObjReal(const char*& p, const char* lineEnd, const char* safeEnd)
+{
+    while (p < lineEnd && IsSpace(*p))
+    {
+        ++p;
+    }
+
+#if SIMD_X86
+    switch (s_level)
+    {
+    // A 32-byte classification measured slower than the string instructions - coordinate tokens fit 16 bytes anyway -
+    // so the wider tiers share the SSE4.2 path
+    case SimdLevel::Avx512:
+    case SimdLevel::Avx2:
+    case SimdLevel::Sse42: return ParseRealSse42(p, lineEnd, safeEnd);
+    default:               break;
+    }
+#else
+    (void)safeEnd;
+#endif
+
+    return ParseRealScalar(p, lineEnd);
+}
+
+bool TryParseDouble(const char* s, const char* s_end, double* result)
+{
+    if (s >= s_end)
+    {
+        return false;
+    }
+
+    double mantissa = 0.0;
+    int exponent = 0;
+
+    char sign = '+';
+    char exp_sign = '+';
+    const char* curr = s;
+
+    int read = 0;
+    bool end_not_reached = false;
+    bool leading_decimal_dots = false;
+
+    if (*curr == '+' || *curr == '-')
+    {
+        sign = *curr;
+        curr++;
+        if ((curr != s_end) && (*curr == '.'))
+        {
+            leading_decimal_dots = true;
+        }
+    }
+    else if (IsDigit(*curr))
+    {
+    }
+    else if (*curr == '.')
+    {
+        leading_decimal_dots = true;
+    }
+    else
+    {
+        return false;
+    }
+
+    // Integer part
+    end_not_reached = (curr != s_end);
+    if (!leading_decimal_dots)
+    {
+        while (end_not_reached && IsDigit(*curr))
+        {
+            mantissa *= 10;
+            mantissa += static_cast<int>(*curr - 0x30);
+            curr++;
+            read++;
+            end_not_reached = (curr != s_end);
+        }
+
+        if (read == 0)
+        {
+            return false;
+        }
+    }
+
+    if (!end_not_reached)
+    {
+        goto assemble;
+    }
+
+    // Fractional part
+    if (*curr == '.')
+    {
+        curr++;
+        read = 1;
+        end_not_reached = (curr != s_end);
+        while (end_not_reached && IsDigit(*curr))
+        {
+            mantissa += static_cast<int>(*curr - 0x30) * FractionScale(read);
+            read++;
+            curr++;
+            end_not_reached = (curr != s_end);
+        }
+    }
+    else if (*curr == 'e' || *curr == 'E')
+    {
+    }
+    else
+    {
+        goto assemble;
+    }
+
+    if (!end_not_reached)
+    {
+        goto assemble;
+    }
+
+    // Exponent part
+    if (*curr == 'e' || *curr == 'E')
+    {
+        curr++;
+        end_not_reached = (curr != s_end);
+        if (end_not_reached && (*curr == '+' || *curr == '-'))
+        {
+            exp_sign = *curr;
+            curr++;
+        }
+        else if (end_not_reached && IsDigit(*curr))
+        {
+        }
+        else
+        {
+            return false;
+        }
+
+        read = 0;
+        end_not_reached = (curr != s_end);
+        while (end_not_reached && IsDigit(*curr))
+        {
+            if (exponent > (2147483647 / 10))
+            {
+                return false;
+            }
+            exponent *= 10;
+            exponent += static_cast<int>(*curr - 0x30);
+            curr++;
+            read++;
+            end_not_reached = (curr != s_end);
+        }
+        exponent *= (exp_sign == '+' ? 1 : -1);
+        if (read == 0)
+        {
+            return false;
+        }
+    }
+
+assemble:
+    *result = (sign == '+' ? 1 : -1) * (exponent ? std::ldexp(mantissa * std::pow(5.0, exponent), exponent) : mantissa);
+    return true;
+}
@@ -0,0 +1,20 @@
+//
+// FloatParser.h
+//
+
+#pragma once
+
+#include "Simd.h"
+
+// Tier used by ParseObjReal - defaults to the highest supported one
+SimdLevel GetFloatParserLevel();
+void      SetFloatParserLevel(SimdLevel level); // Clamped to GetSupportedSimdLevel()
+
+// Parses the next space-delimited real on an OBJ line, bit-identical to tinyobj::parseReal
+// (malformed or missing values read as zero) and advances p past it
+//
+// SIMD tiers classify the whole token at once and may load up to 17 bytes from p, but never past safeEnd
+float ParseObjReal(const char*& p, const char* lineEnd, const char* safeEnd);
+
+// Scalar reference - a port of tinyobj::tryParseDouble
+bool TryParseDouble(const char* s, const char* s_end, double* result);
@@ -0,0 +1,111 @@
+//
+// FrameDiff.cpp
+//
+
+#include "pch.h"
+#include "FrameDiff.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    struct Lab
+    {
+        float L;
+        float A;
+        float B;
+    };
+
+    // sRGB8 to linear, once per value
+    struct SrgbTable
+    {
+        float Linear[256];
+
+        SrgbTable()
+        {
+            for (int i = 0; i < 256; ++i)
+            {
+                float c = i / 255.0f;
+                Linear[i] = (c <= 0.04045f) ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+            }
+        }
+    };
+
+    float LabCurve(float t)
+    {
+        const float delta = 6.0f / 29.0f;
+        return (t > delta * delta * delta) ? std::cbrt(t) : t / (3.0f * delta * delta) + 4.0f / 29.0f;
+    }
+
+    // Through CIE XYZ, relative to the D65 white point sRGB is defined with
+    Lab TexelToLab(uint32_t texel, const SrgbTable& table)
+    {
+        float r = table.Linear[texel & 0xFF];
+        float g = table.Linear[(texel >> 8) & 0xFF];
+        float b = table.Linear[(texel >> 16) & 0xFF];
+
+        float x = (0.4124f * r + 0.3576f * g + 0.1805f * b) / 0.95047f;
+        float y =  0.2126f * r + 0.7152f * g + 0.0722f * b;
+        float z = (0.0193f * r + 0.1192f * g + 0.9505f * b) / 1.08883f;
+
+        float fx = LabCurve(x);
+        float fy = LabCurve(y);
+        float fz = LabCurve(z);
+
+        return { 116.0f * fy - 16.0f, 500.0f * (fx - fy), 200.0f * (fy - fz) };
+    }
+}
+
+HRESULT CompareFrames(const SoftwareFrame& frame, const SoftwareFrame& golden, const FrameDiffOptions& options, FrameDiff& outDiff, SoftwareFrame* outDiffImage)
+{
+    if (frame.Width != golden.Width || frame.Height != golden.Height || frame.Color.size() != golden.Color.size())
+    {
+        return E_INVALIDARG;
+    }
+
+    static const SrgbTable table;
+
+    if (outDiffImage)
+    {
+        outDiffImage->Width  = golden.Width;
+        outDiffImage->Height = golden.Height;
+        outDiffImage->Color.resize(golden.Color.size());
+        outDiffImage->Depth.clear();
+    }
+
+    outDiff = {};
+    double sum = 0.0;
+
+    for (size_t p = 0; p < frame.Color.size(); ++p)
+    {
+        float deltaE = 0.0f;
+        if ((frame.Color[p] & 0xFFFFFF) != (golden.Color[p] & 0xFFFFFF))
+        {
+            Lab a = TexelToLab(frame.Color[p], table);
+            Lab b = TexelToLab(golden.Color[p], table);
+            deltaE = std::sqrt((a.L - b.L) * (a.L - b.L) + (a.A - b.A) * (a.A - b.A) + (a.B - b.B) * (a.B - b.B));
+        }
+
+        bool differs = deltaE >= options.PixelThreshold;
+
+        sum += deltaE;
+        outDiff.MaxDeltaE        = std::max(outDiff.MaxDeltaE, static_cast<double>(deltaE));
+        outDiff.DifferingPixels += differs ? 1 : 0;
+
+        if (outDiffImage)
+        {
+            uint32_t texel = golden.Color[p];
+            uint32_t gray  = (((texel & 0xFF) + ((texel >> 8) & 0xFF) + ((texel >> 16) & 0xFF)) / 3) / 3;
+            uint32_t red   = std::min(128u + static_cast<uint32_t>(deltaE * 4.0f), 255u);
+
+            outDiffImage->Color[p] = differs ? (red | 0xFF000000u) : (gray | (gray << 8) | (gray << 16) | 0xFF000000u);
+        }
+    }
+
+    const size_t pixelCount = frame.Color.size();
+    outDiff.MeanDeltaE = (pixelCount > 0) ? sum / pixelCount : 0.0;
+    outDiff.Matches    = outDiff.DifferingPixels <= options.MaxDifferingFraction * pixelCount && outDiff.MeanDeltaE <= options.MaxMeanDeltaE;
+
+    return S_OK;
+}
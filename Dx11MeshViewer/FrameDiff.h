@@ -0,0 +1,34 @@
+//
+// FrameDiff.h
+//
+
+#pragma once
+
+#include "SoftwareRenderer.h"
+
+#include <cstdint>
+
+// Tolerances for matching a rendered frame against a golden image
+//
+// Pixels are compared by CIE76 delta E - the distance between their CIELAB colors - so the tolerance means the same
+// for dark & bright pixels, unlike a threshold on sRGB8 values
+struct FrameDiffOptions
+{
+    float PixelThreshold       = 2.3f;    // Delta E from which a pixel differs - about one just noticeable difference
+    float MaxDifferingFraction = 0.001f;  // Of the pixels, allowing for silhouette samples flipped by rounding elsewhere
+    float MaxMeanDeltaE        = 0.1f;    // Over the whole frame, catching slight shifts everywhere
+};
+
+struct FrameDiff
+{
+    double   MaxDeltaE       = 0.0;
+    double   MeanDeltaE      = 0.0;
+    uint64_t DifferingPixels = 0;      // Over PixelThreshold
+    bool     Matches         = false;  // Within every tolerance
+};
+
+// Compares the color targets - fails with E_INVALIDARG if their sizes differ
+//
+// outDiffImage, when given, receives the golden image dimmed to gray with each differing pixel in red, brighter
+// the larger its delta E
+HRESULT CompareFrames(const SoftwareFrame& frame, const SoftwareFrame& golden, const FrameDiffOptions& options, FrameDiff& outDiff, SoftwareFrame* outDiffImage = nullptr);
@@ -0,0 +1,185 @@
+//
+// FrustumCuller.cpp
+//
+
+#include "pch.h"
+#include "FrustumCuller.h"
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+    const size_t BlockSize = 16384;  // Boxes per pool task
+
+    const int PlaneCount = 6;
+
+    // For each plane, the arrays holding the box corner farthest along its normal
+    struct PlaneCorners
+    {
+        const float* X[PlaneCount];
+        const float* Y[PlaneCount];
+        const float* Z[PlaneCount];
+    };
+
+    PlaneCorners GetPlaneCorners(const FrustumPlanes& planes, const BoxArrays& boxes)
+    {
+        PlaneCorners corners;
+        for (int p = 0; p < PlaneCount; ++p)
+        {
+            corners.X[p] = (planes.A[p] >= 0.0f) ? boxes.Max[0] : boxes.Min[0];
+            corners.Y[p] = (planes.B[p] >= 0.0f) ? boxes.Max[1] : boxes.Min[1];
+            corners.Z[p] = (planes.C[p] >= 0.0f) ? boxes.Max[2] : boxes.Min[2];
+        }
+        return corners;
+    }
+
+
+    ////
+    // Scalar
+
+    // Culls boxes [first, end), writing survivors from outVisible on - returns how many
+    size_t CullScalar(const FrustumPlanes& planes, const PlaneCorners& corners, size_t first, size_t end, uint32_t* outVisible)
+    {
+        size_t count = 0;
+        for (size_t i = first; i < end; ++i)
+        {
+            bool outside = false;
+            for (int p = 0; p < PlaneCount; ++p)
+            {
+                float distance = ((planes.A[p] * corners.X[p][i] + planes.B[p] * corners.Y[p][i]) + planes.C[p] * corners.Z[p][i]) + planes.D[p];
+                outside = outside | (distance < 0.0f);
+            }
+
+            outVisible[count] = static_cast<uint32_t>(i);
+            count += outside ? 0 : 1;
+        }
+        return count;
+    }
+
+
+#if SIMD_X86
+    ////
+    // AVX2 - 8 boxes at a time
+
+    SIMD_TARGET_AVX2 size_t CullAvx2(const FrustumPlanes& planes, const PlaneCorners& corners, size_t first, size_t end, uint32_t* outVisible)
+    {
+        size_t count = 0;
+        size_t i     = first;
+        for (; i + 8 <= end; i += 8)
+        {
+            __m256 outside = _mm256_setzero_ps();
+            for (int p = 0; p < PlaneCount; ++p)
+            {
+                __m256 distance = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes.A[p]), _mm256_loadu_ps(corners.X[p] + i)),
+                                                _mm256_mul_ps(_mm256_set1_ps(planes.B[p]), _mm256_loadu_ps(corners.Y[p] + i)));
+                distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(planes.C[p]), _mm256_loadu_ps(corners.Z[p] + i)));
+                distance = _mm256_add_ps(distance, _mm256_set1_ps(planes.D[p]));
+                outside  = _mm256_or_ps(outside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_LT_OQ));
+            }
+
+            for (uint32_t visible = ~static_cast<uint32_t>(_mm256_movemask_ps(outside)) & 0xFF; visible != 0; visible &= visible - 1)
+            {
+                outVisible[count++] = static_cast<uint32_t>(i + CountTrailingZeros(visible));
+            }
+        }
+
+        return count + CullScalar(planes, corners, i, end, outVisible + count);
+    }
+
+
+    ////
+    // AVX-512 - 16 boxes at a time, compressing the survivors' indices straight to memory, with explicitly rounded
+    // arithmetic so nothing is fused into FMAs
+
+    SIMD_TARGET_AVX512 size_t CullAvx512(const FrustumPlanes& planes, const PlaneCorners& corners, size_t first, size_t end, uint32_t* outVisible)
+    {
+        const __m512i lanes = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+        size_t count = 0;
+        for (size_t i = first; i < end; i += 16)
+        {
+            __mmask16 valid   = static_cast<__mmask16>((1u << std::min<size_t>(end - i, 16)) - 1);
+            __mmask16 outside = 0;
+            for (int p = 0; p < PlaneCount; ++p)
+            {
+                __m512 distance = AddRounded(MultiplyRounded(_mm512_set1_ps(planes.A[p]), _mm512_maskz_loadu_ps(valid, corners.X[p] + i)),
+                                             MultiplyRounded(_mm512_set1_ps(planes.B[p]), _mm512_maskz_loadu_ps(valid, corners.Y[p] + i)));
+                distance = AddRounded(distance, MultiplyRounded(_mm512_set1_ps(planes.C[p]), _mm512_maskz_loadu_ps(valid, corners.Z[p] + i)));
+                distance = AddRounded(distance, _mm512_set1_ps(planes.D[p]));
+                outside |= _mm512_cmp_ps_mask(distance, _mm512_setzero_ps(), _CMP_LT_OQ);
+            }
+
+            __mmask16 visible = valid & ~outside;
+            _mm512_mask_compressstoreu_epi32(outVisible + count, visible, _mm512_add_epi32(_mm512_set1_epi32(static_cast<int>(i)), lanes));
+            count += PopCount(visible);
+        }
+
+        return count;
+    }
+#endif
+
+    size_t Cull(const FrustumPlanes& planes, const PlaneCorners& corners, size_t first, size_t end, SimdLevel level, uint32_t* outVisible)
+    {
+#if SIMD_X86
+        if (level >= SimdLevel::Avx512)
+        {
+            return CullAvx512(planes, corners, first, end, outVisible);
+        }
+
+        if (level >= SimdLevel::Avx2)
+        {
+            return CullAvx2(planes, corners, first, end, outVisible);
+        }
+#endif
+
+        return CullScalar(planes, corners, first, end, outVisible);
+    }
+}
+
+void ExtractFrustumPlanes(const DirectX::XMFLOAT4X4& toClip, FrustumPlanes& outPlanes)
+{
+    // Row r of toClip gives clip component r, so each bound of the clip volume is a sum of rows
+    const float (&m)[4][4]     = toClip.m;
+    float*      coefficients[] = { outPlanes.A, outPlanes.B, outPlanes.C, outPlanes.D };
+
+    for (int c = 0; c < 4; ++c)
+    {
+        coefficients[c][0] = m[3][c] + m[0][c];  // Left, -w <= x
+        coefficients[c][1] = m[3][c] - m[0][c];  // Right, x <= w
+        coefficients[c][2] = m[3][c] + m[1][c];  // Bottom
+        coefficients[c][3] = m[3][c] - m[1][c];  // Top
+        coefficients[c][4] = m[2][c];            // Near, 0 <= z
+        coefficients[c][5] = m[3][c] - m[2][c];  // Far, z <= w
+    }
+}
+
+size_t CullFrustum(const FrustumPlanes& planes, const BoxArrays& boxes, uint32_t* outVisible, const FrustumCullOptions& options)
+{
+    const PlaneCorners corners = GetPlaneCorners(planes, boxes);
+    const SimdLevel    level   = std::min(options.MaxSimdLevel, GetSupportedSimdLevel());
+
+    ThreadPool  localPool(options.Pool ? 1 : options.ThreadCount);
+    ThreadPool& pool = options.Pool ? *options.Pool : localPool;
+
+    // Each block packs its survivors at its own offset, then the blocks close up in order
+    const size_t blockCount = (boxes.Count + BlockSize - 1) / BlockSize;
+    std::vector<size_t> blockVisible(blockCount);
+
+    pool.Run(blockCount, [&](size_t block, uint32_t)
+    {
+        size_t first = block * BlockSize;
+        blockVisible[block] = Cull(planes, corners, first, std::min(boxes.Count, first + BlockSize), level, outVisible + first);
+    });
+
+    size_t count = 0;
+    for (size_t block = 0; block < blockCount; ++block)
+    {
+        const uint32_t* blockStart = outVisible + block * BlockSize;
+        std::copy(blockStart, blockStart + blockVisible[block], outVisible + count);
+        count += blockVisible[block];
+    }
+    return count;
+}
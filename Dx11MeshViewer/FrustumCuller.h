@@ -0,0 +1,44 @@
+//
+// FrustumCuller.h
+//
+
+#pragma once
+
+#include "Simd.h"
+#include "VertexBounds.h"
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+
+class ThreadPool;
+
+// Left, right, bottom, top, near & far planes of the view volume as A * x + B * y + C * z + D >= 0 inside, as
+// structure-of-arrays
+struct FrustumPlanes
+{
+    float A[6];
+    float B[6];
+    float C[6];
+    float D[6];
+};
+
+struct FrustumCullOptions
+{
+    uint32_t    ThreadCount  = 0;                  // 0 uses every hardware thread
+    ThreadPool* Pool         = nullptr;            // Workers kept across frames, used in place of ThreadCount
+    SimdLevel   MaxSimdLevel = SimdLevel::Avx512;  // Clamped to GetSupportedSimdLevel()
+};
+
+// Planes of D3D's clip volume - -w <= x, y <= w & 0 <= z <= w - in the space toClip transforms from (Gribb & Hartmann
+// 2001), so for world space boxes toClip is the view-projection transform, stored transposed like the shader constants
+void   ExtractFrustumPlanes(const DirectX::XMFLOAT4X4& toClip, FrustumPlanes& outPlanes);
+
+// Writes the indices of the boxes not wholly outside a plane to outVisible, in increasing order, & returns how many -
+// outVisible needs room for every box
+//
+// Each plane is tested against the box corner farthest along its normal, which is the same min or max array for every
+// box, so a plane costs 3 multiplies & adds per box. Tests 8 boxes per instruction at AVX2 & 16 at AVX-512, packing
+// the survivors' indices as it goes, over blocks of boxes spread across the pool. Every level & worker count writes
+// the same list. Boxes straddling two planes outside a corner of the frustum are kept, as is usual for the test.
+size_t CullFrustum(const FrustumPlanes& planes, const BoxArrays& boxes, uint32_t* outVisible, const FrustumCullOptions& options = {});
@@ -0,0 +1,71 @@
+//
+// InstancePacker.cpp
+//
+
+#include "pch.h"
+#include "InstancePacker.h"
+
+#include "SceneObjects.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cstddef>
+
+using namespace DirectX;
+
+// StructuredBuffer<InstanceData> in BasicVS.hlsl reads elements tightly packed, in this order
+static_assert(sizeof(AppInstanceData) == 144, "AppInstanceData must match InstanceData in BasicVS.hlsl");
+static_assert(offsetof(AppInstanceData, WorldViewProjection) == 64, "AppInstanceData must match InstanceData in BasicVS.hlsl");
+static_assert(offsetof(AppInstanceData, Color) == 128, "AppInstanceData must match InstanceData in BasicVS.hlsl");
+
+namespace
+{
+    const size_t BlockSize = 4096;  // Instances per pool task
+
+    void PackRange(const SceneObjectList& objects, const uint32_t* indices, size_t first, size_t end, FXMMATRIX viewProjection,
+                   const XMFLOAT3* colors, AppInstanceData* outInstances)
+    {
+        for (size_t i = first; i < end; ++i)
+        {
+            const uint32_t object = indices[i];
+            XMMATRIX       world  = XMLoadFloat4x4(&objects.World(object));
+
+            // The color & zeroed padding as one vector, so the last 16 bytes go out in one store like the matrix rows
+            XMVECTOR color = XMVectorSetW(XMLoadFloat3(&colors[object]), 0.0f);
+
+            AppInstanceData& instance = outInstances[i];
+            XMStoreFloat4x4(&instance.World, XMMatrixTranspose(world));
+            XMStoreFloat4x4(&instance.WorldViewProjection, XMMatrixTranspose(world * viewProjection));
+            XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&instance.Color), color);
+        }
+    }
+}
+
+void PackInstances(const SceneObjectList& objects, const uint32_t* indices, size_t count, const XMFLOAT4X4& viewProjection,
+                   const XMFLOAT3* colors, AppInstanceData* outInstances, const InstancePackOptions& options)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    const XMMATRIX viewProjMat = XMMatrixTranspose(XMLoadFloat4x4(&viewProjection));
+
+    // Too little work to wake the workers for
+    if (count <= BlockSize)
+    {
+        PackRange(objects, indices, 0, count, viewProjMat, colors, outInstances);
+        return;
+    }
+
+    ThreadPool  localPool(options.Pool ? 1 : options.ThreadCount);
+    ThreadPool& pool = options.Pool ? *options.Pool : localPool;
+
+    const size_t blockCount = (count + BlockSize - 1) / BlockSize;
+
+    pool.Run(blockCount, [&](size_t block, uint32_t)
+    {
+        size_t first = block * BlockSize;
+        PackRange(objects, indices, first, std::min(count, first + BlockSize), viewProjMat, colors, outInstances);
+    });
+}
@@ -0,0 +1,29 @@
+//
+// InstancePacker.h
+//
+
+#pragma once
+
+#include "SceneConstants.h"
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+
+class SceneObjectList;
+class ThreadPool;
+
+struct InstancePackOptions
+{
+    uint32_t    ThreadCount = 0;        // 0 uses every hardware thread
+    ThreadPool* Pool        = nullptr;  // Workers kept across frames, used in place of ThreadCount
+};
+
+// Writes outInstances[i] for object indices[i] - its world & world-view-projection transforms, stored transposed, and
+// colors[indices[i]] - so one DrawIndexedInstanced draws every listed object
+//
+// viewProjection is stored transposed like the constants. Each instance is written front to back with whole 16 byte
+// stores & never read back, so outInstances can be a mapped D3D11_USAGE_DYNAMIC buffer in write-combined memory.
+// Blocks of instances spread across the pool, and every worker count writes the same bytes.
+void PackInstances(const SceneObjectList& objects, const uint32_t* indices, size_t count, const DirectX::XMFLOAT4X4& viewProjection,
+                   const DirectX::XMFLOAT3* colors, AppInstanceData* outInstances, const InstancePackOptions& options = {});
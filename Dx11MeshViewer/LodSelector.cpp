@@ -0,0 +1,44 @@
+//
+// LodSelector.cpp
+//
+
+#include "pch.h"
+#include "LodSelector.h"
+#include "MeshLoader.h"
+
+#include <cmath>
+
+float ProjectedErrorPixels(float error, const LodView& view)
+{
+    if (view.Distance <= 0.0f)
+    {
+        return INFINITY;
+    }
+
+    // A perspective projection maps 2 * tan(fovY / 2) * distance world units onto the viewport's height
+    float pixelsPerUnit = view.ViewportHeight / (2.0f * std::tan(view.FieldOfViewY * 0.5f) * view.Distance);
+    return error * pixelsPerUnit;
+}
+
+float ErrorSwitchDistance(float error, float fieldOfViewY, float viewportHeight, float errorPixels)
+{
+    return error * viewportHeight / (2.0f * std::tan(fieldOfViewY * 0.5f) * errorPixels);
+}
+
+uint32_t SelectLod(const std::vector<MeshLod>& lods, float errorScale, const LodView& view, float maxErrorPixels)
+{
+    uint32_t selected = 0;
+
+    // Each level's error includes that of the ones before it, so the first one over the limit ends the search
+    for (size_t l = 0; l < lods.size(); ++l)
+    {
+        if (!(ProjectedErrorPixels(lods[l].Error * errorScale, view) <= maxErrorPixels))
+        {
+            break;
+        }
+
+        selected = static_cast<uint32_t>(l + 1);
+    }
+
+    return selected;
+}
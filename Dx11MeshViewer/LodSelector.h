@@ -0,0 +1,30 @@
+//
+// LodSelector.h
+//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+struct MeshLod;
+
+// How the mesh is being viewed - no graphics API types, so selection can be checked off the GPU
+struct LodView
+{
+    float Distance;       // From the eye to the nearest point of the object's bounds, in world units
+    float FieldOfViewY;   // Vertical field of view of the projection, in radians
+    float ViewportHeight; // Pixels
+};
+
+// Height in pixels that a world space error projects to at the view's distance
+float ProjectedErrorPixels(float error, const LodView& view);
+
+// Distance at which a world space error projects to errorPixels - the inverse of ProjectedErrorPixels, so a level
+// with that error switches in beyond it
+float ErrorSwitchDistance(float error, float fieldOfViewY, float viewportHeight, float errorPixels);
+
+// Picks the coarsest level whose error, times errorScale (the object's world scale), projects to at most
+// maxErrorPixels - 0 is full detail, and i > 0 is lods[i - 1]. Levels past the first one over the limit are
+// never chosen, and an eye inside the bounds always gets full detail
+uint32_t SelectLod(const std::vector<MeshLod>& lods, float errorScale, const LodView& view, float maxErrorPixels);
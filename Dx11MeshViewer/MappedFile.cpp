@@ -0,0 +1,140 @@
+//
+// MappedFile.cpp
+//
+
+#include "pch.h"
+#include "MappedFile.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+HRESULT MappedFile::Open(const char* filename)
+{
+    Close();
+
+    // Sequential scan hint lets the cache manager read ahead aggressively
+    m_file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (m_file == INVALID_HANDLE_VALUE)
+    {
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+
+    LARGE_INTEGER fileSize{};
+    if (!GetFileSizeEx(m_file, &fileSize))
+    {
+        HRESULT hr = HRESULT_FROM_WIN32(GetLastError());
+        Close();
+        return hr;
+    }
+
+    // Empty files can't be mapped, but are still valid input
+    if (fileSize.QuadPart == 0)
+    {
+        return S_OK;
+    }
+
+    m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m_mapping)
+    {
+        HRESULT hr = HRESULT_FROM_WIN32(GetLastError());
+        Close();
+        return hr;
+    }
+
+    m_data = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!m_data)
+    {
+        HRESULT hr = HRESULT_FROM_WIN32(GetLastError());
+        Close();
+        return hr;
+    }
+
+    m_size = static_cast<size_t>(fileSize.QuadPart);
+
+    return S_OK;
+}
+
+void MappedFile::Close()
+{
+    if (m_data)
+    {
+        UnmapViewOfFile(m_data);
+    }
+
+    if (m_mapping)
+    {
+        CloseHandle(m_mapping);
+    }
+
+    if (m_file != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(m_file);
+    }
+
+    m_data    = nullptr;
+    m_size    = 0;
+    m_mapping = nullptr;
+    m_file    = INVALID_HANDLE_VALUE;
+}
+
+#else // POSIX
+
+HRESULT MappedFile::Open(const char* filename)
+{
+    Close();
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+    {
+        return E_FAIL;
+    }
+
+    struct stat info{};
+    if (fstat(fd, &info) != 0)
+    {
+        close(fd);
+        return E_FAIL;
+    }
+
+    // Empty files can't be mapped, but are still valid input
+    if (info.st_size == 0)
+    {
+        close(fd);
+        return S_OK;
+    }
+
+    void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping holds its own reference to the file
+
+    if (data == MAP_FAILED)
+    {
+        return E_FAIL;
+    }
+
+    // Sequential hint lets the kernel read ahead aggressively & drop pages behind the parser
+    madvise(data, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+
+    m_data = static_cast<const char*>(data);
+    m_size = static_cast<size_t>(info.st_size);
+
+    return S_OK;
+}
+
+void MappedFile::Close()
+{
+    if (m_data)
+    {
+        munmap(const_cast<char*>(m_data), m_size);
+    }
+
+    m_data = nullptr;
+    m_size = 0;
+}
+
+#endif
@@ -0,0 +1,44 @@
+//
+// MappedFile.h
+//
+
+#pragma once
+
+#include <cstddef>
+
+// Read-only memory mapping of an entire file - the OS pages the contents in on demand
+class MappedFile
+{
+public:
+    MappedFile()
+        : m_data(nullptr)
+        , m_size{}
+#ifdef _WIN32
+        , m_file(INVALID_HANDLE_VALUE)
+        , m_mapping(nullptr)
+#endif
+    { }
+
+    ~MappedFile()
+    {
+        Close();
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    HRESULT     Open(const char* filename);
+    void        Close();
+
+    const char* Data() const { return m_data; }
+    size_t      Size() const { return m_size; }
+
+private:
+    const char* m_data;
+    size_t      m_size;
+
+#ifdef _WIN32
+    HANDLE      m_file;
+    HANDLE      m_mapping;
+#endif
+};
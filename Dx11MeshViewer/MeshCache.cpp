@@ -0,0 +1,444 @@
+//
+// MeshCache.cpp
+//
+
+#include "pch.h"
+#include "MeshCache.h"
+#include "MappedFile.h"
+#include "Parallel.h"
+
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+using DirectX::XMFLOAT3;
+
+static const uint32_t MeshCacheMagic   = 0x4853454D; // "MESH"
+static const uint32_t MeshCacheVersion = 5;          // Bump whenever the layout or LoadMesh's output changes
+
+static const size_t   HashBlockSize    = 1 << 20;
+
+struct MeshCacheHeader
+{
+    uint32_t Magic;
+    uint32_t Version;
+    uint64_t SourceSize;
+    uint64_t SourceWriteTime;
+    uint64_t SourceHash;
+    uint64_t SourceOptions;
+    uint64_t VertexCount;
+    uint64_t IndexCount;
+    uint64_t SubmeshCount;
+    uint64_t MeshletCount;
+    uint32_t IndexSize;
+    uint32_t LodCount;     // Each level stores its error, then one Submesh per full detail submesh
+    XMFLOAT3 BoundsMin;
+    XMFLOAT3 BoundsMax;
+};
+
+static_assert(sizeof(MeshCacheHeader) == 104, "MeshCacheHeader must have no padding");
+static_assert(std::is_trivially_copyable<Submesh>::value, "Submeshes are stored as raw bytes");
+static_assert(std::is_trivially_copyable<Meshlet>::value, "Meshlets are stored as raw bytes");
+
+static const size_t VertexStride = 6 * sizeof(float);
+
+static MeshCacheHeader MakeHeader(const MeshSourceKey& sourceKey, uint64_t vertexCount, uint64_t indexCount, uint32_t indexSize, uint64_t submeshCount, uint64_t meshletCount, uint32_t lodCount, const XMFLOAT3& boundsMin, const XMFLOAT3& boundsMax)
+{
+    // The magic stays zero until the file is complete
+    MeshCacheHeader header {};
+    header.Version         = MeshCacheVersion;
+    header.SourceSize      = sourceKey.Size;
+    header.SourceWriteTime = sourceKey.WriteTime;
+    header.SourceHash      = sourceKey.Hash;
+    header.SourceOptions   = sourceKey.Options;
+    header.VertexCount     = vertexCount;
+    header.IndexCount      = indexCount;
+    header.IndexSize       = indexSize;
+    header.SubmeshCount    = submeshCount;
+    header.MeshletCount    = meshletCount;
+    header.LodCount        = lodCount;
+    header.BoundsMin       = boundsMin;
+    header.BoundsMax       = boundsMax;
+
+    return header;
+}
+
+// Writes the completed header over the placeholder at the start of the file
+static HRESULT SealCacheFile(std::ofstream& file, MeshCacheHeader header)
+{
+    file.flush();
+
+    header.Magic = MeshCacheMagic;
+
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.close();
+
+    return file ? S_OK : E_FAIL;
+}
+
+
+////
+// Source keys
+
+HRESULT StatMeshSource(const char* filename, MeshSourceKey& outKey)
+{
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA info;
+    if (!GetFileAttributesExA(filename, GetFileExInfoStandard, &info))
+    {
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+
+    outKey.Size      = (uint64_t(info.nFileSizeHigh) << 32) | info.nFileSizeLow;
+    outKey.WriteTime = (uint64_t(info.ftLastWriteTime.dwHighDateTime) << 32) | info.ftLastWriteTime.dwLowDateTime;
+#else
+    struct stat info{};
+    if (stat(filename, &info) != 0)
+    {
+        return E_FAIL;
+    }
+
+#ifdef __APPLE__
+    const timespec& writeTime = info.st_mtimespec;
+#else
+    const timespec& writeTime = info.st_mtim;
+#endif
+
+    outKey.Size      = static_cast<uint64_t>(info.st_size);
+    outKey.WriteTime = static_cast<uint64_t>(writeTime.tv_sec) * 1000000000ull + static_cast<uint64_t>(writeTime.tv_nsec);
+#endif
+
+    return S_OK;
+}
+
+
+static uint64_t RotateLeft(uint64_t x, int bits)
+{
+    return (x << bits) | (x >> (64 - bits));
+}
+
+static uint64_t MixWord(uint64_t h, uint64_t word)
+{
+    h ^= word * 0x9E3779B97F4A7C15ull;
+    return RotateLeft(h, 31) * 0xC2B2AE3D27D4EB4Full;
+}
+
+static uint64_t HashBlock(const char* data, size_t size)
+{
+    uint64_t h = size * 0x165667B19E3779F9ull;
+
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+    {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        h = MixWord(h, word);
+    }
+
+    if (i < size)
+    {
+        uint64_t word = 0;
+        std::memcpy(&word, data + i, size - i);
+        h = MixWord(h, word);
+    }
+
+    return h ^ (h >> 29);
+}
+
+HRESULT HashMeshSource(const char* filename, uint32_t threadCount, MeshSourceKey& outKey)
+{
+    MappedFile source;
+
+    HRESULT hr = source.Open(filename);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    // Blocks hash independently, then combine in file order - the result doesn't depend on the worker count
+    size_t blockCount = (source.Size() + HashBlockSize - 1) / HashBlockSize;
+    std::vector<uint64_t> blockHashes(blockCount);
+
+    ParallelFor(blockCount, threadCount, [&](size_t b)
+    {
+        size_t begin = b * HashBlockSize;
+        blockHashes[b] = HashBlock(source.Data() + begin, std::min(HashBlockSize, source.Size() - begin));
+    });
+
+    uint64_t h = source.Size();
+    for (uint64_t blockHash : blockHashes)
+    {
+        h = MixWord(h, blockHash);
+    }
+
+    outKey.Hash = h;
+
+    return S_OK;
+}
+
+
+////
+// Cache files
+
+// Ranges a cache file claims must lie inside the arrays it holds
+static bool ValidSubmeshes(const std::vector<Submesh>& submeshes, uint64_t vertexCount, uint64_t indexCount)
+{
+    for (const Submesh& submesh : submeshes)
+    {
+        if (uint64_t(submesh.FirstIndex) + submesh.IndexCount > indexCount ||
+            uint64_t(submesh.FirstVertex) + submesh.VertexCount > vertexCount)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template<typename T>
+static bool ReadArray(std::ifstream& file, std::vector<T>& outArray, size_t count)
+{
+    outArray.resize(count);
+    if (count > 0)
+    {
+        file.read(reinterpret_cast<char*>(outArray.data()), count * sizeof(T));
+    }
+
+    return static_cast<bool>(file);
+}
+
+HRESULT ReadMeshCache(const char* cachePath, const MeshSourceKey& sourceKey, bool checkHash, Mesh& outMesh)
+{
+    std::ifstream file(cachePath, std::ios::binary | std::ios::ate);
+    if (!file)
+    {
+        return E_FAIL;
+    }
+
+    uint64_t fileSize = static_cast<uint64_t>(file.tellg());
+    if (fileSize < sizeof(MeshCacheHeader))
+    {
+        return E_FAIL;
+    }
+
+    MeshCacheHeader header;
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+    if (!file || header.Magic != MeshCacheMagic || header.Version != MeshCacheVersion ||
+        header.SourceSize != sourceKey.Size || header.SourceWriteTime != sourceKey.WriteTime ||
+        header.SourceOptions != sourceKey.Options || (checkHash && header.SourceHash != sourceKey.Hash) ||
+        (header.IndexSize != sizeof(uint16_t) && header.IndexSize != sizeof(uint32_t)))
+    {
+        return E_FAIL;
+    }
+
+    // Bound the counts before multiplying so a corrupt header can't overflow the size check
+    uint64_t payloadSize = fileSize - sizeof(MeshCacheHeader);
+    if (header.VertexCount > payloadSize / VertexStride ||
+        header.IndexCount > payloadSize / header.IndexSize ||
+        header.SubmeshCount > payloadSize / sizeof(Submesh) ||
+        header.MeshletCount > payloadSize / sizeof(Meshlet))
+    {
+        return E_FAIL;
+    }
+
+    uint64_t vertexBytes  = header.VertexCount * VertexStride;
+    uint64_t indexBytes   = header.IndexCount * header.IndexSize;
+    uint64_t submeshBytes = header.SubmeshCount * sizeof(Submesh);
+    uint64_t meshletBytes = header.MeshletCount * sizeof(Meshlet);
+
+    if (vertexBytes + indexBytes + submeshBytes + meshletBytes > payloadSize ||
+        (header.LodCount > 0 && header.SubmeshCount > payloadSize / header.LodCount / sizeof(Submesh)))
+    {
+        return E_FAIL;
+    }
+
+    uint64_t lodBytes = header.LodCount * (sizeof(float) + submeshBytes);
+
+    if (vertexBytes + indexBytes + submeshBytes + meshletBytes + lodBytes != payloadSize)
+    {
+        return E_FAIL;
+    }
+
+    // Every array is read in file order straight into the buffers the mesh keeps - no parsing or welding on this
+    // path, & no staging copy
+    Mesh mesh;
+    mesh.IndexSize = header.IndexSize;
+    mesh.BoundsMin = header.BoundsMin;
+    mesh.BoundsMax = header.BoundsMax;
+
+    bool read = ReadArray(file, mesh.VertexBuffer, static_cast<size_t>(header.VertexCount) * 6);
+
+    // Indices come back at the size they were written with
+    if (mesh.IndexSize == sizeof(uint16_t))
+    {
+        read = read && ReadArray(file, mesh.ShortIndexBuffer, static_cast<size_t>(header.IndexCount));
+    }
+    else
+    {
+        read = read && ReadArray(file, mesh.IndexBuffer, static_cast<size_t>(header.IndexCount));
+    }
+
+    read = read && ReadArray(file, mesh.Submeshes, static_cast<size_t>(header.SubmeshCount));
+    read = read && ReadArray(file, mesh.Meshlets, static_cast<size_t>(header.MeshletCount));
+
+    mesh.Lods.resize(read ? header.LodCount : 0);
+    for (MeshLod& lod : mesh.Lods)
+    {
+        file.read(reinterpret_cast<char*>(&lod.Error), sizeof(float));
+        read = read && ReadArray(file, lod.Submeshes, static_cast<size_t>(header.SubmeshCount));
+    }
+
+    if (!read || !ValidSubmeshes(mesh.Submeshes, header.VertexCount, header.IndexCount))
+    {
+        return E_FAIL;
+    }
+
+    for (const Meshlet& meshlet : mesh.Meshlets)
+    {
+        if (uint64_t(meshlet.FirstIndex) + meshlet.IndexCount > header.IndexCount)
+        {
+            return E_FAIL;
+        }
+    }
+
+    for (const MeshLod& lod : mesh.Lods)
+    {
+        if (!ValidSubmeshes(lod.Submeshes, header.VertexCount, header.IndexCount))
+        {
+            return E_FAIL;
+        }
+    }
+
+    outMesh = std::move(mesh);
+
+    return S_OK;
+}
+
+HRESULT WriteMeshCache(const char* cachePath, const MeshSourceKey& sourceKey, const Mesh& mesh)
+{
+    std::ofstream file(cachePath, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        return E_FAIL;
+    }
+
+    MeshCacheHeader header = MakeHeader(sourceKey, mesh.VertexBuffer.size() / 6, mesh.IndexCount(), mesh.IndexSize, mesh.Submeshes.size(), mesh.Meshlets.size(), static_cast<uint32_t>(mesh.Lods.size()), mesh.BoundsMin, mesh.BoundsMax);
+
+    // Reserve the header with a zero magic, and only fill it in once the payload is complete
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(mesh.VertexBuffer.data()), mesh.VertexBuffer.size() * sizeof(float));
+    file.write(static_cast<const char*>(mesh.IndexData()), mesh.IndexCount() * mesh.IndexSize);
+    file.write(reinterpret_cast<const char*>(mesh.Submeshes.data()), mesh.Submeshes.size() * sizeof(Submesh));
+    file.write(reinterpret_cast<const char*>(mesh.Meshlets.data()), mesh.Meshlets.size() * sizeof(Meshlet));
+
+    for (const MeshLod& lod : mesh.Lods)
+    {
+        // Every level has one range per submesh, which is what lets the header get away with only a count
+        if (lod.Submeshes.size() != mesh.Submeshes.size())
+        {
+            file.close();
+            std::remove(cachePath);
+            return E_FAIL;
+        }
+
+        file.write(reinterpret_cast<const char*>(&lod.Error), sizeof(float));
+        file.write(reinterpret_cast<const char*>(lod.Submeshes.data()), lod.Submeshes.size() * sizeof(Submesh));
+    }
+
+    if (FAILED(SealCacheFile(file, header)))
+    {
+        std::remove(cachePath);
+        return E_FAIL;
+    }
+
+    return S_OK;
+}
+
+
+////
+// Streamed cache files
+
+MeshCacheSink::~MeshCacheSink()
+{
+    // Anything not sealed by Finish is incomplete
+    if (m_file.is_open())
+    {
+        m_file.close();
+        std::remove(m_path.c_str());
+    }
+
+    if (m_indexFile.is_open())
+    {
+        m_indexFile.close();
+    }
+
+    if (!m_path.empty())
+    {
+        std::remove((m_path + ".indices").c_str());
+    }
+}
+
+HRESULT MeshCacheSink::Open(const char* cachePath, const MeshSourceKey& sourceKey)
+{
+    m_path      = cachePath;
+    m_sourceKey = sourceKey;
+
+    m_file.open(m_path, std::ios::binary | std::ios::trunc);
+    m_indexFile.open(m_path + ".indices", std::ios::binary | std::ios::trunc);
+
+    if (!m_file || !m_indexFile)
+    {
+        return E_FAIL;
+    }
+
+    // Placeholder until Finish knows the counts
+    MeshCacheHeader header {};
+    m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    return m_file ? S_OK : E_FAIL;
+}
+
+HRESULT MeshCacheSink::AppendBlock(const float* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount)
+{
+    m_file.write(reinterpret_cast<const char*>(vertices), vertexCount * VertexStride);
+    m_indexFile.write(reinterpret_cast<const char*>(indices), indexCount * sizeof(uint32_t));
+
+    m_vertexCount += vertexCount;
+    m_indexCount  += indexCount;
+
+    return (m_file && m_indexFile) ? S_OK : E_FAIL;
+}
+
+HRESULT MeshCacheSink::Finish(const std::vector<Submesh>& submeshes, const XMFLOAT3& boundsMin, const XMFLOAT3& boundsMax)
+{
+    m_indexFile.close();
+
+    // Copy the spilled indices in behind the vertices through a fixed-size buffer
+    std::ifstream indexFile(m_path + ".indices", std::ios::binary);
+    std::vector<char> buffer(1 << 20);
+
+    while (indexFile && m_file)
+    {
+        indexFile.read(buffer.data(), buffer.size());
+        m_file.write(buffer.data(), indexFile.gcount());
+    }
+
+    indexFile.close();
+
+    m_file.write(reinterpret_cast<const char*>(submeshes.data()), submeshes.size() * sizeof(Submesh));
+
+    HRESULT hr = SealCacheFile(m_file, MakeHeader(m_sourceKey, m_vertexCount, m_indexCount, sizeof(uint32_t), submeshes.size(), 0, 0, boundsMin, boundsMax));
+    if (FAILED(hr))
+    {
+        std::remove(m_path.c_str());
+    }
+
+    return hr;
+}
@@ -0,0 +1,69 @@
+//
+// MeshCache.h
+//
+
+#pragma once
+
+#include "MeshLoader.h"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+// Identifies the source file a cache was built from - size & modification time are the key, while the content hash
+// is recorded for an explicit verify
+struct MeshSourceKey
+{
+    uint64_t Size;
+    uint64_t WriteTime; // Platform file time - only ever compared for equality
+    uint64_t Hash;      // Zero until HashMeshSource fills it in
+    uint64_t Options;   // Load options that change the mesh, so differently processed loads never share a cache
+};
+
+// Fills the size & modification time from the file system, without reading the file
+HRESULT StatMeshSource(const char* filename, MeshSourceKey& outKey);
+
+// Hashes a whole file through a read-only mapping, in parallel 1MB blocks, into outKey.Hash
+HRESULT HashMeshSource(const char* filename, uint32_t threadCount, MeshSourceKey& outKey);
+
+// Binary container holding a loaded Mesh exactly as LoadMesh produced it
+//
+// A fixed header (magic, format version, source key, element counts, bounds) is followed by the raw vertex,
+// index, submesh & meshlet arrays, then any LOD levels. Files are in host byte order, and the header is written
+// last so a partially written file never validates
+
+// Reads the arrays straight into outMesh's buffers - fails if the cache is missing, malformed, from another format
+// version, or was built from a source of a different size, modification time or options. With checkHash, the
+// recorded content hash must match sourceKey.Hash too
+HRESULT ReadMeshCache(const char* cachePath, const MeshSourceKey& sourceKey, bool checkHash, Mesh& outMesh);
+
+// sourceKey.Hash should be filled in, so later loads can verify against it
+HRESULT WriteMeshCache(const char* cachePath, const MeshSourceKey& sourceKey, const Mesh& mesh);
+
+// Streams blocks from StreamMesh straight into a cache file, so out-of-core meshes never need to be held in memory
+// Indices are spilled to "<cachePath>.indices" until Finish appends them after the vertices, and always stay 32-bit
+class MeshCacheSink : public MeshSink
+{
+public:
+    MeshCacheSink()
+        : m_sourceKey{}
+        , m_vertexCount{}
+        , m_indexCount{}
+    { }
+
+    ~MeshCacheSink();
+
+    HRESULT Open(const char* cachePath, const MeshSourceKey& sourceKey);
+
+    HRESULT AppendBlock(const float* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount) override;
+    HRESULT Finish(const std::vector<Submesh>& submeshes, const DirectX::XMFLOAT3& boundsMin, const DirectX::XMFLOAT3& boundsMax) override;
+
+private:
+    std::string   m_path;
+    MeshSourceKey m_sourceKey;
+
+    std::ofstream m_file;
+    std::ofstream m_indexFile;
+    uint64_t      m_vertexCount;
+    uint64_t      m_indexCount;
+};
@@ -4,8 +4,20 @@
 
 #include "pch.h"
 #include "MeshLoader.h"
-
-#include <unordered_map>
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "MeshletBuilder.h"
+#include "ObjParser.h"
+#include "Parallel.h"
+#include "VertexBounds.h"
+#include "VertexWeld.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cstddef>
+#include <cstring>
+#include <string>
 
 #pragma warning(push)
 #pragma warning(disable : 26495 26451 26498 26812)
@@ -18,56 +30,159 @@
 
 using namespace DirectX;
 
-// Helpers for determining unique vertices
-struct Vertex
+// ObjCorner & tinyobj::index_t both lead with (position, normal) int32 indices, so either welds in place
+static_assert(offsetof(ObjCorner, Normal) == sizeof(int32_t), "ObjCorner layout must match CornerIndexStream");
+static_assert(offsetof(tinyobj::index_t, normal_index) == sizeof(int32_t), "index_t layout must match CornerIndexStream");
+
+// The mesh bounds enclose every submesh
+static void ComputeBounds(const std::vector<Submesh>& submeshes, XMFLOAT3& outMin, XMFLOAT3& outMax)
 {
-    Vertex(float* v, float* n)
-        : Position{ v[0], v[1], v[2] }
-        , Normal{ n[0], n[1], n[2] }
-    { }
+    auto boundsMin = DirectX::XMVectorReplicate(FLT_MAX);
+    auto boundsMax = DirectX::XMVectorReplicate(-FLT_MAX);
 
-    float Position[3];
-    float Normal[3];
-};
+    for (const Submesh& submesh : submeshes)
+    {
+        boundsMin = XMVectorMin(boundsMin, XMLoadFloat3(&submesh.BoundsMin));
+        boundsMax = XMVectorMax(boundsMax, XMLoadFloat3(&submesh.BoundsMax));
+    }
 
-template <class T>
-inline void hash_combine(size_t& seed, const T& v)
-{
-    std::hash<T> hasher;
-    seed ^= hasher(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    DirectX::XMStoreFloat3(&outMin, boundsMin);
+    DirectX::XMStoreFloat3(&outMax, boundsMax);
 }
 
-template<>
-struct std::hash<Vertex>
+// Welds every shape into its own vertex & index range of the mesh's shared buffers
+static void BuildSubmeshes(const float* positions, const float* normals, const std::vector<CornerIndexStream>& shapes, const MeshLoadOptions& options, Mesh& outMesh)
 {
-    size_t operator()(const Vertex& a) const noexcept
+    std::vector<Mesh> parts(shapes.size());
+
+    auto weldShape = [&](size_t s, uint32_t threadCount)
     {
-        size_t h = 0;
-        for (int i = 0; i < 3; ++i)
+        Mesh& part = parts[s];
+
+        if (options.WeldMode == MeshWeldMode::ParallelSort)
+        {
+            WeldVerticesSorted(positions, normals, shapes[s], threadCount, part);
+        }
+        else
         {
-            hash_combine(h, a.Position[i]);
-            hash_combine(h, a.Normal[i]);
+            WeldVerticesHashed(positions, normals, shapes[s], part);
         }
-        return h;
+
+        ComputeAabb(part.VertexBuffer.data(), part.VertexBuffer.size() / 6, 6, threadCount, part.BoundsMin, part.BoundsMax);
+    };
+
+    // The sort-based weld is already parallel within a shape; the serial hash weld runs one shape per worker, and
+    // only a lone shape's bounds get the workers to themselves
+    if (options.WeldMode == MeshWeldMode::ParallelSort)
+    {
+        for (size_t s = 0; s < shapes.size(); ++s)
+        {
+            weldShape(s, options.ThreadCount);
+        }
+    }
+    else
+    {
+        ParallelFor(shapes.size(), options.ThreadCount, [&](size_t s) { weldShape(s, (shapes.size() == 1) ? options.ThreadCount : 1); });
+    }
+
+    ////
+    // Lay the shapes out back to back & gather the per-shape ranges
+
+    size_t vertexCount = 0;
+    size_t indexCount  = 0;
+
+    outMesh.Submeshes.resize(parts.size());
+
+    for (size_t s = 0; s < parts.size(); ++s)
+    {
+        Submesh& submesh = outMesh.Submeshes[s];
+        submesh.FirstIndex  = static_cast<uint32_t>(indexCount);
+        submesh.IndexCount  = static_cast<uint32_t>(parts[s].IndexBuffer.size());
+        submesh.FirstVertex = static_cast<uint32_t>(vertexCount);
+        submesh.VertexCount = static_cast<uint32_t>(parts[s].VertexBuffer.size() / 6);
+        submesh.BoundsMin   = parts[s].BoundsMin;
+        submesh.BoundsMax   = parts[s].BoundsMax;
+
+        vertexCount += submesh.VertexCount;
+        indexCount  += submesh.IndexCount;
+    }
+
+    if (parts.size() == 1)
+    {
+        // Nothing to rebase
+        outMesh.VertexBuffer = std::move(parts[0].VertexBuffer);
+        outMesh.IndexBuffer  = std::move(parts[0].IndexBuffer);
     }
-};
+    else
+    {
+        outMesh.VertexBuffer.resize(vertexCount * 6);
+        outMesh.IndexBuffer.resize(indexCount);
 
-template<>
-struct std::equal_to<Vertex>
+        ParallelFor(parts.size(), options.ThreadCount, [&](size_t s)
+        {
+            const Submesh& submesh = outMesh.Submeshes[s];
+            const Mesh&    part    = parts[s];
+
+            if (submesh.VertexCount > 0)
+            {
+                std::memcpy(&outMesh.VertexBuffer[submesh.FirstVertex * size_t(6)], part.VertexBuffer.data(), part.VertexBuffer.size() * sizeof(float));
+            }
+
+            for (uint32_t i = 0; i < submesh.IndexCount; ++i)
+            {
+                outMesh.IndexBuffer[submesh.FirstIndex + i] = part.IndexBuffer[i] + submesh.FirstVertex;
+            }
+        });
+    }
+
+    ComputeBounds(outMesh.Submeshes, outMesh.BoundsMin, outMesh.BoundsMax);
+}
+
+// Loads through ObjParser - returns E_NOTIMPL for content it defers to tinyobjloader
+static HRESULT LoadMeshObjParser(const char* filename, Mesh& outMesh, const MeshLoadOptions& options)
 {
-    bool operator()(const Vertex& a, const Vertex& b) const noexcept
+    ObjData obj;
+
+    uint32_t threadCount = options.ParallelParse ? options.ThreadCount : 1;
+
+    HRESULT hr = ParseObjFile(filename, threadCount, options.MemoryMapped, obj);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    // Normals are expected from the model file in this sample
+    if (obj.Normals.size() == 0 || obj.Shapes.empty())
+    {
+        return E_FAIL;
+    }
+
+    std::vector<CornerIndexStream> corners;
+    corners.reserve(obj.Shapes.size());
+
+    for (const ObjShape& shape : obj.Shapes)
     {
-        return std::memcmp(&a, &b, sizeof(a)) == 0;
+        corners.push_back({ &obj.Corners[shape.FirstCorner].Position, sizeof(ObjCorner) / sizeof(int32_t), shape.CornerCount });
     }
-};
 
+    BuildSubmeshes(obj.Positions.data(), obj.Normals.data(), corners, options, outMesh);
 
-HRESULT LoadMesh(const char* filename, Mesh& outMesh)
+    return S_OK;
+}
+
+
+// Parses & welds the .obj file into submeshes
+static HRESULT ParseAndWeldObj(const char* filename, Mesh& outMesh, const MeshLoadOptions& options)
 {
-    const char* ext = strstr(filename, ".obj");
-    if (!ext)
+    if (options.ParallelParse || options.MemoryMapped)
     {
-        return E_FAIL; // Only supports .obj files
+        HRESULT hr = LoadMeshObjParser(filename, outMesh, options);
+        if (hr != E_NOTIMPL)
+        {
+            return hr;
+        }
+
+        // Otherwise fall back to tinyobjloader below
     }
 
     // Leverage TinyObjLoader to load the mesh
@@ -92,88 +207,292 @@ HRESULT LoadMesh(const char* filename, Mesh& outMesh)
         return E_FAIL;
     }
 
-    // Map used to de-duplicate vertices and generate an index buffer
-    std::unordered_map<Vertex, size_t> uniqueVertexMap;
-    
-    // Process the OBJ mesh into a vertex and index buffer
-    for (size_t f = 0; f < shapes[0].mesh.indices.size() / 3; f++)
+    std::vector<CornerIndexStream> corners;
+    corners.reserve(shapes.size());
+
+    for (const tinyobj::shape_t& shape : shapes)
     {
-        tinyobj::index_t idx0 = shapes[0].mesh.indices[3 * f + 0];
-        tinyobj::index_t idx1 = shapes[0].mesh.indices[3 * f + 1];
-        tinyobj::index_t idx2 = shapes[0].mesh.indices[3 * f + 2];
+        const std::vector<tinyobj::index_t>& indices = shape.mesh.indices;
 
-        float v[3][3] {};
-        for (int k = 0; k < 3; k++)
+        // Shapes made only of lines or points have nothing to draw
+        if (!indices.empty())
         {
-            size_t f0 = idx0.vertex_index;
-            size_t f1 = idx1.vertex_index;
-            size_t f2 = idx2.vertex_index;
-
-            v[0][k] = attrib.vertices[3 * f0 + k];
-            v[1][k] = attrib.vertices[3 * f1 + k];
-            v[2][k] = attrib.vertices[3 * f2 + k];
+            corners.push_back({ &indices[0].vertex_index, sizeof(tinyobj::index_t) / sizeof(int32_t), indices.size() });
         }
+    }
+
+    if (corners.empty())
+    {
+        return E_FAIL;
+    }
+
+    BuildSubmeshes(attrib.vertices.data(), attrib.normals.data(), corners, options, outMesh);
+
+    return S_OK;
+}
+
+
+bool ShortenIndices(Mesh& mesh)
+{
+    if (mesh.IndexSize == sizeof(uint16_t))
+    {
+        return true;
+    }
+
+    // Triangle lists never use the 0xffff strip-cut value, so all 65536 vertices are addressable
+    if (mesh.VertexBuffer.size() / 6 > 0x10000)
+    {
+        return false;
+    }
+
+    mesh.ShortIndexBuffer.assign(mesh.IndexBuffer.begin(), mesh.IndexBuffer.end());
+    std::vector<uint32_t>().swap(mesh.IndexBuffer);
+    mesh.IndexSize = sizeof(uint16_t);
+
+    return true;
+}
+
+void WidenIndices(Mesh& mesh)
+{
+    if (mesh.IndexSize == sizeof(uint32_t))
+    {
+        return;
+    }
+
+    mesh.IndexBuffer.assign(mesh.ShortIndexBuffer.begin(), mesh.ShortIndexBuffer.end());
+    std::vector<uint16_t>().swap(mesh.ShortIndexBuffer);
+    mesh.IndexSize = sizeof(uint32_t);
+}
+
+
+// Parses & welds the .obj file itself, then applies the optional processing
+static HRESULT LoadMeshObj(const char* filename, Mesh& outMesh, const MeshLoadOptions& options)
+{
+    HRESULT hr = ParseAndWeldObj(filename, outMesh, options);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    if (options.Optimize)
+    {
+        MeshOptimizeOptions optimizeOptions;
+        optimizeOptions.ThreadCount = options.ThreadCount;
+
+        OptimizeMesh(outMesh, optimizeOptions);
+    }
+
+    // After optimizing, which would reorder triangles across meshlet boundaries
+    if (options.BuildMeshlets)
+    {
+        MeshletBuildOptions meshletOptions;
+        meshletOptions.ThreadCount = options.ThreadCount;
+
+        BuildMeshlets(outMesh, meshletOptions);
+    }
+
+    // Last, as the levels' ranges are appended after everything the earlier passes laid out
+    if (options.BuildLods)
+    {
+        MeshLodOptions lodOptions;
+        lodOptions.ThreadCount = options.ThreadCount;
+
+        BuildLodChain(outMesh, lodOptions);
+    }
+
+    if (options.ShortIndices)
+    {
+        ShortenIndices(outMesh);
+    }
+
+    return S_OK;
+}
+
+
+HRESULT LoadMesh(const char* filename, Mesh& outMesh, const MeshLoadOptions& options)
+{
+    const char* ext = strstr(filename, ".obj");
+    if (!ext)
+    {
+        return E_FAIL; // Only supports .obj files
+    }
+
+    if (!options.UseCache)
+    {
+        return LoadMeshObj(filename, outMesh, options);
+    }
+
+    MeshSourceKey sourceKey {};
+
+    HRESULT hr = StatMeshSource(filename, sourceKey);
+    if (SUCCEEDED(hr) && options.VerifyCache)
+    {
+        hr = HashMeshSource(filename, options.ThreadCount, sourceKey);
+    }
+
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    sourceKey.Options = (options.Optimize ? 1 : 0) | (options.ShortIndices ? 2 : 0) | (options.BuildMeshlets ? 4 : 0) | (options.BuildLods ? 8 : 0);
+
+    std::string cachePath = std::string(filename) + ".meshcache";
+
+    if (SUCCEEDED(ReadMeshCache(cachePath.c_str(), sourceKey, options.VerifyCache, outMesh)))
+    {
+        return S_OK;
+    }
+
+    hr = LoadMeshObj(filename, outMesh, options);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    // The content hash is recorded for later verified loads; an unwritable cache only costs the next load a full parse
+    if (!options.VerifyCache)
+    {
+        hr = HashMeshSource(filename, options.ThreadCount, sourceKey);
+    }
+
+    if (FAILED(hr) || FAILED(WriteMeshCache(cachePath.c_str(), sourceKey, outMesh)))
+    {
+        OutputDebugStringA("Failed to write mesh cache\n");
+    }
+
+    return S_OK;
+}
+
+
+HRESULT MemoryMeshSink::AppendBlock(const float* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount)
+{
+    m_mesh.VertexBuffer.insert(m_mesh.VertexBuffer.end(), vertices, vertices + vertexCount * 6);
+    m_mesh.IndexBuffer.insert(m_mesh.IndexBuffer.end(), indices, indices + indexCount);
+
+    return S_OK;
+}
+
+HRESULT MemoryMeshSink::Finish(const std::vector<Submesh>& submeshes, const XMFLOAT3& boundsMin, const XMFLOAT3& boundsMax)
+{
+    m_mesh.Submeshes = submeshes;
+    m_mesh.BoundsMin = boundsMin;
+    m_mesh.BoundsMax = boundsMax;
+
+    return S_OK;
+}
 
-        float n[3][3] {};
+
+HRESULT StreamMesh(const char* filename, MeshSink& sink, const MeshStreamOptions& options)
+{
+    const char* ext = strstr(filename, ".obj");
+    if (!ext)
+    {
+        return E_FAIL; // Only supports .obj files
+    }
+
+    // Parsing & welding a window allocates roughly a dozen times its text size (corners, triangles, dedup table, block)
+    size_t windowSize = std::max<size_t>(options.MemoryBudget / 16, 64 << 10);
+
+    std::string scratchPath = options.ScratchPath ? options.ScratchPath : filename;
+
+    std::vector<Submesh> submeshes;
+    Submesh shape {}; // The shape being streamed - it may span several windows
+
+    size_t vertexCount = 0;
+    size_t indexCount  = 0;
+
+    Mesh block;
+
+    // Welds the corners of one shape within one window & hands them to the sink
+    auto emitBlock = [&](const ObjStreamWindow& window, size_t first, size_t last)
+    {
+        if (first == last)
         {
-            size_t nf0 = idx0.normal_index;
-            size_t nf1 = idx1.normal_index;
-            size_t nf2 = idx2.normal_index;
+            return S_OK;
+        }
 
-            for (int k = 0; k < 3; k++) 
-            {
-                n[0][k] = attrib.normals[3 * nf0 + k];
-                n[1][k] = attrib.normals[3 * nf1 + k];
-                n[2][k] = attrib.normals[3 * nf2 + k];
-            }
+        block.VertexBuffer.clear();
+        block.IndexBuffer.clear();
+
+        CornerIndexStream corners = { &window.Corners[first].Position, sizeof(ObjCorner) / sizeof(int32_t), last - first };
+        WeldVerticesHashed(window.Positions, window.Normals, corners, block);
+
+        ComputeAabb(block.VertexBuffer.data(), block.VertexBuffer.size() / 6, 6, 1, block.BoundsMin, block.BoundsMax);
+
+        for (uint32_t& index : block.IndexBuffer)
+        {
+            index += static_cast<uint32_t>(vertexCount);
         }
 
-        for (int k = 0; k < 3; k++)
+        if (shape.IndexCount == 0)
         {
-            Vertex m (v[k], n[k]);
+            shape.FirstIndex  = static_cast<uint32_t>(indexCount);
+            shape.FirstVertex = static_cast<uint32_t>(vertexCount);
+            shape.BoundsMin   = block.BoundsMin;
+            shape.BoundsMax   = block.BoundsMax;
+        }
+        else
+        {
+            XMStoreFloat3(&shape.BoundsMin, XMVectorMin(XMLoadFloat3(&shape.BoundsMin), XMLoadFloat3(&block.BoundsMin)));
+            XMStoreFloat3(&shape.BoundsMax, XMVectorMax(XMLoadFloat3(&shape.BoundsMax), XMLoadFloat3(&block.BoundsMax)));
+        }
 
-            // Check our unique vertex map for identical vertices
-            auto it = uniqueVertexMap.find(m);
+        size_t blockVertexCount = block.VertexBuffer.size() / 6;
 
-            if (it == uniqueVertexMap.end())
-            {
-                // A new vertex! Add it to the vertex buffer
-                outMesh.VertexBuffer.push_back(v[k][0]);
-                outMesh.VertexBuffer.push_back(v[k][1]);
-                outMesh.VertexBuffer.push_back(v[k][2]);
+        shape.IndexCount  += static_cast<uint32_t>(block.IndexBuffer.size());
+        shape.VertexCount += static_cast<uint32_t>(blockVertexCount);
 
-                outMesh.VertexBuffer.push_back(n[k][0]);
-                outMesh.VertexBuffer.push_back(n[k][1]);
-                outMesh.VertexBuffer.push_back(n[k][2]);
+        vertexCount += blockVertexCount;
+        indexCount  += block.IndexBuffer.size();
 
-                // Toss it into the hash map
-                uniqueVertexMap.insert(std::make_pair(m, uniqueVertexMap.size()));
+        return sink.AppendBlock(block.VertexBuffer.data(), blockVertexCount, block.IndexBuffer.data(), block.IndexBuffer.size());
+    };
+
+    // Like LoadMesh, shapes without triangles are dropped
+    auto closeShape = [&]()
+    {
+        if (shape.IndexCount > 0)
+        {
+            submeshes.push_back(shape);
+        }
+        shape = {};
+    };
+
+    HRESULT hr = StreamObjFile(filename, scratchPath.c_str(), windowSize, [&](const ObjStreamWindow& window)
+    {
+        size_t first = 0;
 
-                it = uniqueVertexMap.find(m);
+        for (size_t b = 0; b < window.ShapeBreakCount; ++b)
+        {
+            HRESULT blockResult = emitBlock(window, first, window.ShapeBreaks[b]);
+            if (FAILED(blockResult))
+            {
+                return blockResult;
             }
 
-            // Keep building our index list
-            outMesh.IndexBuffer.push_back(static_cast<uint32_t>(it->second));
+            closeShape();
+            first = window.ShapeBreaks[b];
         }
-    }
 
+        return emitBlock(window, first, window.CornerCount);
+    });
 
-    // Find spatial bounds of the mesh
-    auto boundsMin = DirectX::XMVectorReplicate(FLT_MAX);
-    auto boundsMax = DirectX::XMVectorReplicate(-FLT_MAX);
-
-    for (int i = 0; i < outMesh.VertexBuffer.size(); i += 6)
+    if (FAILED(hr))
     {
-        auto v = reinterpret_cast<XMFLOAT3*>(&outMesh.VertexBuffer[i]);
-        auto position = XMLoadFloat3(v);
+        return hr;
+    }
+
+    closeShape();
 
-        boundsMax = XMVectorMax(boundsMax, position);
-        boundsMin = XMVectorMin(boundsMin, position);
+    // Normals are validated per corner while streaming, so this only catches files without any triangles
+    if (submeshes.empty())
+    {
+        return E_FAIL;
     }
 
-    DirectX::XMStoreFloat3(&outMesh.BoundsMin, boundsMin);
-    DirectX::XMStoreFloat3(&outMesh.BoundsMax, boundsMax);
+    XMFLOAT3 meshMin, meshMax;
+    ComputeBounds(submeshes, meshMin, meshMax);
 
-    return S_OK;
+    return sink.Finish(submeshes, meshMin, meshMax);
 }
-
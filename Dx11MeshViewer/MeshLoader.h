@@ -7,13 +7,130 @@
 #include <DirectXMath.h>
 #include <vector>
 
+// One OBJ shape within the mesh's shared buffers - drawn with DrawIndexed(IndexCount, FirstIndex, 0)
+struct Submesh
+{
+    uint32_t              FirstIndex;
+    uint32_t              IndexCount;
+    uint32_t              FirstVertex; // Vertices are never shared between submeshes, so each owns a contiguous range
+    uint32_t              VertexCount;
+
+    DirectX::XMFLOAT3     BoundsMin;
+    DirectX::XMFLOAT3     BoundsMax;
+};
+
+// A cluster of at most 64 vertices & 124 triangles within one submesh, for culling at a finer grain than submeshes
+// Its triangles are contiguous in the index buffer, so a visible meshlet is one DrawIndexed(IndexCount, FirstIndex, 0)
+struct Meshlet
+{
+    uint32_t              FirstIndex;
+    uint32_t              IndexCount;
+    uint32_t              VertexCount; // Distinct vertices referenced
+
+    DirectX::XMFLOAT3     BoundsMin;
+    DirectX::XMFLOAT3     BoundsMax;
+    DirectX::XMFLOAT3     Center;      // Bounding sphere
+    float                 Radius;
+
+    // Every triangle's front-face normal lies within the cone - see IsMeshletBackfacing in MeshletBuilder.h
+    DirectX::XMFLOAT3     ConeAxis;
+    float                 ConeCutoff;  // Cosine of the widest angle from the axis; <= 0 when the cone can't cull
+};
+
+// A reduced-detail version of every submesh, drawn out of the same vertex buffer - see MeshSimplifier.h
+struct MeshLod
+{
+    std::vector<Submesh>  Submeshes; // Mesh::Submeshes' vertex ranges & bounds, with index ranges of their own
+    float                 Error;     // Estimated worst deviation from full detail, in object space units
+};
+
 struct Mesh
 {
     std::vector<float>    VertexBuffer;
+
+    // Indices address the whole vertex buffer, not just their submesh's range
+    // Only the buffer matching IndexSize is populated - see ShortenIndices & WidenIndices
     std::vector<uint32_t> IndexBuffer;
+    std::vector<uint16_t> ShortIndexBuffer;
+    uint32_t              IndexSize = sizeof(uint32_t); // Bytes per index
+
+    std::vector<Submesh>  Submeshes;   // One per shape with triangles, in file order
+    std::vector<Meshlet>  Meshlets;    // In submesh order - empty unless built (see MeshLoadOptions::BuildMeshlets)
+    std::vector<MeshLod>  Lods;        // Successively coarser levels after the full detail Submeshes - empty unless built
 
     DirectX::XMFLOAT3     BoundsMin {};
     DirectX::XMFLOAT3     BoundsMax {};
+
+    size_t      IndexCount() const { return IndexSize == sizeof(uint16_t) ? ShortIndexBuffer.size() : IndexBuffer.size(); }
+    const void* IndexData() const  { return IndexSize == sizeof(uint16_t) ? static_cast<const void*>(ShortIndexBuffer.data()) : IndexBuffer.data(); }
+};
+
+// Switches the mesh to 16-bit indices if every vertex is addressable with them - returns whether it did
+bool ShortenIndices(Mesh& mesh);
+
+// Switches the mesh back to 32-bit indices, which processing passes work on
+void WidenIndices(Mesh& mesh);
+
+// How LoadMesh merges identical triangle corners into indexed vertices - both produce identical output
+enum class MeshWeldMode
+{
+    HashTable,    // Serial, through a flat open-addressing hash set
+    ParallelSort, // Radix-sorts corners by vertex hash across all cores; no shared map
+};
+
+// Optional loader behaviors - the defaults parse with tinyobjloader and weld each shape through a hash table
+struct MeshLoadOptions
+{
+    bool         ParallelParse = false;                   // Parse newline-aligned chunks of the file on all cores
+    bool         MemoryMapped  = false;                   // Parse straight out of a read-only mapping of the file instead of a heap copy
+    MeshWeldMode WeldMode      = MeshWeldMode::HashTable;
+    bool         Optimize      = false;                   // Reorder for vertex cache, overdraw & fetch locality (see MeshOptimizer.h)
+    bool         BuildMeshlets = false;                   // Partition every submesh into meshlets (see MeshletBuilder.h)
+    bool         BuildLods     = false;                   // Simplify every submesh into a chain of coarser levels (see MeshSimplifier.h)
+    bool         ShortIndices  = true;                    // Emit 16-bit indices when the mesh has at most 65536 vertices
+    bool         UseCache      = false;                   // Reload "<file>.meshcache" when it matches the source's size & modification time, or rewrite it
+    bool         VerifyCache   = false;                   // Also rehash the source & require the cache's recorded content hash to match
+    uint32_t     ThreadCount   = 0;                       // Worker count for parallel stages (including per-shape welding); 0 uses every hardware thread
+};
+
+HRESULT LoadMesh(const char* filename, Mesh& outMesh, const MeshLoadOptions& options = {}); // Currently only supports .obj format
+
+
+// Receives a streamed mesh block by block, in file order
+class MeshSink
+{
+public:
+    virtual ~MeshSink() = default;
+
+    // A block's vertices are numbered after those of all previous blocks, and its indices address that whole sequence
+    virtual HRESULT AppendBlock(const float* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount) = 0;
+
+    // Called once, after the last block
+    virtual HRESULT Finish(const std::vector<Submesh>& submeshes, const DirectX::XMFLOAT3& boundsMin, const DirectX::XMFLOAT3& boundsMax) = 0;
+};
+
+// Collects a streamed mesh into an in-memory Mesh
+class MemoryMeshSink : public MeshSink
+{
+public:
+    explicit MemoryMeshSink(Mesh& mesh)
+        : m_mesh(mesh)
+    { }
+
+    HRESULT AppendBlock(const float* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount) override;
+    HRESULT Finish(const std::vector<Submesh>& submeshes, const DirectX::XMFLOAT3& boundsMin, const DirectX::XMFLOAT3& boundsMax) override;
+
+private:
+    Mesh& m_mesh;
+};
+
+struct MeshStreamOptions
+{
+    size_t      MemoryBudget = 64 << 20; // Approximate cap on the loader's own allocations; spilled attributes are mapped & paged by the OS
+    const char* ScratchPath  = nullptr;  // Prefix of the attribute spill files, written beside the source by default
 };
 
-HRESULT LoadMesh(const char* filename, Mesh& outMesh); // Currently only supports .obj format
+// Loads an .obj file through bounded windows & emits each window's welded vertices and indices to the sink, for meshes
+// too large to parse in memory. Vertices are only merged within a window, so those shared across a window boundary are
+// duplicated; with a budget covering the whole file, the output matches LoadMesh
+HRESULT StreamMesh(const char* filename, MeshSink& sink, const MeshStreamOptions& options = {});
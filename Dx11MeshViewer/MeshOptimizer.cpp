@@ -0,0 +1,476 @@
+//
+// MeshOptimizer.cpp
+//
+
+#include "pch.h"
+#include "MeshOptimizer.h"
+#include "MeshLoader.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    const uint32_t InvalidIndex = ~0u;
+    const size_t   VertexSize   = 6;
+
+    // FIFO cache modeled with timestamps: a miss stamps the vertex and advances the clock, so a vertex is still
+    // cached while fewer than cacheSize misses have happened since it was stamped
+    class FifoCache
+    {
+    public:
+        FifoCache(size_t vertexCount, uint32_t cacheSize)
+            : m_stamps(vertexCount, 0)
+            , m_time(cacheSize + 1)
+            , m_size(cacheSize)
+        { }
+
+        bool Contains(uint32_t v) const { return m_time - m_stamps[v] <= m_size; }
+        uint32_t Age(uint32_t v) const  { return m_time - m_stamps[v]; }
+
+        // Returns 1 on a miss
+        uint32_t Touch(uint32_t v)
+        {
+            if (Contains(v))
+            {
+                return 0;
+            }
+
+            m_stamps[v] = m_time++;
+            return 1;
+        }
+
+        uint32_t TouchTriangle(const uint32_t* triangle)
+        {
+            return Touch(triangle[0]) + Touch(triangle[1]) + Touch(triangle[2]);
+        }
+
+        void Flush() { m_time += m_size + 1; }
+
+    private:
+        std::vector<uint32_t> m_stamps;
+        uint32_t              m_time;
+        uint32_t              m_size;
+    };
+
+    // Triangles around each vertex, as ranges of one flat list
+    struct VertexAdjacency
+    {
+        std::vector<uint32_t> Offsets;
+        std::vector<uint32_t> Triangles;
+    };
+
+    void BuildAdjacency(const uint32_t* indices, size_t indexCount, size_t vertexCount, VertexAdjacency& adjacency)
+    {
+        adjacency.Offsets.assign(vertexCount + 1, 0);
+
+        for (size_t i = 0; i < indexCount; ++i)
+        {
+            ++adjacency.Offsets[indices[i] + 1];
+        }
+
+        for (size_t v = 0; v < vertexCount; ++v)
+        {
+            adjacency.Offsets[v + 1] += adjacency.Offsets[v];
+        }
+
+        std::vector<uint32_t> cursor(adjacency.Offsets.begin(), adjacency.Offsets.end() - 1);
+        adjacency.Triangles.resize(indexCount);
+
+        for (size_t i = 0; i < indexCount; ++i)
+        {
+            adjacency.Triangles[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+    }
+}
+
+
+VertexCacheStats AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize)
+{
+    FifoCache cache(vertexCount, cacheSize);
+    std::vector<uint8_t> referenced(vertexCount, 0);
+
+    size_t misses = 0;
+    size_t referencedCount = 0;
+
+    for (size_t i = 0; i < indexCount; ++i)
+    {
+        misses += cache.Touch(indices[i]);
+
+        referencedCount += referenced[indices[i]] == 0;
+        referenced[indices[i]] = 1;
+    }
+
+    VertexCacheStats stats {};
+    stats.Acmr = indexCount ? float(misses) / float(indexCount / 3) : 0.0f;
+    stats.Atvr = referencedCount ? float(misses) / float(referencedCount) : 0.0f;
+
+    return stats;
+}
+
+
+void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize, std::vector<uint32_t>* outClusters)
+{
+    if (outClusters)
+    {
+        outClusters->assign(indexCount ? 1 : 0, 0);
+    }
+
+    if (indexCount == 0)
+    {
+        return;
+    }
+
+    VertexAdjacency adjacency;
+    BuildAdjacency(indices, indexCount, vertexCount, adjacency);
+
+    std::vector<uint32_t> liveTriangles(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        liveTriangles[v] = adjacency.Offsets[v + 1] - adjacency.Offsets[v];
+    }
+
+    std::vector<uint8_t>  emitted(indexCount / 3, 0);
+    std::vector<uint32_t> output(indexCount);
+    std::vector<uint32_t> deadEnds;
+    std::vector<uint32_t> candidates;
+
+    FifoCache cache(vertexCount, cacheSize);
+
+    size_t   outputCount = 0;
+    size_t   scanCursor  = 0;
+    uint32_t fan         = indices[0];
+
+    while (fan != InvalidIndex)
+    {
+        ////
+        // Emit every remaining triangle around the fanning vertex
+
+        candidates.clear();
+
+        for (uint32_t a = adjacency.Offsets[fan]; a < adjacency.Offsets[fan + 1]; ++a)
+        {
+            uint32_t triangle = adjacency.Triangles[a];
+            if (emitted[triangle])
+            {
+                continue;
+            }
+
+            emitted[triangle] = 1;
+
+            for (size_t k = 0; k < 3; ++k)
+            {
+                uint32_t v = indices[triangle * 3 + k];
+
+                output[outputCount++] = v;
+                deadEnds.push_back(v);
+                candidates.push_back(v);
+
+                --liveTriangles[v];
+                cache.Touch(v);
+            }
+        }
+
+        ////
+        // Fan next around the oldest candidate that stays cached while its remaining triangles are emitted
+
+        uint32_t next = InvalidIndex;
+        int64_t  bestPriority = -1;
+
+        for (uint32_t v : candidates)
+        {
+            if (liveTriangles[v] == 0)
+            {
+                continue;
+            }
+
+            // Each remaining triangle can push up to two new vertices into the cache
+            int64_t priority = 0;
+            if (int64_t(cache.Age(v)) + 2 * int64_t(liveTriangles[v]) <= cacheSize)
+            {
+                priority = cache.Age(v);
+            }
+
+            if (priority > bestPriority)
+            {
+                bestPriority = priority;
+                next = v;
+            }
+        }
+
+        if (next == InvalidIndex)
+        {
+            // Dead end - restart from the most recent vertex that still has triangles, else the next one in order
+            while (next == InvalidIndex && !deadEnds.empty())
+            {
+                uint32_t v = deadEnds.back();
+                deadEnds.pop_back();
+
+                if (liveTriangles[v] > 0)
+                {
+                    next = v;
+                }
+            }
+
+            for (; next == InvalidIndex && scanCursor < vertexCount; ++scanCursor)
+            {
+                if (liveTriangles[scanCursor] > 0)
+                {
+                    next = static_cast<uint32_t>(scanCursor);
+                }
+            }
+
+            if (outClusters && next != InvalidIndex)
+            {
+                outClusters->push_back(static_cast<uint32_t>(outputCount / 3));
+            }
+        }
+
+        fan = next;
+    }
+
+    std::memcpy(indices, output.data(), indexCount * sizeof(uint32_t));
+}
+
+
+void OptimizeOverdraw(uint32_t* indices, size_t indexCount, const float* vertices, size_t vertexCount, const std::vector<uint32_t>& clusters, uint32_t cacheSize, float threshold)
+{
+    size_t triangleCount = indexCount / 3;
+
+    if (clusters.empty() || triangleCount == 0)
+    {
+        return;
+    }
+
+    ////
+    // Split the clusters wherever the triangles so far already match the cluster's cache efficiency (within threshold)
+
+    FifoCache cache(vertexCount, cacheSize);
+    std::vector<uint32_t> softClusters;
+
+    for (size_t c = 0; c < clusters.size(); ++c)
+    {
+        size_t start = clusters[c];
+        size_t end   = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+
+        cache.Flush();
+
+        size_t clusterMisses = 0;
+        for (size_t t = start; t < end; ++t)
+        {
+            clusterMisses += cache.TouchTriangle(&indices[t * 3]);
+        }
+
+        float targetAcmr = threshold * float(clusterMisses) / float(end - start);
+
+        softClusters.push_back(static_cast<uint32_t>(start));
+        cache.Flush();
+
+        size_t runMisses = 0;
+        size_t runStart  = start;
+
+        for (size_t t = start; t < end; ++t)
+        {
+            runMisses += cache.TouchTriangle(&indices[t * 3]);
+
+            if (float(runMisses) <= targetAcmr * float(t + 1 - runStart))
+            {
+                softClusters.push_back(static_cast<uint32_t>(t + 1));
+                cache.Flush();
+
+                runMisses = 0;
+                runStart  = t + 1;
+            }
+        }
+
+        // The trailing run never reached the target, so fold it into the previous one (this also drops a split at 'end')
+        if (softClusters.back() != start)
+        {
+            softClusters.pop_back();
+        }
+    }
+
+    ////
+    // Sort clusters by how far they face away from the mesh center - outer surfaces occlude inner ones
+
+    double center[3] = {};
+    for (size_t i = 0; i < indexCount; ++i)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            center[k] += vertices[indices[i] * VertexSize + k];
+        }
+    }
+
+    for (int k = 0; k < 3; ++k)
+    {
+        center[k] /= double(indexCount);
+    }
+
+    std::vector<float> sortKeys(softClusters.size());
+
+    for (size_t c = 0; c < softClusters.size(); ++c)
+    {
+        size_t start = softClusters[c];
+        size_t end   = c + 1 < softClusters.size() ? softClusters[c + 1] : triangleCount;
+
+        // Area-weighted centroid & normal of the cluster
+        double centroid[3] = {};
+        double normal[3] = {};
+        double area = 0.0;
+
+        for (size_t t = start; t < end; ++t)
+        {
+            const float* p0 = &vertices[indices[t * 3 + 0] * VertexSize];
+            const float* p1 = &vertices[indices[t * 3 + 1] * VertexSize];
+            const float* p2 = &vertices[indices[t * 3 + 2] * VertexSize];
+
+            double e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+            double e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+            double n[3]  = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+
+            double triangleArea = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+            for (int k = 0; k < 3; ++k)
+            {
+                centroid[k] += (p0[k] + p1[k] + p2[k]) / 3.0 * triangleArea;
+                normal[k]   += n[k];
+            }
+
+            area += triangleArea;
+        }
+
+        double normalLength = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        double key = 0.0;
+
+        if (area > 0.0 && normalLength > 0.0)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                key += (centroid[k] / area - center[k]) * (normal[k] / normalLength);
+            }
+        }
+
+        sortKeys[c] = static_cast<float>(key);
+    }
+
+    std::vector<uint32_t> order(softClusters.size());
+    for (size_t c = 0; c < order.size(); ++c)
+    {
+        order[c] = static_cast<uint32_t>(c);
+    }
+
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+    std::vector<uint32_t> source(indices, indices + indexCount);
+    size_t write = 0;
+
+    for (uint32_t c : order)
+    {
+        size_t start = softClusters[c];
+        size_t end   = c + 1 < softClusters.size() ? softClusters[c + 1] : triangleCount;
+
+        std::memcpy(&indices[write], &source[start * 3], (end - start) * 3 * sizeof(uint32_t));
+        write += (end - start) * 3;
+    }
+}
+
+
+void OptimizeVertexFetch(Mesh& mesh, uint32_t threadCount)
+{
+    bool shortIndices = mesh.IndexSize == sizeof(uint16_t);
+    WidenIndices(mesh);
+
+    std::vector<float> vertices(mesh.VertexBuffer.size());
+
+    // Meshes built by hand may have no submesh table - treat them as a single submesh
+    std::vector<Submesh> ranges = mesh.Submeshes;
+    if (ranges.empty())
+    {
+        Submesh whole {};
+        whole.IndexCount  = static_cast<uint32_t>(mesh.IndexBuffer.size());
+        whole.VertexCount = static_cast<uint32_t>(mesh.VertexBuffer.size() / VertexSize);
+        whole.BoundsMin   = mesh.BoundsMin;
+        whole.BoundsMax   = mesh.BoundsMax;
+        ranges.push_back(whole);
+    }
+
+    // Submeshes own disjoint vertex ranges, so each is renumbered within its own range
+    ParallelFor(ranges.size(), threadCount, [&](size_t s)
+    {
+        const Submesh& submesh = ranges[s];
+
+        std::vector<uint32_t> remap(submesh.VertexCount, InvalidIndex);
+        uint32_t next = submesh.FirstVertex;
+
+        for (uint32_t i = submesh.FirstIndex; i < submesh.FirstIndex + submesh.IndexCount; ++i)
+        {
+            uint32_t& index = mesh.IndexBuffer[i];
+            uint32_t& target = remap[index - submesh.FirstVertex];
+
+            if (target == InvalidIndex)
+            {
+                target = next++;
+            }
+
+            index = target;
+        }
+
+        // Unreferenced vertices keep their relative order at the end of the range
+        for (uint32_t v = 0; v < submesh.VertexCount; ++v)
+        {
+            if (remap[v] == InvalidIndex)
+            {
+                remap[v] = next++;
+            }
+
+            std::memcpy(&vertices[remap[v] * VertexSize], &mesh.VertexBuffer[(submesh.FirstVertex + v) * VertexSize], VertexSize * sizeof(float));
+        }
+    });
+
+    mesh.VertexBuffer.swap(vertices);
+
+    if (shortIndices)
+    {
+        ShortenIndices(mesh);
+    }
+}
+
+
+void OptimizeMesh(Mesh& mesh, const MeshOptimizeOptions& options)
+{
+    bool shortIndices = mesh.IndexSize == sizeof(uint16_t);
+    WidenIndices(mesh);
+
+    ParallelFor(mesh.Submeshes.size(), options.ThreadCount, [&](size_t s)
+    {
+        const Submesh& submesh = mesh.Submeshes[s];
+
+        uint32_t* indices = &mesh.IndexBuffer[submesh.FirstIndex];
+        const float* vertices = &mesh.VertexBuffer[submesh.FirstVertex * VertexSize];
+
+        // Work in submesh-local vertex numbering so the per-vertex tables only span this submesh
+        for (uint32_t i = 0; i < submesh.IndexCount; ++i)
+        {
+            indices[i] -= submesh.FirstVertex;
+        }
+
+        std::vector<uint32_t> clusters;
+        OptimizeVertexCache(indices, submesh.IndexCount, submesh.VertexCount, options.CacheSize, &clusters);
+        OptimizeOverdraw(indices, submesh.IndexCount, vertices, submesh.VertexCount, clusters, options.CacheSize, options.OverdrawThreshold);
+
+        for (uint32_t i = 0; i < submesh.IndexCount; ++i)
+        {
+            indices[i] += submesh.FirstVertex;
+        }
+    });
+
+    OptimizeVertexFetch(mesh, options.ThreadCount);
+
+    if (shortIndices)
+    {
+        ShortenIndices(mesh);
+    }
+}
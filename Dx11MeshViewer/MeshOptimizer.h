@@ -0,0 +1,44 @@
+//
+// MeshOptimizer.h
+//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+struct Mesh;
+
+// Post-transform vertex cache efficiency of an index buffer
+struct VertexCacheStats
+{
+    float Acmr; // Average cache miss ratio - vertex shader invocations per triangle (3 is worst, ~0.5 ideal for closed meshes)
+    float Atvr; // Average transformed vertex ratio - invocations per referenced vertex (1 is ideal)
+};
+
+struct MeshOptimizeOptions
+{
+    uint32_t CacheSize         = 16;    // FIFO entries assumed by the cache optimization
+    float    OverdrawThreshold = 1.05f; // How much ACMR the overdraw pass may give up to get finer-grained clusters
+    uint32_t ThreadCount       = 0;     // Submeshes are optimized concurrently; 0 uses every hardware thread
+};
+
+// Simulates a FIFO post-transform cache of cacheSize entries over the index buffer
+VertexCacheStats AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize = 16);
+
+// Reorders triangles for post-transform cache reuse with Tipsify (Sander et al. 2007) - fans around the vertex
+// that stays cached longest, and restarts from a recently used vertex at dead ends. Indices must lie in
+// [0, vertexCount). Optionally returns the first triangle of each cluster between dead-end restarts
+void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize, std::vector<uint32_t>* outClusters = nullptr);
+
+// Reorders the clusters found by OptimizeVertexCache so outward-facing ones draw first, cutting overdraw from
+// most viewpoints. Clusters are first split into smaller runs wherever a run's ACMR stays within threshold times
+// the whole cluster's. Vertices are position/normal pairs of 6 floats
+void OptimizeOverdraw(uint32_t* indices, size_t indexCount, const float* vertices, size_t vertexCount, const std::vector<uint32_t>& clusters, uint32_t cacheSize, float threshold);
+
+// Renumbers each submesh's vertices in order of first use, so vertex fetch walks memory sequentially
+// Both Mesh passes accept either index size, and leave it as they found it
+void OptimizeVertexFetch(Mesh& mesh, uint32_t threadCount = 0);
+
+// Runs the cache, overdraw & fetch passes over every submesh - submesh ranges and bounds are unchanged
+void OptimizeMesh(Mesh& mesh, const MeshOptimizeOptions& options = {});
@@ -0,0 +1,792 @@
+//
+// MeshSimplifier.cpp
+//
+
+#include "pch.h"
+#include "MeshSimplifier.h"
+#include "MeshLoader.h"
+#include "MeshOptimizer.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    const uint32_t InvalidIndex          = ~0u;
+    const size_t   VertexSize            = 6;
+    const size_t   BlockSize             = 16384;   // Positions per parallel work item
+    const size_t   LargeSubmeshTriangles = 1 << 18; // Submeshes from this size on spread their own work over the workers
+    const uint32_t LodCacheSize          = 16;
+
+    // Symmetric 4x4 matrix summing squared distances to a set of planes (ax + by + cz + d = 0)
+    //
+    // Each position keeps its quadric in a frame centered on itself. Errors are tiny next to the plane offsets
+    // from a distant origin, and would drown in float rounding there
+    struct Quadric
+    {
+        float A2, B2, C2, AB, AC, BC, AD, BD, CD, D2;
+    };
+
+    void AddPlane(Quadric& q, const float* normal, float d, float weight)
+    {
+        float a = normal[0], b = normal[1], c = normal[2];
+
+        q.A2 += a * a * weight;
+        q.B2 += b * b * weight;
+        q.C2 += c * c * weight;
+        q.AB += a * b * weight;
+        q.AC += a * c * weight;
+        q.BC += b * c * weight;
+        q.AD += a * d * weight;
+        q.BD += b * d * weight;
+        q.CD += c * d * weight;
+        q.D2 += d * d * weight;
+    }
+
+    float Evaluate(const Quadric& q, const float* p)
+    {
+        float x = p[0], y = p[1], z = p[2];
+
+        float error = q.A2 * x * x + q.B2 * y * y + q.C2 * z * z
+                    + 2.0f * (q.AB * x * y + q.AC * x * z + q.BC * y * z)
+                    + 2.0f * (q.AD * x + q.BD * y + q.CD * z)
+                    + q.D2;
+
+        return std::max(error, 0.0f); // Rounding can push an exact fit slightly negative
+    }
+
+    void AddQuadric(Quadric& q, const Quadric& other)
+    {
+        q.A2 += other.A2; q.B2 += other.B2; q.C2 += other.C2;
+        q.AB += other.AB; q.AC += other.AC; q.BC += other.BC;
+        q.AD += other.AD; q.BD += other.BD; q.CD += other.CD;
+        q.D2 += other.D2;
+    }
+
+    // Adds other, whose frame is centered 'offset' away from q's - moving a quadric's frame by t keeps its
+    // matrix, shifts its linear part by the matrix times t, and makes its constant the error at t
+    void AddQuadric(Quadric& q, const Quadric& other, const float* offset)
+    {
+        float x = offset[0], y = offset[1], z = offset[2];
+
+        Quadric moved = other;
+        moved.AD = other.AD + other.A2 * x + other.AB * y + other.AC * z;
+        moved.BD = other.BD + other.AB * x + other.B2 * y + other.BC * z;
+        moved.CD = other.CD + other.AC * x + other.BC * y + other.C2 * z;
+        moved.D2 = Evaluate(other, offset);
+
+        AddQuadric(q, moved);
+    }
+
+    void Cross(const float* a, const float* b, const float* c, float* n)
+    {
+        float e0[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+        float e1[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+
+        n[0] = e0[1] * e1[2] - e0[2] * e1[1];
+        n[1] = e0[2] * e1[0] - e0[0] * e1[2];
+        n[2] = e0[0] * e1[1] - e0[1] * e1[0];
+    }
+
+    bool Normalize(float* v)
+    {
+        float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+        if (length == 0.0f)
+        {
+            return false;
+        }
+
+        v[0] /= length;
+        v[1] /= length;
+        v[2] /= length;
+        return true;
+    }
+
+    enum class VertexKind : uint8_t
+    {
+        Interior, // Fully surrounded - may collapse onto any neighbor
+        Border,   // On one open boundary loop - may only collapse along it
+        Locked,   // Seam, non-manifold or already collapsed - never moves
+    };
+
+    // Neighbors of a position, each with how many of its triangles share that edge
+    struct Ring
+    {
+        std::vector<uint32_t> Neighbors;
+        std::vector<uint32_t> EdgeCounts;
+        std::vector<uint32_t> EdgeTriangles; // The last triangle seen on each edge
+
+        void Add(uint32_t neighbor, uint32_t triangle)
+        {
+            for (size_t i = 0; i < Neighbors.size(); ++i)
+            {
+                if (Neighbors[i] == neighbor)
+                {
+                    ++EdgeCounts[i];
+                    EdgeTriangles[i] = triangle;
+                    return;
+                }
+            }
+
+            Neighbors.push_back(neighbor);
+            EdgeCounts.push_back(1);
+            EdgeTriangles.push_back(triangle);
+        }
+
+        void Clear()
+        {
+            Neighbors.clear();
+            EdgeCounts.clear();
+            EdgeTriangles.clear();
+        }
+    };
+
+    // Simplifies one submesh in its own local vertex numbering
+    //
+    // Topology is tracked per position rather than per vertex, so vertices split by their normals still count as
+    // one. Each pass scores every position's cheapest collapse in parallel, then applies the cheapest ones whose
+    // one-rings don't overlap
+    class SubmeshSimplifier
+    {
+    public:
+        SubmeshSimplifier(const float* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount, uint32_t firstVertex, uint32_t threadCount);
+
+        // Collapses until at most targetTriangleCount triangles remain, or nothing more can collapse
+        void Simplify(size_t targetTriangleCount);
+
+        const std::vector<uint32_t>& Indices() const { return m_indices; }
+
+        // Square root of the costliest collapse so far, back in object space units
+        float Error() const { return std::sqrt(m_maxError) * m_scale; }
+
+    private:
+        struct Collapse
+        {
+            float    Cost;
+            uint32_t From;
+            uint32_t To;
+        };
+
+        const float* Position(uint32_t p) const { return &m_positions[p * 3]; }
+        uint32_t     PositionOf(size_t corner) const { return m_positionOf[m_indices[corner]]; }
+
+        void GroupPositions(const float* vertices, size_t vertexCount);
+        void BuildAdjacency();
+        void GatherRing(uint32_t p, Ring& ring) const;
+        void ClassifyAndComputeQuadrics();
+        bool IsCollapseValid(const Collapse& collapse, Ring& fromRing, Ring& toRing) const;
+        void RemoveDegenerateTriangles();
+
+    private:
+        uint32_t                m_threadCount;
+        float                   m_scale;      // Positions are centered & scaled into the unit cube, which keeps the quadrics well conditioned in floats
+
+        std::vector<float>      m_positions;
+        std::vector<uint32_t>   m_positionOf; // Vertex to position
+        std::vector<uint32_t>   m_wedgeCounts;
+        std::vector<VertexKind> m_kinds;
+        std::vector<Quadric>    m_quadrics;
+
+        std::vector<uint32_t>   m_indices;
+        std::vector<uint32_t>   m_offsets;    // Position to its triangles, rebuilt every pass
+        std::vector<uint32_t>   m_triangles;
+        std::vector<uint32_t>   m_wedgeRemap; // Where each vertex has collapsed to
+
+        float                   m_maxError;
+    };
+
+    SubmeshSimplifier::SubmeshSimplifier(const float* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount, uint32_t firstVertex, uint32_t threadCount)
+        : m_threadCount(threadCount)
+        , m_scale(1.0f)
+        , m_indices(indexCount)
+        , m_wedgeRemap(vertexCount)
+        , m_maxError(0.0f)
+    {
+        for (size_t i = 0; i < indexCount; ++i)
+        {
+            m_indices[i] = indices[i] - firstVertex;
+        }
+
+        for (size_t v = 0; v < vertexCount; ++v)
+        {
+            m_wedgeRemap[v] = static_cast<uint32_t>(v);
+        }
+
+        GroupPositions(vertices, vertexCount);
+        RemoveDegenerateTriangles();
+        BuildAdjacency();
+        ClassifyAndComputeQuadrics();
+    }
+
+    void SubmeshSimplifier::GroupPositions(const float* vertices, size_t vertexCount)
+    {
+        float boundsMin[3] = {  FLT_MAX,  FLT_MAX,  FLT_MAX };
+        float boundsMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+        for (size_t v = 0; v < vertexCount; ++v)
+        {
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                boundsMin[axis] = std::min(boundsMin[axis], vertices[v * VertexSize + axis]);
+                boundsMax[axis] = std::max(boundsMax[axis], vertices[v * VertexSize + axis]);
+            }
+        }
+
+        float center[3];
+        float extent = 0.0f;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            center[axis] = (boundsMin[axis] + boundsMax[axis]) * 0.5f;
+            extent = std::max(extent, boundsMax[axis] - boundsMin[axis]);
+        }
+
+        m_scale = (extent > 0.0f) ? extent : 1.0f;
+
+        // Bitwise-equal positions share an id, through an open-addressing table of representative vertices
+        size_t capacity = 16;
+        while (capacity < vertexCount * 2)
+        {
+            capacity *= 2;
+        }
+
+        std::vector<uint32_t> table(capacity, InvalidIndex);
+        std::vector<uint32_t> representatives;
+
+        m_positionOf.resize(vertexCount);
+
+        for (size_t v = 0; v < vertexCount; ++v)
+        {
+            const float* position = &vertices[v * VertexSize];
+
+            uint32_t bits[3];
+            std::memcpy(bits, position, sizeof(bits));
+
+            uint64_t h = (bits[0] * 0x9E3779B97F4A7C15ull) ^ (bits[1] * 0xC2B2AE3D27D4EB4Full) ^ (bits[2] * 0x165667B19E3779F9ull);
+            size_t slot = static_cast<size_t>(h ^ (h >> 29)) & (capacity - 1);
+
+            for (;;)
+            {
+                uint32_t p = table[slot];
+                if (p == InvalidIndex)
+                {
+                    p = static_cast<uint32_t>(representatives.size());
+                    representatives.push_back(static_cast<uint32_t>(v));
+                    table[slot] = p;
+                    m_positionOf[v] = p;
+                    break;
+                }
+
+                if (std::memcmp(&vertices[representatives[p] * VertexSize], position, 3 * sizeof(float)) == 0)
+                {
+                    m_positionOf[v] = p;
+                    break;
+                }
+
+                slot = (slot + 1) & (capacity - 1);
+            }
+        }
+
+        m_positions.resize(representatives.size() * 3);
+        for (size_t p = 0; p < representatives.size(); ++p)
+        {
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                m_positions[p * 3 + axis] = (vertices[representatives[p] * VertexSize + axis] - center[axis]) / m_scale;
+            }
+        }
+
+        // Only vertices the triangles actually use count as wedges of their position
+        std::vector<uint8_t> referenced(vertexCount, 0);
+        m_wedgeCounts.assign(representatives.size(), 0);
+
+        for (uint32_t index : m_indices)
+        {
+            if (!referenced[index])
+            {
+                referenced[index] = 1;
+                ++m_wedgeCounts[m_positionOf[index]];
+            }
+        }
+    }
+
+    void SubmeshSimplifier::BuildAdjacency()
+    {
+        size_t positionCount = m_positions.size() / 3;
+
+        m_offsets.assign(positionCount + 1, 0);
+
+        for (size_t i = 0; i < m_indices.size(); ++i)
+        {
+            ++m_offsets[PositionOf(i) + 1];
+        }
+
+        for (size_t p = 0; p < positionCount; ++p)
+        {
+            m_offsets[p + 1] += m_offsets[p];
+        }
+
+        std::vector<uint32_t> cursor(m_offsets.begin(), m_offsets.end() - 1);
+        m_triangles.resize(m_indices.size());
+
+        for (size_t i = 0; i < m_indices.size(); ++i)
+        {
+            m_triangles[cursor[PositionOf(i)]++] = static_cast<uint32_t>(i / 3);
+        }
+    }
+
+    void SubmeshSimplifier::GatherRing(uint32_t p, Ring& ring) const
+    {
+        ring.Clear();
+
+        for (uint32_t i = m_offsets[p]; i < m_offsets[p + 1]; ++i)
+        {
+            uint32_t t = m_triangles[i];
+
+            for (int k = 0; k < 3; ++k)
+            {
+                uint32_t q = PositionOf(t * 3 + k);
+                if (q != p)
+                {
+                    ring.Add(q, t);
+                }
+            }
+        }
+    }
+
+    void SubmeshSimplifier::ClassifyAndComputeQuadrics()
+    {
+        size_t positionCount = m_positions.size() / 3;
+
+        m_kinds.assign(positionCount, VertexKind::Locked);
+        m_quadrics.assign(positionCount, Quadric {});
+
+        ParallelFor((positionCount + BlockSize - 1) / BlockSize, m_threadCount, [&](size_t block)
+        {
+            Ring ring;
+            size_t end = std::min(positionCount, (block + 1) * BlockSize);
+
+            for (size_t p = block * BlockSize; p < end; ++p)
+            {
+                uint32_t position = static_cast<uint32_t>(p);
+                GatherRing(position, ring);
+
+                if (ring.Neighbors.empty())
+                {
+                    continue;
+                }
+
+                Quadric& quadric = m_quadrics[p];
+
+                // Every triangle's plane, gathered from this position's side so no two workers write the same quadric
+                // The planes all pass through the position itself, so in its own frame they have no offset
+                for (uint32_t i = m_offsets[p]; i < m_offsets[p + 1]; ++i)
+                {
+                    uint32_t t = m_triangles[i];
+
+                    float normal[3];
+                    Cross(Position(PositionOf(t * 3)), Position(PositionOf(t * 3 + 1)), Position(PositionOf(t * 3 + 2)), normal);
+
+                    if (Normalize(normal))
+                    {
+                        AddPlane(quadric, normal, 0.0f, 1.0f);
+                    }
+                }
+
+                uint32_t borderEdges = 0;
+                bool     manifold    = true;
+
+                for (size_t n = 0; n < ring.Neighbors.size(); ++n)
+                {
+                    manifold &= ring.EdgeCounts[n] <= 2;
+
+                    if (ring.EdgeCounts[n] != 1)
+                    {
+                        continue;
+                    }
+
+                    ++borderEdges;
+
+                    // Open edges also pull towards the plane standing on them, so borders keep their outline
+                    uint32_t t = ring.EdgeTriangles[n];
+
+                    float faceNormal[3];
+                    Cross(Position(PositionOf(t * 3)), Position(PositionOf(t * 3 + 1)), Position(PositionOf(t * 3 + 2)), faceNormal);
+
+                    const float* a = Position(position);
+                    const float* b = Position(ring.Neighbors[n]);
+                    float edge[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+
+                    float normal[3] = { edge[1] * faceNormal[2] - edge[2] * faceNormal[1], edge[2] * faceNormal[0] - edge[0] * faceNormal[2], edge[0] * faceNormal[1] - edge[1] * faceNormal[0] };
+                    if (Normalize(normal))
+                    {
+                        AddPlane(quadric, normal, 0.0f, 1.0f);
+                    }
+                }
+
+                if (m_wedgeCounts[p] == 1 && manifold && borderEdges == 0)
+                {
+                    m_kinds[p] = VertexKind::Interior;
+                }
+                else if (m_wedgeCounts[p] == 1 && manifold && borderEdges == 2)
+                {
+                    m_kinds[p] = VertexKind::Border;
+                }
+            }
+        });
+    }
+
+    bool SubmeshSimplifier::IsCollapseValid(const Collapse& collapse, Ring& fromRing, Ring& toRing) const
+    {
+        GatherRing(collapse.From, fromRing);
+        GatherRing(collapse.To, toRing);
+
+        uint32_t sharedTriangles = 0;
+        for (size_t n = 0; n < fromRing.Neighbors.size(); ++n)
+        {
+            if (fromRing.Neighbors[n] == collapse.To)
+            {
+                sharedTriangles = fromRing.EdgeCounts[n];
+            }
+        }
+
+        // Link condition - the two ends may only have the neighbors opposite their edge in common, or the
+        // collapse would pinch the surface into a non-manifold fold
+        uint32_t commonNeighbors = 0;
+        for (uint32_t neighbor : fromRing.Neighbors)
+        {
+            commonNeighbors += std::find(toRing.Neighbors.begin(), toRing.Neighbors.end(), neighbor) != toRing.Neighbors.end();
+        }
+
+        if (commonNeighbors != sharedTriangles)
+        {
+            return false;
+        }
+
+        // None of the triangles that survive may flip over or fold flat
+        const float* target = Position(collapse.To);
+
+        for (uint32_t i = m_offsets[collapse.From]; i < m_offsets[collapse.From + 1]; ++i)
+        {
+            uint32_t t = m_triangles[i];
+
+            const float* corners[3];
+            const float* moved[3];
+            bool removed = false;
+
+            for (int k = 0; k < 3; ++k)
+            {
+                uint32_t q = PositionOf(t * 3 + k);
+                removed |= q == collapse.To;
+
+                corners[k] = Position(q);
+                moved[k]   = (q == collapse.From) ? target : corners[k];
+            }
+
+            if (removed)
+            {
+                continue;
+            }
+
+            float before[3], after[3];
+            Cross(corners[0], corners[1], corners[2], before);
+            Cross(moved[0], moved[1], moved[2], after);
+
+            if (!Normalize(before) || !Normalize(after) || before[0] * after[0] + before[1] * after[1] + before[2] * after[2] < 0.25f)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void SubmeshSimplifier::RemoveDegenerateTriangles()
+    {
+        size_t write = 0;
+
+        for (size_t i = 0; i < m_indices.size(); i += 3)
+        {
+            uint32_t a = m_wedgeRemap[m_indices[i + 0]];
+            uint32_t b = m_wedgeRemap[m_indices[i + 1]];
+            uint32_t c = m_wedgeRemap[m_indices[i + 2]];
+
+            uint32_t pa = m_positionOf[a], pb = m_positionOf[b], pc = m_positionOf[c];
+            if (pa == pb || pb == pc || pa == pc)
+            {
+                continue;
+            }
+
+            m_indices[write++] = a;
+            m_indices[write++] = b;
+            m_indices[write++] = c;
+        }
+
+        m_indices.resize(write);
+    }
+
+    void SubmeshSimplifier::Simplify(size_t targetTriangleCount)
+    {
+        size_t positionCount = m_positions.size() / 3;
+
+        std::vector<Collapse> candidates(positionCount);
+        std::vector<uint8_t>  touched(positionCount);
+
+        while (m_indices.size() / 3 > targetTriangleCount)
+        {
+            // Cheapest collapse out of every movable position; Q(from) + Q(to) measured where 'to' already is,
+            // which in their own frames is Q(from) at the offset between them plus Q(to)'s constant
+            ParallelFor((positionCount + BlockSize - 1) / BlockSize, m_threadCount, [&](size_t block)
+            {
+                Ring ring;
+                size_t end = std::min(positionCount, (block + 1) * BlockSize);
+
+                for (size_t p = block * BlockSize; p < end; ++p)
+                {
+                    Collapse& best = candidates[p];
+                    best = { FLT_MAX, static_cast<uint32_t>(p), InvalidIndex };
+
+                    if (m_kinds[p] == VertexKind::Locked || m_offsets[p] == m_offsets[p + 1])
+                    {
+                        continue;
+                    }
+
+                    const float* from = Position(static_cast<uint32_t>(p));
+
+                    auto consider = [&](uint32_t to)
+                    {
+                        const float* target = Position(to);
+                        float offset[3] = { target[0] - from[0], target[1] - from[1], target[2] - from[2] };
+
+                        float cost = Evaluate(m_quadrics[p], offset) + std::max(m_quadrics[to].D2, 0.0f);
+                        if (cost < best.Cost)
+                        {
+                            best.Cost = cost;
+                            best.To   = to;
+                        }
+                    };
+
+                    // Borders need edge counts to find their open edges; interior neighbors are simply seen twice
+                    if (m_kinds[p] == VertexKind::Border)
+                    {
+                        GatherRing(static_cast<uint32_t>(p), ring);
+
+                        for (size_t n = 0; n < ring.Neighbors.size(); ++n)
+                        {
+                            if (ring.EdgeCounts[n] == 1)
+                            {
+                                consider(ring.Neighbors[n]);
+                            }
+                        }
+
+                        continue;
+                    }
+
+                    for (uint32_t i = m_offsets[p]; i < m_offsets[p + 1]; ++i)
+                    {
+                        uint32_t t = m_triangles[i];
+
+                        for (int k = 0; k < 3; ++k)
+                        {
+                            uint32_t q = PositionOf(t * 3 + k);
+                            if (q != p)
+                            {
+                                consider(q);
+                            }
+                        }
+                    }
+                }
+            });
+
+            auto validEnd = std::remove_if(candidates.begin(), candidates.end(), [](const Collapse& c) { return c.To == InvalidIndex; });
+            size_t validCount = validEnd - candidates.begin();
+
+            if (validCount == 0)
+            {
+                break;
+            }
+
+            // Only the cheapest quarter competes each pass, so costly collapses wait for the cheap ones around them
+            auto byCost = [](const Collapse& a, const Collapse& b) { return a.Cost < b.Cost || (a.Cost == b.Cost && a.From < b.From); };
+
+            size_t considered = std::max<size_t>(validCount / 4, 1);
+            std::nth_element(candidates.begin(), candidates.begin() + (considered - 1), validEnd, byCost);
+            std::sort(candidates.begin(), candidates.begin() + considered, byCost);
+
+            // Topology & flip checks only read this pass' state, so they all run up front
+            ParallelFor((considered + BlockSize - 1) / BlockSize, m_threadCount, [&](size_t block)
+            {
+                Ring fromRing, toRing;
+                size_t end = std::min(considered, (block + 1) * BlockSize);
+
+                for (size_t c = block * BlockSize; c < end; ++c)
+                {
+                    if (!IsCollapseValid(candidates[c], fromRing, toRing))
+                    {
+                        candidates[c].To = InvalidIndex;
+                    }
+                }
+            });
+
+            std::fill(touched.begin(), touched.end(), 0);
+
+            size_t goal    = m_indices.size() / 3 - targetTriangleCount;
+            size_t removed = 0;
+
+            for (size_t c = 0; c < considered && removed < goal; ++c)
+            {
+                const Collapse& collapse = candidates[c];
+
+                if (collapse.To == InvalidIndex || touched[collapse.From] || touched[collapse.To])
+                {
+                    continue;
+                }
+
+                // A movable position has a single vertex, which takes over the target's vertex on their shared edge
+                // Nothing else around it may change in this pass
+                for (uint32_t i = m_offsets[collapse.From]; i < m_offsets[collapse.From + 1]; ++i)
+                {
+                    const uint32_t* triangle = &m_indices[m_triangles[i] * 3];
+
+                    uint32_t fromVertex = InvalidIndex, toVertex = InvalidIndex;
+                    for (int k = 0; k < 3; ++k)
+                    {
+                        if (m_positionOf[triangle[k]] == collapse.From) fromVertex = triangle[k];
+                        if (m_positionOf[triangle[k]] == collapse.To)   toVertex   = triangle[k];
+
+                        touched[m_positionOf[triangle[k]]] = 1;
+                    }
+
+                    if (toVertex != InvalidIndex)
+                    {
+                        m_wedgeRemap[fromVertex] = toVertex;
+                        removed += 1;
+                    }
+                }
+
+                const float* from = Position(collapse.From);
+                const float* to   = Position(collapse.To);
+                float offset[3] = { to[0] - from[0], to[1] - from[1], to[2] - from[2] };
+
+                AddQuadric(m_quadrics[collapse.To], m_quadrics[collapse.From], offset);
+                m_kinds[collapse.From] = VertexKind::Locked;
+                m_maxError = std::max(m_maxError, collapse.Cost);
+            }
+
+            if (removed == 0)
+            {
+                break;
+            }
+
+            candidates.resize(positionCount);
+
+            RemoveDegenerateTriangles();
+            BuildAdjacency();
+        }
+    }
+}
+
+
+void BuildLodChain(Mesh& mesh, const MeshLodOptions& options)
+{
+    bool shortIndices = mesh.IndexSize == sizeof(uint16_t);
+    WidenIndices(mesh);
+
+    // Meshes built by hand may have no submesh table - treat them as a single submesh
+    std::vector<Submesh> ranges = mesh.Submeshes;
+    if (ranges.empty())
+    {
+        Submesh whole {};
+        whole.IndexCount  = static_cast<uint32_t>(mesh.IndexBuffer.size());
+        whole.VertexCount = static_cast<uint32_t>(mesh.VertexBuffer.size() / VertexSize);
+        whole.BoundsMin   = mesh.BoundsMin;
+        whole.BoundsMax   = mesh.BoundsMax;
+        ranges.push_back(whole);
+    }
+
+    // Drop the indices of any previous chain
+    uint32_t fullDetailEnd = 0;
+    for (const Submesh& submesh : ranges)
+    {
+        fullDetailEnd = std::max(fullDetailEnd, submesh.FirstIndex + submesh.IndexCount);
+    }
+
+    mesh.IndexBuffer.resize(fullDetailEnd);
+    mesh.Lods.clear();
+
+    const size_t lodCount = options.TriangleRatios.size();
+
+    std::vector<std::vector<std::vector<uint32_t>>> lodIndices(ranges.size(), std::vector<std::vector<uint32_t>>(lodCount));
+    std::vector<std::vector<float>>                 lodErrors(ranges.size(), std::vector<float>(lodCount));
+
+    auto simplifySubmesh = [&](size_t s, uint32_t threadCount)
+    {
+        const Submesh& submesh = ranges[s];
+
+        SubmeshSimplifier simplifier(&mesh.VertexBuffer[submesh.FirstVertex * VertexSize], submesh.VertexCount,
+            &mesh.IndexBuffer[submesh.FirstIndex], submesh.IndexCount, submesh.FirstVertex, threadCount);
+
+        for (size_t l = 0; l < lodCount; ++l)
+        {
+            simplifier.Simplify(static_cast<size_t>(submesh.IndexCount / 3 * options.TriangleRatios[l]));
+
+            std::vector<uint32_t>& indices = lodIndices[s][l];
+            indices = simplifier.Indices();
+
+            OptimizeVertexCache(indices.data(), indices.size(), submesh.VertexCount, LodCacheSize);
+
+            for (uint32_t& index : indices)
+            {
+                index += submesh.FirstVertex;
+            }
+
+            lodErrors[s][l] = simplifier.Error();
+        }
+    };
+
+    // Large submeshes take every worker in turn; the rest are spread across the workers one per submesh
+    std::vector<size_t> smallSubmeshes;
+    for (size_t s = 0; s < ranges.size(); ++s)
+    {
+        if (ranges[s].IndexCount / 3 >= LargeSubmeshTriangles)
+        {
+            simplifySubmesh(s, options.ThreadCount);
+        }
+        else
+        {
+            smallSubmeshes.push_back(s);
+        }
+    }
+
+    ParallelFor(smallSubmeshes.size(), options.ThreadCount, [&](size_t i)
+    {
+        simplifySubmesh(smallSubmeshes[i], 1);
+    });
+
+    mesh.Lods.resize(lodCount);
+
+    for (size_t l = 0; l < lodCount; ++l)
+    {
+        MeshLod& lod = mesh.Lods[l];
+        lod.Error = 0.0f;
+
+        for (size_t s = 0; s < ranges.size(); ++s)
+        {
+            Submesh submesh = ranges[s];
+            submesh.FirstIndex = static_cast<uint32_t>(mesh.IndexBuffer.size());
+            submesh.IndexCount = static_cast<uint32_t>(lodIndices[s][l].size());
+
+            mesh.IndexBuffer.insert(mesh.IndexBuffer.end(), lodIndices[s][l].begin(), lodIndices[s][l].end());
+            lod.Submeshes.push_back(submesh);
+
+            lod.Error = std::max(lod.Error, lodErrors[s][l]);
+        }
+    }
+
+    if (shortIndices)
+    {
+        ShortenIndices(mesh);
+    }
+}
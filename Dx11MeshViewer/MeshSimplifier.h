@@ -0,0 +1,28 @@
+//
+// MeshSimplifier.h
+//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+struct Mesh;
+
+struct MeshLodOptions
+{
+    std::vector<float> TriangleRatios = { 0.5f, 0.25f, 0.125f, 0.0625f }; // Target share of full detail triangles, per level
+    uint32_t           ThreadCount    = 0;                                // 0 uses every hardware thread
+};
+
+// Builds mesh.Lods by quadric error edge collapse (Garland & Heckbert 1997), each level continuing from the last
+//
+// Vertices are only ever collapsed onto a neighbor, so every level indexes the existing vertex buffer and their
+// indices are appended to the index buffer. Positions shared by several vertices (normal seams) and non-manifold
+// vertices stay fixed, and open borders only collapse along themselves, so levels never crack apart. A level that
+// can't reach its target keeps the closest count it could. Each level is also reordered for the vertex cache.
+//
+// Small submeshes are simplified concurrently, large ones one at a time with the work within them spread out.
+// Run it last - OptimizeMesh & BuildMeshlets only know about the full detail ranges.
+// Accepts either index size, and leaves it as it found it
+void BuildLodChain(Mesh& mesh, const MeshLodOptions& options = {});
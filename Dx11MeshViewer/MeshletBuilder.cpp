@@ -0,0 +1,394 @@
+//
+// MeshletBuilder.cpp
+//
+
+#include "pch.h"
+#include "MeshletBuilder.h"
+#include "MeshLoader.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+using DirectX::XMFLOAT3;
+
+namespace
+{
+    const uint32_t InvalidIndex = ~0u;
+    const size_t   VertexSize   = 6;
+
+    // Unused triangles around each vertex - used ones are swapped out past LiveCounts, so the meshlet's interior
+    // vertices stop costing anything to scan
+    struct LiveAdjacency
+    {
+        std::vector<uint32_t> Offsets;
+        std::vector<uint32_t> LiveCounts;
+        std::vector<uint32_t> Triangles;
+
+        void Build(const uint32_t* indices, size_t indexCount, size_t vertexCount)
+        {
+            Offsets.assign(vertexCount + 1, 0);
+            LiveCounts.assign(vertexCount, 0);
+
+            for (size_t i = 0; i < indexCount; ++i)
+            {
+                ++LiveCounts[indices[i]];
+            }
+
+            for (size_t v = 0; v < vertexCount; ++v)
+            {
+                Offsets[v + 1] = Offsets[v] + LiveCounts[v];
+            }
+
+            std::vector<uint32_t> cursor(Offsets.begin(), Offsets.end() - 1);
+            Triangles.resize(indexCount);
+
+            for (size_t i = 0; i < indexCount; ++i)
+            {
+                Triangles[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+
+        void Remove(const uint32_t* triangle, uint32_t t)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                uint32_t  v    = triangle[k];
+                uint32_t* list = &Triangles[Offsets[v]];
+                uint32_t& live = LiveCounts[v];
+
+                for (uint32_t i = 0; i < live; ++i)
+                {
+                    if (list[i] == t)
+                    {
+                        std::swap(list[i], list[live - 1]);
+                        --live;
+                        break;
+                    }
+                }
+            }
+        }
+    };
+
+    void Normalize(float* v)
+    {
+        float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+        if (length > 0.0f)
+        {
+            v[0] /= length;
+            v[1] /= length;
+            v[2] /= length;
+        }
+    }
+
+    // Bounds & normal cone over the meshlet's triangles - indices are submesh-local, vertices the submesh's own
+    void ComputeMeshletBounds(const uint32_t* indices, size_t indexCount, const float* vertices, Meshlet& meshlet)
+    {
+        float boundsMin[3] = {  FLT_MAX,  FLT_MAX,  FLT_MAX };
+        float boundsMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+        for (size_t i = 0; i < indexCount; ++i)
+        {
+            const float* p = &vertices[indices[i] * VertexSize];
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                boundsMin[axis] = std::min(boundsMin[axis], p[axis]);
+                boundsMax[axis] = std::max(boundsMax[axis], p[axis]);
+            }
+        }
+
+        float center[3];
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            center[axis] = (boundsMin[axis] + boundsMax[axis]) * 0.5f;
+        }
+
+        float radiusSq = 0.0f;
+        for (size_t i = 0; i < indexCount; ++i)
+        {
+            const float* p = &vertices[indices[i] * VertexSize];
+            float dx = p[0] - center[0], dy = p[1] - center[1], dz = p[2] - center[2];
+            radiusSq = std::max(radiusSq, dx * dx + dy * dy + dz * dz);
+        }
+
+        // Face normals follow the winding - counter-clockwise triangles face their cross product, as in OBJ
+        std::vector<float> normals;
+        normals.reserve(indexCount);
+
+        float axis[3] = {};
+        for (size_t i = 0; i < indexCount; i += 3)
+        {
+            const float* a = &vertices[indices[i + 0] * VertexSize];
+            const float* b = &vertices[indices[i + 1] * VertexSize];
+            const float* c = &vertices[indices[i + 2] * VertexSize];
+
+            float e0[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+            float e1[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+            float n[3]  = { e0[1] * e1[2] - e0[2] * e1[1], e0[2] * e1[0] - e0[0] * e1[2], e0[0] * e1[1] - e0[1] * e1[0] };
+
+            if (n[0] == 0.0f && n[1] == 0.0f && n[2] == 0.0f)
+            {
+                continue; // Degenerate - faces nowhere, so can't be back-facing either
+            }
+
+            Normalize(n);
+            normals.insert(normals.end(), n, n + 3);
+
+            axis[0] += n[0];
+            axis[1] += n[1];
+            axis[2] += n[2];
+        }
+
+        Normalize(axis);
+
+        float cutoff = normals.empty() ? 0.0f : 1.0f;
+        for (size_t i = 0; i < normals.size(); i += 3)
+        {
+            cutoff = std::min(cutoff, normals[i] * axis[0] + normals[i + 1] * axis[1] + normals[i + 2] * axis[2]);
+        }
+
+        meshlet.BoundsMin  = XMFLOAT3(boundsMin[0], boundsMin[1], boundsMin[2]);
+        meshlet.BoundsMax  = XMFLOAT3(boundsMax[0], boundsMax[1], boundsMax[2]);
+        meshlet.Center     = XMFLOAT3(center[0], center[1], center[2]);
+        meshlet.Radius     = std::sqrt(radiusSq);
+        meshlet.ConeAxis   = XMFLOAT3(axis[0], axis[1], axis[2]);
+        meshlet.ConeCutoff = cutoff;
+    }
+
+    // Partitions one submesh, whose indices have been made local to its vertex range
+    void BuildSubmeshMeshlets(uint32_t* indices, size_t indexCount, const float* vertices, size_t vertexCount, const MeshletBuildOptions& options, std::vector<Meshlet>& outMeshlets)
+    {
+        const size_t triangleCount = indexCount / 3;
+
+        LiveAdjacency adjacency;
+        adjacency.Build(indices, indexCount, vertexCount);
+
+        std::vector<uint8_t>  used(triangleCount, 0);
+        std::vector<uint32_t> vertexMeshlet(vertexCount, InvalidIndex); // Which meshlet last took each vertex
+
+        std::vector<uint32_t> frontier;         // Meshlet vertices that may still have unused triangles
+        std::vector<uint32_t> meshletTriangles;
+        size_t                meshletVertexCount = 0;
+        std::vector<uint32_t> orderedTriangles;
+        orderedTriangles.reserve(triangleCount);
+
+        size_t   seedCursor   = 0;
+        uint32_t meshletIndex = 0;
+
+        auto addTriangle = [&](uint32_t t)
+        {
+            const uint32_t* triangle = &indices[t * 3];
+            for (int k = 0; k < 3; ++k)
+            {
+                if (vertexMeshlet[triangle[k]] != meshletIndex)
+                {
+                    vertexMeshlet[triangle[k]] = meshletIndex;
+                    frontier.push_back(triangle[k]);
+                    ++meshletVertexCount;
+                }
+            }
+
+            used[t] = 1;
+            adjacency.Remove(triangle, t);
+            meshletTriangles.push_back(t);
+        };
+
+        auto newVertexCount = [&](uint32_t t)
+        {
+            const uint32_t* triangle = &indices[t * 3];
+            return uint32_t(vertexMeshlet[triangle[0]] != meshletIndex) + uint32_t(vertexMeshlet[triangle[1]] != meshletIndex) + uint32_t(vertexMeshlet[triangle[2]] != meshletIndex);
+        };
+
+        auto closeMeshlet = [&]()
+        {
+            // Restore the incoming order within the meshlet, which is what vertex cache optimization arranged
+            std::sort(meshletTriangles.begin(), meshletTriangles.end());
+
+            Meshlet meshlet {};
+            meshlet.FirstIndex  = static_cast<uint32_t>(orderedTriangles.size() * 3);
+            meshlet.IndexCount  = static_cast<uint32_t>(meshletTriangles.size() * 3);
+            meshlet.VertexCount = static_cast<uint32_t>(meshletVertexCount);
+            outMeshlets.push_back(meshlet);
+
+            orderedTriangles.insert(orderedTriangles.end(), meshletTriangles.begin(), meshletTriangles.end());
+
+            frontier.clear();
+            meshletTriangles.clear();
+            meshletVertexCount = 0;
+            ++meshletIndex;
+        };
+
+        while (orderedTriangles.size() + meshletTriangles.size() < triangleCount)
+        {
+            // Vertices with nothing left around them are interior now, and drop out of the scan for good
+            frontier.erase(std::remove_if(frontier.begin(), frontier.end(), [&](uint32_t v) { return adjacency.LiveCounts[v] == 0; }), frontier.end());
+
+            // Best unused triangle touching the meshlet: fewest new vertices, then fewest remaining neighbors, so
+            // the growth front stays compact instead of snaking along open edges. One that adds no vertices is
+            // taken straight away
+            uint32_t best     = InvalidIndex;
+            uint32_t bestNew  = 4;
+            uint32_t bestLive = ~0u;
+
+            for (size_t f = 0; f < frontier.size() && bestNew > 0; ++f)
+            {
+                uint32_t v = frontier[f];
+                const uint32_t* list = &adjacency.Triangles[adjacency.Offsets[v]];
+
+                for (uint32_t i = 0; i < adjacency.LiveCounts[v]; ++i)
+                {
+                    uint32_t t = list[i];
+                    uint32_t added = newVertexCount(t);
+
+                    if (meshletVertexCount + added > options.MaxVertices || added > bestNew)
+                    {
+                        continue;
+                    }
+
+                    const uint32_t* triangle = &indices[t * 3];
+                    uint32_t live = adjacency.LiveCounts[triangle[0]] + adjacency.LiveCounts[triangle[1]] + adjacency.LiveCounts[triangle[2]];
+
+                    if (added < bestNew || live < bestLive)
+                    {
+                        best     = t;
+                        bestNew  = added;
+                        bestLive = live;
+                    }
+                }
+            }
+
+            // Nothing connected fits - a mostly empty meshlet continues with the next triangle in submesh order,
+            // which after cache optimization is usually close by; otherwise it's done
+            if (best == InvalidIndex && !meshletTriangles.empty() && meshletTriangles.size() * 2 >= options.MaxTriangles)
+            {
+                closeMeshlet();
+                continue;
+            }
+
+            if (best == InvalidIndex)
+            {
+                while (used[seedCursor])
+                {
+                    ++seedCursor;
+                }
+
+                if (meshletVertexCount + newVertexCount(static_cast<uint32_t>(seedCursor)) > options.MaxVertices)
+                {
+                    closeMeshlet();
+                    continue;
+                }
+
+                best = static_cast<uint32_t>(seedCursor);
+            }
+
+            addTriangle(best);
+
+            if (meshletTriangles.size() >= options.MaxTriangles)
+            {
+                closeMeshlet();
+            }
+        }
+
+        if (!meshletTriangles.empty())
+        {
+            closeMeshlet();
+        }
+
+        std::vector<uint32_t> reordered(indexCount);
+        for (size_t i = 0; i < orderedTriangles.size(); ++i)
+        {
+            std::copy_n(&indices[orderedTriangles[i] * 3], 3, &reordered[i * 3]);
+        }
+
+        std::copy(reordered.begin(), reordered.end(), indices);
+
+        for (Meshlet& meshlet : outMeshlets)
+        {
+            ComputeMeshletBounds(&indices[meshlet.FirstIndex], meshlet.IndexCount, vertices, meshlet);
+        }
+    }
+}
+
+
+void BuildMeshlets(Mesh& mesh, const MeshletBuildOptions& options)
+{
+    bool shortIndices = mesh.IndexSize == sizeof(uint16_t);
+    WidenIndices(mesh);
+
+    std::vector<std::vector<Meshlet>> submeshMeshlets(mesh.Submeshes.size());
+
+    ParallelFor(mesh.Submeshes.size(), options.ThreadCount, [&](size_t s)
+    {
+        const Submesh& submesh = mesh.Submeshes[s];
+
+        uint32_t* indices = &mesh.IndexBuffer[submesh.FirstIndex];
+        const float* vertices = &mesh.VertexBuffer[submesh.FirstVertex * VertexSize];
+
+        // Work in submesh-local vertex numbering so the per-vertex tables only span this submesh
+        for (uint32_t i = 0; i < submesh.IndexCount; ++i)
+        {
+            indices[i] -= submesh.FirstVertex;
+        }
+
+        BuildSubmeshMeshlets(indices, submesh.IndexCount, vertices, submesh.VertexCount, options, submeshMeshlets[s]);
+
+        for (uint32_t i = 0; i < submesh.IndexCount; ++i)
+        {
+            indices[i] += submesh.FirstVertex;
+        }
+
+        for (Meshlet& meshlet : submeshMeshlets[s])
+        {
+            meshlet.FirstIndex += submesh.FirstIndex;
+        }
+    });
+
+    mesh.Meshlets.clear();
+    for (const auto& meshlets : submeshMeshlets)
+    {
+        mesh.Meshlets.insert(mesh.Meshlets.end(), meshlets.begin(), meshlets.end());
+    }
+
+    if (shortIndices)
+    {
+        ShortenIndices(mesh);
+    }
+}
+
+bool IsMeshletBackfacing(const Meshlet& meshlet, const XMFLOAT3& cameraPosition)
+{
+    if (meshlet.ConeCutoff <= 0.0f)
+    {
+        return false;
+    }
+
+    float d[3] = { meshlet.Center.x - cameraPosition.x, meshlet.Center.y - cameraPosition.y, meshlet.Center.z - cameraPosition.z };
+    float distance = std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+
+    if (distance <= meshlet.Radius)
+    {
+        return false;
+    }
+
+    // Every point of the sphere is seen within asin(Radius / distance) of its center, and every normal lies within
+    // acos(ConeCutoff) of the axis - all triangles face away while those two angles plus the axis' own angle from
+    // the view direction stay under 90 degrees
+    float sinSphere = meshlet.Radius / distance;
+    float cosSphere = std::sqrt(1.0f - sinSphere * sinSphere);
+    float cosCone   = meshlet.ConeCutoff;
+    float sinCone   = std::sqrt(std::max(0.0f, 1.0f - cosCone * cosCone));
+
+    // Cosine & sine of the cone and sphere angles combined
+    float cosSpread = cosCone * cosSphere - sinCone * sinSphere;
+    float sinSpread = sinCone * cosSphere + cosCone * sinSphere;
+
+    if (cosSpread <= 0.0f)
+    {
+        return false;
+    }
+
+    float cosView = (d[0] * meshlet.ConeAxis.x + d[1] * meshlet.ConeAxis.y + d[2] * meshlet.ConeAxis.z) / distance;
+
+    return cosView > sinSpread;
+}
@@ -0,0 +1,30 @@
+//
+// MeshletBuilder.h
+//
+
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstdint>
+
+struct Mesh;
+struct Meshlet;
+
+struct MeshletBuildOptions
+{
+    uint32_t MaxVertices  = 64;
+    uint32_t MaxTriangles = 124;
+    uint32_t ThreadCount  = 0; // Submeshes are partitioned concurrently; 0 uses every hardware thread
+};
+
+// Partitions every submesh into meshlets, replacing mesh.Meshlets
+//
+// Meshlets grow greedily across shared vertices, preferring triangles that add the fewest new ones. Each meshlet's
+// triangles are then regrouped into one index range, keeping their previous relative order so earlier vertex cache
+// optimization still mostly holds - run it after OptimizeMesh, which would scatter the ranges again.
+// Accepts either index size, and leaves it as it found it
+void BuildMeshlets(Mesh& mesh, const MeshletBuildOptions& options = {});
+
+// Whether every triangle of the meshlet faces away from a camera at cameraPosition, given in the mesh's object space
+// Conservative - also accounts for the meshlet's extent through its bounding sphere
+bool IsMeshletBackfacing(const Meshlet& meshlet, const DirectX::XMFLOAT3& cameraPosition);
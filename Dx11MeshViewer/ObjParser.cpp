@@ -0,0 +1,837 @@
+//
+// ObjParser.cpp
+//
+
+#include "pch.h"
+#include "ObjParser.h"
+#include "FloatParser.h"
+#include "MappedFile.h"
+#include "Parallel.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+namespace
+{
+    const size_t MinChunkSize = 1 << 20; // Files below this aren't worth splitting
+
+    // Parse results of a single chunk - indices stay chunk-local until stitched
+    struct ObjChunk
+    {
+        const char*            Begin = nullptr;
+        const char*            End = nullptr;
+
+        bool                   ParseAttributes = true; // Otherwise 'v'/'vn' records are only counted
+        bool                   ParseFaces = true;
+
+        // Where the chunk's 'v' & 'vn' records are parsed to, sized from a CountChunk pass
+        float*                 Positions = nullptr;
+        float*                 Normals = nullptr;
+        int64_t                PositionCount = 0;
+        int64_t                NormalCount = 0;
+        int64_t                TexcoordCount = 0;
+
+        std::vector<ObjCorner> FaceCorners;  // Face corners as written, before triangulation
+        std::vector<uint32_t>  FaceSizes;    // Corner count of each face
+        size_t                 FaceCount = 0;       // Counted instead when faces aren't parsed
+        size_t                 FaceCornerCount = 0;
+        std::vector<size_t>    ShapeBreaks;  // Face count at each 'o'/'g' record
+
+        // Relative (negative) indices are resolved against the chunk-local record count, then
+        // offset by the record count of all preceding chunks during the stitch
+        std::vector<size_t>    RelativePositions;
+        std::vector<size_t>    RelativeNormals;
+        int64_t                MinRelativeTexcoord = 0;
+
+        std::vector<size_t>    CornerBreaks; // ShapeBreaks translated to offsets among the chunk's triangulated corners
+
+        HRESULT                Result = S_OK;
+    };
+
+    inline bool IsSpace(char c) { return c == ' ' || c == '\t'; }
+    inline bool IsDigit(char c) { return static_cast<unsigned int>(c - '0') < 10u; }
+
+    inline const char* SkipSpace(const char* p, const char* end)
+    {
+        while (p < end && IsSpace(*p))
+        {
+            ++p;
+        }
+        return p;
+    }
+
+    // Mirrors atoi(), which tinyobjloader uses for face indices
+    int ParseInt(const char* p, const char* end)
+    {
+        while (p < end && (IsSpace(*p) || *p == '\v' || *p == '\f'))
+        {
+            ++p;
+        }
+
+        bool negative = false;
+        if (p < end && (*p == '+' || *p == '-'))
+        {
+            negative = (*p == '-');
+            ++p;
+        }
+
+        int64_t value = 0;
+        while (p < end && IsDigit(*p) && value <= INT32_MAX)
+        {
+            value = value * 10 + (*p - '0');
+            ++p;
+        }
+
+        value = negative ? -value : value;
+        return static_cast<int>(std::min<int64_t>(std::max<int64_t>(value, INT32_MIN), INT32_MAX));
+    }
+
+    inline const char* SkipIndex(const char* p, const char* end)
+    {
+        while (p < end && *p != '/' && !IsSpace(*p))
+        {
+            ++p;
+        }
+        return p;
+    }
+
+    // Mirrors tinyobj::fixIndex - converts a one-based (or negative, relative) OBJ index to zero-based
+    inline bool FixIndex(int idx, int64_t count, bool allowZero, int64_t& outIndex, bool& outRelative)
+    {
+        outRelative = idx < 0;
+        outIndex = outRelative ? count + idx : static_cast<int64_t>(idx) - 1;
+        return idx != 0 || allowZero;
+    }
+
+    // Parses one i, i/j, i//k or i/j/k face corner
+    bool ParseCorner(const char*& p, const char* end, ObjChunk& chunk)
+    {
+        size_t cornerIndex = chunk.FaceCorners.size();
+
+        ObjCorner corner{ -1, -1 };
+        int64_t   index = 0;
+        bool      relative = false;
+
+        if (!FixIndex(ParseInt(p, end), chunk.PositionCount, false, index, relative))
+        {
+            return false;
+        }
+
+        corner.Position = static_cast<int32_t>(index);
+        if (relative)
+        {
+            chunk.RelativePositions.push_back(cornerIndex);
+        }
+
+        p = SkipIndex(p, end);
+        if (p < end && *p == '/')
+        {
+            ++p;
+
+            // Texcoords aren't loaded, but relative ones must still be validated
+            if (p >= end || *p != '/')
+            {
+                FixIndex(ParseInt(p, end), chunk.TexcoordCount, true, index, relative);
+                if (relative)
+                {
+                    chunk.MinRelativeTexcoord = std::min(chunk.MinRelativeTexcoord, index);
+                }
+
+                p = SkipIndex(p, end);
+            }
+
+            if (p < end && *p == '/')
+            {
+                ++p;
+
+                FixIndex(ParseInt(p, end), chunk.NormalCount, true, index, relative);
+
+                corner.Normal = static_cast<int32_t>(index);
+                if (relative)
+                {
+                    chunk.RelativeNormals.push_back(cornerIndex);
+                }
+
+                p = SkipIndex(p, end);
+            }
+        }
+
+        chunk.FaceCorners.push_back(corner);
+        return true;
+    }
+
+    // Handles a single line, following the record matching order of tinyobj::LoadObj
+    HRESULT ParseLine(const char* p, const char* end, ObjChunk& chunk)
+    {
+        p = SkipSpace(p, end);
+
+        if (p == end || p[0] == '#')
+        {
+            return S_OK;
+        }
+
+        size_t length = end - p;
+        char   c0 = p[0];
+        char   c1 = length > 1 ? p[1] : '\0';
+        char   c2 = length > 2 ? p[2] : '\0';
+
+        // Position
+        if (c0 == 'v' && IsSpace(c1))
+        {
+            ++chunk.PositionCount;
+
+            p += 2;
+            for (int k = 0; k < 3 && chunk.ParseAttributes; ++k)
+            {
+                chunk.Positions[(chunk.PositionCount - 1) * 3 + k] = ParseObjReal(p, end, chunk.End);
+            }
+            return S_OK;
+        }
+
+        // Normal
+        if (c0 == 'v' && c1 == 'n' && IsSpace(c2))
+        {
+            ++chunk.NormalCount;
+
+            p += 3;
+            for (int k = 0; k < 3 && chunk.ParseAttributes; ++k)
+            {
+                chunk.Normals[(chunk.NormalCount - 1) * 3 + k] = ParseObjReal(p, end, chunk.End);
+            }
+            return S_OK;
+        }
+
+        // Texcoord
+        if (c0 == 'v' && c1 == 't' && IsSpace(c2))
+        {
+            ++chunk.TexcoordCount;
+            return S_OK;
+        }
+
+        // Lines & points need tinyobjloader
+        if ((c0 == 'l' || c0 == 'p') && IsSpace(c1))
+        {
+            return E_NOTIMPL;
+        }
+
+        // Face
+        if (c0 == 'f' && IsSpace(c1))
+        {
+            if (!chunk.ParseFaces)
+            {
+                // One corner per run of non-space characters, as ParseCorner reads them
+                for (p = SkipSpace(p + 2, end); p < end; p = SkipSpace(p, end))
+                {
+                    ++chunk.FaceCornerCount;
+                    while (p < end && !IsSpace(*p))
+                    {
+                        ++p;
+                    }
+                }
+
+                ++chunk.FaceCount;
+                return S_OK;
+            }
+
+            p = SkipSpace(p + 2, end);
+
+            uint32_t faceSize = 0;
+            while (p < end)
+            {
+                if (!ParseCorner(p, end, chunk))
+                {
+                    return E_FAIL;
+                }
+
+                ++faceSize;
+                p = SkipSpace(p, end);
+            }
+
+            // tinyobjloader ear-clips larger polygons
+            if (faceSize > 4)
+            {
+                return E_NOTIMPL;
+            }
+
+            chunk.FaceSizes.push_back(faceSize);
+            return S_OK;
+        }
+
+        // Group & object names start a new shape
+        if ((c0 == 'g' || c0 == 'o') && IsSpace(c1))
+        {
+            chunk.ShapeBreaks.push_back(chunk.FaceSizes.size());
+            return S_OK;
+        }
+
+        // Everything else (materials, smoothing groups, tags) doesn't affect the geometry
+        return S_OK;
+    }
+
+    void ParseChunk(ObjChunk& chunk)
+    {
+        const char* line = chunk.Begin;
+
+        while (line < chunk.End && SUCCEEDED(chunk.Result))
+        {
+            // tinyobjloader treats a lone '\r' as a line ending too
+            const char* lineEnd = line;
+            while (lineEnd < chunk.End && *lineEnd != '\n' && *lineEnd != '\r')
+            {
+                ++lineEnd;
+            }
+
+            chunk.Result = ParseLine(line, lineEnd, chunk);
+            line = lineEnd + 1;
+        }
+    }
+
+    // Counts the chunk's records without parsing them, so the arrays they're parsed into can be sized first
+    void CountChunk(ObjChunk& chunk)
+    {
+        ObjChunk counter;
+        counter.Begin = chunk.Begin;
+        counter.End = chunk.End;
+        counter.ParseAttributes = false;
+        counter.ParseFaces = false;
+
+        ParseChunk(counter);
+
+        chunk.PositionCount = counter.PositionCount;
+        chunk.NormalCount = counter.NormalCount;
+        chunk.FaceCount = counter.FaceCount;
+        chunk.FaceCornerCount = counter.FaceCornerCount;
+        chunk.Result = counter.Result;
+    }
+
+    inline bool IsValidQuad(const ObjCorner* face, size_t positionCount)
+    {
+        return static_cast<size_t>(face[0].Position) < positionCount && static_cast<size_t>(face[1].Position) < positionCount &&
+               static_cast<size_t>(face[2].Position) < positionCount && static_cast<size_t>(face[3].Position) < positionCount;
+    }
+
+    // Corners TriangulateChunk will write for the chunk's faces
+    size_t CountTriangulatedCorners(const ObjChunk& chunk, size_t positionCount)
+    {
+        size_t count = 0;
+        size_t first = 0;
+
+        for (size_t f = 0; f < chunk.FaceSizes.size(); first += chunk.FaceSizes[f], ++f)
+        {
+            if (chunk.FaceSizes[f] == 3)
+            {
+                count += 3;
+            }
+            else if (chunk.FaceSizes[f] == 4 && IsValidQuad(&chunk.FaceCorners[first], positionCount))
+            {
+                count += 6;
+            }
+        }
+
+        return count;
+    }
+
+    // Splits faces into triangles the way tinyobj::exportGroupsToShape does, writing CountTriangulatedCorners corners to
+    // outCorners, then validates the final indices
+    void TriangulateChunk(ObjChunk& chunk, const float* v, size_t positionCount, size_t normalCount, ObjCorner* outCorners)
+    {
+        ObjCorner* out = outCorners;
+
+        size_t breakIndex = 0;
+        size_t first = 0;
+
+        for (size_t f = 0; f < chunk.FaceSizes.size(); first += chunk.FaceSizes[f], ++f)
+        {
+            while (breakIndex < chunk.ShapeBreaks.size() && chunk.ShapeBreaks[breakIndex] == f)
+            {
+                chunk.CornerBreaks.push_back(out - outCorners);
+                ++breakIndex;
+            }
+
+            const ObjCorner* face = &chunk.FaceCorners[first];
+
+            if (chunk.FaceSizes[f] == 3)
+            {
+                out = std::copy(face, face + 3, out);
+            }
+            else if (chunk.FaceSizes[f] == 4)
+            {
+                // Invalid quads are skipped rather than failing the load
+                if (!IsValidQuad(face, positionCount))
+                {
+                    continue;
+                }
+
+                size_t vi[4];
+                for (int k = 0; k < 4; ++k)
+                {
+                    vi[k] = static_cast<size_t>(face[k].Position);
+                }
+
+                // Split along the shorter diagonal
+                float e02x = v[vi[2] * 3 + 0] - v[vi[0] * 3 + 0];
+                float e02y = v[vi[2] * 3 + 1] - v[vi[0] * 3 + 1];
+                float e02z = v[vi[2] * 3 + 2] - v[vi[0] * 3 + 2];
+                float e13x = v[vi[3] * 3 + 0] - v[vi[1] * 3 + 0];
+                float e13y = v[vi[3] * 3 + 1] - v[vi[1] * 3 + 1];
+                float e13z = v[vi[3] * 3 + 2] - v[vi[1] * 3 + 2];
+
+                float sqr02 = e02x * e02x + e02y * e02y + e02z * e02z;
+                float sqr13 = e13x * e13x + e13y * e13y + e13z * e13z;
+
+                if (sqr02 < sqr13)
+                {
+                    ObjCorner tris[] = { face[0], face[1], face[2], face[0], face[2], face[3] };
+                    out = std::copy(tris, tris + 6, out);
+                }
+                else
+                {
+                    ObjCorner tris[] = { face[0], face[1], face[3], face[1], face[2], face[3] };
+                    out = std::copy(tris, tris + 6, out);
+                }
+            }
+            // Faces with fewer than three corners are degenerate and dropped
+        }
+
+        while (breakIndex < chunk.ShapeBreaks.size())
+        {
+            chunk.CornerBreaks.push_back(out - outCorners);
+            ++breakIndex;
+        }
+
+        for (const ObjCorner* corner = outCorners; corner < out; ++corner)
+        {
+            if (corner->Position < 0 || static_cast<size_t>(corner->Position) >= positionCount ||
+                corner->Normal < 0 || static_cast<size_t>(corner->Normal) >= normalCount)
+            {
+                chunk.Result = E_FAIL;
+                break;
+            }
+        }
+
+        std::vector<ObjCorner>().swap(chunk.FaceCorners);
+        std::vector<uint32_t>().swap(chunk.FaceSizes);
+    }
+
+    // Reads a file through a bounded buffer, handing each run of whole lines to onWindow as [begin, end)
+    template <class Fn>
+    HRESULT ForEachWindow(const char* filename, size_t windowSize, Fn onWindow)
+    {
+        std::ifstream file(filename, std::ios::binary | std::ios::ate);
+        if (!file)
+        {
+            return E_FAIL;
+        }
+
+        // Small files are read in one go, without allocating the whole window
+        auto fileSize = static_cast<size_t>(file.tellg());
+        file.seekg(0);
+
+        std::vector<char> buffer(std::min(windowSize, fileSize + 1));
+        size_t carried = 0;
+
+        for (;;)
+        {
+            file.read(buffer.data() + carried, buffer.size() - carried);
+
+            size_t filled = carried + static_cast<size_t>(file.gcount());
+            bool   atEnd  = filled < buffer.size();
+
+            const char* begin = buffer.data();
+            const char* split = begin + filled;
+
+            // Hold back the trailing partial line for the next window
+            if (!atEnd)
+            {
+                while (split > begin && split[-1] != '\n' && split[-1] != '\r')
+                {
+                    --split;
+                }
+
+                // A single line longer than the window - grow until it fits
+                if (split == begin)
+                {
+                    carried = filled;
+                    buffer.resize(buffer.size() * 2);
+                    continue;
+                }
+            }
+
+            HRESULT hr = onWindow(begin, split);
+            if (FAILED(hr) || atEnd)
+            {
+                return hr;
+            }
+
+            carried = begin + filled - split;
+            std::memmove(buffer.data(), split, carried);
+        }
+    }
+
+    HRESULT WriteFloats(std::ofstream& file, const std::vector<float>& values)
+    {
+        file.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(float));
+        return file ? S_OK : E_FAIL;
+    }
+}
+
+
+HRESULT ParseObj(const char* data, size_t size, uint32_t threadCount, ObjData& outData)
+{
+    ////
+    // Split the file into newline-aligned chunks - a few per worker to balance uneven content
+
+    threadCount = ResolveThreadCount(threadCount);
+
+    size_t chunkCount = std::max<size_t>(1, std::min<size_t>(size / MinChunkSize, threadCount * 4));
+    std::vector<ObjChunk> chunks(chunkCount);
+
+    const char* end = data + size;
+    const char* begin = data;
+
+    for (size_t i = 0; i < chunkCount; ++i)
+    {
+        const char* chunkEnd = end;
+
+        if (i + 1 < chunkCount)
+        {
+            chunkEnd = std::max(begin, data + size / chunkCount * (i + 1));
+
+            // Push the split point past the next newline so no record straddles two chunks
+            auto newline = static_cast<const char*>(std::memchr(chunkEnd, '\n', end - chunkEnd));
+            chunkEnd = newline ? newline + 1 : end;
+        }
+
+        chunks[i].Begin = begin;
+        chunks[i].End = chunkEnd;
+        begin = chunkEnd;
+    }
+
+    ////
+    // Count the attribute records first, so every chunk parses straight into its slice of the output arrays
+
+    ParallelFor(chunkCount, threadCount, [&](size_t i) { CountChunk(chunks[i]); });
+
+    std::vector<size_t> positionBase(chunkCount + 1);
+    std::vector<size_t> normalBase(chunkCount + 1);
+
+    for (size_t i = 0; i < chunkCount; ++i)
+    {
+        if (FAILED(chunks[i].Result))
+        {
+            return chunks[i].Result;
+        }
+
+        positionBase[i + 1] = positionBase[i] + static_cast<size_t>(chunks[i].PositionCount) * 3;
+        normalBase[i + 1] = normalBase[i] + static_cast<size_t>(chunks[i].NormalCount) * 3;
+    }
+
+    outData.Positions.resize(positionBase[chunkCount]);
+    outData.Normals.resize(normalBase[chunkCount]);
+
+    ParallelFor(chunkCount, threadCount, [&](size_t i)
+    {
+        ObjChunk& chunk = chunks[i];
+
+        chunk.Positions = outData.Positions.data() + positionBase[i];
+        chunk.Normals = outData.Normals.data() + normalBase[i];
+        chunk.PositionCount = 0;
+        chunk.NormalCount = 0;
+        chunk.FaceCorners.reserve(chunk.FaceCornerCount);
+        chunk.FaceSizes.reserve(chunk.FaceCount);
+
+        ParseChunk(chunk);
+    });
+
+    for (const ObjChunk& chunk : chunks)
+    {
+        if (FAILED(chunk.Result))
+        {
+            return chunk.Result;
+        }
+    }
+
+
+    ////
+    // Rebase relative indices against the records of the preceding chunks
+
+    int64_t texcoordBase = 0;
+
+    for (size_t i = 0; i < chunkCount; ++i)
+    {
+        if (texcoordBase + chunks[i].MinRelativeTexcoord < 0)
+        {
+            return E_FAIL; // Relative texcoord index points before the first 'vt'
+        }
+        texcoordBase += chunks[i].TexcoordCount;
+    }
+
+    ParallelFor(chunkCount, threadCount, [&](size_t i)
+    {
+        ObjChunk& chunk = chunks[i];
+
+        for (size_t c : chunk.RelativePositions)
+        {
+            int32_t& index = chunk.FaceCorners[c].Position;
+            index += static_cast<int32_t>(positionBase[i] / 3);
+
+            if (index < 0)
+            {
+                chunk.Result = E_FAIL; // Relative index points before the first 'v'
+            }
+        }
+
+        for (size_t c : chunk.RelativeNormals)
+        {
+            chunk.FaceCorners[c].Normal += static_cast<int32_t>(normalBase[i] / 3);
+        }
+    });
+
+    for (const ObjChunk& chunk : chunks)
+    {
+        if (FAILED(chunk.Result))
+        {
+            return chunk.Result;
+        }
+    }
+
+
+    ////
+    // Triangulate against the complete position array, straight into each chunk's slice of the corners
+
+    const size_t positionCount = outData.Positions.size() / 3;
+
+    std::vector<size_t> cornerBase(chunkCount + 1);
+
+    ParallelFor(chunkCount, threadCount, [&](size_t i) { cornerBase[i + 1] = CountTriangulatedCorners(chunks[i], positionCount); });
+
+    for (size_t i = 0; i < chunkCount; ++i)
+    {
+        cornerBase[i + 1] += cornerBase[i];
+    }
+
+    outData.Corners.resize(cornerBase[chunkCount]);
+
+    ParallelFor(chunkCount, threadCount, [&](size_t i)
+    {
+        TriangulateChunk(chunks[i], outData.Positions.data(), positionCount, outData.Normals.size() / 3, outData.Corners.data() + cornerBase[i]);
+    });
+
+    for (const ObjChunk& chunk : chunks)
+    {
+        if (FAILED(chunk.Result))
+        {
+            return chunk.Result;
+        }
+    }
+
+
+    ////
+    // Each 'o'/'g' record closes the current shape; like tinyobjloader, shapes without triangles are dropped
+
+    size_t shapeStart = 0;
+
+    auto closeShape = [&](size_t shapeEnd)
+    {
+        if (shapeEnd > shapeStart)
+        {
+            outData.Shapes.push_back({ shapeStart, shapeEnd - shapeStart });
+        }
+        shapeStart = shapeEnd;
+    };
+
+    for (size_t i = 0; i < chunkCount; ++i)
+    {
+        for (size_t corner : chunks[i].CornerBreaks)
+        {
+            closeShape(cornerBase[i] + corner);
+        }
+    }
+
+    closeShape(outData.Corners.size());
+
+    return S_OK;
+}
+
+HRESULT ParseObjFile(const char* filename, uint32_t threadCount, bool memoryMap, ObjData& outData)
+{
+    if (memoryMap)
+    {
+        MappedFile mapping;
+
+        HRESULT hr = mapping.Open(filename);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        return ParseObj(mapping.Data(), mapping.Size(), threadCount, outData);
+    }
+
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file)
+    {
+        return E_FAIL;
+    }
+
+    std::vector<char> contents(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+
+    if (!file.read(contents.data(), contents.size()))
+    {
+        return E_FAIL;
+    }
+
+    return ParseObj(contents.data(), contents.size(), threadCount, outData);
+}
+
+
+HRESULT StreamObjFile(const char* filename, const char* scratchPath, size_t windowSize, const std::function<HRESULT(const ObjStreamWindow&)>& onWindow)
+{
+    std::string positionPath = std::string(scratchPath) + ".v";
+    std::string normalPath   = std::string(scratchPath) + ".vn";
+
+    auto stream = [&]()
+    {
+        ////
+        // First pass - spill the attributes so the second pass can resolve any face corner without holding them
+
+        int64_t positionCount = 0;
+        int64_t normalCount   = 0;
+
+        {
+            std::ofstream positionFile(positionPath, std::ios::binary | std::ios::trunc);
+            std::ofstream normalFile(normalPath, std::ios::binary | std::ios::trunc);
+
+            if (!positionFile || !normalFile)
+            {
+                return E_FAIL;
+            }
+
+            HRESULT hr = ForEachWindow(filename, windowSize, [&](const char* begin, const char* end)
+            {
+                ObjChunk chunk;
+                chunk.Begin = begin;
+                chunk.End = end;
+                chunk.ParseFaces = false;
+
+                CountChunk(chunk);
+                if (FAILED(chunk.Result))
+                {
+                    return chunk.Result;
+                }
+
+                std::vector<float> windowPositions(static_cast<size_t>(chunk.PositionCount) * 3);
+                std::vector<float> windowNormals(static_cast<size_t>(chunk.NormalCount) * 3);
+
+                chunk.Positions = windowPositions.data();
+                chunk.Normals = windowNormals.data();
+                chunk.PositionCount = 0;
+                chunk.NormalCount = 0;
+
+                ParseChunk(chunk);
+                if (FAILED(chunk.Result))
+                {
+                    return chunk.Result;
+                }
+
+                positionCount += chunk.PositionCount;
+                normalCount   += chunk.NormalCount;
+
+                return SUCCEEDED(WriteFloats(positionFile, windowPositions)) ? WriteFloats(normalFile, windowNormals) : E_FAIL;
+            });
+
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+        }
+
+        MappedFile positions;
+        MappedFile normals;
+
+        HRESULT hr = positions.Open(positionPath.c_str());
+        if (SUCCEEDED(hr))
+        {
+            hr = normals.Open(normalPath.c_str());
+        }
+
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+
+        ////
+        // Second pass - attributes are only counted now, to rebase relative indices of each window's faces
+
+        int64_t positionBase = 0;
+        int64_t normalBase   = 0;
+        int64_t texcoordBase = 0;
+
+        hr = ForEachWindow(filename, windowSize, [&](const char* begin, const char* end)
+        {
+            ObjChunk chunk;
+            chunk.Begin = begin;
+            chunk.End = end;
+            chunk.ParseAttributes = false;
+
+            ParseChunk(chunk);
+            if (FAILED(chunk.Result))
+            {
+                return chunk.Result;
+            }
+
+            if (texcoordBase + chunk.MinRelativeTexcoord < 0)
+            {
+                return E_FAIL; // Relative texcoord index points before the first 'vt'
+            }
+
+            for (size_t c : chunk.RelativePositions)
+            {
+                int32_t& index = chunk.FaceCorners[c].Position;
+                index += static_cast<int32_t>(positionBase);
+
+                if (index < 0)
+                {
+                    return E_FAIL; // Relative index points before the first 'v'
+                }
+            }
+
+            for (size_t c : chunk.RelativeNormals)
+            {
+                chunk.FaceCorners[c].Normal += static_cast<int32_t>(normalBase);
+            }
+
+            positionBase  += chunk.PositionCount;
+            normalBase    += chunk.NormalCount;
+            texcoordBase  += chunk.TexcoordCount;
+
+            auto v = reinterpret_cast<const float*>(positions.Data());
+            auto vn = reinterpret_cast<const float*>(normals.Data());
+
+            std::vector<ObjCorner> corners(CountTriangulatedCorners(chunk, static_cast<size_t>(positionCount)));
+
+            TriangulateChunk(chunk, v, static_cast<size_t>(positionCount), static_cast<size_t>(normalCount), corners.data());
+            if (FAILED(chunk.Result))
+            {
+                return chunk.Result;
+            }
+
+            ObjStreamWindow window = { v, vn, corners.data(), corners.size(), chunk.CornerBreaks.data(), chunk.CornerBreaks.size() };
+            return onWindow(window);
+        });
+
+        return hr;
+    };
+
+    HRESULT hr = stream();
+
+    // The mappings are closed by now, so the scratch files can go
+    std::remove(positionPath.c_str());
+    std::remove(normalPath.c_str());
+
+    return hr;
+}
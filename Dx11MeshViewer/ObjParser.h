@@ -0,0 +1,63 @@
+//
+// ObjParser.h
+//
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Zero-based position & normal indices of one triangle corner
+struct ObjCorner
+{
+    int32_t Position;
+    int32_t Normal;
+};
+
+// Range of triangle corners belonging to one 'o'/'g' shape (only shapes with triangles are kept)
+struct ObjShape
+{
+    size_t FirstCorner;
+    size_t CornerCount;
+};
+
+// Geometry of an OBJ file, triangulated exactly as tinyobjloader would
+struct ObjData
+{
+    std::vector<float>     Positions; // XYZ per 'v' record
+    std::vector<float>     Normals;   // XYZ per 'vn' record
+    std::vector<ObjCorner> Corners;   // Three per triangle, in file order
+    std::vector<ObjShape>  Shapes;
+};
+
+// Parses the v/vn/f records of an in-memory OBJ file by splitting it into newline-aligned chunks
+// which are parsed concurrently and stitched back together in file order
+//
+// A counting pass sizes the attribute arrays so chunks parse straight into them, & triangles are written straight
+// into Corners - only the face corners as written are held besides the output, so peak memory is the output plus
+// at most one more copy of Corners (two thirds of one for all-quad files)
+//
+// Returns E_NOTIMPL for content only tinyobjloader handles (polygons with more than four corners, 'l' & 'p' records)
+HRESULT ParseObj(const char* data, size_t size, uint32_t threadCount, ObjData& outData);
+
+// Hands the file's contents to ParseObj - either memory-mapped and parsed in place, or read into a heap copy
+HRESULT ParseObjFile(const char* filename, uint32_t threadCount, bool memoryMap, ObjData& outData);
+
+// One window of a streamed OBJ file - corners index the complete attribute arrays of the file
+struct ObjStreamWindow
+{
+    const float*     Positions;       // XYZ per 'v' record
+    const float*     Normals;         // XYZ per 'vn' record
+    const ObjCorner* Corners;         // Three per triangle, in file order
+    size_t           CornerCount;
+    const size_t*    ShapeBreaks;     // Corner offsets within the window at which an 'o'/'g' record starts a new shape
+    size_t           ShapeBreakCount;
+};
+
+// Streams an OBJ file through newline-aligned windows of about windowSize bytes, so memory use doesn't grow with the file
+//
+// A first pass spills every position & normal to "<scratchPath>.v" & "<scratchPath>.vn", which the second pass maps
+// (leaving residency to the OS) while each window's triangles are handed to onWindow in file order. Returns E_NOTIMPL
+// for content only tinyobjloader handles, since that can't be streamed
+HRESULT StreamObjFile(const char* filename, const char* scratchPath, size_t windowSize, const std::function<HRESULT(const ObjStreamWindow&)>& onWindow);
@@ -0,0 +1,705 @@
+//
+// OcclusionCuller.cpp
+//
+
+#include "pch.h"
+#include "OcclusionCuller.h"
+
+#include "MeshLoader.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace
+{
+    const size_t BlockSize = 2048;  // Boxes per pool task
+    const size_t ChunkSize = 256;   // Boxes projected at once, keeping their extents in L1
+
+    // toClip as plain arrays - row r gives clip component r
+    struct ClipMatrix
+    {
+        float M[4][4];
+    };
+
+    ClipMatrix GetClipMatrix(const DirectX::XMFLOAT4X4& toClip)
+    {
+        ClipMatrix matrix;
+        for (int r = 0; r < 4; ++r)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                matrix.M[r][c] = toClip.m[r][c];
+            }
+        }
+        return matrix;
+    }
+
+    // Screen rectangles & nearest depths of a chunk of boxes, as the kernels write them - a rectangle spans the
+    // pixels of a Width x Height target its box touches, inclusive & clamped to the target
+    struct ProjectedBoxes
+    {
+        int32_t X0[ChunkSize];
+        int32_t Y0[ChunkSize];
+        int32_t X1[ChunkSize];
+        int32_t Y1[ChunkSize];
+        float   NearZ[ChunkSize];  // -infinity crossing the near plane & +infinity off screen, both without a rectangle
+    };
+
+    // What a box's extents in normalized device coordinates make of it
+    float ClassifyNearZ(float minX, float maxX, float minY, float maxY, float minZ, bool clipped)
+    {
+        if (clipped)
+        {
+            return -INFINITY;
+        }
+
+        bool offScreen = maxX < -1.0f || minX > 1.0f || maxY < -1.0f || minY > 1.0f || minZ > 1.0f;
+        return offScreen ? INFINITY : minZ;
+    }
+
+
+    // The pixel a screen coordinate falls in, clamped to the target
+    int32_t ToPixel(float screen, uint32_t size)
+    {
+        return static_cast<int32_t>(std::min(std::max(std::floor(screen), 0.0f), size - 1.0f));
+    }
+
+
+    ////
+    // Box projection - each corner's clip coordinates sum per-axis products shared between corners, & every level
+    // rounds each step as the scalar code does
+
+    // Writes boxes [first, first + count) to out from index 0
+    void ProjectBoxesScalar(const BoxArrays& boxes, size_t first, size_t count, const ClipMatrix& m, uint32_t width, uint32_t height, ProjectedBoxes& out)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            float lo[4][3];
+            float hi[4][3];
+            for (int r = 0; r < 4; ++r)
+            {
+                for (int a = 0; a < 3; ++a)
+                {
+                    lo[r][a] = m.M[r][a] * boxes.Min[a][first + i];
+                    hi[r][a] = m.M[r][a] * boxes.Max[a][first + i];
+                }
+            }
+
+            float minX    = FLT_MAX;
+            float maxX    = -FLT_MAX;
+            float minY    = FLT_MAX;
+            float maxY    = -FLT_MAX;
+            float minZ    = FLT_MAX;
+            bool  clipped = false;
+
+            for (int corner = 0; corner < 8; ++corner)
+            {
+                float clip[4];
+                for (int r = 0; r < 4; ++r)
+                {
+                    float x = (corner & 1) ? hi[r][0] : lo[r][0];
+                    float y = (corner & 2) ? hi[r][1] : lo[r][1];
+                    float z = (corner & 4) ? hi[r][2] : lo[r][2];
+                    clip[r] = ((x + y) + z) + m.M[r][3];
+                }
+
+                clipped = clipped || !(clip[3] > 0.0f) || clip[2] < 0.0f;
+
+                float invW = 1.0f / clip[3];
+                float x    = clip[0] * invW;
+                float y    = clip[1] * invW;
+
+                minX = std::min(minX, x);
+                maxX = std::max(maxX, x);
+                minY = std::min(minY, y);
+                maxY = std::max(maxY, y);
+                minZ = std::min(minZ, clip[2] * invW);
+            }
+
+            out.NearZ[i] = ClassifyNearZ(minX, maxX, minY, maxY, minZ, clipped);
+            if (std::isinf(out.NearZ[i]))
+            {
+                // Extents may be infinite or NaN, which don't convert to pixels
+                out.X0[i] = out.Y0[i] = out.X1[i] = out.Y1[i] = 0;
+                continue;
+            }
+
+            // As RenderMesh maps to the viewport, rows from the top
+            out.X0[i] = ToPixel((minX * 0.5f + 0.5f) * width, width);
+            out.X1[i] = ToPixel((maxX * 0.5f + 0.5f) * width, width);
+            out.Y0[i] = ToPixel((0.5f - maxY * 0.5f) * height, height);
+            out.Y1[i] = ToPixel((0.5f - minY * 0.5f) * height, height);
+        }
+    }
+
+
+#if SIMD_X86
+    ////
+    // AVX2 - 8 boxes at a time
+
+    SIMD_TARGET_AVX2 __m256i ToPixelAvx2(__m256 screen, __m256 size)
+    {
+        return _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(_mm256_floor_ps(screen), _mm256_setzero_ps()), _mm256_sub_ps(size, _mm256_set1_ps(1.0f))));
+    }
+
+    SIMD_TARGET_AVX2 void ProjectBoxesAvx2(const BoxArrays& boxes, size_t first, size_t count, const ClipMatrix& m, uint32_t width, uint32_t height, ProjectedBoxes& out)
+    {
+        const __m256 zero    = _mm256_setzero_ps();
+        const __m256 one     = _mm256_set1_ps(1.0f);
+        const __m256 half    = _mm256_set1_ps(0.5f);
+        const __m256 widthF  = _mm256_set1_ps(static_cast<float>(width));
+        const __m256 heightF = _mm256_set1_ps(static_cast<float>(height));
+
+        for (size_t base = 0; base < count; base += 8)
+        {
+            __m256i mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(std::min<size_t>(count - base, 8))), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+
+            __m256 lo[4][3];
+            __m256 hi[4][3];
+            for (int a = 0; a < 3; ++a)
+            {
+                __m256 boxMin = _mm256_maskload_ps(boxes.Min[a] + first + base, mask);
+                __m256 boxMax = _mm256_maskload_ps(boxes.Max[a] + first + base, mask);
+                for (int r = 0; r < 4; ++r)
+                {
+                    lo[r][a] = _mm256_mul_ps(_mm256_set1_ps(m.M[r][a]), boxMin);
+                    hi[r][a] = _mm256_mul_ps(_mm256_set1_ps(m.M[r][a]), boxMax);
+                }
+            }
+
+            __m256 minX    = _mm256_set1_ps(FLT_MAX);
+            __m256 maxX    = _mm256_set1_ps(-FLT_MAX);
+            __m256 minY    = _mm256_set1_ps(FLT_MAX);
+            __m256 maxY    = _mm256_set1_ps(-FLT_MAX);
+            __m256 minZ    = _mm256_set1_ps(FLT_MAX);
+            __m256 clipped = zero;
+
+            for (int corner = 0; corner < 8; ++corner)
+            {
+                __m256 clip[4];
+                for (int r = 0; r < 4; ++r)
+                {
+                    __m256 x = (corner & 1) ? hi[r][0] : lo[r][0];
+                    __m256 y = (corner & 2) ? hi[r][1] : lo[r][1];
+                    __m256 z = (corner & 4) ? hi[r][2] : lo[r][2];
+                    clip[r] = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(x, y), z), _mm256_set1_ps(m.M[r][3]));
+                }
+
+                clipped = _mm256_or_ps(clipped, _mm256_cmp_ps(clip[3], zero, _CMP_NGT_UQ));
+                clipped = _mm256_or_ps(clipped, _mm256_cmp_ps(clip[2], zero, _CMP_LT_OQ));
+
+                __m256 invW = _mm256_div_ps(one, clip[3]);
+                __m256 x    = _mm256_mul_ps(clip[0], invW);
+                __m256 y    = _mm256_mul_ps(clip[1], invW);
+
+                minX = _mm256_min_ps(minX, x);
+                maxX = _mm256_max_ps(maxX, x);
+                minY = _mm256_min_ps(minY, y);
+                maxY = _mm256_max_ps(maxY, y);
+                minZ = _mm256_min_ps(minZ, _mm256_mul_ps(clip[2], invW));
+            }
+
+            _mm256_maskstore_epi32(out.X0 + base, mask, ToPixelAvx2(_mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(minX, half), half), widthF), widthF));
+            _mm256_maskstore_epi32(out.X1 + base, mask, ToPixelAvx2(_mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(maxX, half), half), widthF), widthF));
+            _mm256_maskstore_epi32(out.Y0 + base, mask, ToPixelAvx2(_mm256_mul_ps(_mm256_sub_ps(half, _mm256_mul_ps(maxY, half)), heightF), heightF));
+            _mm256_maskstore_epi32(out.Y1 + base, mask, ToPixelAvx2(_mm256_mul_ps(_mm256_sub_ps(half, _mm256_mul_ps(minY, half)), heightF), heightF));
+
+            __m256 offScreen = _mm256_or_ps(_mm256_or_ps(_mm256_cmp_ps(maxX, _mm256_set1_ps(-1.0f), _CMP_LT_OQ), _mm256_cmp_ps(minX, one, _CMP_GT_OQ)),
+                                            _mm256_or_ps(_mm256_cmp_ps(maxY, _mm256_set1_ps(-1.0f), _CMP_LT_OQ), _mm256_cmp_ps(minY, one, _CMP_GT_OQ)));
+            offScreen = _mm256_or_ps(offScreen, _mm256_cmp_ps(minZ, one, _CMP_GT_OQ));
+
+            __m256 nearZ = _mm256_blendv_ps(minZ, _mm256_set1_ps(INFINITY), offScreen);
+            nearZ = _mm256_blendv_ps(nearZ, _mm256_set1_ps(-INFINITY), clipped);
+            _mm256_maskstore_ps(out.NearZ + base, mask, nearZ);
+        }
+    }
+
+
+    ////
+    // AVX-512 - 16 boxes at a time, with explicitly rounded arithmetic so nothing is fused into FMAs
+
+    SIMD_TARGET_AVX512 __m512i ToPixelAvx512(__m512 screen, __m512 size)
+    {
+        __m512 pixel = _mm512_roundscale_ps(screen, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+        return _mm512_cvttps_epi32(_mm512_min_ps(_mm512_max_ps(pixel, _mm512_setzero_ps()), SubtractRounded(size, _mm512_set1_ps(1.0f))));
+    }
+
+    SIMD_TARGET_AVX512 void ProjectBoxesAvx512(const BoxArrays& boxes, size_t first, size_t count, const ClipMatrix& m, uint32_t width, uint32_t height, ProjectedBoxes& out)
+    {
+        const __m512 zero    = _mm512_setzero_ps();
+        const __m512 one     = _mm512_set1_ps(1.0f);
+        const __m512 half    = _mm512_set1_ps(0.5f);
+        const __m512 widthF  = _mm512_set1_ps(static_cast<float>(width));
+        const __m512 heightF = _mm512_set1_ps(static_cast<float>(height));
+
+        for (size_t base = 0; base < count; base += 16)
+        {
+            __mmask16 mask = static_cast<__mmask16>((1u << std::min<size_t>(count - base, 16)) - 1);
+
+            __m512 lo[4][3];
+            __m512 hi[4][3];
+            for (int a = 0; a < 3; ++a)
+            {
+                __m512 boxMin = _mm512_maskz_loadu_ps(mask, boxes.Min[a] + first + base);
+                __m512 boxMax = _mm512_maskz_loadu_ps(mask, boxes.Max[a] + first + base);
+                for (int r = 0; r < 4; ++r)
+                {
+                    lo[r][a] = MultiplyRounded(_mm512_set1_ps(m.M[r][a]), boxMin);
+                    hi[r][a] = MultiplyRounded(_mm512_set1_ps(m.M[r][a]), boxMax);
+                }
+            }
+
+            __m512    minX    = _mm512_set1_ps(FLT_MAX);
+            __m512    maxX    = _mm512_set1_ps(-FLT_MAX);
+            __m512    minY    = _mm512_set1_ps(FLT_MAX);
+            __m512    maxY    = _mm512_set1_ps(-FLT_MAX);
+            __m512    minZ    = _mm512_set1_ps(FLT_MAX);
+            __mmask16 clipped = 0;
+
+            for (int corner = 0; corner < 8; ++corner)
+            {
+                __m512 clip[4];
+                for (int r = 0; r < 4; ++r)
+                {
+                    __m512 x = (corner & 1) ? hi[r][0] : lo[r][0];
+                    __m512 y = (corner & 2) ? hi[r][1] : lo[r][1];
+                    __m512 z = (corner & 4) ? hi[r][2] : lo[r][2];
+                    clip[r] = AddRounded(AddRounded(AddRounded(x, y), z), _mm512_set1_ps(m.M[r][3]));
+                }
+
+                clipped |= _mm512_cmp_ps_mask(clip[3], zero, _CMP_NGT_UQ);
+                clipped |= _mm512_cmp_ps_mask(clip[2], zero, _CMP_LT_OQ);
+
+                __m512 invW = _mm512_div_ps(one, clip[3]);
+                __m512 x    = MultiplyRounded(clip[0], invW);
+                __m512 y    = MultiplyRounded(clip[1], invW);
+
+                minX = _mm512_min_ps(minX, x);
+                maxX = _mm512_max_ps(maxX, x);
+                minY = _mm512_min_ps(minY, y);
+                maxY = _mm512_max_ps(maxY, y);
+                minZ = _mm512_min_ps(minZ, MultiplyRounded(clip[2], invW));
+            }
+
+            _mm512_mask_storeu_epi32(out.X0 + base, mask, ToPixelAvx512(MultiplyRounded(AddRounded(MultiplyRounded(minX, half), half), widthF), widthF));
+            _mm512_mask_storeu_epi32(out.X1 + base, mask, ToPixelAvx512(MultiplyRounded(AddRounded(MultiplyRounded(maxX, half), half), widthF), widthF));
+            _mm512_mask_storeu_epi32(out.Y0 + base, mask, ToPixelAvx512(MultiplyRounded(SubtractRounded(half, MultiplyRounded(maxY, half)), heightF), heightF));
+            _mm512_mask_storeu_epi32(out.Y1 + base, mask, ToPixelAvx512(MultiplyRounded(SubtractRounded(half, MultiplyRounded(minY, half)), heightF), heightF));
+
+            __mmask16 offScreen = _mm512_cmp_ps_mask(maxX, _mm512_set1_ps(-1.0f), _CMP_LT_OQ) | _mm512_cmp_ps_mask(minX, one, _CMP_GT_OQ) |
+                                  _mm512_cmp_ps_mask(maxY, _mm512_set1_ps(-1.0f), _CMP_LT_OQ) | _mm512_cmp_ps_mask(minY, one, _CMP_GT_OQ) |
+                                  _mm512_cmp_ps_mask(minZ, one, _CMP_GT_OQ);
+
+            __m512 nearZ = _mm512_mask_blend_ps(offScreen, minZ, _mm512_set1_ps(INFINITY));
+            nearZ = _mm512_mask_blend_ps(clipped, nearZ, _mm512_set1_ps(-INFINITY));
+            _mm512_mask_storeu_ps(out.NearZ + base, mask, nearZ);
+        }
+    }
+#endif
+
+    void ProjectBoxes(const BoxArrays& boxes, size_t first, size_t count, const ClipMatrix& m, uint32_t width, uint32_t height, SimdLevel level, ProjectedBoxes& out)
+    {
+#if SIMD_X86
+        if (level >= SimdLevel::Avx512)
+        {
+            ProjectBoxesAvx512(boxes, first, count, m, width, height, out);
+            return;
+        }
+
+        if (level >= SimdLevel::Avx2)
+        {
+            ProjectBoxesAvx2(boxes, first, count, m, width, height, out);
+            return;
+        }
+#endif
+
+        ProjectBoxesScalar(boxes, first, count, m, width, height, out);
+    }
+
+
+    ////
+    // Depth pyramid
+
+    // Reduces a pair of source rows into outMin & outMax from texel first on - the last texel of an odd width
+    // covers a single column
+    void ReduceRowsScalar(const float* minA, const float* minB, const float* maxA, const float* maxB, uint32_t sourceWidth, uint32_t first, uint32_t width, float* outMin, float* outMax)
+    {
+        for (uint32_t x = first; x < width; ++x)
+        {
+            uint32_t x0 = 2 * x;
+            uint32_t x1 = std::min(x0 + 1, sourceWidth - 1);
+
+            outMin[x] = std::min(std::min(minA[x0], minA[x1]), std::min(minB[x0], minB[x1]));
+            outMax[x] = std::max(std::max(maxA[x0], maxA[x1]), std::max(maxB[x0], maxB[x1]));
+        }
+    }
+
+#if SIMD_X86
+    // 4 texels from 8 columns at a time
+    SIMD_TARGET_SSE42 void ReduceRowsSse42(const float* minA, const float* minB, const float* maxA, const float* maxB, uint32_t sourceWidth, uint32_t width, float* outMin, float* outMax)
+    {
+        uint32_t x = 0;
+        for (; x + 4 <= sourceWidth / 2; x += 4)
+        {
+            __m128 min0 = _mm_min_ps(_mm_loadu_ps(minA + 2 * x), _mm_loadu_ps(minB + 2 * x));
+            __m128 min1 = _mm_min_ps(_mm_loadu_ps(minA + 2 * x + 4), _mm_loadu_ps(minB + 2 * x + 4));
+            __m128 max0 = _mm_max_ps(_mm_loadu_ps(maxA + 2 * x), _mm_loadu_ps(maxB + 2 * x));
+            __m128 max1 = _mm_max_ps(_mm_loadu_ps(maxA + 2 * x + 4), _mm_loadu_ps(maxB + 2 * x + 4));
+
+            // Even & odd columns side by side
+            _mm_storeu_ps(outMin + x, _mm_min_ps(_mm_shuffle_ps(min0, min1, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(min0, min1, _MM_SHUFFLE(3, 1, 3, 1))));
+            _mm_storeu_ps(outMax + x, _mm_max_ps(_mm_shuffle_ps(max0, max1, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(max0, max1, _MM_SHUFFLE(3, 1, 3, 1))));
+        }
+
+        ReduceRowsScalar(minA, minB, maxA, maxB, sourceWidth, x, width, outMin, outMax);
+    }
+#endif
+
+    // Farthest of each texel & its left & right neighbors, from texel first on
+    void RowMaxScalar(const float* row, uint32_t width, uint32_t first, float* out)
+    {
+        for (uint32_t x = first; x < width; ++x)
+        {
+            out[x] = std::max(std::max(row[(x > 0) ? x - 1 : 0], row[x]), row[std::min(x + 1, width - 1)]);
+        }
+    }
+
+    void ColumnMaxScalar(const float* above, const float* row, const float* below, uint32_t width, uint32_t first, float* out)
+    {
+        for (uint32_t x = first; x < width; ++x)
+        {
+            out[x] = std::max(std::max(above[x], row[x]), below[x]);
+        }
+    }
+
+#if SIMD_X86
+    SIMD_TARGET_SSE42 void RowMaxSse42(const float* row, uint32_t width, float* out)
+    {
+        RowMaxScalar(row, std::min(width, 1u), 0, out);
+
+        uint32_t x = 1;
+        for (; x + 5 <= width; x += 4)
+        {
+            _mm_storeu_ps(out + x, _mm_max_ps(_mm_max_ps(_mm_loadu_ps(row + x - 1), _mm_loadu_ps(row + x)), _mm_loadu_ps(row + x + 1)));
+        }
+
+        RowMaxScalar(row, width, x, out);
+    }
+
+    SIMD_TARGET_SSE42 void ColumnMaxSse42(const float* above, const float* row, const float* below, uint32_t width, float* out)
+    {
+        uint32_t x = 0;
+        for (; x + 4 <= width; x += 4)
+        {
+            _mm_storeu_ps(out + x, _mm_max_ps(_mm_max_ps(_mm_loadu_ps(above + x), _mm_loadu_ps(row + x)), _mm_loadu_ps(below + x)));
+        }
+
+        ColumnMaxScalar(above, row, below, width, x, out);
+    }
+#endif
+
+    // Farthest depth over each texel's 3x3 neighborhood - depth is sampled at texel centers, so across a texel an
+    // occluder's surface may lie anywhere up to its neighbors' samples, & its silhouette may end short of the next
+    // center. Taking the neighbors' farthest keeps the pyramid from hiding what full resolution depth would show.
+    void DilateMax(const SoftwareFrame& frame, SimdLevel level, float* outMax)
+    {
+        const uint32_t width  = frame.Width;
+        const uint32_t height = frame.Height;
+
+        for (uint32_t y = 0; y < height; ++y)
+        {
+#if SIMD_X86
+            if (level >= SimdLevel::Sse42)
+            {
+                RowMaxSse42(frame.Depth.data() + size_t(y) * width, width, outMax + size_t(y) * width);
+                continue;
+            }
+#endif
+            RowMaxScalar(frame.Depth.data() + size_t(y) * width, width, 0, outMax + size_t(y) * width);
+        }
+
+        // Columns in place, keeping the row maxima each output row overwrites
+        std::vector<float> above(outMax, outMax + width);
+        std::vector<float> row(width);
+
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            float*       out   = outMax + size_t(y) * width;
+            const float* below = (y + 1 < height) ? out + width : row.data();
+            std::copy(out, out + width, row.begin());
+
+#if SIMD_X86
+            if (level >= SimdLevel::Sse42)
+            {
+                ColumnMaxSse42(above.data(), row.data(), below, width, out);
+                above.swap(row);
+                continue;
+            }
+#endif
+            ColumnMaxScalar(above.data(), row.data(), below, width, 0, out);
+            above.swap(row);
+        }
+    }
+
+    void BuildPyramid(OcclusionBuffer& buffer, SimdLevel level)
+    {
+        uint32_t levelCount = 1;
+        while ((buffer.Frame.Width - 1) >> (levelCount - 1) > 0 || (buffer.Frame.Height - 1) >> (levelCount - 1) > 0)
+        {
+            ++levelCount;
+        }
+
+        // Resized in place, so a buffer kept across frames reuses its allocations
+        buffer.Levels.resize(levelCount);
+
+        DepthPyramidLevel& base = buffer.Levels[0];
+        base.Width  = buffer.Frame.Width;
+        base.Height = buffer.Frame.Height;
+        base.MinDepth.assign(buffer.Frame.Depth.begin(), buffer.Frame.Depth.end());
+        base.MaxDepth.resize(buffer.Frame.Depth.size());
+        DilateMax(buffer.Frame, level, base.MaxDepth.data());
+
+        for (uint32_t n = 1; n < levelCount; ++n)
+        {
+            const DepthPyramidLevel& source = buffer.Levels[n - 1];
+            DepthPyramidLevel&       target = buffer.Levels[n];
+
+            target.Width  = (source.Width + 1) / 2;
+            target.Height = (source.Height + 1) / 2;
+            target.MinDepth.resize(size_t(target.Width) * target.Height);
+            target.MaxDepth.resize(size_t(target.Width) * target.Height);
+
+            for (uint32_t y = 0; y < target.Height; ++y)
+            {
+                size_t rowA = size_t(2 * y) * source.Width;
+                size_t rowB = size_t(std::min(2 * y + 1, source.Height - 1)) * source.Width;
+
+                const float* minA   = source.MinDepth.data() + rowA;
+                const float* minB   = source.MinDepth.data() + rowB;
+                const float* maxA   = source.MaxDepth.data() + rowA;
+                const float* maxB   = source.MaxDepth.data() + rowB;
+                float*       outMin = target.MinDepth.data() + size_t(y) * target.Width;
+                float*       outMax = target.MaxDepth.data() + size_t(y) * target.Width;
+
+#if SIMD_X86
+                if (level >= SimdLevel::Sse42)
+                {
+                    ReduceRowsSse42(minA, minB, maxA, maxB, source.Width, target.Width, outMin, outMax);
+                    continue;
+                }
+#endif
+                ReduceRowsScalar(minA, minB, maxA, maxB, source.Width, 0, target.Width, outMin, outMax);
+            }
+        }
+    }
+
+    // Nearest & farthest depth over a rectangle of a level's texels, inclusive
+    void GetDepthRange(const DepthPyramidLevel& level, int32_t x0, int32_t y0, int32_t x1, int32_t y1, float& outMin, float& outMax)
+    {
+        outMin = FLT_MAX;
+        outMax = -FLT_MAX;
+        for (int32_t y = y0; y <= y1; ++y)
+        {
+            const float* minRow = level.MinDepth.data() + size_t(y) * level.Width;
+            const float* maxRow = level.MaxDepth.data() + size_t(y) * level.Width;
+            for (int32_t x = x0; x <= x1; ++x)
+            {
+                outMin = std::min(outMin, minRow[x]);
+                outMax = std::max(outMax, maxRow[x]);
+            }
+        }
+    }
+
+    // Behind every occluder texel under box i's rectangle - equal depth still passes LESS_EQUAL, so isn't hidden
+    bool IsOccluded(const std::vector<DepthPyramidLevel>& levels, const ProjectedBoxes& boxes, size_t i, uint64_t& refined)
+    {
+        const int32_t x0    = boxes.X0[i];
+        const int32_t y0    = boxes.Y0[i];
+        const int32_t x1    = boxes.X1[i];
+        const int32_t y1    = boxes.Y1[i];
+        const float   nearZ = boxes.NearZ[i];
+
+        // The coarsest level where the rectangle spans at most 2x2 texels
+        int n = 0;
+        while ((x1 >> n) - (x0 >> n) > 1 || (y1 >> n) - (y0 >> n) > 1)
+        {
+            ++n;
+        }
+
+        // Spanning a single texel along an axis reads it twice, which leaves the range as it is
+        const DepthPyramidLevel& coarse = levels[n];
+        const size_t             row0   = size_t(y0 >> n) * coarse.Width;
+        const size_t             row1   = size_t(y1 >> n) * coarse.Width;
+        const size_t             texels[] = { row0 + (x0 >> n), row0 + (x1 >> n), row1 + (x0 >> n), row1 + (x1 >> n) };
+
+        float minDepth = std::min(std::min(coarse.MinDepth[texels[0]], coarse.MinDepth[texels[1]]), std::min(coarse.MinDepth[texels[2]], coarse.MinDepth[texels[3]]));
+        float maxDepth = std::max(std::max(coarse.MaxDepth[texels[0]], coarse.MaxDepth[texels[1]]), std::max(coarse.MaxDepth[texels[2]], coarse.MaxDepth[texels[3]]));
+
+        if (nearZ > maxDepth)
+        {
+            return true;
+        }
+
+        // In front of the nearest occluder, no finer texel's farthest depth can hide the box either
+        if (nearZ <= minDepth || n == 0)
+        {
+            return false;
+        }
+
+        // The finer texels hug the rectangle closer, up to 4x4 of them
+        ++refined;
+        --n;
+        GetDepthRange(levels[n], x0 >> n, y0 >> n, x1 >> n, y1 >> n, minDepth, maxDepth);
+        return nearZ > maxDepth;
+    }
+}
+
+void AppendOccluder(const Mesh& proxy, const std::vector<Submesh>& submeshes, DirectX::FXMMATRIX world, Mesh& occluders)
+{
+    using namespace DirectX;
+
+    std::vector<uint32_t> remap(proxy.VertexBuffer.size() / 6, UINT32_MAX);
+
+    for (const Submesh& submesh : submeshes)
+    {
+        for (uint32_t i = submesh.FirstIndex; i < submesh.FirstIndex + submesh.IndexCount; ++i)
+        {
+            uint32_t index = (proxy.IndexSize == sizeof(uint16_t)) ? proxy.ShortIndexBuffer[i] : proxy.IndexBuffer[i];
+            if (remap[index] == UINT32_MAX)
+            {
+                remap[index] = static_cast<uint32_t>(occluders.VertexBuffer.size() / 6);
+
+                const float* vertex = &proxy.VertexBuffer[size_t(index) * 6];
+                XMFLOAT3 position;
+                XMStoreFloat3(&position, XMVector3TransformCoord(XMVectorSet(vertex[0], vertex[1], vertex[2], 1.0f), world));
+                occluders.VertexBuffer.insert(occluders.VertexBuffer.end(), { position.x, position.y, position.z, vertex[3], vertex[4], vertex[5] });
+            }
+            occluders.IndexBuffer.push_back(remap[index]);
+        }
+    }
+
+    if (occluders.Submeshes.empty())
+    {
+        occluders.Submeshes.push_back(Submesh {});
+    }
+
+    occluders.Submeshes[0].IndexCount  = static_cast<uint32_t>(occluders.IndexBuffer.size());
+    occluders.Submeshes[0].VertexCount = static_cast<uint32_t>(occluders.VertexBuffer.size() / 6);
+}
+
+HRESULT RenderOccluders(const Mesh& occluders, const std::vector<Submesh>& submeshes, const DirectX::XMFLOAT4X4& toClip, OcclusionBuffer& buffer, const OcclusionOptions& options)
+{
+    AppShaderConstants constants = {};
+    constants.WorldViewProjection = toClip;
+
+    SoftwareRenderOptions renderOptions;
+    renderOptions.ThreadCount  = options.ThreadCount;
+    renderOptions.Pool         = options.Pool;
+    renderOptions.MaxSimdLevel = options.MaxSimdLevel;
+    renderOptions.DepthOnly    = true;
+
+    buffer.Frame.Width  = options.Width;
+    buffer.Frame.Height = options.Height;
+
+    HRESULT hr = RenderMesh(occluders, submeshes, constants, buffer.Frame, renderOptions);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    BuildPyramid(buffer, std::min(options.MaxSimdLevel, GetSupportedSimdLevel()));
+    return S_OK;
+}
+
+void TestOcclusion(const OcclusionBuffer& buffer, const BoxArrays& boxes, const DirectX::XMFLOAT4X4& toClip, uint8_t* outVisible, const OcclusionOptions& options, OcclusionStats* outStats)
+{
+    const ClipMatrix matrix = GetClipMatrix(toClip);
+    const SimdLevel  level  = std::min(options.MaxSimdLevel, GetSupportedSimdLevel());
+
+    ThreadPool  localPool(options.Pool ? 1 : options.ThreadCount);
+    ThreadPool& pool = options.Pool ? *options.Pool : localPool;
+
+    const size_t blockCount = (boxes.Count + BlockSize - 1) / BlockSize;
+    std::vector<OcclusionStats> blockStats(blockCount);
+
+    pool.Run(blockCount, [&](size_t block, uint32_t)
+    {
+        OcclusionStats& stats = blockStats[block];
+        size_t          end   = std::min(boxes.Count, (block + 1) * BlockSize);
+
+        ProjectedBoxes projected;
+
+        for (size_t first = block * BlockSize; first < end; first += ChunkSize)
+        {
+            size_t count = std::min(end - first, ChunkSize);
+            ProjectBoxes(boxes, first, count, matrix, buffer.Frame.Width, buffer.Frame.Height, level, projected);
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                bool visible = true;
+                if (projected.NearZ[i] == -INFINITY)
+                {
+                    ++stats.NearClipped;
+                }
+                else if (projected.NearZ[i] == INFINITY)
+                {
+                    ++stats.OffScreen;
+                    visible = false;
+                }
+                else if (IsOccluded(buffer.Levels, projected, i, stats.Refined))
+                {
+                    ++stats.Occluded;
+                    visible = false;
+                }
+
+                outVisible[first + i] = visible ? 1 : 0;
+            }
+        }
+    });
+
+    if (outStats)
+    {
+        *outStats       = {};
+        outStats->Level = level;
+        outStats->Boxes = boxes.Count;
+        for (const OcclusionStats& stats : blockStats)
+        {
+            outStats->OffScreen   += stats.OffScreen;
+            outStats->NearClipped += stats.NearClipped;
+            outStats->Occluded    += stats.Occluded;
+            outStats->Refined     += stats.Refined;
+        }
+    }
+}
+
+void TestOcclusionReference(const SoftwareFrame& depth, const BoxArrays& boxes, const DirectX::XMFLOAT4X4& toClip, uint8_t* outVisible)
+{
+    const ClipMatrix matrix = GetClipMatrix(toClip);
+
+    ProjectedBoxes projected;
+
+    for (size_t first = 0; first < boxes.Count; first += ChunkSize)
+    {
+        size_t count = std::min(boxes.Count - first, ChunkSize);
+        ProjectBoxesScalar(boxes, first, count, matrix, depth.Width, depth.Height, projected);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            bool visible = (projected.NearZ[i] == -INFINITY);
+            if (!std::isinf(projected.NearZ[i]))
+            {
+                for (int32_t y = projected.Y0[i]; y <= projected.Y1[i] && !visible; ++y)
+                {
+                    for (int32_t x = projected.X0[i]; x <= projected.X1[i] && !visible; ++x)
+                    {
+                        visible = projected.NearZ[i] <= depth.Depth[size_t(y) * depth.Width + x];
+                    }
+                }
+            }
+
+            outVisible[first + i] = visible ? 1 : 0;
+        }
+    }
+}
@@ -0,0 +1,77 @@
+//
+// OcclusionCuller.h
+//
+
+#pragma once
+
+#include "Simd.h"
+#include "SoftwareRenderer.h"
+#include "VertexBounds.h"
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct Mesh;
+struct Submesh;
+class  ThreadPool;
+
+struct OcclusionOptions
+{
+    uint32_t    Width        = 320;                // Of the occluder depth buffer - best at the screen's aspect ratio
+    uint32_t    Height       = 180;
+    uint32_t    ThreadCount  = 0;                  // 0 uses every hardware thread
+    ThreadPool* Pool         = nullptr;            // Workers kept across frames, used in place of ThreadCount
+    SimdLevel   MaxSimdLevel = SimdLevel::Avx512;  // Clamped to GetSupportedSimdLevel()
+};
+
+// Texel (x, y) of level n covers texels [x * 2^n, (x + 1) * 2^n) x [y * 2^n, (y + 1) * 2^n) of level 0
+struct DepthPyramidLevel
+{
+    uint32_t           Width  = 0;
+    uint32_t           Height = 0;
+    std::vector<float> MinDepth;  // Nearest occluder depth under the texel
+    std::vector<float> MaxDepth;  // Farthest - anything behind it is hidden across the whole texel
+};
+
+struct OcclusionBuffer
+{
+    SoftwareFrame                  Frame;   // Occluder depth, with the color target unused
+    std::vector<DepthPyramidLevel> Levels;  // From Frame's resolution down to 1x1
+};
+
+// Outcome of one TestOcclusion call
+struct OcclusionStats
+{
+    SimdLevel Level       = SimdLevel::Scalar; // Of the box projection kernel used
+    uint64_t  Boxes       = 0;
+    uint64_t  OffScreen   = 0;  // Outside the viewport or beyond the far plane
+    uint64_t  NearClipped = 0;  // Crossing the near plane, so kept without a test
+    uint64_t  Occluded    = 0;
+    uint64_t  Refined     = 0;  // Tested again a level finer after the coarse test couldn't decide
+};
+
+// Copies the submeshes' triangles & the vertices they use into occluders, transformed by world, & grows the single
+// submesh covering all of occluders' triangles - normals are left untransformed, as occluder depth needs only positions
+void AppendOccluder(const Mesh& proxy, const std::vector<Submesh>& submeshes, DirectX::FXMMATRIX world, Mesh& occluders);
+
+// Draws the occluders' depth at options.Width x options.Height with the CPU renderer & builds the pyramid
+//
+// toClip maps the occluder vertices to clip space, stored transposed like AppShaderConstants::WorldViewProjection.
+// Occluders should be cheap proxies, such as a mesh's coarsest LOD, and several can be merged into one Mesh in world
+// space. Depth is sampled at texel centers, so an object seen through a gap narrower than a texel may be culled.
+HRESULT RenderOccluders(const Mesh& occluders, const std::vector<Submesh>& submeshes, const DirectX::XMFLOAT4X4& toClip, OcclusionBuffer& buffer, const OcclusionOptions& options = {});
+
+// Sets outVisible[i] to 0 for each box hidden behind the occluders or outside the view, otherwise to 1
+//
+// toClip maps the boxes to clip space, like RenderOccluders' matrix. Each box is projected to its screen rectangle &
+// nearest depth, then compared with the farthest occluder depth over at most 2x2 texels of the coarsest level that
+// covers it. When the box is neither behind those texels nor in front of their nearest depth, one finer level
+// decides. The projection runs 8 or 16 boxes at a time at AVX2 or AVX-512, and blocks of boxes spread across the
+// pool. Every level & worker count gives the same result.
+void TestOcclusion(const OcclusionBuffer& buffer, const BoxArrays& boxes, const DirectX::XMFLOAT4X4& toClip, uint8_t* outVisible, const OcclusionOptions& options = {}, OcclusionStats* outStats = nullptr);
+
+// Checks every pixel under each box's screen rectangle instead of the pyramid - the reference TestOcclusion is
+// verified against, given the occluder depth at full resolution
+void TestOcclusionReference(const SoftwareFrame& depth, const BoxArrays& boxes, const DirectX::XMFLOAT4X4& toClip, uint8_t* outVisible);
@@ -0,0 +1,62 @@
+//
+// Parallel.h
+//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// Resolves a requested worker count - zero means one worker per hardware thread
+inline uint32_t ResolveThreadCount(uint32_t threadCount)
+{
+    if (threadCount == 0)
+    {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    return threadCount;
+}
+
+// Invokes fn(i) for every i in [0, count), handing indices out to up to threadCount workers
+// The calling thread participates, so a single worker simply runs the loop inline
+template <class Fn>
+void ParallelFor(size_t count, uint32_t threadCount, Fn fn)
+{
+    size_t workerCount = std::min<size_t>(ResolveThreadCount(threadCount), count);
+
+    if (workerCount <= 1)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            fn(i);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next{ 0 };
+    auto worker = [&]()
+    {
+        for (size_t i = next++; i < count; i = next++)
+        {
+            fn(i);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(workerCount - 1);
+
+    for (size_t t = 1; t < workerCount; ++t)
+    {
+        threads.emplace_back(worker);
+    }
+
+    worker();
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
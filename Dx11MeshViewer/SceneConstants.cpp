@@ -0,0 +1,108 @@
+//
+// SceneConstants.cpp
+//
+
+#include "pch.h"
+#include "SceneConstants.h"
+
+#include <cmath>
+
+using namespace DirectX;
+
+void FocusCamera(SceneState& scene, const XMFLOAT3& boundsMin, const XMFLOAT3& boundsMax)
+{
+    XMVECTOR min = XMLoadFloat3(&boundsMin);
+    XMVECTOR max = XMLoadFloat3(&boundsMax);
+
+    XMStoreFloat3(&scene.CameraFocus, (max + min) / 2 * scene.ObjectScale);
+}
+
+namespace
+{
+    // The orbital camera's eye position, view & projection transforms
+    void ComputeCamera(const SceneState& scene, float aspectRatio, XMVECTOR& outCameraPosition, XMMATRIX& outViewMat, XMMATRIX& outProjMat)
+    {
+        const float degToRads = XM_PI / 180.0f;
+        XMVECTOR yAxis = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+
+        float phi   = scene.CameraPhi * degToRads;
+        float theta = scene.CameraTheta * degToRads;
+
+        // Spherical to Cartesian Coordinates
+        outCameraPosition = XMVectorSet(
+            scene.CameraDistance * sinf(phi) * cosf(theta),
+            scene.CameraDistance * cosf(phi),
+            scene.CameraDistance * sinf(phi) * sinf(theta),
+            1.0f
+        );
+
+        outViewMat = XMMatrixLookAtRH(outCameraPosition, XMLoadFloat3(&scene.CameraFocus), yAxis);
+        outProjMat = XMMatrixPerspectiveFovRH(scene.FieldOfViewY * degToRads, aspectRatio, scene.NearZ, scene.FarZ);
+    }
+}
+
+void ComputeShaderConstants(const SceneState& scene, float aspectRatio, AppShaderConstants& outConstants)
+{
+    const float degToRads = XM_PI / 180.0f;
+    XMVECTOR yAxis = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+
+    // Compute our object's world-space transform
+    XMMATRIX worldMat = XMMatrixAffineTransformation(
+        XMVectorReplicate(scene.ObjectScale),
+        XMQuaternionIdentity(),
+        XMQuaternionRotationAxis(yAxis, scene.ObjectRotation * degToRads),
+        XMLoadFloat3(&scene.ObjectPosition)
+    );
+
+    XMVECTOR cameraPosition;
+    XMMATRIX viewMat;
+    XMMATRIX projMat;
+    ComputeCamera(scene, aspectRatio, cameraPosition, viewMat, projMat);
+
+    XMMATRIX worldViewProjMat = worldMat * viewMat * projMat;
+
+    outConstants = {};
+    XMStoreFloat4x4(&outConstants.World, XMMatrixTranspose(worldMat)); // Want to keep consistent
+    XMStoreFloat4x4(&outConstants.WorldViewProjection, XMMatrixTranspose(worldViewProjMat));
+
+    XMStoreFloat3(&outConstants.ObjectColor, XMLoadFloat3(&scene.ObjectColor));
+    outConstants.ObjectShininess = scene.ObjectShininess;
+
+    XMStoreFloat4(&outConstants.LightPositionWS, XMLoadFloat3(&scene.LightPosition));
+    XMStoreFloat4(&outConstants.LightColor, XMLoadFloat3(&scene.LightColor));
+
+    XMStoreFloat4(&outConstants.CameraPositionWS, cameraPosition);
+}
+
+void SplitShaderConstants(const AppShaderConstants& constants, AppFrameConstants& outFrame, AppMaterialConstants& outMaterial)
+{
+    outFrame.LightPositionWS  = constants.LightPositionWS;
+    outFrame.LightColor       = constants.LightColor;
+    outFrame.CameraPositionWS = constants.CameraPositionWS;
+
+    outMaterial.ObjectColor     = constants.ObjectColor;
+    outMaterial.ObjectShininess = constants.ObjectShininess;
+}
+
+void ComposeInstanceConstants(const AppFrameConstants& frame, const AppMaterialConstants& material, const AppInstanceData& instance, AppShaderConstants& outConstants)
+{
+    outConstants.World               = instance.World;
+    outConstants.WorldViewProjection = instance.WorldViewProjection;
+
+    XMStoreFloat3(&outConstants.ObjectColor, XMLoadFloat3(&material.ObjectColor) * XMLoadFloat3(&instance.Color));
+    outConstants.ObjectShininess = material.ObjectShininess;
+
+    outConstants.LightPositionWS  = frame.LightPositionWS;
+    outConstants.LightColor       = frame.LightColor;
+    outConstants.CameraPositionWS = frame.CameraPositionWS;
+}
+
+void ComputeViewProjection(const SceneState& scene, float aspectRatio, XMFLOAT4X4& outViewProjection)
+{
+    XMVECTOR cameraPosition;
+    XMMATRIX viewMat;
+    XMMATRIX projMat;
+    ComputeCamera(scene, aspectRatio, cameraPosition, viewMat, projMat);
+
+    XMStoreFloat4x4(&outViewProjection, XMMatrixTranspose(viewMat * projMat));
+}
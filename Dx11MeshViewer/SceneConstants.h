@@ -0,0 +1,106 @@
+//
+// SceneConstants.h
+//
+
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstdint>
+
+// Every shader input for drawing one object, as the CPU renderer takes them - the GPU gets the same values split by
+// how often they change, as the blocks below
+// Matrices are stored transposed, as HLSL reads constant buffer matrices column-major
+struct AppShaderConstants
+{
+    // Transforms
+    DirectX::XMFLOAT4X4 World;
+    DirectX::XMFLOAT4X4 WorldViewProjection;
+
+    // Object material properties
+    DirectX::XMFLOAT3   ObjectColor;
+    float               ObjectShininess;
+
+    // Light properties
+    DirectX::XMFLOAT4   LightPositionWS;
+    DirectX::XMFLOAT4   LightColor;
+
+    // Camera properties
+    DirectX::XMFLOAT4   CameraPositionWS;
+};
+
+
+////
+// Constant buffers as BasicVS.hlsl & BasicPS.hlsl declare them, one per update frequency, so a block is only uploaded
+// when something in it changed
+
+// b0 - changes when the camera or light moves
+struct AppFrameConstants
+{
+    DirectX::XMFLOAT4   LightPositionWS;
+    DirectX::XMFLOAT4   LightColor;
+    DirectX::XMFLOAT4   CameraPositionWS;
+};
+
+// b1 - shared by every instance drawn with the material
+struct AppMaterialConstants
+{
+    DirectX::XMFLOAT3   ObjectColor;
+    float               ObjectShininess;
+};
+
+// b2 - per instanced draw, as each object's own data is in its AppInstanceData
+struct AppObjectConstants
+{
+    uint32_t            FirstInstance;  // Of the draw's instances in the buffer, as SV_InstanceID counts from 0 in every draw
+    uint32_t            Padding[3];
+};
+
+// One element of the Instances structured buffer in BasicVS.hlsl - a copy of the mesh drawn by DrawIndexedInstanced
+// Matrices are stored transposed like the constants', as HLSL reads structured buffer matrices column-major too
+struct AppInstanceData
+{
+    DirectX::XMFLOAT4X4 World;
+    DirectX::XMFLOAT4X4 WorldViewProjection;
+
+    DirectX::XMFLOAT3   Color;   // Multiplies the material's ObjectColor
+    float               Padding;
+};
+
+// Everything the constants are computed from - the defaults are the viewer's startup scene
+struct SceneState
+{
+    // Object properties
+    DirectX::XMFLOAT3   ObjectPosition  = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+    float               ObjectRotation  = 0.0f;   // Degrees about the Y-axis
+    float               ObjectScale     = 0.7f;
+    DirectX::XMFLOAT3   ObjectColor     = DirectX::XMFLOAT3(0.6f, 0.7f, 0.1f);
+    float               ObjectShininess = 256.0f;
+
+    // Orbital camera properties (spherical coordinates about the origin, in degrees)
+    DirectX::XMFLOAT3   CameraFocus     = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+    float               CameraDistance  = 5.0f;
+    float               CameraPhi       = 60.0f;
+    float               CameraTheta     = 0.0f;
+    float               FieldOfViewY    = 60.0f;  // Degrees
+    float               NearZ           = 0.25f;
+    float               FarZ            = 1000.0f;
+
+    DirectX::XMFLOAT3   LightPosition   = DirectX::XMFLOAT3(1.0f, 3.0f, 0.0f);
+    DirectX::XMFLOAT3   LightColor      = DirectX::XMFLOAT3(1.0f, 1.0f, 1.0f);
+};
+
+// Points the camera at the center of the mesh bounds, as scaled into world space
+void FocusCamera(SceneState& scene, const DirectX::XMFLOAT3& boundsMin, const DirectX::XMFLOAT3& boundsMax);
+
+// Composes the world, view & projection transforms and gathers the material, light & camera properties
+void ComputeShaderConstants(const SceneState& scene, float aspectRatio, AppShaderConstants& outConstants);
+
+// The per-frame & per-material blocks of the constants
+void SplitShaderConstants(const AppShaderConstants& constants, AppFrameConstants& outFrame, AppMaterialConstants& outMaterial);
+
+// The constants BasicVS & BasicPS shade one instance with - its transforms from the packed instance data, & the
+// material's color times the instance's, as the shaders fetch them by SV_InstanceID
+void ComposeInstanceConstants(const AppFrameConstants& frame, const AppMaterialConstants& material, const AppInstanceData& instance, AppShaderConstants& outConstants);
+
+// The camera's view & projection transforms alone, for world space culling - stored transposed like the constants
+void ComputeViewProjection(const SceneState& scene, float aspectRatio, DirectX::XMFLOAT4X4& outViewProjection);
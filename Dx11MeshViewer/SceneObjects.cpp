@@ -0,0 +1,81 @@
+//
+// SceneObjects.cpp
+//
+
+#include "pch.h"
+#include "SceneObjects.h"
+
+using namespace DirectX;
+
+uint32_t SceneObjectList::Add(FXMMATRIX world, const XMFLOAT3& localMin, const XMFLOAT3& localMax)
+{
+    XMVECTOR min = XMLoadFloat3(&localMin);
+    XMVECTOR max = XMLoadFloat3(&localMax);
+
+    XMFLOAT3 center;
+    XMFLOAT3 extents;
+    XMStoreFloat3(&center, (max + min) / 2);
+    XMStoreFloat3(&extents, (max - min) / 2);
+
+    m_world.emplace_back();
+    m_localCenter.push_back(center);
+    m_localExtents.push_back(extents);
+    for (int a = 0; a < 3; ++a)
+    {
+        m_boundsMin[a].push_back(0.0f);
+        m_boundsMax[a].push_back(0.0f);
+    }
+
+    uint32_t index = static_cast<uint32_t>(m_world.size() - 1);
+    SetWorld(index, world);
+    return index;
+}
+
+void SceneObjectList::SetWorld(uint32_t index, FXMMATRIX world)
+{
+    XMStoreFloat4x4(&m_world[index], world);
+
+    // The transformed box's center, & each world axis' reach as the absolute projections of the local half sizes
+    // onto it (Arvo 1990) - exact for the box's corners, without transforming all 8
+    XMVECTOR center  = XMVector3Transform(XMLoadFloat3(&m_localCenter[index]), world);
+    XMVECTOR extents = XMLoadFloat3(&m_localExtents[index]);
+
+    XMVECTOR reach = XMVectorAbs(world.r[0]) * XMVectorSplatX(extents) + XMVectorAbs(world.r[1]) * XMVectorSplatY(extents) +
+                     XMVectorAbs(world.r[2]) * XMVectorSplatZ(extents);
+
+    XMFLOAT3 min;
+    XMFLOAT3 max;
+    XMStoreFloat3(&min, center - reach);
+    XMStoreFloat3(&max, center + reach);
+
+    m_boundsMin[0][index] = min.x;
+    m_boundsMin[1][index] = min.y;
+    m_boundsMin[2][index] = min.z;
+    m_boundsMax[0][index] = max.x;
+    m_boundsMax[1][index] = max.y;
+    m_boundsMax[2][index] = max.z;
+}
+
+void SceneObjectList::Clear()
+{
+    m_world.clear();
+    m_localCenter.clear();
+    m_localExtents.clear();
+    for (int a = 0; a < 3; ++a)
+    {
+        m_boundsMin[a].clear();
+        m_boundsMax[a].clear();
+    }
+}
+
+BoxArrays SceneObjectList::Boxes() const
+{
+    BoxArrays boxes;
+    for (int a = 0; a < 3; ++a)
+    {
+        boxes.Min[a] = m_boundsMin[a].data();
+        boxes.Max[a] = m_boundsMax[a].data();
+    }
+    boxes.Count = m_world.size();
+    return boxes;
+}
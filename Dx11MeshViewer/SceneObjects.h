@@ -0,0 +1,38 @@
+//
+// SceneObjects.h
+//
+
+#pragma once
+
+#include "VertexBounds.h"
+
+#include <DirectXMath.h>
+#include <cstdint>
+#include <vector>
+
+// Meshes placed in the scene - each object's world transform & the world space box around its mesh, with the boxes
+// kept as structure-of-arrays so culling passes stream just the coordinates they test
+class SceneObjectList
+{
+public:
+    // Places an object bounded by localMin & localMax in object space - returns its index
+    uint32_t  Add(DirectX::FXMMATRIX world, const DirectX::XMFLOAT3& localMin, const DirectX::XMFLOAT3& localMax);
+
+    // Moves an object, refitting its world space box
+    void      SetWorld(uint32_t index, DirectX::FXMMATRIX world);
+
+    void      Clear();
+
+    size_t                     Count() const                  { return m_world.size(); }
+    const DirectX::XMFLOAT4X4& World(uint32_t index) const    { return m_world[index]; }
+
+    // World space boxes - valid until the next Add or Clear
+    BoxArrays Boxes() const;
+
+private:
+    std::vector<DirectX::XMFLOAT4X4> m_world;
+    std::vector<DirectX::XMFLOAT3>   m_localCenter;
+    std::vector<DirectX::XMFLOAT3>   m_localExtents; // Half sizes
+    std::vector<float>               m_boundsMin[3];
+    std::vector<float>               m_boundsMax[3];
+};
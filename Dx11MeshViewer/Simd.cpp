@@ -0,0 +1,69 @@
+//
+// Simd.cpp
+//
+
+#include "pch.h"
+#include "Simd.h"
+
+static SimdLevel DetectSimdLevel()
+{
+#if !SIMD_X86
+    return SimdLevel::Scalar;
+#elif defined(_MSC_VER)
+    int info[4] = {};
+    __cpuid(info, 1);
+
+    bool sse42   = (info[2] & (1 << 20)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx     = (info[2] & (1 << 28)) != 0;
+
+    // AVX registers are only usable if the OS saves the YMM state on context switches, & AVX-512's the opmask & ZMM state too
+    unsigned long long xcr0 = (osxsave && avx) ? _xgetbv(0) : 0;
+    bool avxState    = (xcr0 & 0x6) == 0x6;
+    bool avx512State = (xcr0 & 0xE6) == 0xE6;
+
+    __cpuidex(info, 7, 0);
+    bool avx2    = (info[1] & (1 << 5)) != 0;
+    bool bmi     = (info[1] & (1 << 3)) != 0;
+    bool avx512f = (info[1] & (1 << 16)) != 0;
+
+    if (avx512State && avx2 && bmi && avx512f)
+    {
+        return SimdLevel::Avx512;
+    }
+    if (avxState && avx2 && bmi)
+    {
+        return SimdLevel::Avx2;
+    }
+    return sse42 ? SimdLevel::Sse42 : SimdLevel::Scalar;
+#else
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi"))
+    {
+        return SimdLevel::Avx512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi"))
+    {
+        return SimdLevel::Avx2;
+    }
+    return __builtin_cpu_supports("sse4.2") ? SimdLevel::Sse42 : SimdLevel::Scalar;
+#endif
+}
+
+SimdLevel GetSupportedSimdLevel()
+{
+    static const SimdLevel s_level = DetectSimdLevel();
+    return s_level;
+}
+
+const char* GetSimdLevelName(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::Sse42:  return "SSE4.2";
+    case SimdLevel::Avx2:   return "AVX2";
+    case SimdLevel::Avx512: return "AVX-512";
+    default:                return "Scalar";
+    }
+}
@@ -0,0 +1,91 @@
+//
+// Simd.h
+//
+
+#pragma once
+
+#include <cstdint>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86 1
+#else
+#define SIMD_X86 0
+#endif
+
+#if SIMD_X86
+#include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Per-function instruction set enablement - MSVC accepts any intrinsic anywhere, GCC & Clang need the target spelled out
+#if defined(_MSC_VER)
+#define SIMD_TARGET_SSE42
+#define SIMD_TARGET_AVX2
+#define SIMD_TARGET_AVX512
+#else
+#define SIMD_TARGET_SSE42  __attribute__((target("sse4.2")))
+#define SIMD_TARGET_AVX2   __attribute__((target("avx2,bmi")))
+#define SIMD_TARGET_AVX512 __attribute__((target("avx512f,avx2,bmi")))
+#endif
+
+// Instruction set tiers of the hand-vectorized CPU kernels, in increasing order
+enum class SimdLevel
+{
+    Scalar,
+    Sse42,
+    Avx2,
+    Avx512,   // AVX-512F
+};
+
+// Highest tier supported by both the CPU and the OS (detected once)
+SimdLevel   GetSupportedSimdLevel();
+const char* GetSimdLevelName(SimdLevel level);
+
+// Index of the lowest set bit - mask must be non-zero
+inline unsigned CountTrailingZeros(uint32_t mask)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+// Number of set bits
+inline unsigned PopCount(uint32_t mask)
+{
+#if defined(_MSC_VER)
+    unsigned count = 0;
+    for (; mask != 0; mask &= mask - 1)
+    {
+        ++count;
+    }
+    return count;
+#else
+    return static_cast<unsigned>(__builtin_popcount(mask));
+#endif
+}
+
+#if SIMD_X86
+// AVX-512 arithmetic with explicit rounding, which compilers can't fuse into FMAs the way they may fuse _mm512_mul_ps
+// & _mm512_add_ps under an AVX-512 target - for kernels that must round exactly like the other levels
+SIMD_TARGET_AVX512 inline __m512 MultiplyRounded(__m512 a, __m512 b)
+{
+    return _mm512_mul_round_ps(a, b, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+}
+
+SIMD_TARGET_AVX512 inline __m512 AddRounded(__m512 a, __m512 b)
+{
+    return _mm512_add_round_ps(a, b, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+}
+
+SIMD_TARGET_AVX512 inline __m512 SubtractRounded(__m512 a, __m512 b)
+{
+    return _mm512_sub_round_ps(a, b, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+}
+#endif
@@ -0,0 +1,1161 @@
+//
+// SoftwareRenderer.cpp
+//
+
+#include "pch.h"
+#include "SoftwareRenderer.h"
+#include "BlinnPhongKernel.h"
+#include "MeshLoader.h"
+#include "Simd.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+namespace
+{
+    const size_t   VertexSize      = 6;
+    const size_t   AttributeCount  = 6;       // World space position & normal
+    const size_t   VertexBlockSize = 4096;    // Vertices per geometry work item
+    const size_t   SetupBlockSize  = 1024;    // Triangles per geometry work item, each binning its own
+    const uint32_t TileSize        = 64;      // Pixels along each side of a raster work item
+    const uint32_t MaxDimension    = 16384;
+    const int      SubpixelBits    = 8;
+    const float    SubpixelScale   = 256.0f;
+    const int64_t  PixelSize       = 1 << SubpixelBits;
+    const int64_t  PixelCenter     = PixelSize / 2;
+    const int32_t  BlockHeight     = 8;       // Rows of a block, the unit of hierarchical rejection & of the coverage kernels
+    const int32_t  MaxSpanWidth    = 16;      // Pixels of a block row at AVX-512, the widest level
+
+    // Edges with |A| + |B| under this vary by less than 2^31 across any block, so a block that an edge crosses can be
+    // evaluated in 32-bit lanes - longer edges fall back to 64-bit arithmetic
+    const int64_t  NarrowEdgeLimit = int64_t(1) << 19;
+
+    // Clip space x & y are clipped at this multiple of w rather than at the viewport edges, which leaves almost every
+    // triangle unclipped while keeping snapped coordinates within 24 bits for any viewport up to MaxDimension
+    const float    GuardBand       = 3.0f;
+    const int      ClipPlaneCount  = 6;
+    const int      MaxClipVertices = 3 + ClipPlaneCount;
+
+    // VSMain's outputs
+    struct ShadedVertex
+    {
+        float Clip[4];
+        float Attributes[AttributeCount]; // PositionWS, NormalWS
+    };
+
+    // A clipped, snapped triangle ready for traversal - wound so that all three edge functions are positive inside
+    struct SetupTriangle
+    {
+        int64_t  EdgeA[3];      // Edge i runs between the two vertices other than i; Ei = A * x + B * y + C
+        int64_t  EdgeB[3];
+        int64_t  EdgeC[3];      // Includes the fill rule bias, so a pixel is covered when every Ei >= 0
+        float    InvArea;
+        uint32_t WideEdges;     // Bit i set when edge i is too long for 32-bit evaluation
+
+        float    BaryStepX[3];  // Change in each barycentric coordinate per pixel
+        float    BaryStepY[3];
+        float    Z[3];          // z / w
+        float    InvW[3];
+        float    Attributes[3][AttributeCount]; // Divided by w, for perspective-correct interpolation
+    };
+
+    // Inclusive pixel bounds of a set up triangle, within the viewport - kept apart from the rest of the setup, which
+    // binning doesn't otherwise read for triangles within one tile
+    struct PixelRect
+    {
+        int32_t MinX, MinY, MaxX, MaxY;
+    };
+
+    // Set up triangles of one geometry work item, in submission order, & the screen tiles they touch
+    struct SetupBlock
+    {
+        std::vector<SetupTriangle> Triangles;
+        std::vector<PixelRect>     Bounds;
+        std::vector<uint32_t>      BinStart;     // Tile t's triangles are BinTriangles[BinStart[t], BinStart[t + 1])
+        std::vector<uint32_t>      BinTriangles; // Indices into Triangles, grouped by tile & ascending within each
+    };
+
+
+    ////
+    // Shader stages
+
+    // mul(v, M) for a matrix stored transposed, as in the constant buffer - each stored row dots with v
+    void TransformRow(const DirectX::XMFLOAT4X4& m, const float* v, float* out, int rows)
+    {
+        for (int r = 0; r < rows; ++r)
+        {
+            out[r] = m.m[r][0] * v[0] + m.m[r][1] * v[1] + m.m[r][2] * v[2] + m.m[r][3] * v[3];
+        }
+    }
+
+    // BasicVS.hlsl VSMain
+    void ShadeVertex(const float* vertex, const AppShaderConstants& constants, ShadedVertex& out)
+    {
+        const float position[4] = { vertex[0], vertex[1], vertex[2], 1.0f };
+        const float normal[4]   = { vertex[3], vertex[4], vertex[5], 0.0f };
+
+        TransformRow(constants.WorldViewProjection, position, out.Clip, 4);
+        TransformRow(constants.World, position, out.Attributes, 3);
+        TransformRow(constants.World, normal, out.Attributes + 3, 3);
+    }
+
+    float Saturate(float x)
+    {
+        // Also maps NaN to 0, as HLSL's saturate does
+        return (x > 0.0f) ? std::min(x, 1.0f) : 0.0f;
+    }
+
+    uint32_t PackSrgb(const float* color, float alpha)
+    {
+        // Alpha is stored linearly
+        uint32_t a = static_cast<uint32_t>(Saturate(alpha) * 255.0f + 0.5f);
+        return LinearToSrgb8(color[0]) | (LinearToSrgb8(color[1]) << 8) | (LinearToSrgb8(color[2]) << 16) | (a << 24);
+    }
+
+
+    ////
+    // Clipping
+
+    float PlaneDistance(const float* clip, int plane)
+    {
+        switch (plane)
+        {
+        case 0:  return clip[2];                        // Near - z >= 0
+        case 1:  return clip[3] - clip[2];              // Far - z <= w
+        case 2:  return clip[0] + GuardBand * clip[3];
+        case 3:  return GuardBand * clip[3] - clip[0];
+        case 4:  return clip[1] + GuardBand * clip[3];
+        default: return GuardBand * clip[3] - clip[1];
+        }
+    }
+
+    uint32_t Outcode(const float* clip)
+    {
+        uint32_t code = 0;
+        for (int plane = 0; plane < ClipPlaneCount; ++plane)
+        {
+            code |= (PlaneDistance(clip, plane) < 0.0f) ? (1u << plane) : 0u;
+        }
+        return code;
+    }
+
+    ShadedVertex Lerp(const ShadedVertex& a, const ShadedVertex& b, float t)
+    {
+        ShadedVertex v;
+        for (int i = 0; i < 4; ++i)
+        {
+            v.Clip[i] = a.Clip[i] + (b.Clip[i] - a.Clip[i]) * t;
+        }
+        for (size_t i = 0; i < AttributeCount; ++i)
+        {
+            v.Attributes[i] = a.Attributes[i] + (b.Attributes[i] - a.Attributes[i]) * t;
+        }
+        return v;
+    }
+
+    // Sutherland-Hodgman against each plane the polygon crosses - returns the remaining vertex count
+    int ClipPolygon(ShadedVertex* polygon, int count, uint32_t planes)
+    {
+        ShadedVertex scratch[MaxClipVertices];
+
+        for (int plane = 0; plane < ClipPlaneCount && count > 0; ++plane)
+        {
+            if (!(planes & (1u << plane)))
+            {
+                continue;
+            }
+
+            int clippedCount = 0;
+            for (int i = 0; i < count; ++i)
+            {
+                const ShadedVertex& a = polygon[i];
+                const ShadedVertex& b = polygon[(i + 1) % count];
+
+                float da = PlaneDistance(a.Clip, plane);
+                float db = PlaneDistance(b.Clip, plane);
+
+                if (da >= 0.0f)
+                {
+                    scratch[clippedCount++] = a;
+                }
+
+                if ((da >= 0.0f) != (db >= 0.0f))
+                {
+                    scratch[clippedCount++] = Lerp(a, b, da / (da - db));
+                }
+            }
+
+            std::copy(scratch, scratch + clippedCount, polygon);
+            count = clippedCount;
+        }
+
+        return count;
+    }
+
+
+    ////
+    // Triangle setup
+
+    int64_t FloorDiv(int64_t a, int64_t b)
+    {
+        return (a >= 0) ? a / b : -((-a + b - 1) / b);
+    }
+
+    // Snaps to the viewport's fixed point grid & builds the edge functions - false for triangles covering no pixel
+    bool SetupTriangleFromVertices(const ShadedVertex* v0, const ShadedVertex* v1, const ShadedVertex* v2, uint32_t width, uint32_t height, SetupTriangle& out, PixelRect& outBounds)
+    {
+        const ShadedVertex* v[3] = { v0, v1, v2 };
+
+        int64_t x[3], y[3];
+        float   invW[3];
+
+        for (int i = 0; i < 3; ++i)
+        {
+            if (!(v[i]->Clip[3] > 0.0f))
+            {
+                return false;
+            }
+
+            invW[i] = 1.0f / v[i]->Clip[3];
+
+            // NDC to viewport, y pointing down
+            float screenX = (v[i]->Clip[0] * invW[i] * 0.5f + 0.5f) * width;
+            float screenY = (0.5f - v[i]->Clip[1] * invW[i] * 0.5f) * height;
+
+            x[i] = static_cast<int64_t>(std::floor(screenX * SubpixelScale + 0.5f));
+            y[i] = static_cast<int64_t>(std::floor(screenY * SubpixelScale + 0.5f));
+        }
+
+        int64_t area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+        if (area == 0)
+        {
+            return false;
+        }
+
+        // No culling - triangles facing the other way are just rewound
+        int order[3] = { 0, 1, 2 };
+        if (area < 0)
+        {
+            std::swap(order[1], order[2]);
+            area = -area;
+        }
+
+        int64_t minX = INT64_MAX, minY = INT64_MAX, maxX = INT64_MIN, maxY = INT64_MIN;
+
+        for (int i = 0; i < 3; ++i)
+        {
+            int s = order[i];
+
+            out.Z[i]    = v[s]->Clip[2] * invW[s];
+            out.InvW[i] = invW[s];
+            for (size_t a = 0; a < AttributeCount; ++a)
+            {
+                out.Attributes[i][a] = v[s]->Attributes[a] * invW[s];
+            }
+
+            minX = std::min(minX, x[s]);
+            minY = std::min(minY, y[s]);
+            maxX = std::max(maxX, x[s]);
+            maxY = std::max(maxY, y[s]);
+        }
+
+        // Pixels whose centers lie within the snapped bounds
+        outBounds.MinX = static_cast<int32_t>(std::max<int64_t>(FloorDiv(minX - PixelCenter + PixelSize - 1, PixelSize), 0));
+        outBounds.MinY = static_cast<int32_t>(std::max<int64_t>(FloorDiv(minY - PixelCenter + PixelSize - 1, PixelSize), 0));
+        outBounds.MaxX = static_cast<int32_t>(std::min<int64_t>(FloorDiv(maxX - PixelCenter, PixelSize), width - 1));
+        outBounds.MaxY = static_cast<int32_t>(std::min<int64_t>(FloorDiv(maxY - PixelCenter, PixelSize), height - 1));
+
+        if (outBounds.MinX > outBounds.MaxX || outBounds.MinY > outBounds.MaxY)
+        {
+            return false;
+        }
+
+        for (int i = 0; i < 3; ++i)
+        {
+            int a = order[(i + 1) % 3];
+            int b = order[(i + 2) % 3];
+
+            int64_t dx = x[b] - x[a];
+            int64_t dy = y[b] - y[a];
+
+            // E(p) = dx * (p.y - a.y) - dy * (p.x - a.x), positive inside with this winding (clockwise on screen)
+            out.EdgeA[i] = -dy;
+            out.EdgeB[i] = dx;
+            out.EdgeC[i] = dy * x[a] - dx * y[a];
+
+            // Top-left rule - pixels exactly on a top edge (flat, running right) or a left edge (running up) are
+            // covered, those on any other edge are left to the neighboring triangle
+            bool topLeft = (dy == 0 && dx > 0) || dy < 0;
+            if (!topLeft)
+            {
+                out.EdgeC[i] -= 1;
+            }
+        }
+
+        out.InvArea   = static_cast<float>(1.0 / static_cast<double>(area));
+        out.WideEdges = 0;
+
+        for (int i = 0; i < 3; ++i)
+        {
+            out.BaryStepX[i] = static_cast<float>(static_cast<double>(out.EdgeA[i] * PixelSize) / static_cast<double>(area));
+            out.BaryStepY[i] = static_cast<float>(static_cast<double>(out.EdgeB[i] * PixelSize) / static_cast<double>(area));
+
+            if (std::abs(out.EdgeA[i]) + std::abs(out.EdgeB[i]) >= NarrowEdgeLimit)
+            {
+                out.WideEdges |= 1u << i;
+            }
+        }
+        return true;
+    }
+
+    // Clips one triangle & appends the triangles of whatever remains
+    void SetupClippedTriangle(const ShadedVertex& v0, const ShadedVertex& v1, const ShadedVertex& v2, uint32_t width, uint32_t height, SetupBlock& out)
+    {
+        uint32_t code0 = Outcode(v0.Clip);
+        uint32_t code1 = Outcode(v1.Clip);
+        uint32_t code2 = Outcode(v2.Clip);
+
+        if (code0 & code1 & code2)
+        {
+            return;
+        }
+
+        SetupTriangle triangle;
+        PixelRect     bounds;
+
+        if ((code0 | code1 | code2) == 0)
+        {
+            if (SetupTriangleFromVertices(&v0, &v1, &v2, width, height, triangle, bounds))
+            {
+                out.Triangles.push_back(triangle);
+                out.Bounds.push_back(bounds);
+            }
+            return;
+        }
+
+        ShadedVertex polygon[MaxClipVertices] = { v0, v1, v2 };
+        int count = ClipPolygon(polygon, 3, code0 | code1 | code2);
+
+        for (int i = 1; i + 1 < count; ++i)
+        {
+            if (SetupTriangleFromVertices(&polygon[0], &polygon[i], &polygon[i + 1], width, height, triangle, bounds))
+            {
+                out.Triangles.push_back(triangle);
+                out.Bounds.push_back(bounds);
+            }
+        }
+    }
+
+
+    ////
+    // Traversal
+
+    uint32_t LaneMask(int32_t count)
+    {
+        return (count >= 32) ? ~0u : (1u << count) - 1;
+    }
+
+    // Edge functions at the top left pixel center of [x0, x1] x [y0, y1], & which of the given edges cross it - false
+    // when the rectangle lies wholly outside one of them. Edges left out are known to contain the rectangle
+    bool ClassifyRect(const SetupTriangle& triangle, int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint32_t edges, int64_t* e, uint32_t& outPartial)
+    {
+        int64_t px = (int64_t(x0) << SubpixelBits) + PixelCenter;
+        int64_t py = (int64_t(y0) << SubpixelBits) + PixelCenter;
+
+        int64_t extentX = int64_t(x1 - x0) << SubpixelBits;
+        int64_t extentY = int64_t(y1 - y0) << SubpixelBits;
+
+        outPartial = 0;
+
+        for (int i = 0; i < 3; ++i)
+        {
+            e[i] = triangle.EdgeA[i] * px + triangle.EdgeB[i] * py + triangle.EdgeC[i];
+
+            if (!(edges & (1u << i)))
+            {
+                continue;
+            }
+
+            // Linear, so the extremes are at the corners
+            int64_t dx = triangle.EdgeA[i] * extentX;
+            int64_t dy = triangle.EdgeB[i] * extentY;
+
+            int64_t lowest  = e[i] + std::min<int64_t>(dx, 0) + std::min<int64_t>(dy, 0);
+            int64_t highest = e[i] + std::max<int64_t>(dx, 0) + std::max<int64_t>(dy, 0);
+
+            if (highest < 0)
+            {
+                return false;
+            }
+            if (lowest < 0)
+            {
+                outPartial |= 1u << i;
+            }
+        }
+
+        return true;
+    }
+
+    // Barycentrics at a pixel of a span, stepped from the traversal origin the same way at every SIMD level
+    void SpanBarycentrics(const SetupTriangle& triangle, const float* rowBary, float x, float* b)
+    {
+        b[0] = rowBary[0] + triangle.BaryStepX[0] * x;
+        b[1] = rowBary[1] + triangle.BaryStepX[1] * x;
+        b[2] = rowBary[2] + triangle.BaryStepX[2] * x;
+    }
+
+
+    ////
+    // Coverage kernels - write a block's row masks of the pixels inside every edge given, bit i of a row being the pixel
+    // i columns right of the block's left edge. Edges are given at the block's top left pixel center, with their steps
+    // per pixel, & only those that cross the block need be
+
+    // Exact for edges of any length
+    void CoverBlockWide(const int64_t* e, const int64_t* stepX, const int64_t* stepY, int edgeCount, int32_t width, int32_t height, uint32_t* rowMasks)
+    {
+        for (int32_t row = 0; row < height; ++row)
+        {
+            uint32_t mask = 0;
+            for (int32_t lane = 0; lane < width; ++lane)
+            {
+                // Only the sign bits matter - a pixel is covered when no edge is negative
+                int64_t sign = 0;
+                for (int i = 0; i < edgeCount; ++i)
+                {
+                    sign |= e[i] + stepY[i] * row + stepX[i] * lane;
+                }
+                mask |= (sign >= 0) ? (1u << lane) : 0u;
+            }
+            rowMasks[row] = mask;
+        }
+    }
+
+#if SIMD_X86
+    // 4 pixels per instruction, a span being two registers
+    SIMD_TARGET_SSE42 void CoverBlockSse42(const int32_t* e, const int32_t* stepX, const int32_t* stepY, int edgeCount, int32_t width, int32_t height, uint32_t* rowMasks)
+    {
+        const __m128i lane = _mm_setr_epi32(0, 1, 2, 3);
+
+        __m128i left[3], right[3], step[3];
+        for (int i = 0; i < edgeCount; ++i)
+        {
+            __m128i dx = _mm_set1_epi32(stepX[i]);
+            left[i]  = _mm_add_epi32(_mm_set1_epi32(e[i]), _mm_mullo_epi32(dx, lane));
+            right[i] = _mm_add_epi32(left[i], _mm_slli_epi32(dx, 2));
+            step[i]  = _mm_set1_epi32(stepY[i]);
+        }
+
+        for (int32_t row = 0; row < height; ++row)
+        {
+            __m128i signLeft  = _mm_setzero_si128();
+            __m128i signRight = _mm_setzero_si128();
+            for (int i = 0; i < edgeCount; ++i)
+            {
+                signLeft  = _mm_or_si128(signLeft, left[i]);
+                signRight = _mm_or_si128(signRight, right[i]);
+                left[i]   = _mm_add_epi32(left[i], step[i]);
+                right[i]  = _mm_add_epi32(right[i], step[i]);
+            }
+
+            uint32_t outside = static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(signLeft)) | (_mm_movemask_ps(_mm_castsi128_ps(signRight)) << 4));
+            rowMasks[row] = ~outside & LaneMask(width);
+        }
+    }
+
+    // 8 pixels per instruction
+    SIMD_TARGET_AVX2 void CoverBlockAvx2(const int32_t* e, const int32_t* stepX, const int32_t* stepY, int edgeCount, int32_t width, int32_t height, uint32_t* rowMasks)
+    {
+        const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+        __m256i value[3], step[3];
+        for (int i = 0; i < edgeCount; ++i)
+        {
+            value[i] = _mm256_add_epi32(_mm256_set1_epi32(e[i]), _mm256_mullo_epi32(_mm256_set1_epi32(stepX[i]), lane));
+            step[i]  = _mm256_set1_epi32(stepY[i]);
+        }
+
+        for (int32_t row = 0; row < height; ++row)
+        {
+            __m256i sign = _mm256_setzero_si256();
+            for (int i = 0; i < edgeCount; ++i)
+            {
+                sign     = _mm256_or_si256(sign, value[i]);
+                value[i] = _mm256_add_epi32(value[i], step[i]);
+            }
+
+            uint32_t outside = static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(sign)));
+            rowMasks[row] = ~outside & LaneMask(width);
+        }
+    }
+
+    // 16 pixels per instruction
+    SIMD_TARGET_AVX512 void CoverBlockAvx512(const int32_t* e, const int32_t* stepX, const int32_t* stepY, int edgeCount, int32_t width, int32_t height, uint32_t* rowMasks)
+    {
+        const __m512i lane = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+        __m512i value[3], step[3];
+        for (int i = 0; i < edgeCount; ++i)
+        {
+            value[i] = _mm512_add_epi32(_mm512_set1_epi32(e[i]), _mm512_mullo_epi32(_mm512_set1_epi32(stepX[i]), lane));
+            step[i]  = _mm512_set1_epi32(stepY[i]);
+        }
+
+        for (int32_t row = 0; row < height; ++row)
+        {
+            __m512i sign = _mm512_setzero_si512();
+            for (int i = 0; i < edgeCount; ++i)
+            {
+                sign     = _mm512_or_si512(sign, value[i]);
+                value[i] = _mm512_add_epi32(value[i], step[i]);
+            }
+
+            uint32_t inside = _mm512_cmpge_epi32_mask(sign, _mm512_setzero_si512());
+            rowMasks[row] = inside & LaneMask(width);
+        }
+    }
+#endif
+
+
+    ////
+    // Depth test kernels - interpolate z across the covered pixels of a span, write those passing LESS_EQUAL & return
+    // their mask. Every level rounds exactly as the scalar version does
+
+    uint32_t DepthTestSpanScalar(const SetupTriangle& triangle, const float* rowBary, float column, uint32_t cover, float* depth)
+    {
+        uint32_t pass = 0;
+
+        for (; cover != 0; cover &= cover - 1)
+        {
+            unsigned lane = CountTrailingZeros(cover);
+
+            float b[3];
+            SpanBarycentrics(triangle, rowBary, column + static_cast<float>(lane), b);
+
+            float z = b[0] * triangle.Z[0] + b[1] * triangle.Z[1] + b[2] * triangle.Z[2];
+            if (z <= depth[lane])
+            {
+                depth[lane] = z;
+                pass |= 1u << lane;
+            }
+        }
+
+        return pass;
+    }
+
+#if SIMD_X86
+    SIMD_TARGET_SSE42 uint32_t DepthTestSpanSse42(const SetupTriangle& triangle, const float* rowBary, float column, uint32_t cover, float* depth)
+    {
+        uint32_t pass = 0;
+
+        for (uint32_t half = 0; half < 2; ++half)
+        {
+            uint32_t covered = (cover >> (half * 4)) & 0xF;
+            if (covered == 0)
+            {
+                continue;
+            }
+
+            float* halfDepth = depth + half * 4;
+
+            __m128 x  = _mm_add_ps(_mm_set1_ps(column + static_cast<float>(half * 4)), _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f));
+            __m128 b0 = _mm_add_ps(_mm_set1_ps(rowBary[0]), _mm_mul_ps(_mm_set1_ps(triangle.BaryStepX[0]), x));
+            __m128 b1 = _mm_add_ps(_mm_set1_ps(rowBary[1]), _mm_mul_ps(_mm_set1_ps(triangle.BaryStepX[1]), x));
+            __m128 b2 = _mm_add_ps(_mm_set1_ps(rowBary[2]), _mm_mul_ps(_mm_set1_ps(triangle.BaryStepX[2]), x));
+
+            __m128 z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(b0, _mm_set1_ps(triangle.Z[0])), _mm_mul_ps(b1, _mm_set1_ps(triangle.Z[1]))), _mm_mul_ps(b2, _mm_set1_ps(triangle.Z[2])));
+
+            // No masked loads before AVX - only covered pixels are read, as the rest may lie past the target or in
+            // another worker's tile
+            float current[4] = {};
+            for (uint32_t bits = covered; bits != 0; bits &= bits - 1)
+            {
+                unsigned lane = CountTrailingZeros(bits);
+                current[lane] = halfDepth[lane];
+            }
+
+            uint32_t passed = static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(z, _mm_loadu_ps(current)))) & covered;
+
+            float interpolated[4];
+            _mm_storeu_ps(interpolated, z);
+            for (uint32_t bits = passed; bits != 0; bits &= bits - 1)
+            {
+                unsigned lane = CountTrailingZeros(bits);
+                halfDepth[lane] = interpolated[lane];
+            }
+
+            pass |= passed << (half * 4);
+        }
+
+        return pass;
+    }
+
+    SIMD_TARGET_AVX2 uint32_t DepthTestSpanAvx2(const SetupTriangle& triangle, const float* rowBary, float column, uint32_t cover, float* depth)
+    {
+        const __m256i laneBit = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+
+        __m256 x  = _mm256_add_ps(_mm256_set1_ps(column), _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f));
+        __m256 b0 = _mm256_add_ps(_mm256_set1_ps(rowBary[0]), _mm256_mul_ps(_mm256_set1_ps(triangle.BaryStepX[0]), x));
+        __m256 b1 = _mm256_add_ps(_mm256_set1_ps(rowBary[1]), _mm256_mul_ps(_mm256_set1_ps(triangle.BaryStepX[1]), x));
+        __m256 b2 = _mm256_add_ps(_mm256_set1_ps(rowBary[2]), _mm256_mul_ps(_mm256_set1_ps(triangle.BaryStepX[2]), x));
+
+        __m256 z = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(b0, _mm256_set1_ps(triangle.Z[0])), _mm256_mul_ps(b1, _mm256_set1_ps(triangle.Z[1]))), _mm256_mul_ps(b2, _mm256_set1_ps(triangle.Z[2])));
+
+        __m256i covered = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(static_cast<int>(cover)), laneBit), laneBit);
+        __m256  current = _mm256_maskload_ps(depth, covered);
+        __m256  passed  = _mm256_and_ps(_mm256_cmp_ps(z, current, _CMP_LE_OQ), _mm256_castsi256_ps(covered));
+
+        _mm256_maskstore_ps(depth, _mm256_castps_si256(passed), z);
+        return static_cast<uint32_t>(_mm256_movemask_ps(passed));
+    }
+
+    SIMD_TARGET_AVX512 uint32_t DepthTestSpanAvx512(const SetupTriangle& triangle, const float* rowBary, float column, uint32_t cover, float* depth)
+    {
+        __m512 x  = _mm512_add_ps(_mm512_set1_ps(column), _mm512_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f));
+        __m512 b0 = AddRounded(_mm512_set1_ps(rowBary[0]), MultiplyRounded(_mm512_set1_ps(triangle.BaryStepX[0]), x));
+        __m512 b1 = AddRounded(_mm512_set1_ps(rowBary[1]), MultiplyRounded(_mm512_set1_ps(triangle.BaryStepX[1]), x));
+        __m512 b2 = AddRounded(_mm512_set1_ps(rowBary[2]), MultiplyRounded(_mm512_set1_ps(triangle.BaryStepX[2]), x));
+
+        __m512 z = AddRounded(AddRounded(MultiplyRounded(b0, _mm512_set1_ps(triangle.Z[0])), MultiplyRounded(b1, _mm512_set1_ps(triangle.Z[1]))), MultiplyRounded(b2, _mm512_set1_ps(triangle.Z[2])));
+
+        __mmask16 covered = static_cast<__mmask16>(cover);
+        __m512    current = _mm512_maskz_loadu_ps(covered, depth);
+        __mmask16 passed  = _mm512_mask_cmp_ps_mask(covered, z, current, _CMP_LE_OQ);
+
+        _mm512_mask_storeu_ps(depth, passed, z);
+        return passed;
+    }
+#endif
+
+    // Interpolates the attributes perspective-correctly for each pixel of a span that passed, then runs the pixel shader
+    // on them all at once
+    void ShadeSpan(const SetupTriangle& triangle, const float* rowBary, float column, uint32_t pass, const AppShaderConstants& constants, const ShadingOptions& shading, uint32_t* color)
+    {
+        float    attributes[AttributeCount][MaxSpanWidth];
+        unsigned lanes[MaxSpanWidth];
+        size_t   count = 0;
+
+        for (; pass != 0; pass &= pass - 1, ++count)
+        {
+            unsigned lane = CountTrailingZeros(pass);
+
+            float b[3];
+            SpanBarycentrics(triangle, rowBary, column + static_cast<float>(lane), b);
+
+            float invW = b[0] * triangle.InvW[0] + b[1] * triangle.InvW[1] + b[2] * triangle.InvW[2];
+            float w    = 1.0f / invW;
+
+            for (size_t a = 0; a < AttributeCount; ++a)
+            {
+                attributes[a][count] = (b[0] * triangle.Attributes[0][a] + b[1] * triangle.Attributes[1][a] + b[2] * triangle.Attributes[2][a]) * w;
+            }
+            lanes[count] = lane;
+        }
+
+        FragmentBatch fragments;
+        fragments.PositionWS[0] = attributes[0];
+        fragments.PositionWS[1] = attributes[1];
+        fragments.PositionWS[2] = attributes[2];
+        fragments.NormalWS[0]   = attributes[3];
+        fragments.NormalWS[1]   = attributes[4];
+        fragments.NormalWS[2]   = attributes[5];
+        fragments.Count         = count;
+
+        float  shaded[3][MaxSpanWidth];
+        float* outColor[3] = { shaded[0], shaded[1], shaded[2] };
+        ShadeFragments(fragments, constants, outColor, shading);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const float rgb[3] = { shaded[0][i], shaded[1][i], shaded[2][i] };
+            color[lanes[i]] = PackSrgb(rgb, 1.0f);
+        }
+    }
+
+    struct RasterKernels
+    {
+        int32_t SpanWidth;
+
+        // Null at the scalar level, which evaluates every edge in 64 bits
+        void     (*CoverBlock)(const int32_t* e, const int32_t* stepX, const int32_t* stepY, int edgeCount, int32_t width, int32_t height, uint32_t* rowMasks);
+        uint32_t (*DepthTestSpan)(const SetupTriangle& triangle, const float* rowBary, float column, uint32_t cover, float* depth);
+    };
+
+    RasterKernels SelectRasterKernels(SimdLevel level)
+    {
+#if SIMD_X86
+        switch (std::min(level, GetSupportedSimdLevel()))
+        {
+        case SimdLevel::Avx512: return { 16, CoverBlockAvx512, DepthTestSpanAvx512 };
+        case SimdLevel::Avx2:   return { 8, CoverBlockAvx2, DepthTestSpanAvx2 };
+        case SimdLevel::Sse42:  return { 8, CoverBlockSse42, DepthTestSpanSse42 };
+        default:                break;
+        }
+#else
+        (void)level;
+#endif
+        return { 8, nullptr, DepthTestSpanScalar };
+    }
+
+    // Covers the part of the triangle within [x0, x1] x [y0, y1], depth testing & shading each covered pixel
+    //
+    // Hierarchical - the whole rectangle is tested against the edges first, then each block of SpanWidth x BlockHeight
+    // pixels against those edges that cross the rectangle. Blocks outside an edge are skipped, blocks inside all of them
+    // need no per-pixel edge tests, & only the rest run the coverage kernel
+    void RasterizeTriangle(const SetupTriangle& triangle, int32_t x0, int32_t y0, int32_t x1, int32_t y1, const RasterKernels& kernels, const AppShaderConstants& constants, const ShadingOptions& shading, bool depthOnly, SoftwareFrame& frame, SoftwareRenderStats& stats)
+    {
+        int64_t  e[3];
+        uint32_t partial;
+
+        if (!ClassifyRect(triangle, x0, y0, x1, y1, 0x7, e, partial))
+        {
+            return;
+        }
+
+        // Barycentrics at the rectangle's top left, which doesn't depend on the block size
+        float originBary[3];
+        for (int i = 0; i < 3; ++i)
+        {
+            originBary[i] = static_cast<float>(e[i]) * triangle.InvArea;
+        }
+
+        const int32_t spanWidth = kernels.SpanWidth;
+
+        for (int32_t blockY0 = y0, blockY1; blockY0 <= y1; blockY0 = blockY1 + 1)
+        {
+            blockY1 = std::min(y1, (blockY0 / BlockHeight + 1) * BlockHeight - 1);
+
+            for (int32_t blockX0 = x0, blockX1; blockX0 <= x1; blockX0 = blockX1 + 1)
+            {
+                blockX1 = std::min(x1, (blockX0 / spanWidth + 1) * spanWidth - 1);
+
+                int64_t  blockE[3];
+                uint32_t blockPartial;
+
+                ++stats.BlocksTested;
+                if (!ClassifyRect(triangle, blockX0, blockY0, blockX1, blockY1, partial, blockE, blockPartial))
+                {
+                    ++stats.BlocksRejected;
+                    continue;
+                }
+
+                const int32_t width  = blockX1 - blockX0 + 1;
+                const int32_t height = blockY1 - blockY0 + 1;
+
+                uint32_t rowMasks[BlockHeight];
+
+                if (blockPartial == 0)
+                {
+                    ++stats.BlocksCovered;
+                    std::fill(rowMasks, rowMasks + height, LaneMask(width));
+                }
+                else
+                {
+                    int64_t e64[3], stepX64[3], stepY64[3];
+                    int     edgeCount = 0;
+
+                    for (int i = 0; i < 3; ++i)
+                    {
+                        if (blockPartial & (1u << i))
+                        {
+                            e64[edgeCount]     = blockE[i];
+                            stepX64[edgeCount] = triangle.EdgeA[i] * PixelSize;
+                            stepY64[edgeCount] = triangle.EdgeB[i] * PixelSize;
+                            ++edgeCount;
+                        }
+                    }
+
+                    if (kernels.CoverBlock && !(blockPartial & triangle.WideEdges))
+                    {
+                        int32_t e32[3], stepX32[3], stepY32[3];
+                        for (int i = 0; i < edgeCount; ++i)
+                        {
+                            e32[i]     = static_cast<int32_t>(e64[i]);
+                            stepX32[i] = static_cast<int32_t>(stepX64[i]);
+                            stepY32[i] = static_cast<int32_t>(stepY64[i]);
+                        }
+                        kernels.CoverBlock(e32, stepX32, stepY32, edgeCount, width, height, rowMasks);
+                    }
+                    else
+                    {
+                        CoverBlockWide(e64, stepX64, stepY64, edgeCount, width, height, rowMasks);
+                    }
+                }
+
+                const float column = static_cast<float>(blockX0 - x0);
+
+                for (int32_t row = 0; row < height; ++row)
+                {
+                    uint32_t cover = rowMasks[row];
+                    if (cover == 0)
+                    {
+                        continue;
+                    }
+
+                    const int32_t y = blockY0 + row;
+
+                    float rowBary[3];
+                    for (int i = 0; i < 3; ++i)
+                    {
+                        rowBary[i] = originBary[i] + triangle.BaryStepY[i] * static_cast<float>(y - y0);
+                    }
+
+                    size_t   pixel = size_t(y) * frame.Width + blockX0;
+                    uint32_t pass  = kernels.DepthTestSpan(triangle, rowBary, column, cover, &frame.Depth[pixel]);
+
+                    stats.PixelsCovered += PopCount(cover);
+                    stats.PixelsWritten += PopCount(pass);
+
+                    if (pass != 0 && !depthOnly)
+                    {
+                        ShadeSpan(triangle, rowBary, column, pass, constants, shading, &frame.Color[pixel]);
+                    }
+                }
+            }
+        }
+    }
+
+
+    ////
+    // Binning
+
+    // Sorts a block's triangles into the screen tiles they touch - a triangle whose bounds span several tiles is only
+    // binned to those its edges don't exclude
+    void BinTriangles(SetupBlock& block, uint32_t tilesX, uint32_t tilesY)
+    {
+        std::vector<uint32_t> refTiles;     // (tile, triangle) references, in triangle order
+        std::vector<uint32_t> refTriangles;
+        refTiles.reserve(block.Triangles.size() * 2);
+        refTriangles.reserve(block.Triangles.size() * 2);
+
+        for (uint32_t t = 0; t < static_cast<uint32_t>(block.Triangles.size()); ++t)
+        {
+            const PixelRect& bounds = block.Bounds[t];
+
+            uint32_t tileX0 = bounds.MinX / TileSize;
+            uint32_t tileY0 = bounds.MinY / TileSize;
+            uint32_t tileX1 = bounds.MaxX / TileSize;
+            uint32_t tileY1 = bounds.MaxY / TileSize;
+
+            for (uint32_t tileY = tileY0; tileY <= tileY1; ++tileY)
+            {
+                for (uint32_t tileX = tileX0; tileX <= tileX1; ++tileX)
+                {
+                    if (tileX0 != tileX1 || tileY0 != tileY1)
+                    {
+                        int32_t x0 = std::max<int32_t>(bounds.MinX, tileX * TileSize);
+                        int32_t y0 = std::max<int32_t>(bounds.MinY, tileY * TileSize);
+                        int32_t x1 = std::min<int32_t>(bounds.MaxX, (tileX + 1) * TileSize - 1);
+                        int32_t y1 = std::min<int32_t>(bounds.MaxY, (tileY + 1) * TileSize - 1);
+
+                        int64_t  e[3];
+                        uint32_t partial;
+                        if (!ClassifyRect(block.Triangles[t], x0, y0, x1, y1, 0x7, e, partial))
+                        {
+                            continue;
+                        }
+                    }
+
+                    refTiles.push_back(tileY * tilesX + tileX);
+                    refTriangles.push_back(t);
+                }
+            }
+        }
+
+        // Counting sort by tile, which keeps each tile's triangles in order
+        block.BinStart.assign(size_t(tilesX) * tilesY + 1, 0);
+        for (uint32_t tile : refTiles)
+        {
+            ++block.BinStart[tile + 1];
+        }
+        for (size_t tile = 1; tile < block.BinStart.size(); ++tile)
+        {
+            block.BinStart[tile] += block.BinStart[tile - 1];
+        }
+
+        std::vector<uint32_t> cursor(block.BinStart.begin(), block.BinStart.end() - 1);
+
+        block.BinTriangles.resize(refTiles.size());
+        for (size_t r = 0; r < refTiles.size(); ++r)
+        {
+            block.BinTriangles[cursor[refTiles[r]]++] = refTriangles[r];
+        }
+    }
+}
+
+HRESULT RenderMesh(const Mesh& mesh, const std::vector<Submesh>& submeshes, const AppShaderConstants& constants, SoftwareFrame& frame, const SoftwareRenderOptions& options, SoftwareRenderStats* outStats)
+{
+    using namespace std::chrono;
+
+    if (frame.Width == 0 || frame.Height == 0 || frame.Width > MaxDimension || frame.Height > MaxDimension)
+    {
+        return E_INVALIDARG;
+    }
+
+    const uint32_t width  = frame.Width;
+    const uint32_t height = frame.Height;
+
+    // A pool made for this call only has the threads it needs started, which is all ParallelFor would do
+    ThreadPool  localPool(options.Pool ? 1 : options.ThreadCount);
+    ThreadPool& pool = options.Pool ? *options.Pool : localPool;
+
+    auto geometryStart = high_resolution_clock::now();
+
+    // Cleared tile by tile in the raster phase
+    frame.Color.resize(size_t(width) * height);
+    frame.Depth.resize(size_t(width) * height);
+
+
+    ////
+    // Geometry phase - vertex shading, then clipping, setup & binning in blocks that keep submission order
+
+    const size_t vertexCount = mesh.VertexBuffer.size() / VertexSize;
+    std::vector<ShadedVertex> vertices(vertexCount);
+
+    pool.Run((vertexCount + VertexBlockSize - 1) / VertexBlockSize, [&](size_t block, uint32_t)
+    {
+        size_t end = std::min(vertexCount, (block + 1) * VertexBlockSize);
+        for (size_t v = block * VertexBlockSize; v < end; ++v)
+        {
+            ShadeVertex(&mesh.VertexBuffer[v * VertexSize], constants, vertices[v]);
+        }
+    });
+
+    struct TriangleRange
+    {
+        uint32_t FirstIndex;
+        uint32_t IndexCount;
+    };
+
+    std::vector<TriangleRange> ranges;
+    for (const Submesh& submesh : submeshes)
+    {
+        for (uint32_t first = 0; first + 3 <= submesh.IndexCount; first += SetupBlockSize * 3)
+        {
+            ranges.push_back({ submesh.FirstIndex + first, std::min<uint32_t>(submesh.IndexCount - first, SetupBlockSize * 3) / 3 * 3 });
+        }
+    }
+
+    const bool      shortIndices = (mesh.IndexSize == sizeof(uint16_t));
+    const uint16_t* shortIndex   = mesh.ShortIndexBuffer.data();
+    const uint32_t* index        = mesh.IndexBuffer.data();
+
+    const uint32_t tilesX = (width + TileSize - 1) / TileSize;
+    const uint32_t tilesY = (height + TileSize - 1) / TileSize;
+
+    std::vector<SetupBlock> blocks(ranges.size());
+
+    pool.Run(ranges.size(), [&](size_t r, uint32_t)
+    {
+        const TriangleRange& range = ranges[r];
+        blocks[r].Triangles.reserve(range.IndexCount / 3);
+        blocks[r].Bounds.reserve(range.IndexCount / 3);
+
+        for (uint32_t i = range.FirstIndex; i < range.FirstIndex + range.IndexCount; i += 3)
+        {
+            uint32_t i0 = shortIndices ? shortIndex[i]     : index[i];
+            uint32_t i1 = shortIndices ? shortIndex[i + 1] : index[i + 1];
+            uint32_t i2 = shortIndices ? shortIndex[i + 2] : index[i + 2];
+
+            if (i0 < vertexCount && i1 < vertexCount && i2 < vertexCount)
+            {
+                SetupClippedTriangle(vertices[i0], vertices[i1], vertices[i2], width, height, blocks[r]);
+            }
+        }
+
+        BinTriangles(blocks[r], tilesX, tilesY);
+    });
+
+    auto rasterStart = high_resolution_clock::now();
+
+
+    ////
+    // Raster phase - tiles own disjoint pixels, so they need no synchronization, & each draws its bins in submission
+    // order whichever worker takes it
+
+    const RasterKernels kernels    = SelectRasterKernels(options.MaxSimdLevel);
+    const uint32_t      clearColor = PackSrgb(options.ClearColor, options.ClearColor[3]);
+
+    ShadingOptions shading;
+    shading.Pow          = options.Pow;
+    shading.MaxSimdLevel = options.MaxSimdLevel;
+
+    std::vector<SoftwareRenderStats> tileStats(size_t(tilesX) * tilesY);
+
+    pool.Run(size_t(tilesX) * tilesY, [&](size_t tile, uint32_t)
+    {
+        PixelRect tileRect;
+        tileRect.MinX = static_cast<int32_t>(tile % tilesX * TileSize);
+        tileRect.MinY = static_cast<int32_t>(tile / tilesX * TileSize);
+        tileRect.MaxX = std::min<int32_t>(tileRect.MinX + TileSize, width) - 1;
+        tileRect.MaxY = std::min<int32_t>(tileRect.MinY + TileSize, height) - 1;
+
+        for (int32_t y = tileRect.MinY; y <= tileRect.MaxY; ++y)
+        {
+            size_t row = size_t(y) * width;
+            std::fill(&frame.Color[row + tileRect.MinX], &frame.Color[row + tileRect.MaxX] + 1, clearColor);
+            std::fill(&frame.Depth[row + tileRect.MinX], &frame.Depth[row + tileRect.MaxX] + 1, 1.0f);
+        }
+
+        for (const SetupBlock& block : blocks)
+        {
+            for (uint32_t bin = block.BinStart[tile]; bin < block.BinStart[tile + 1]; ++bin)
+            {
+                uint32_t         t      = block.BinTriangles[bin];
+                const PixelRect& bounds = block.Bounds[t];
+
+                int32_t x0 = std::max(bounds.MinX, tileRect.MinX);
+                int32_t y0 = std::max(bounds.MinY, tileRect.MinY);
+                int32_t x1 = std::min(bounds.MaxX, tileRect.MaxX);
+                int32_t y1 = std::min(bounds.MaxY, tileRect.MaxY);
+
+                RasterizeTriangle(block.Triangles[t], x0, y0, x1, y1, kernels, constants, shading, options.DepthOnly, frame, tileStats[tile]);
+            }
+        }
+    });
+
+    auto rasterEnd = high_resolution_clock::now();
+
+    if (outStats)
+    {
+        *outStats = {};
+        outStats->Level                = std::min(options.MaxSimdLevel, GetSupportedSimdLevel());
+        outStats->GeometryMilliseconds = duration<double, std::milli>(rasterStart - geometryStart).count();
+        outStats->RasterMilliseconds   = duration<double, std::milli>(rasterEnd - rasterStart).count();
+
+        for (const SetupBlock& block : blocks)
+        {
+            outStats->Triangles      += block.Triangles.size();
+            outStats->BinnedTriangles += block.BinTriangles.size();
+        }
+
+        for (const SoftwareRenderStats& stats : tileStats)
+        {
+            outStats->BlocksTested   += stats.BlocksTested;
+            outStats->BlocksRejected += stats.BlocksRejected;
+            outStats->BlocksCovered  += stats.BlocksCovered;
+            outStats->PixelsCovered  += stats.PixelsCovered;
+            outStats->PixelsWritten  += stats.PixelsWritten;
+        }
+    }
+
+    return S_OK;
+}
+
+uint32_t LinearToSrgb8(float linear)
+{
+    float x = Saturate(linear);
+    float srgb = (x <= 0.0031308f) ? x * 12.92f : 1.055f * std::pow(x, 1.0f / 2.4f) - 0.055f;
+    return static_cast<uint32_t>(srgb * 255.0f + 0.5f);
+}
+
+HRESULT WriteFrameBmp(const char* filename, const SoftwareFrame& frame)
+{
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        return E_FAIL;
+    }
+
+    // Rows of 24-bit BGR, padded to 4 bytes & stored bottom-up
+    const uint32_t rowSize   = (frame.Width * 3 + 3) & ~3u;
+    const uint32_t imageSize = rowSize * frame.Height;
+
+    uint8_t header[54] = { 'B', 'M' };
+    auto put32 = [&](size_t offset, uint32_t value)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            header[offset + i] = static_cast<uint8_t>(value >> (8 * i));
+        }
+    };
+
+    put32(2, sizeof(header) + imageSize); // File size
+    put32(10, sizeof(header));            // Pixel data offset
+    put32(14, 40);                        // BITMAPINFOHEADER size
+    put32(18, frame.Width);
+    put32(22, frame.Height);
+    header[26] = 1;                       // Planes
+    header[28] = 24;                      // Bits per pixel
+    put32(34, imageSize);
+
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+    std::vector<uint8_t> row(rowSize, 0);
+    for (uint32_t y = frame.Height; y-- > 0;)
+    {
+        const uint32_t* texels = &frame.Color[size_t(y) * frame.Width];
+        for (uint32_t x = 0; x < frame.Width; ++x)
+        {
+            row[x * 3 + 0] = static_cast<uint8_t>(texels[x] >> 16);
+            row[x * 3 + 1] = static_cast<uint8_t>(texels[x] >> 8);
+            row[x * 3 + 2] = static_cast<uint8_t>(texels[x]);
+        }
+        file.write(reinterpret_cast<const char*>(row.data()), rowSize);
+    }
+
+    file.close();
+    return file ? S_OK : E_FAIL;
+}
+
+HRESULT ReadFrameBmp(const char* filename, SoftwareFrame& outFrame)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (!file)
+    {
+        return E_FAIL;
+    }
+
+    uint8_t header[54];
+    if (!file.read(reinterpret_cast<char*>(header), sizeof(header)) || header[0] != 'B' || header[1] != 'M')
+    {
+        return E_FAIL;
+    }
+
+    auto get32 = [&](size_t offset)
+    {
+        return uint32_t(header[offset]) | (uint32_t(header[offset + 1]) << 8) | (uint32_t(header[offset + 2]) << 16) | (uint32_t(header[offset + 3]) << 24);
+    };
+
+    const uint32_t dataOffset  = get32(10);
+    const int32_t  width       = static_cast<int32_t>(get32(18));
+    const int32_t  height      = static_cast<int32_t>(get32(22));  // Negative for rows stored top-down
+    const uint32_t bitCount    = header[28] | (header[29] << 8);
+    const uint32_t compression = get32(30);
+
+    const uint32_t rows = static_cast<uint32_t>(height < 0 ? -int64_t(height) : height);
+    if (get32(14) < 40 || width <= 0 || rows == 0 || width > int32_t(MaxDimension) || rows > MaxDimension || compression != 0 || (bitCount != 24 && bitCount != 32))
+    {
+        return E_FAIL;
+    }
+
+    const uint32_t pixelSize = bitCount / 8;
+    const uint32_t rowSize   = (width * pixelSize + 3) & ~3u;
+
+    outFrame.Width  = static_cast<uint32_t>(width);
+    outFrame.Height = rows;
+    outFrame.Color.resize(size_t(outFrame.Width) * rows);
+    outFrame.Depth.clear();
+
+    file.seekg(dataOffset);
+
+    std::vector<uint8_t> row(rowSize);
+    for (uint32_t stored = 0; stored < rows; ++stored)
+    {
+        if (!file.read(reinterpret_cast<char*>(row.data()), rowSize))
+        {
+            return E_FAIL;
+        }
+
+        uint32_t  y      = (height < 0) ? stored : rows - 1 - stored;
+        uint32_t* texels = &outFrame.Color[size_t(y) * outFrame.Width];
+        for (uint32_t x = 0; x < outFrame.Width; ++x)
+        {
+            const uint8_t* bgr = &row[x * pixelSize];
+            texels[x] = bgr[2] | (bgr[1] << 8) | (uint32_t(bgr[0]) << 16) | 0xFF000000u;
+        }
+    }
+
+    return S_OK;
+}
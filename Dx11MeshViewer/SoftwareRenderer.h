@@ -0,0 +1,76 @@
+//
+// SoftwareRenderer.h
+//
+
+#pragma once
+
+#include "BlinnPhongKernel.h"
+#include "SceneConstants.h"
+#include "Simd.h"
+
+#include <cstdint>
+#include <vector>
+
+struct Mesh;
+struct Submesh;
+class  ThreadPool;
+
+// Color & depth targets of a frame rendered on the CPU
+struct SoftwareFrame
+{
+    uint32_t              Width  = 0;
+    uint32_t              Height = 0;
+    std::vector<uint32_t> Color;  // R8G8B8A8_UNORM_SRGB texels, red in the low byte, rows from the top
+    std::vector<float>    Depth;  // D32_FLOAT
+};
+
+struct SoftwareRenderOptions
+{
+    float       ClearColor[4] = { 0.025f, 0.025f, 0.025f, 1.0f }; // Linear, converted like a clear of an sRGB view
+    uint32_t    ThreadCount   = 0;                                // 0 uses every hardware thread
+    ThreadPool* Pool          = nullptr;                          // Workers kept across frames, used in place of ThreadCount
+    SimdLevel   MaxSimdLevel  = SimdLevel::Avx512;                // Clamped to GetSupportedSimdLevel()
+    bool        DepthOnly     = false;                            // Skips pixel shading, leaving Color cleared
+    SpecularPow Pow           = SpecularPow::Exact;               // An approximation trades highlight accuracy for speed
+};
+
+// Work done by one RenderMesh call
+struct SoftwareRenderStats
+{
+    SimdLevel Level                = SimdLevel::Scalar; // Of the rasterization kernels used
+    uint64_t  Triangles            = 0;     // Set up after clipping, less those covering no pixel center
+    uint64_t  BinnedTriangles      = 0;     // Triangle references across all tiles' bins
+    uint64_t  BlocksTested         = 0;     // Blocks of 16x8 pixels at AVX-512, 8x8 otherwise
+    uint64_t  BlocksRejected       = 0;     // Outside an edge, so skipped
+    uint64_t  BlocksCovered        = 0;     // Inside every edge, so needing no per-pixel edge tests
+    uint64_t  PixelsCovered        = 0;
+    uint64_t  PixelsWritten        = 0;     // Passed the depth test
+
+    double    GeometryMilliseconds = 0.0;   // Vertex shading, clipping, setup & binning
+    double    RasterMilliseconds   = 0.0;   // Clearing, traversal & pixel shading
+};
+
+// Clears the frame at its Width & Height and draws the submeshes with BasicVS/BasicPS and the viewer's pipeline
+// state - no culling, a LESS_EQUAL test against D32 depth, sRGB writes - for rendering where there's no GPU
+//
+// Follows D3D11's rasterization rules: clipping to 0 <= z <= w, vertices snapped to 8 subpixel bits, pixel
+// centers sampled with the top-left fill rule, and perspective-correct interpolation.
+//
+// Runs in two phases on a work-stealing pool. The geometry phase shades vertices, then clips, sets up & bins
+// triangles into 64x64 pixel tiles in parallel blocks. The raster phase then draws each tile, walking its bins
+// in submission order, so the image doesn't depend on the worker count.
+//
+// Traversal is hierarchical, rejecting or accepting whole tiles & blocks against the integer edge functions
+// before testing 4, 8 or 16 pixels per instruction with the SSE4.2, AVX2 or AVX-512 kernels. The pixels of a span
+// that pass the depth test are shaded together by ShadeFragments. Every level renders the same image.
+// Fails with E_INVALIDARG for a frame larger than D3D11's 16384 texel limit
+HRESULT RenderMesh(const Mesh& mesh, const std::vector<Submesh>& submeshes, const AppShaderConstants& constants, SoftwareFrame& frame, const SoftwareRenderOptions& options = {}, SoftwareRenderStats* outStats = nullptr);
+
+// The conversion an R8G8B8A8_UNORM_SRGB render target applies on write
+uint32_t LinearToSrgb8(float linear);
+
+// Writes the color target as an uncompressed 24-bit .bmp
+HRESULT WriteFrameBmp(const char* filename, const SoftwareFrame& frame);
+
+// Reads an uncompressed 24 or 32-bit .bmp, such as WriteFrameBmp writes, into the color target - Depth is left empty
+HRESULT ReadFrameBmp(const char* filename, SoftwareFrame& outFrame);
@@ -0,0 +1,170 @@
+//
+// ThreadPool.cpp
+//
+
+#include "pch.h"
+#include "ThreadPool.h"
+#include "Parallel.h"
+
+ThreadPool::ThreadPool(uint32_t threadCount)
+    : m_threadCount(ResolveThreadCount(threadCount))
+    , m_ranges(new Range[m_threadCount])
+    , m_task(nullptr)
+    , m_generation(0)
+    , m_busyWorkers(0)
+    , m_stop(false)
+    , m_steals(0)
+{
+    m_threads.reserve(m_threadCount - 1);
+
+    for (uint32_t worker = 1; worker < m_threadCount; ++worker)
+    {
+        m_threads.emplace_back([this, worker]() { WorkerMain(worker); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+
+    for (auto& thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+void ThreadPool::Run(size_t count, const std::function<void(size_t, uint32_t)>& task)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    if (m_threadCount == 1 || count == 1)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            task(i, 0);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+
+        for (uint32_t worker = 0; worker < m_threadCount; ++worker)
+        {
+            std::lock_guard<std::mutex> rangeLock(m_ranges[worker].Lock);
+            m_ranges[worker].Begin = count * worker / m_threadCount;
+            m_ranges[worker].End   = count * (worker + 1) / m_threadCount;
+        }
+
+        m_task        = &task;
+        m_busyWorkers = m_threadCount - 1;
+        ++m_generation;
+    }
+    m_wake.notify_all();
+
+    Work(0);
+
+    // Every worker checks in once per generation, so none can still be looking at this task afterwards
+    std::unique_lock<std::mutex> lock(m_lock);
+    m_finished.wait(lock, [this]() { return m_busyWorkers == 0; });
+    m_task = nullptr;
+}
+
+void ThreadPool::WorkerMain(uint32_t worker)
+{
+    uint64_t generation = 0;
+
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+            m_wake.wait(lock, [&]() { return m_stop || m_generation != generation; });
+
+            if (m_stop)
+            {
+                return;
+            }
+            generation = m_generation;
+        }
+
+        Work(worker);
+
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (--m_busyWorkers == 0)
+        {
+            m_finished.notify_one();
+        }
+    }
+}
+
+void ThreadPool::Work(uint32_t worker)
+{
+    const std::function<void(size_t, uint32_t)>& task = *m_task;
+
+    // Indices only ever move from one range to another, so once none is left to pop or steal, all have been taken
+    size_t index;
+    while (PopFront(worker, index) || Steal(worker, index))
+    {
+        task(index, worker);
+    }
+}
+
+bool ThreadPool::PopFront(uint32_t worker, size_t& outIndex)
+{
+    Range& range = m_ranges[worker];
+    std::lock_guard<std::mutex> lock(range.Lock);
+
+    if (range.Begin == range.End)
+    {
+        return false;
+    }
+
+    outIndex = range.Begin++;
+    return true;
+}
+
+bool ThreadPool::Steal(uint32_t worker, size_t& outIndex)
+{
+    for (uint32_t offset = 1; offset < m_threadCount; ++offset)
+    {
+        Range& victim = m_ranges[(worker + offset) % m_threadCount];
+
+        size_t begin, end;
+        {
+            std::lock_guard<std::mutex> lock(victim.Lock);
+
+            size_t remaining = victim.End - victim.Begin;
+            if (remaining == 0)
+            {
+                continue;
+            }
+
+            // The back half, rounded up so a single remaining index can be taken too
+            begin = victim.End - (remaining + 1) / 2;
+            end   = victim.End;
+            victim.End = begin;
+        }
+
+        ++m_steals;
+
+        // Only this worker refills its own range, & it's empty, so the stolen indices can simply replace it
+        Range& own = m_ranges[worker];
+        {
+            std::lock_guard<std::mutex> lock(own.Lock);
+            own.Begin = begin + 1;
+            own.End   = end;
+        }
+
+        outIndex = begin;
+        return true;
+    }
+
+    return false;
+}
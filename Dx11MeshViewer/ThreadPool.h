@@ -0,0 +1,73 @@
+//
+// ThreadPool.h
+//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent workers for repeated parallel loops, such as one per rendered frame, that shouldn't pay for starting
+// threads each time
+//
+// Each loop's indices are dealt out as one contiguous range per worker, which keeps neighboring items (e.g. screen
+// tiles) on the same worker. A worker that exhausts its range steals the back half of another's, so uneven items still
+// balance. The calling thread works as worker 0.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(uint32_t threadCount = 0); // Including the caller - zero means one per hardware thread
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    uint32_t ThreadCount() const { return m_threadCount; }
+    uint64_t StealCount() const  { return m_steals; }    // Ranges stolen since construction
+
+    // Invokes task(i, worker) for every i in [0, count) & returns once all have run - worker is in [0, ThreadCount())
+    // and no two concurrent calls share one, so it can index per-worker scratch
+    void     Run(size_t count, const std::function<void(size_t index, uint32_t worker)>& task);
+
+private:
+    // A worker's remaining indices - the owner takes from the front, thieves from the back
+    struct RangeState
+    {
+        std::mutex Lock;
+        size_t     Begin = 0;
+        size_t     End   = 0;
+    };
+
+    // Padded rather than alignas(64), which C++14's new ignores - a gap of at least a cache line after each range
+    // keeps neighbours off each other's lines wherever the array lands
+    struct Range : RangeState
+    {
+        char Padding[128 - sizeof(RangeState) % 64];
+    };
+
+    void     WorkerMain(uint32_t worker);
+    void     Work(uint32_t worker);
+    bool     PopFront(uint32_t worker, size_t& outIndex);
+    bool     Steal(uint32_t worker, size_t& outIndex);
+
+private:
+    uint32_t                                               m_threadCount;
+    std::unique_ptr<Range[]>                               m_ranges;
+    std::vector<std::thread>                               m_threads;
+
+    std::mutex                                             m_lock;
+    std::condition_variable                                m_wake;
+    std::condition_variable                                m_finished;
+    const std::function<void(size_t, uint32_t)>*           m_task;
+    uint64_t                                               m_generation; // Bumped by each Run to wake the workers
+    uint32_t                                               m_busyWorkers;
+    bool                                                   m_stop;
+
+    std::atomic<uint64_t>                                  m_steals;
+};
@@ -0,0 +1,711 @@
+//
+// VertexBounds.cpp
+//
+
+#include "pch.h"
+#include "VertexBounds.h"
+#include "Parallel.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <vector>
+
+using DirectX::XMFLOAT3;
+
+namespace
+{
+    const size_t BlockSize           = 1 << 16; // Vertices per parallel work item
+    const int    DirectionCount      = 7;
+    const int    MaxSphereIterations = 32;
+    const float  SphereTolerance     = 1e-5f;   // Relative slack before another growth pass, so rounding can't keep it going
+
+    size_t BlockCount(size_t vertexCount)
+    {
+        return (vertexCount + BlockSize - 1) / BlockSize;
+    }
+
+    // The SIMD kernels load whole 4-float vectors per vertex, so the position must be followed by at least one more float
+    bool UseSse(size_t stride)
+    {
+        return SIMD_X86 && stride >= 4 && GetSupportedSimdLevel() >= SimdLevel::Sse42;
+    }
+
+    // Runs fn(begin, end, result) for every block in parallel, then merges the results in block order
+    template <class Result, class BlockFn, class MergeFn>
+    Result ReduceBlocks(size_t vertexCount, uint32_t threadCount, const Result& identity, BlockFn blockFn, MergeFn mergeFn)
+    {
+        std::vector<Result> blockResults(BlockCount(vertexCount), identity);
+
+        ParallelFor(blockResults.size(), threadCount, [&](size_t b)
+        {
+            blockFn(b * BlockSize, std::min(vertexCount, (b + 1) * BlockSize), blockResults[b]);
+        });
+
+        Result result = identity;
+        for (const Result& blockResult : blockResults)
+        {
+            mergeFn(result, blockResult);
+        }
+
+        return result;
+    }
+
+
+    ////
+    // Axis-aligned bounds
+
+    struct Aabb
+    {
+        float Min[3];
+        float Max[3];
+    };
+
+    const Aabb EmptyAabb = { { FLT_MAX, FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX, -FLT_MAX } };
+
+    void MergeAabb(Aabb& into, const Aabb& from)
+    {
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            into.Min[axis] = std::min(into.Min[axis], from.Min[axis]);
+            into.Max[axis] = std::max(into.Max[axis], from.Max[axis]);
+        }
+    }
+
+    void AabbScalar(const float* vertices, size_t begin, size_t end, size_t stride, Aabb& out)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            const float* p = vertices + i * stride;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                out.Min[axis] = std::min(out.Min[axis], p[axis]);
+                out.Max[axis] = std::max(out.Max[axis], p[axis]);
+            }
+        }
+    }
+
+#if SIMD_X86
+    // One unaligned load per vertex with two independent min/max chains - the fourth lane is whatever follows the
+    // position, and is dropped at the end
+    SIMD_TARGET_SSE42 void AabbSse(const float* vertices, size_t begin, size_t end, size_t stride, Aabb& out)
+    {
+        __m128 min0 = _mm_set1_ps(FLT_MAX), min1 = min0;
+        __m128 max0 = _mm_set1_ps(-FLT_MAX), max1 = max0;
+
+        const float* p = vertices + begin * stride;
+
+        size_t i = begin;
+        for (; i + 2 <= end; i += 2, p += 2 * stride)
+        {
+            __m128 a = _mm_loadu_ps(p);
+            __m128 b = _mm_loadu_ps(p + stride);
+
+            min0 = _mm_min_ps(min0, a);
+            max0 = _mm_max_ps(max0, a);
+            min1 = _mm_min_ps(min1, b);
+            max1 = _mm_max_ps(max1, b);
+        }
+
+        if (i < end)
+        {
+            __m128 a = _mm_loadu_ps(p);
+            min0 = _mm_min_ps(min0, a);
+            max0 = _mm_max_ps(max0, a);
+        }
+
+        Aabb lanes;
+        float minLanes[4], maxLanes[4];
+        _mm_storeu_ps(minLanes, _mm_min_ps(min0, min1));
+        _mm_storeu_ps(maxLanes, _mm_max_ps(max0, max1));
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            lanes.Min[axis] = minLanes[axis];
+            lanes.Max[axis] = maxLanes[axis];
+        }
+
+        MergeAabb(out, lanes);
+    }
+#endif
+
+    void ComputeAabbBlock(const float* vertices, size_t begin, size_t end, size_t stride, Aabb& out)
+    {
+#if SIMD_X86
+        if (UseSse(stride))
+        {
+            AabbSse(vertices, begin, end, stride, out);
+            return;
+        }
+#endif
+        AabbScalar(vertices, begin, end, stride, out);
+    }
+
+
+    ////
+    // Extreme vertices along the coordinate axes & the four body diagonals, which seed the sphere
+
+    struct Extremes
+    {
+        float    Min[DirectionCount];
+        float    Max[DirectionCount];
+        uint32_t MinIndex[DirectionCount];
+        uint32_t MaxIndex[DirectionCount];
+    };
+
+    Extremes MakeEmptyExtremes()
+    {
+        Extremes extremes;
+        for (int d = 0; d < DirectionCount; ++d)
+        {
+            extremes.Min[d]      = FLT_MAX;
+            extremes.Max[d]      = -FLT_MAX;
+            extremes.MinIndex[d] = 0;
+            extremes.MaxIndex[d] = 0;
+        }
+        return extremes;
+    }
+
+    // Ties go to the lower index, so the SIMD lanes & blocks reduce to the same vertices as a serial scan
+    void ConsiderExtreme(Extremes& extremes, int d, float value, uint32_t index)
+    {
+        if (value < extremes.Min[d] || (value == extremes.Min[d] && index < extremes.MinIndex[d]))
+        {
+            extremes.Min[d]      = value;
+            extremes.MinIndex[d] = index;
+        }
+
+        if (value > extremes.Max[d] || (value == extremes.Max[d] && index < extremes.MaxIndex[d]))
+        {
+            extremes.Max[d]      = value;
+            extremes.MaxIndex[d] = index;
+        }
+    }
+
+    void MergeExtremes(Extremes& into, const Extremes& from)
+    {
+        for (int d = 0; d < DirectionCount; ++d)
+        {
+            ConsiderExtreme(into, d, from.Min[d], from.MinIndex[d]);
+            ConsiderExtreme(into, d, from.Max[d], from.MaxIndex[d]);
+        }
+    }
+
+    // Unnormalized projections - x, y, z, x+y+z, x+y-z, x-y+z, x-y-z - in the same operation order as the SIMD kernel
+    void Project(const float* p, float* projections)
+    {
+        float xy  = p[0] + p[1];
+        float xmy = p[0] - p[1];
+
+        projections[0] = p[0];
+        projections[1] = p[1];
+        projections[2] = p[2];
+        projections[3] = xy + p[2];
+        projections[4] = xy - p[2];
+        projections[5] = xmy + p[2];
+        projections[6] = xmy - p[2];
+    }
+
+    void ExtremesScalar(const float* vertices, size_t begin, size_t end, size_t stride, Extremes& out)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            float projections[DirectionCount];
+            Project(vertices + i * stride, projections);
+
+            for (int d = 0; d < DirectionCount; ++d)
+            {
+                ConsiderExtreme(out, d, projections[d], static_cast<uint32_t>(i));
+            }
+        }
+    }
+
+#if SIMD_X86
+    // Four vertices per step, transposed to x, y & z vectors; each lane keeps the first extreme among its vertices
+    SIMD_TARGET_SSE42 void ExtremesSse(const float* vertices, size_t begin, size_t end, size_t stride, Extremes& out)
+    {
+        __m128  minValue[DirectionCount], maxValue[DirectionCount];
+        __m128i minIndex[DirectionCount], maxIndex[DirectionCount];
+
+        for (int d = 0; d < DirectionCount; ++d)
+        {
+            minValue[d] = _mm_set1_ps(FLT_MAX);
+            maxValue[d] = _mm_set1_ps(-FLT_MAX);
+            minIndex[d] = maxIndex[d] = _mm_setzero_si128();
+        }
+
+        const uint32_t first = static_cast<uint32_t>(begin);
+        __m128i index = _mm_setr_epi32(first, first + 1, first + 2, first + 3);
+
+        size_t i = begin;
+        for (; i + 4 <= end; i += 4)
+        {
+            const float* p = vertices + i * stride;
+
+            __m128 x = _mm_loadu_ps(p);
+            __m128 y = _mm_loadu_ps(p + stride);
+            __m128 z = _mm_loadu_ps(p + 2 * stride);
+            __m128 w = _mm_loadu_ps(p + 3 * stride);
+            _MM_TRANSPOSE4_PS(x, y, z, w);
+
+            __m128 xy  = _mm_add_ps(x, y);
+            __m128 xmy = _mm_sub_ps(x, y);
+
+            __m128 projections[DirectionCount] =
+            {
+                x, y, z, _mm_add_ps(xy, z), _mm_sub_ps(xy, z), _mm_add_ps(xmy, z), _mm_sub_ps(xmy, z),
+            };
+
+            for (int d = 0; d < DirectionCount; ++d)
+            {
+                __m128 less    = _mm_cmplt_ps(projections[d], minValue[d]);
+                __m128 greater = _mm_cmpgt_ps(projections[d], maxValue[d]);
+
+                minValue[d] = _mm_blendv_ps(minValue[d], projections[d], less);
+                maxValue[d] = _mm_blendv_ps(maxValue[d], projections[d], greater);
+                minIndex[d] = _mm_castps_si128(_mm_blendv_ps(_mm_castsi128_ps(minIndex[d]), _mm_castsi128_ps(index), less));
+                maxIndex[d] = _mm_castps_si128(_mm_blendv_ps(_mm_castsi128_ps(maxIndex[d]), _mm_castsi128_ps(index), greater));
+            }
+
+            index = _mm_add_epi32(index, _mm_set1_epi32(4));
+        }
+
+        if (i > begin)
+        {
+            for (int d = 0; d < DirectionCount; ++d)
+            {
+                float    values[4];
+                uint32_t indices[4];
+
+                _mm_storeu_ps(values, minValue[d]);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(indices), minIndex[d]);
+                for (int lane = 0; lane < 4; ++lane)
+                {
+                    ConsiderExtreme(out, d, values[lane], indices[lane]);
+                }
+
+                _mm_storeu_ps(values, maxValue[d]);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(indices), maxIndex[d]);
+                for (int lane = 0; lane < 4; ++lane)
+                {
+                    ConsiderExtreme(out, d, values[lane], indices[lane]);
+                }
+            }
+        }
+
+        ExtremesScalar(vertices, i, end, stride, out);
+    }
+#endif
+
+    void ComputeExtremesBlock(const float* vertices, size_t begin, size_t end, size_t stride, Extremes& out)
+    {
+#if SIMD_X86
+        if (UseSse(stride))
+        {
+            ExtremesSse(vertices, begin, end, stride, out);
+            return;
+        }
+#endif
+        ExtremesScalar(vertices, begin, end, stride, out);
+    }
+
+
+    ////
+    // Farthest vertex from a point, which drives the sphere's growth
+
+    struct Farthest
+    {
+        float    DistanceSq;
+        uint32_t Index;
+    };
+
+    const Farthest NoFarthest = { -1.0f, 0 };
+
+    void MergeFarthest(Farthest& into, const Farthest& from)
+    {
+        if (from.DistanceSq > into.DistanceSq || (from.DistanceSq == into.DistanceSq && from.Index < into.Index))
+        {
+            into = from;
+        }
+    }
+
+    void FarthestScalar(const float* vertices, size_t begin, size_t end, size_t stride, const float* center, Farthest& out)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            const float* p = vertices + i * stride;
+
+            float dx = p[0] - center[0];
+            float dy = p[1] - center[1];
+            float dz = p[2] - center[2];
+
+            MergeFarthest(out, { dx * dx + dy * dy + dz * dz, static_cast<uint32_t>(i) });
+        }
+    }
+
+#if SIMD_X86
+    SIMD_TARGET_SSE42 void FarthestSse(const float* vertices, size_t begin, size_t end, size_t stride, const float* center, Farthest& out)
+    {
+        __m128  cx = _mm_set1_ps(center[0]);
+        __m128  cy = _mm_set1_ps(center[1]);
+        __m128  cz = _mm_set1_ps(center[2]);
+
+        __m128  best      = _mm_set1_ps(-1.0f);
+        __m128i bestIndex = _mm_setzero_si128();
+
+        const uint32_t first = static_cast<uint32_t>(begin);
+        __m128i index = _mm_setr_epi32(first, first + 1, first + 2, first + 3);
+
+        size_t i = begin;
+        for (; i + 4 <= end; i += 4)
+        {
+            const float* p = vertices + i * stride;
+
+            __m128 x = _mm_loadu_ps(p);
+            __m128 y = _mm_loadu_ps(p + stride);
+            __m128 z = _mm_loadu_ps(p + 2 * stride);
+            __m128 w = _mm_loadu_ps(p + 3 * stride);
+            _MM_TRANSPOSE4_PS(x, y, z, w);
+
+            __m128 dx = _mm_sub_ps(x, cx);
+            __m128 dy = _mm_sub_ps(y, cy);
+            __m128 dz = _mm_sub_ps(z, cz);
+            __m128 distanceSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+            __m128 greater = _mm_cmpgt_ps(distanceSq, best);
+            best      = _mm_blendv_ps(best, distanceSq, greater);
+            bestIndex = _mm_castps_si128(_mm_blendv_ps(_mm_castsi128_ps(bestIndex), _mm_castsi128_ps(index), greater));
+
+            index = _mm_add_epi32(index, _mm_set1_epi32(4));
+        }
+
+        if (i > begin)
+        {
+            float    values[4];
+            uint32_t indices[4];
+            _mm_storeu_ps(values, best);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(indices), bestIndex);
+
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                MergeFarthest(out, { values[lane], indices[lane] });
+            }
+        }
+
+        FarthestScalar(vertices, i, end, stride, center, out);
+    }
+#endif
+
+    void ComputeFarthestBlock(const float* vertices, size_t begin, size_t end, size_t stride, const float* center, Farthest& out)
+    {
+#if SIMD_X86
+        if (UseSse(stride))
+        {
+            FarthestSse(vertices, begin, end, stride, center, out);
+            return;
+        }
+#endif
+        FarthestScalar(vertices, begin, end, stride, center, out);
+    }
+
+
+    ////
+    // Bounding sphere
+
+    void ComputeSphere(const float* vertices, size_t vertexCount, size_t stride, uint32_t threadCount, float* center, float& radius)
+    {
+        Extremes extremes = ReduceBlocks(vertexCount, threadCount, MakeEmptyExtremes(),
+            [&](size_t begin, size_t end, Extremes& out) { ComputeExtremesBlock(vertices, begin, end, stride, out); },
+            MergeExtremes);
+
+        // Start from the extreme pair farthest apart as the diameter
+        float diameterSq = -1.0f;
+        for (int d = 0; d < DirectionCount; ++d)
+        {
+            const float* a = vertices + extremes.MinIndex[d] * stride;
+            const float* b = vertices + extremes.MaxIndex[d] * stride;
+
+            float dx = b[0] - a[0], dy = b[1] - a[1], dz = b[2] - a[2];
+            float lengthSq = dx * dx + dy * dy + dz * dz;
+
+            if (lengthSq > diameterSq)
+            {
+                diameterSq = lengthSq;
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    center[axis] = (a[axis] + b[axis]) * 0.5f;
+                }
+            }
+        }
+
+        radius = std::sqrt(std::max(diameterSq, 0.0f)) * 0.5f;
+
+        // Each pass finds the vertex farthest outside and grows the sphere just enough to touch it, keeping the
+        // opposite side fixed. The sphere with the last pass's farthest distance encloses everything regardless,
+        // so stopping early only costs tightness
+        for (int iteration = 0; ; ++iteration)
+        {
+            Farthest farthest = ReduceBlocks(vertexCount, threadCount, NoFarthest,
+                [&](size_t begin, size_t end, Farthest& out) { ComputeFarthestBlock(vertices, begin, end, stride, center, out); },
+                MergeFarthest);
+
+            float distance = std::sqrt(std::max(farthest.DistanceSq, 0.0f));
+
+            if (distance <= radius * (1.0f + SphereTolerance) || iteration == MaxSphereIterations)
+            {
+                radius = std::max(radius, distance);
+                break;
+            }
+
+            const float* p = vertices + farthest.Index * stride;
+
+            float grownRadius = (radius + distance) * 0.5f;
+            float shift       = (grownRadius - radius) / distance;
+
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                center[axis] += (p[axis] - center[axis]) * shift;
+            }
+
+            radius = grownRadius;
+        }
+    }
+
+
+    ////
+    // Oriented box
+
+    struct Moments
+    {
+        double Sum[3];
+        double Products[6]; // xx, xy, xz, yy, yz, zz
+    };
+
+    void MergeMoments(Moments& into, const Moments& from)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            into.Sum[i] += from.Sum[i];
+        }
+
+        for (int i = 0; i < 6; ++i)
+        {
+            into.Products[i] += from.Products[i];
+        }
+    }
+
+    // Eigenvectors of a symmetric 3x3 matrix by cyclic Jacobi rotations - vectors end up in the columns
+    void SymmetricEigenvectors(double a[3][3], double vectors[3][3])
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            for (int j = 0; j < 3; ++j)
+            {
+                vectors[i][j] = (i == j) ? 1.0 : 0.0;
+            }
+        }
+
+        for (int sweep = 0; sweep < 32; ++sweep)
+        {
+            double offDiagonal = std::fabs(a[0][1]) + std::fabs(a[0][2]) + std::fabs(a[1][2]);
+            if (offDiagonal < 1e-12 * (std::fabs(a[0][0]) + std::fabs(a[1][1]) + std::fabs(a[2][2])) || offDiagonal == 0.0)
+            {
+                break;
+            }
+
+            for (int p = 0; p < 2; ++p)
+            {
+                for (int q = p + 1; q < 3; ++q)
+                {
+                    if (a[p][q] == 0.0)
+                    {
+                        continue;
+                    }
+
+                    // Rotation angle that zeroes a[p][q]
+                    double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+                    double t     = (theta >= 0.0 ? 1.0 : -1.0) / (std::fabs(theta) + std::sqrt(theta * theta + 1.0));
+                    double c     = 1.0 / std::sqrt(t * t + 1.0);
+                    double s     = t * c;
+
+                    for (int k = 0; k < 3; ++k)
+                    {
+                        double akp = a[k][p], akq = a[k][q];
+                        a[k][p] = c * akp - s * akq;
+                        a[k][q] = s * akp + c * akq;
+                    }
+
+                    for (int k = 0; k < 3; ++k)
+                    {
+                        double apk = a[p][k], aqk = a[q][k];
+                        a[p][k] = c * apk - s * aqk;
+                        a[q][k] = s * apk + c * aqk;
+                    }
+
+                    for (int k = 0; k < 3; ++k)
+                    {
+                        double vkp = vectors[k][p], vkq = vectors[k][q];
+                        vectors[k][p] = c * vkp - s * vkq;
+                        vectors[k][q] = s * vkp + c * vkq;
+                    }
+                }
+            }
+        }
+    }
+
+    void ComputeOrientedBox(const float* vertices, size_t vertexCount, size_t stride, uint32_t threadCount, const Aabb& aabb, VertexBounds& out)
+    {
+        // Moments about the AABB center, so the sums stay small relative to the spread
+        const float origin[3] = { (aabb.Min[0] + aabb.Max[0]) * 0.5f, (aabb.Min[1] + aabb.Max[1]) * 0.5f, (aabb.Min[2] + aabb.Max[2]) * 0.5f };
+
+        Moments moments = ReduceBlocks(vertexCount, threadCount, Moments {},
+            [&](size_t begin, size_t end, Moments& out)
+            {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    const float* p = vertices + i * stride;
+                    double x = double(p[0]) - origin[0], y = double(p[1]) - origin[1], z = double(p[2]) - origin[2];
+
+                    out.Sum[0] += x;
+                    out.Sum[1] += y;
+                    out.Sum[2] += z;
+                    out.Products[0] += x * x;
+                    out.Products[1] += x * y;
+                    out.Products[2] += x * z;
+                    out.Products[3] += y * y;
+                    out.Products[4] += y * z;
+                    out.Products[5] += z * z;
+                }
+            },
+            MergeMoments);
+
+        double n = static_cast<double>(vertexCount);
+        double mean[3] = { moments.Sum[0] / n, moments.Sum[1] / n, moments.Sum[2] / n };
+
+        double covariance[3][3];
+        covariance[0][0] = moments.Products[0] / n - mean[0] * mean[0];
+        covariance[0][1] = covariance[1][0] = moments.Products[1] / n - mean[0] * mean[1];
+        covariance[0][2] = covariance[2][0] = moments.Products[2] / n - mean[0] * mean[2];
+        covariance[1][1] = moments.Products[3] / n - mean[1] * mean[1];
+        covariance[1][2] = covariance[2][1] = moments.Products[4] / n - mean[1] * mean[2];
+        covariance[2][2] = moments.Products[5] / n - mean[2] * mean[2];
+
+        double vectors[3][3];
+        SymmetricEigenvectors(covariance, vectors);
+
+        float axes[3][3];
+        for (int a = 0; a < 2; ++a)
+        {
+            double length = std::sqrt(vectors[0][a] * vectors[0][a] + vectors[1][a] * vectors[1][a] + vectors[2][a] * vectors[2][a]);
+            for (int k = 0; k < 3; ++k)
+            {
+                axes[a][k] = static_cast<float>(vectors[k][a] / length);
+            }
+        }
+
+        // Rebuild the third axis rather than trusting its sign
+        axes[2][0] = axes[0][1] * axes[1][2] - axes[0][2] * axes[1][1];
+        axes[2][1] = axes[0][2] * axes[1][0] - axes[0][0] * axes[1][2];
+        axes[2][2] = axes[0][0] * axes[1][1] - axes[0][1] * axes[1][0];
+
+        // Extents along the axes - the same min/max reduction as the AABB, just through a rotation
+        Aabb projected = ReduceBlocks(vertexCount, threadCount, EmptyAabb,
+            [&](size_t begin, size_t end, Aabb& out)
+            {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    const float* p = vertices + i * stride;
+                    for (int a = 0; a < 3; ++a)
+                    {
+                        float d = p[0] * axes[a][0] + p[1] * axes[a][1] + p[2] * axes[a][2];
+                        out.Min[a] = std::min(out.Min[a], d);
+                        out.Max[a] = std::max(out.Max[a], d);
+                    }
+                }
+            },
+            MergeAabb);
+
+        float boxVolume  = 1.0f;
+        float aabbVolume = 1.0f;
+        for (int a = 0; a < 3; ++a)
+        {
+            boxVolume  *= projected.Max[a] - projected.Min[a];
+            aabbVolume *= aabb.Max[a] - aabb.Min[a];
+        }
+
+        // Principal axes are only a heuristic - an axis-aligned mesh is often better served by its AABB
+        if (aabbVolume <= boxVolume)
+        {
+            for (int a = 0; a < 3; ++a)
+            {
+                for (int k = 0; k < 3; ++k)
+                {
+                    axes[a][k] = (a == k) ? 1.0f : 0.0f;
+                }
+            }
+            projected = aabb;
+        }
+
+        float center[3] = {};
+        float extents[3];
+        for (int a = 0; a < 3; ++a)
+        {
+            float middle = (projected.Min[a] + projected.Max[a]) * 0.5f;
+            extents[a] = (projected.Max[a] - projected.Min[a]) * 0.5f;
+
+            // Rounding through the rotation & back can leave the outermost vertices a few ulps outside
+            extents[a] += (std::fabs(middle) + extents[a]) * 4.0f * FLT_EPSILON;
+
+            for (int k = 0; k < 3; ++k)
+            {
+                center[k] += axes[a][k] * middle;
+            }
+        }
+
+        out.BoxCenter  = XMFLOAT3(center[0], center[1], center[2]);
+        out.BoxExtents = XMFLOAT3(extents[0], extents[1], extents[2]);
+        for (int a = 0; a < 3; ++a)
+        {
+            out.BoxAxes[a] = XMFLOAT3(axes[a][0], axes[a][1], axes[a][2]);
+        }
+    }
+}
+
+void ComputeAabb(const float* vertices, size_t vertexCount, size_t stride, uint32_t threadCount, XMFLOAT3& outMin, XMFLOAT3& outMax)
+{
+    Aabb aabb = ReduceBlocks(vertexCount, threadCount, EmptyAabb,
+        [&](size_t begin, size_t end, Aabb& out) { ComputeAabbBlock(vertices, begin, end, stride, out); },
+        MergeAabb);
+
+    outMin = XMFLOAT3(aabb.Min[0], aabb.Min[1], aabb.Min[2]);
+    outMax = XMFLOAT3(aabb.Max[0], aabb.Max[1], aabb.Max[2]);
+}
+
+void ComputeVertexBounds(const float* vertices, size_t vertexCount, size_t stride, VertexBounds& outBounds, const VertexBoundsOptions& options)
+{
+    outBounds = {};
+    outBounds.BoxAxes[0] = XMFLOAT3(1.0f, 0.0f, 0.0f);
+    outBounds.BoxAxes[1] = XMFLOAT3(0.0f, 1.0f, 0.0f);
+    outBounds.BoxAxes[2] = XMFLOAT3(0.0f, 0.0f, 1.0f);
+
+    ComputeAabb(vertices, vertexCount, stride, options.ThreadCount, outBounds.Min, outBounds.Max);
+
+    if (vertexCount == 0)
+    {
+        return;
+    }
+
+    if (options.Sphere)
+    {
+        float center[3];
+        ComputeSphere(vertices, vertexCount, stride, options.ThreadCount, center, outBounds.SphereRadius);
+        outBounds.SphereCenter = XMFLOAT3(center[0], center[1], center[2]);
+    }
+
+    if (options.OrientedBox)
+    {
+        Aabb aabb = { { outBounds.Min.x, outBounds.Min.y, outBounds.Min.z }, { outBounds.Max.x, outBounds.Max.y, outBounds.Max.z } };
+        ComputeOrientedBox(vertices, vertexCount, stride, options.ThreadCount, aabb, outBounds);
+    }
+}
@@ -0,0 +1,50 @@
+//
+// VertexBounds.h
+//
+
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+
+// Vertex positions are the first three floats of every 'stride' floats - 6 for the mesh's position & normal vertices
+
+// Axis-aligned bounds, reduced over blocks on up to threadCount workers (0 uses every hardware thread)
+// Identical to a serial min/max loop; no vertices leave outMin at FLT_MAX & outMax at -FLT_MAX
+void ComputeAabb(const float* vertices, size_t vertexCount, size_t stride, uint32_t threadCount, DirectX::XMFLOAT3& outMin, DirectX::XMFLOAT3& outMax);
+
+struct VertexBoundsOptions
+{
+    bool     Sphere      = true;
+    bool     OrientedBox = false;
+    uint32_t ThreadCount = 0;     // 0 uses every hardware thread
+};
+
+struct VertexBounds
+{
+    DirectX::XMFLOAT3 Min;
+    DirectX::XMFLOAT3 Max;
+
+    // Starts from the farthest apart pair of extreme points along 7 directions, then grows toward the farthest
+    // outside vertex until none are left (Ritter 1990, with the growth order chosen by distance instead of by index)
+    DirectX::XMFLOAT3 SphereCenter;
+    float             SphereRadius;
+
+    // Principal axes of the vertices, or the coordinate axes when those enclose less volume
+    DirectX::XMFLOAT3 BoxCenter;
+    DirectX::XMFLOAT3 BoxExtents;  // Half sizes along each axis
+    DirectX::XMFLOAT3 BoxAxes[3];  // Orthonormal & right-handed
+};
+
+// Every pass is a blocked parallel SIMD reduction, and its result doesn't depend on the worker count
+// Without vertices, the sphere & box are empty and centered on the origin
+void ComputeVertexBounds(const float* vertices, size_t vertexCount, size_t stride, VertexBounds& outBounds, const VertexBoundsOptions& options = {});
+
+// Axis-aligned boxes as structure-of-arrays, for culling passes - element i of each array belongs to box i
+struct BoxArrays
+{
+    const float* Min[3];  // x, y & z arrays
+    const float* Max[3];
+    size_t       Count = 0;
+};
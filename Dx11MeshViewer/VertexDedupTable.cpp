@@ -0,0 +1,147 @@
+//
+// VertexDedupTable.cpp
+//
+
+#include "pch.h"
+#include "VertexDedupTable.h"
+#include "Simd.h"
+
+#include <cstring>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define DEDUP_SSE2 1
+#else
+#define DEDUP_SSE2 0
+#endif
+
+namespace
+{
+    const size_t  GroupSize = 16;
+    const uint8_t Empty     = 0x80; // Full slots store a 7-bit tag, so only empty ones have the high bit set
+
+    // Bit i set for each control byte in the group equal to 'tag', and for each empty byte
+    inline void MatchGroup(const uint8_t* group, uint8_t tag, uint32_t& outMatches, uint32_t& outEmpty)
+    {
+#if DEDUP_SSE2
+        __m128i control = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+        outMatches = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8(static_cast<char>(tag)))));
+        outEmpty   = static_cast<uint32_t>(_mm_movemask_epi8(control));
+#else
+        outMatches = 0;
+        outEmpty   = 0;
+        for (uint32_t i = 0; i < GroupSize; ++i)
+        {
+            outMatches |= (group[i] == tag ? 1u : 0u) << i;
+            outEmpty   |= (group[i] == Empty ? 1u : 0u) << i;
+        }
+#endif
+    }
+}
+
+
+VertexDedupTable::VertexDedupTable(size_t expectedCount)
+    : m_groupMask{}
+    , m_size{}
+    , m_growThreshold{}
+{
+    // Size for a 7/8 maximum load factor up front so typical meshes never rehash
+    size_t capacity = GroupSize;
+    while (capacity * 7 / 8 < expectedCount)
+    {
+        capacity *= 2;
+    }
+
+    Allocate(capacity);
+}
+
+void VertexDedupTable::Allocate(size_t capacity)
+{
+    m_control.assign(capacity, Empty);
+    m_slots.resize(capacity);
+
+    m_groupMask     = capacity / GroupSize - 1;
+    m_growThreshold = capacity * 7 / 8;
+}
+
+uint32_t VertexDedupTable::FindOrAppend(const float* vertex, std::vector<float>& vertices)
+{
+    uint64_t hash = HashVertex(vertex);
+    uint8_t  tag  = static_cast<uint8_t>(hash & 0x7f);
+
+    // Triangular probing over whole groups visits every group of a power-of-two table
+    size_t group = (hash >> 7) & m_groupMask;
+
+    for (size_t step = 1; ; ++step)
+    {
+        const uint8_t* control = &m_control[group * GroupSize];
+
+        uint32_t matches, empty;
+        MatchGroup(control, tag, matches, empty);
+
+        for (; matches; matches &= matches - 1)
+        {
+            uint32_t index = m_slots[group * GroupSize + CountTrailingZeros(matches)];
+
+            if (std::memcmp(&vertices[index * VertexSize], vertex, VertexSize * sizeof(float)) == 0)
+            {
+                return index;
+            }
+        }
+
+        // Nothing is ever erased, so an empty slot ends the probe sequence
+        if (empty)
+        {
+            uint32_t index = static_cast<uint32_t>(m_size);
+            vertices.insert(vertices.end(), vertex, vertex + VertexSize);
+
+            if (m_size >= m_growThreshold)
+            {
+                Grow(vertices);
+                Insert(hash, index);
+            }
+            else
+            {
+                size_t slot = group * GroupSize + CountTrailingZeros(empty);
+                m_control[slot] = tag;
+                m_slots[slot]   = index;
+            }
+
+            ++m_size;
+            return index;
+        }
+
+        group = (group + step) & m_groupMask;
+    }
+}
+
+void VertexDedupTable::Grow(const std::vector<float>& vertices)
+{
+    Allocate(m_control.size() * 2);
+
+    for (uint32_t index = 0; index < m_size; ++index)
+    {
+        Insert(HashVertex(&vertices[index * VertexSize]), index);
+    }
+}
+
+void VertexDedupTable::Insert(uint64_t hash, uint32_t index)
+{
+    size_t group = (hash >> 7) & m_groupMask;
+
+    for (size_t step = 1; ; ++step)
+    {
+        uint32_t matches, empty;
+        MatchGroup(&m_control[group * GroupSize], 0, matches, empty);
+
+        if (empty)
+        {
+            size_t slot = group * GroupSize + CountTrailingZeros(empty);
+            m_control[slot] = static_cast<uint8_t>(hash & 0x7f);
+            m_slots[slot]   = index;
+            return;
+        }
+
+        group = (group + step) & m_groupMask;
+    }
+}
@@ -0,0 +1,53 @@
+//
+// VertexDedupTable.h
+//
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Mixes the raw bits of a six-float vertex - welding compares vertices bitwise, so hashing bits is consistent with it
+inline uint64_t HashVertex(const float* vertex)
+{
+    uint64_t a, b, c;
+    std::memcpy(&a, vertex + 0, sizeof(a));
+    std::memcpy(&b, vertex + 2, sizeof(b));
+    std::memcpy(&c, vertex + 4, sizeof(c));
+
+    uint64_t h = a * 0x9E3779B97F4A7C15ull;
+    h = (h ^ (h >> 32) ^ b) * 0xC2B2AE3D27D4EB4Full;
+    h = (h ^ (h >> 29) ^ c) * 0x165667B19E3779F9ull;
+    return h ^ (h >> 32);
+}
+
+// Flat open-addressing hash set of vertices, used to weld identical triangle corners
+//
+// Slots only hold indices into the caller's vertex array, so keys aren't stored twice. Each slot has a control
+// byte (7-bit hash tag, or empty), and groups of 16 control bytes are matched at once with SSE2 compares.
+class VertexDedupTable
+{
+public:
+    static const size_t VertexSize = 6; // Position & normal floats per vertex
+
+    explicit VertexDedupTable(size_t expectedCount);
+
+    // Returns the index of the bitwise-identical vertex in 'vertices', appending this one first if it's new
+    uint32_t FindOrAppend(const float* vertex, std::vector<float>& vertices);
+
+    size_t   Size() const { return m_size; }
+    size_t   MemoryUsage() const { return m_control.size() + m_slots.size() * sizeof(uint32_t); }
+
+private:
+    void     Allocate(size_t capacity);
+    void     Grow(const std::vector<float>& vertices);
+    void     Insert(uint64_t hash, uint32_t index); // Caller guarantees the vertex isn't present
+
+private:
+    std::vector<uint8_t>  m_control;
+    std::vector<uint32_t> m_slots;
+    size_t                m_groupMask;
+    size_t                m_size;
+    size_t                m_growThreshold;
+};
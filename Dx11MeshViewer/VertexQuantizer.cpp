@@ -0,0 +1,268 @@
+//
+// VertexQuantizer.cpp
+//
+
+#include "pch.h"
+#include "VertexQuantizer.h"
+#include "MeshLoader.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using DirectX::XMFLOAT3;
+
+namespace
+{
+    const size_t   VertexSize     = 6;
+    const size_t   BlockSize      = 16384; // Vertices per parallel work item
+    const float    PositionLevels = 65535.0f;
+
+    float SignNotZero(float x)
+    {
+        return (x < 0.0f) ? -1.0f : 1.0f;
+    }
+
+    // Projects a unit vector onto the octahedron, then folds the lower half over the upper - (u, v) in [-1, 1]
+    void OctahedralEncode(const float* n, float& u, float& v)
+    {
+        float l1 = std::fabs(n[0]) + std::fabs(n[1]) + std::fabs(n[2]);
+        if (l1 == 0.0f)
+        {
+            u = v = 0.0f;
+            return;
+        }
+
+        u = n[0] / l1;
+        v = n[1] / l1;
+
+        if (n[2] < 0.0f)
+        {
+            float foldedU = (1.0f - std::fabs(v)) * SignNotZero(u);
+            float foldedV = (1.0f - std::fabs(u)) * SignNotZero(v);
+            u = foldedU;
+            v = foldedV;
+        }
+    }
+
+    void OctahedralDecode(float u, float v, float* n)
+    {
+        n[0] = u;
+        n[1] = v;
+        n[2] = 1.0f - std::fabs(u) - std::fabs(v);
+
+        if (n[2] < 0.0f)
+        {
+            n[0] = (1.0f - std::fabs(v)) * SignNotZero(u);
+            n[1] = (1.0f - std::fabs(u)) * SignNotZero(v);
+        }
+
+        float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        n[0] /= length;
+        n[1] /= length;
+        n[2] /= length;
+    }
+
+    // Matches the D3D SNORM conversion - the most negative value also maps to -1
+    float SnormToFloat(int value, int maxValue)
+    {
+        return std::max(static_cast<float>(value) / maxValue, -1.0f);
+    }
+
+    // Rounding each component to nearest isn't the closest encoding after the unfold, so every floor/ceil
+    // combination around the continuous (u, v) is decoded and the one nearest the source kept
+    void QuantizeNormal(const float* normal, int maxValue, int& outX, int& outY)
+    {
+        outX = outY = 0;
+
+        float n[3] = { normal[0], normal[1], normal[2] };
+        float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (length == 0.0f)
+        {
+            return;
+        }
+
+        n[0] /= length;
+        n[1] /= length;
+        n[2] /= length;
+
+        float u, v;
+        OctahedralEncode(n, u, v);
+
+        int baseX = static_cast<int>(std::floor(u * maxValue));
+        int baseY = static_cast<int>(std::floor(v * maxValue));
+
+        float bestDot = -2.0f;
+        for (int i = 0; i < 4; ++i)
+        {
+            int x = std::min(std::max(baseX + (i & 1), -maxValue), maxValue);
+            int y = std::min(std::max(baseY + (i >> 1), -maxValue), maxValue);
+
+            float decoded[3];
+            OctahedralDecode(SnormToFloat(x, maxValue), SnormToFloat(y, maxValue), decoded);
+
+            float dot = decoded[0] * n[0] + decoded[1] * n[1] + decoded[2] * n[2];
+            if (dot > bestDot)
+            {
+                bestDot = dot;
+                outX = x;
+                outY = y;
+            }
+        }
+    }
+
+    uint16_t QuantizePosition(float value, float offset, float extent)
+    {
+        if (extent <= 0.0f)
+        {
+            return 0;
+        }
+
+        float level = std::round((value - offset) / extent * PositionLevels);
+        return static_cast<uint16_t>(std::min(std::max(level, 0.0f), PositionLevels));
+    }
+
+    QuantizedVertexFormat MakeFormat(NormalEncoding encoding, const XMFLOAT3& boundsMin, const XMFLOAT3& boundsMax)
+    {
+        QuantizedVertexFormat format {};
+        format.Encoding       = encoding;
+        format.PositionScale  = XMFLOAT3(boundsMax.x - boundsMin.x, boundsMax.y - boundsMin.y, boundsMax.z - boundsMin.z);
+        format.PositionOffset = boundsMin;
+
+        format.Elements[0] = { "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 };
+
+        if (encoding == NormalEncoding::Octahedral16)
+        {
+            format.Elements[1]  = { "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, 4 * sizeof(uint16_t), D3D11_INPUT_PER_VERTEX_DATA, 0 };
+            format.ElementCount = 2;
+            format.Stride       = 6 * sizeof(uint16_t);
+        }
+        else
+        {
+            format.ElementCount = 1;
+            format.Stride       = 4 * sizeof(uint16_t);
+        }
+
+        return format;
+    }
+}
+
+void QuantizeVertices(const Mesh& mesh, NormalEncoding encoding, QuantizedMesh& outMesh, uint32_t threadCount)
+{
+    const QuantizedVertexFormat format = MakeFormat(encoding, mesh.BoundsMin, mesh.BoundsMax);
+    const size_t vertexCount = mesh.VertexBuffer.size() / VertexSize;
+    const int    normalMax   = (encoding == NormalEncoding::Octahedral16) ? 32767 : 127;
+
+    outMesh.Format = format;
+    outMesh.VertexBuffer.resize(vertexCount * format.Stride);
+
+    const float* offset = &format.PositionOffset.x;
+    const float* extent = &format.PositionScale.x;
+
+    ParallelFor((vertexCount + BlockSize - 1) / BlockSize, threadCount, [&](size_t block)
+    {
+        size_t end = std::min(vertexCount, (block + 1) * BlockSize);
+
+        for (size_t v = block * BlockSize; v < end; ++v)
+        {
+            const float* source = &mesh.VertexBuffer[v * VertexSize];
+
+            uint16_t packed[6] = {};
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                packed[axis] = QuantizePosition(source[axis], offset[axis], extent[axis]);
+            }
+
+            int x, y;
+            QuantizeNormal(source + 3, normalMax, x, y);
+
+            if (encoding == NormalEncoding::Octahedral16)
+            {
+                packed[4] = static_cast<uint16_t>(static_cast<int16_t>(x));
+                packed[5] = static_cast<uint16_t>(static_cast<int16_t>(y));
+            }
+            else
+            {
+                packed[3] = static_cast<uint16_t>(static_cast<uint8_t>(static_cast<int8_t>(x)) | (static_cast<uint8_t>(static_cast<int8_t>(y)) << 8));
+            }
+
+            std::memcpy(&outMesh.VertexBuffer[v * format.Stride], packed, format.Stride);
+        }
+    });
+}
+
+void DequantizeVertices(const QuantizedMesh& mesh, std::vector<float>& outVertices)
+{
+    const QuantizedVertexFormat& format = mesh.Format;
+    const size_t vertexCount = mesh.VertexBuffer.size() / format.Stride;
+
+    const float* offset = &format.PositionOffset.x;
+    const float* scale  = &format.PositionScale.x;
+
+    outVertices.resize(vertexCount * VertexSize);
+
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        uint16_t packed[6];
+        std::memcpy(packed, &mesh.VertexBuffer[v * format.Stride], format.Stride);
+
+        float* vertex = &outVertices[v * VertexSize];
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            vertex[axis] = packed[axis] / PositionLevels * scale[axis] + offset[axis];
+        }
+
+        if (format.Encoding == NormalEncoding::Octahedral16)
+        {
+            OctahedralDecode(SnormToFloat(static_cast<int16_t>(packed[4]), 32767), SnormToFloat(static_cast<int16_t>(packed[5]), 32767), vertex + 3);
+        }
+        else
+        {
+            OctahedralDecode(SnormToFloat(static_cast<int8_t>(packed[3] & 0xFF), 127), SnormToFloat(static_cast<int8_t>(packed[3] >> 8), 127), vertex + 3);
+        }
+    }
+}
+
+QuantizationError MeasureQuantizationError(const Mesh& source, const QuantizedMesh& quantized)
+{
+    std::vector<float> decoded;
+    DequantizeVertices(quantized, decoded);
+
+    double maxPositionError = 0.0;
+    double maxNormalError   = 0.0;
+
+    size_t vertexCount = std::min(source.VertexBuffer.size(), decoded.size()) / VertexSize;
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        const float* a = &source.VertexBuffer[v * VertexSize];
+        const float* b = &decoded[v * VertexSize];
+
+        double dx = double(a[0]) - b[0];
+        double dy = double(a[1]) - b[1];
+        double dz = double(a[2]) - b[2];
+        maxPositionError = std::max(maxPositionError, std::sqrt(dx * dx + dy * dy + dz * dz));
+
+        // atan2 of |cross| & dot keeps small angles accurate, where acos of a dot near 1 would be all rounding noise
+        double dot    = a[3] * double(b[3]) + a[4] * double(b[4]) + a[5] * double(b[5]);
+        double crossX = a[4] * double(b[5]) - a[5] * double(b[4]);
+        double crossY = a[5] * double(b[3]) - a[3] * double(b[5]);
+        double crossZ = a[3] * double(b[4]) - a[4] * double(b[3]);
+        double cross  = std::sqrt(crossX * crossX + crossY * crossY + crossZ * crossZ);
+
+        if (a[3] != 0.0f || a[4] != 0.0f || a[5] != 0.0f)
+        {
+            maxNormalError = std::max(maxNormalError, std::atan2(cross, dot));
+        }
+    }
+
+    const XMFLOAT3& extent = quantized.Format.PositionScale;
+    double diagonal = std::sqrt(double(extent.x) * extent.x + double(extent.y) * extent.y + double(extent.z) * extent.z);
+
+    QuantizationError error;
+    error.MaxPositionError      = static_cast<float>(maxPositionError);
+    error.MaxPositionErrorRatio = (diagonal > 0.0) ? static_cast<float>(maxPositionError / diagonal) : 0.0f;
+    error.MaxNormalErrorDegrees = static_cast<float>(maxNormalError * 180.0 / 3.14159265358979323846);
+
+    return error;
+}
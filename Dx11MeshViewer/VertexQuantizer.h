@@ -0,0 +1,58 @@
+//
+// VertexQuantizer.h
+//
+
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstdint>
+#include <vector>
+
+struct Mesh;
+
+// How unit normals are packed - both use an octahedral mapping (Cigolle et al. 2014) onto two signed components
+enum class NormalEncoding
+{
+    Octahedral16, // 2x16 bits in their own R16G16_SNORM element - 12 byte vertices
+    Octahedral8,  // 2x8 bits in the spare W component of the position - 8 byte vertices
+};
+
+// Everything needed to bind and decode a quantized vertex buffer
+//
+// Positions are R16G16B16A16_UNORM, relative to the mesh bounds: position = p.xyz * PositionScale + PositionOffset
+// Normals decode with the usual octahedral unfold of (x, y) in [-1, 1]:
+//   n = float3(x, y, 1 - |x| - |y|); if (n.z < 0) n.xy = (1 - abs(n.yx)) * sign(n.xy); normalize(n)
+// Octahedral16 reads (x, y) from the NORMAL element. Octahedral8 stores x in the low & y in the high byte of
+// p.w, each a two's complement snorm8 - recover the bits with uint(p.w * 65535 + 0.5)
+struct QuantizedVertexFormat
+{
+    NormalEncoding           Encoding;
+    uint32_t                 Stride;       // Bytes per vertex
+    uint32_t                 ElementCount;
+    D3D11_INPUT_ELEMENT_DESC Elements[2];  // Input layout matching the vertex buffer, in slot 0
+
+    DirectX::XMFLOAT3        PositionScale;
+    DirectX::XMFLOAT3        PositionOffset;
+};
+
+struct QuantizedMesh
+{
+    std::vector<uint8_t>     VertexBuffer; // Same vertex order as the source, so its index buffer & submeshes still apply
+    QuantizedVertexFormat    Format;
+};
+
+// Worst-case deviation of decoded vertices from the float source
+struct QuantizationError
+{
+    float MaxPositionError;      // Object space units
+    float MaxPositionErrorRatio; // Relative to the bounds diagonal
+    float MaxNormalErrorDegrees; // Angle between unit normals; zero-length source normals are skipped
+};
+
+// Quantizes the mesh's position/normal vertices against its BoundsMin/BoundsMax
+void QuantizeVertices(const Mesh& mesh, NormalEncoding encoding, QuantizedMesh& outMesh, uint32_t threadCount = 0);
+
+// Decodes back into 6-float position/normal vertices, exactly as the input layout & shader decode would
+void DequantizeVertices(const QuantizedMesh& mesh, std::vector<float>& outVertices);
+
+QuantizationError MeasureQuantizationError(const Mesh& source, const QuantizedMesh& quantized);
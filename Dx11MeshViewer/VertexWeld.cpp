@@ -0,0 +1,251 @@
+//
+// VertexWeld.cpp
+//
+
+#include "pch.h"
+#include "VertexWeld.h"
+#include "MeshLoader.h"
+#include "Parallel.h"
+#include "VertexDedupTable.h"
+
+namespace
+{
+    const size_t VertexSize = VertexDedupTable::VertexSize;
+    const size_t RadixBits  = 8;
+    const size_t RadixSize  = 1 << RadixBits;
+
+    inline void FetchVertex(const float* positions, const float* normals, const CornerIndexStream& corners, size_t corner, float* outVertex)
+    {
+        const float* p = &positions[3 * corners.Position(corner)];
+        const float* n = &normals[3 * corners.Normal(corner)];
+
+        outVertex[0] = p[0]; outVertex[1] = p[1]; outVertex[2] = p[2];
+        outVertex[3] = n[0]; outVertex[4] = n[1]; outVertex[5] = n[2];
+    }
+
+    inline uint32_t SortKey(uint64_t entry) { return static_cast<uint32_t>(entry >> 32); }
+    inline uint32_t SortCorner(uint64_t entry) { return static_cast<uint32_t>(entry); }
+
+    // Splits [0, count) into 'blockCount' nearly equal ranges
+    inline size_t BlockStart(size_t block, size_t blockCount, size_t count)
+    {
+        return count / blockCount * block + std::min(block, count % blockCount);
+    }
+
+    // Stable parallel LSD radix sort on the upper 32 bits of each entry
+    // Each pass histograms per block, scans the (digit, block) table, then scatters every block independently
+    void RadixSortByKey(std::vector<uint64_t>& entries, uint32_t threadCount)
+    {
+        size_t count      = entries.size();
+        size_t blockCount = std::max<size_t>(1, std::min<size_t>(threadCount * 4, count / 65536));
+
+        std::vector<uint64_t> scratch(count);
+        std::vector<size_t>   histograms(blockCount * RadixSize);
+
+        for (size_t shift = 32; shift < 64; shift += RadixBits)
+        {
+            std::fill(histograms.begin(), histograms.end(), 0);
+
+            ParallelFor(blockCount, threadCount, [&](size_t b)
+            {
+                size_t* histogram = &histograms[b * RadixSize];
+                for (size_t i = BlockStart(b, blockCount, count); i < BlockStart(b + 1, blockCount, count); ++i)
+                {
+                    ++histogram[(entries[i] >> shift) & (RadixSize - 1)];
+                }
+            });
+
+            // Turn counts into scatter offsets, digit-major so equal digits keep their block order
+            size_t offset = 0;
+            for (size_t digit = 0; digit < RadixSize; ++digit)
+            {
+                for (size_t b = 0; b < blockCount; ++b)
+                {
+                    size_t digitCount = histograms[b * RadixSize + digit];
+                    histograms[b * RadixSize + digit] = offset;
+                    offset += digitCount;
+                }
+            }
+
+            ParallelFor(blockCount, threadCount, [&](size_t b)
+            {
+                size_t* offsets = &histograms[b * RadixSize];
+                for (size_t i = BlockStart(b, blockCount, count); i < BlockStart(b + 1, blockCount, count); ++i)
+                {
+                    scratch[offsets[(entries[i] >> shift) & (RadixSize - 1)]++] = entries[i];
+                }
+            });
+
+            entries.swap(scratch);
+        }
+    }
+}
+
+
+void WeldVerticesHashed(const float* positions, const float* normals, const CornerIndexStream& corners, Mesh& outMesh)
+{
+    // Flat hash set used to de-duplicate vertices and generate an index buffer
+    // Closed meshes average roughly one unique vertex per two triangles, so the triangle count is ample headroom
+    VertexDedupTable uniqueVertices(corners.Count / 3);
+
+    outMesh.IndexBuffer.reserve(outMesh.IndexBuffer.size() + corners.Count);
+
+    for (size_t c = 0; c < corners.Count; c++)
+    {
+        float vertex[VertexSize];
+        FetchVertex(positions, normals, corners, c, vertex);
+
+        // New vertices are appended to the vertex buffer; repeats reuse the existing index
+        outMesh.IndexBuffer.push_back(uniqueVertices.FindOrAppend(vertex, outMesh.VertexBuffer));
+    }
+}
+
+void WeldVerticesSorted(const float* positions, const float* normals, const CornerIndexStream& corners, uint32_t threadCount, Mesh& outMesh)
+{
+    // Sort entries & first corners hold 32-bit corner indices
+    if (corners.Count > UINT32_MAX)
+    {
+        WeldVerticesHashed(positions, normals, corners, outMesh);
+        return;
+    }
+
+    threadCount = ResolveThreadCount(threadCount);
+
+    size_t count      = corners.Count;
+    size_t blockCount = std::max<size_t>(1, std::min<size_t>(threadCount * 4, count / 65536));
+
+
+    ////
+    // Key every corner by the hash of its vertex; the corner index in the low half keeps equal keys in corner order
+
+    std::vector<uint64_t> entries(count);
+
+    ParallelFor(blockCount, threadCount, [&](size_t b)
+    {
+        for (size_t c = BlockStart(b, blockCount, count); c < BlockStart(b + 1, blockCount, count); ++c)
+        {
+            float vertex[VertexSize];
+            FetchVertex(positions, normals, corners, c, vertex);
+
+            entries[c] = (HashVertex(vertex) & 0xffffffff00000000ull) | c;
+        }
+    });
+
+    RadixSortByKey(entries, threadCount);
+
+
+    ////
+    // Collapse each run of equal keys - every corner maps to the first (lowest) corner with a bitwise-identical vertex
+
+    std::vector<uint32_t> firstCorner(count);
+
+    ParallelFor(blockCount, threadCount, [&](size_t b)
+    {
+        // A run belongs to the block it starts in
+        auto runStart = [&](size_t i)
+        {
+            while (i > 0 && i < count && SortKey(entries[i]) == SortKey(entries[i - 1]))
+            {
+                ++i;
+            }
+            return i;
+        };
+
+        size_t end = runStart(BlockStart(b + 1, blockCount, count));
+
+        std::vector<uint32_t> representatives;
+
+        for (size_t i = runStart(BlockStart(b, blockCount, count)); i < end; )
+        {
+            size_t runEnd = i + 1;
+            while (runEnd < count && SortKey(entries[runEnd]) == SortKey(entries[i]))
+            {
+                ++runEnd;
+            }
+
+            // Nearly every run is a single vertex; distinct vertices only share a run on a hash collision
+            representatives.clear();
+
+            for (; i < runEnd; ++i)
+            {
+                uint32_t corner = SortCorner(entries[i]);
+
+                float vertex[VertexSize];
+                FetchVertex(positions, normals, corners, corner, vertex);
+
+                uint32_t first = corner;
+                for (uint32_t representative : representatives)
+                {
+                    float other[VertexSize];
+                    FetchVertex(positions, normals, corners, representative, other);
+
+                    if (std::memcmp(vertex, other, sizeof(vertex)) == 0)
+                    {
+                        first = representative;
+                        break;
+                    }
+                }
+
+                if (first == corner)
+                {
+                    representatives.push_back(corner);
+                }
+
+                firstCorner[corner] = first;
+            }
+        }
+    });
+
+    std::vector<uint64_t>().swap(entries);
+
+
+    ////
+    // Number unique vertices in order of first use with a parallel prefix sum over first corners
+
+    std::vector<size_t> blockBase(blockCount + 1);
+
+    ParallelFor(blockCount, threadCount, [&](size_t b)
+    {
+        size_t uniqueCount = 0;
+        for (size_t c = BlockStart(b, blockCount, count); c < BlockStart(b + 1, blockCount, count); ++c)
+        {
+            uniqueCount += (firstCorner[c] == c);
+        }
+        blockBase[b + 1] = uniqueCount;
+    });
+
+    for (size_t b = 0; b < blockCount; ++b)
+    {
+        blockBase[b + 1] += blockBase[b];
+    }
+
+    size_t vertexBase = outMesh.VertexBuffer.size() / VertexSize;
+    size_t indexBase  = outMesh.IndexBuffer.size();
+
+    outMesh.VertexBuffer.resize((vertexBase + blockBase[blockCount]) * VertexSize);
+    outMesh.IndexBuffer.resize(indexBase + count);
+
+    // First corners record their vertex index in place of the self-reference
+    std::vector<uint32_t> vertexIndex(count);
+
+    ParallelFor(blockCount, threadCount, [&](size_t b)
+    {
+        size_t next = vertexBase + blockBase[b];
+        for (size_t c = BlockStart(b, blockCount, count); c < BlockStart(b + 1, blockCount, count); ++c)
+        {
+            if (firstCorner[c] == c)
+            {
+                FetchVertex(positions, normals, corners, c, &outMesh.VertexBuffer[next * VertexSize]);
+                vertexIndex[c] = static_cast<uint32_t>(next++);
+            }
+        }
+    });
+
+    ParallelFor(blockCount, threadCount, [&](size_t b)
+    {
+        for (size_t c = BlockStart(b, blockCount, count); c < BlockStart(b + 1, blockCount, count); ++c)
+        {
+            outMesh.IndexBuffer[indexBase + c] = vertexIndex[firstCorner[c]];
+        }
+    });
+}
@@ -0,0 +1,32 @@
+//
+// VertexWeld.h
+//
+
+#pragma once
+
+#include <cstdint>
+
+struct Mesh;
+
+// Triangle corners as (position, normal) index pairs spaced Stride int32s apart
+// This is the leading layout of both ObjCorner and tinyobj::index_t, so either can be welded in place
+struct CornerIndexStream
+{
+    const int32_t* Indices;
+    size_t         Stride;
+    size_t         Count;
+
+    size_t Position(size_t corner) const { return static_cast<size_t>(Indices[corner * Stride + 0]); }
+    size_t Normal(size_t corner) const   { return static_cast<size_t>(Indices[corner * Stride + 1]); }
+};
+
+// Both welders append bitwise-unique position/normal vertices to the mesh's vertex buffer in order of first
+// use, and one index per corner to its index buffer - their output is identical
+
+// Serial weld through a single VertexDedupTable
+void WeldVerticesHashed(const float* positions, const float* normals, const CornerIndexStream& corners, Mesh& outMesh);
+
+// Parallel weld with no shared hash map: corners are keyed by vertex hash, radix-sorted, collapsed into runs
+// of identical vertices, and numbered by a prefix sum over each vertex's first corner
+// Streams of more than UINT32_MAX corners, which the sort can't index, go through WeldVerticesHashed instead
+void WeldVerticesSorted(const float* positions, const float* normals, const CornerIndexStream& corners, uint32_t threadCount, Mesh& outMesh);
@@ -7,23 +7,87 @@
 #define NOMINMAX
 
 #include <chrono>
-#include <d3d11_4.h>
 #include <exception>
 #include <memory>
 #include <string>
 
+#ifdef _WIN32
+
+#include <d3d11_4.h>
 #include <windows.h>
 #include <wrl.h>
 
 using Microsoft::WRL::ComPtr;
 
+#else
+
+// Headless builds of the shared sources (MeshTool through CMake) - just the Windows & D3D11 names they use
+
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+
+typedef int32_t      HRESULT;
+typedef unsigned int UINT;
+
+#define S_OK          static_cast<HRESULT>(0)
+#define E_NOTIMPL     static_cast<HRESULT>(0x80004001)
+#define E_FAIL        static_cast<HRESULT>(0x80004005)
+#define E_OUTOFMEMORY static_cast<HRESULT>(0x8007000E)
+#define E_INVALIDARG  static_cast<HRESULT>(0x80070057)
+
+#define FAILED(hr)    (static_cast<HRESULT>(hr) < 0)
+#define SUCCEEDED(hr) (static_cast<HRESULT>(hr) >= 0)
+
+#define _countof(a) (sizeof(a) / sizeof((a)[0]))
+
+inline void OutputDebugStringA(const char* message)
+{
+    fputs(message, stderr);
+}
+
+template <size_t N>
+inline int sprintf_s(char (&buffer)[N], const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, N, format, args);
+    va_end(args);
+    return length;
+}
+
+// Values as in dxgiformat.h & d3d11.h, for the vertex layouts VertexQuantizer describes
+enum DXGI_FORMAT
+{
+    DXGI_FORMAT_R16G16B16A16_UNORM = 11,
+    DXGI_FORMAT_R16G16_SNORM       = 37,
+};
+
+enum D3D11_INPUT_CLASSIFICATION
+{
+    D3D11_INPUT_PER_VERTEX_DATA = 0,
+};
+
+struct D3D11_INPUT_ELEMENT_DESC
+{
+    const char*                SemanticName;
+    UINT                       SemanticIndex;
+    DXGI_FORMAT                Format;
+    UINT                       InputSlot;
+    UINT                       AlignedByteOffset;
+    D3D11_INPUT_CLASSIFICATION InputSlotClass;
+    UINT                       InstanceDataStepRate;
+};
+
+#endif
+
 // Helper class for COM exceptions
 class com_exception : public std::exception
 {
 public:
     com_exception(HRESULT hr) : result(hr) {}
 
-    virtual const char* what() const override
+    virtual const char* what() const noexcept override
     {
         static char s_str[64] = {};
         sprintf_s(s_str, "Failure with HRESULT of %08X", result);
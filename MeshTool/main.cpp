@@ -0,0 +1,2835 @@
+//
+// main.cpp
+//
+
+#include "pch.h"
+
+#include "BlinnPhongKernel.h"
+#include "ConstantRing.h"
+#include "ConstantShadow.h"
+#include "FloatParser.h"
+#include "FrameDiff.h"
+#include "FrustumCuller.h"
+#include "InstancePacker.h"
+#include "LodSelector.h"
+#include "MeshLoader.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "MeshletBuilder.h"
+#include "ObjParser.h"
+#include "OcclusionCuller.h"
+#include "Parallel.h"
+#include "SceneObjects.h"
+#include "SoftwareRenderer.h"
+#include "ThreadPool.h"
+#include "VertexBounds.h"
+#include "VertexDedupTable.h"
+#include "VertexQuantizer.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+
+#pragma warning(push)
+#pragma warning(disable : 26495 26451 26498 26812)
+
+// Declarations only - the implementation is compiled into MeshLoader.cpp
+#include "tiny_obj_loader.h"
+
+#pragma warning(pop)
+
+using namespace std::chrono;
+
+// Headless companion to Dx11MeshViewer - runs the viewer's mesh pipeline without a window or a D3D device
+//
+//   MeshTool stats <file.obj>...      Post-transform vertex cache efficiency before & after OptimizeMesh
+//   MeshTool quantize <file.obj>...   Size & worst-case error of each quantized vertex format
+//   MeshTool meshlets <file.obj>...   Meshlet builder throughput, fill & back-face cone culling rate
+//   MeshTool lods <file.obj>...       LOD chain build time, triangle counts, geometric error & switch distance per level
+//   MeshTool bounds <file.obj>...     Bounds reduction throughput against the loader's old serial loop, & sphere/box tightness
+//   MeshTool render <file.obj> <out.bmp> [width height]
+//                                     Draws the viewer's startup frame on the CPU & times it
+//   MeshTool raster <file.obj>...     CPU rasterizer triangle & pixel rates per SIMD level at several resolutions, on one thread
+//   MeshTool scaling <file.obj> [width height]
+//                                     CPU renderer frame time from 1 to 64 worker threads, & whether every image matches
+//   MeshTool shading <file.obj>...    Pixel shading kernel rates per SIMD level & specular pow, with error against the scalar reference
+//   MeshTool regress <file.obj> [golden dir] [--update]
+//                                     Renders fixed camera & rotation keyframes on the CPU from packed instance data & compares
+//                                     them with golden images (by default the teapot's, in MeshTool/golden), or replaces the
+//                                     goldens - exits with 1 if any frame differs
+//   MeshTool occlusion <file.obj> [boxes]
+//                                     Hierarchical Z culling of a field of boxes behind a wall of LOD proxies - cost per SIMD
+//                                     level & thread count, & culls checked against full resolution depth
+//   MeshTool frustum                  Scene object refit & frustum culling cost from 1k to 1M objects per SIMD level & thread count
+//   MeshTool instances                Instance buffer packing cost & bandwidth from 1k to 1M instances per thread count, with
+//                                     the layout & packed transforms checked
+//   MeshTool uploads [objects] [draws]
+//                                     Bytes the viewer uploads per frame as its constant blocks change, with the draws sharing
+//                                     the per-object block & with a ring block each - against restaging every object's whole
+//                                     constant buffer each frame
+//   MeshTool ring                     Constant ring allocation & wraparound checks, then allocation rates with & without writing
+//                                     the blocks
+//   MeshTool parse [file.obj]...      tinyobjloader against ObjParser per thread count, read & memory-mapped, on the files &
+//                                     generated grids, then the weld's rate & table size against the old unordered_map -
+//                                     exits with 1 unless every configuration loads an identical mesh
+//   MeshTool floats                   OBJ real parsing rate per SIMD level, with every level checked bit for bit against the
+//                                     scalar parser on generated edge-case tokens - exits with 1 on any mismatch
+//   MeshTool cache <file.obj>...      Load time with the viewer's options - uncached, cold (parsing & writing the mesh cache)
+//                                     & warm (reading it, keyed on size & modification time) & verified (also rehashing the
+//                                     source) - exits with 1 unless the cached mesh matches the uncached one
+//   MeshTool lodselect [file.obj]...  LOD selection checks at fixed distances, & either side of every level's switch distance
+//                                     on a synthetic chain & the files' chains - exits with 1 on any failure
+
+static void PrintUsage()
+{
+    printf("Usage: MeshTool stats <file.obj>...\n");
+    printf("       MeshTool quantize <file.obj>...\n");
+    printf("       MeshTool meshlets <file.obj>...\n");
+    printf("       MeshTool lods <file.obj>...\n");
+    printf("       MeshTool bounds <file.obj>...\n");
+    printf("       MeshTool render <file.obj> <out.bmp> [width height]\n");
+    printf("       MeshTool raster <file.obj>...\n");
+    printf("       MeshTool scaling <file.obj> [width height]\n");
+    printf("       MeshTool shading <file.obj>...\n");
+    printf("       MeshTool regress <file.obj> [golden dir] [--update]\n");
+    printf("       MeshTool occlusion <file.obj> [boxes]\n");
+    printf("       MeshTool frustum\n");
+    printf("       MeshTool instances\n");
+    printf("       MeshTool uploads [objects] [draws]\n");
+    printf("       MeshTool ring\n");
+    printf("       MeshTool parse [file.obj]...\n");
+    printf("       MeshTool floats\n");
+    printf("       MeshTool cache <file.obj>...\n");
+    printf("       MeshTool lodselect [file.obj]...\n");
+}
+
+static int RunStats(int fileCount, char** files)
+{
+    printf("%-32s %10s %10s   %-17s %-17s %10s\n", "", "vertices", "triangles", "ACMR", "ATVR", "");
+
+    for (int i = 0; i < fileCount; ++i)
+    {
+        Mesh mesh;
+
+        HRESULT hr = LoadMesh(files[i], mesh);
+        if (FAILED(hr))
+        {
+            fprintf(stderr, "%s: failed to load (HRESULT %08X)\n", files[i], static_cast<unsigned int>(hr));
+            return 1;
+        }
+
+        // Analysis reads 32-bit indices
+        WidenIndices(mesh);
+
+        size_t vertexCount = mesh.VertexBuffer.size() / 6;
+        VertexCacheStats before = AnalyzeVertexCache(mesh.IndexBuffer.data(), mesh.IndexBuffer.size(), vertexCount);
+
+        auto start = high_resolution_clock::now();
+        OptimizeMesh(mesh);
+        auto optimizeTime = duration<double, std::milli>(high_resolution_clock::now() - start).count();
+
+        VertexCacheStats after = AnalyzeVertexCache(mesh.IndexBuffer.data(), mesh.IndexBuffer.size(), vertexCount);
+
+        printf("%-32s %10zu %10zu   %.3f -> %.3f    %.3f -> %.3f    %8.1f ms\n",
+            files[i], vertexCount, mesh.IndexBuffer.size() / 3, before.Acmr, after.Acmr, before.Atvr, after.Atvr, optimizeTime);
+    }
+
+    return 0;
+}
+
+static int RunQuantize(int fileCount, char** files)
+{
+    const struct
+    {
+        NormalEncoding Encoding;
+        const char*    Name;
+    } encodings[] =
+    {
+        { NormalEncoding::Octahedral16, "oct16" },
+        { NormalEncoding::Octahedral8,  "oct8"  },
+    };
+
+    printf("%-32s %-6s %10s %12s %14s %12s %14s\n", "", "", "vertices", "bytes", "max pos err", "(of diag)", "max nrm err");
+
+    for (int i = 0; i < fileCount; ++i)
+    {
+        Mesh mesh;
+
+        HRESULT hr = LoadMesh(files[i], mesh);
+        if (FAILED(hr))
+        {
+            fprintf(stderr, "%s: failed to load (HRESULT %08X)\n", files[i], static_cast<unsigned int>(hr));
+            return 1;
+        }
+
+        size_t vertexCount = mesh.VertexBuffer.size() / 6;
+        printf("%-32s %-6s %10zu %12zu\n", files[i], "float", vertexCount, mesh.VertexBuffer.size() * sizeof(float));
+
+        for (const auto& encoding : encodings)
+        {
+            QuantizedMesh quantized;
+            QuantizeVertices(mesh, encoding.Encoding, quantized);
+
+            QuantizationError error = MeasureQuantizationError(mesh, quantized);
+
+            printf("%-32s %-6s %10zu %12zu %14.3g %11.5f%% %12.3f deg\n",
+                "", encoding.Name, vertexCount, quantized.VertexBuffer.size(), error.MaxPositionError, error.MaxPositionErrorRatio * 100.0f, error.MaxNormalErrorDegrees);
+        }
+    }
+
+    return 0;
+}
+
+static int RunMeshlets(int fileCount, char** files)
+{
+    printf("%-32s %10s %10s %10s %10s %10s %14s %10s\n", "", "triangles", "meshlets", "avg verts", "avg tris", "culled", "build", "Mtri/s");
+
+    for (int i = 0; i < fileCount; ++i)
+    {
+        MeshLoadOptions loadOptions;
+        loadOptions.Optimize = true;
+
+        Mesh mesh;
+
+        HRESULT hr = LoadMesh(files[i], mesh, loadOptions);
+        if (FAILED(hr))
+        {
+            fprintf(stderr, "%s: failed to load (HRESULT %08X)\n", files[i], static_cast<unsigned int>(hr));
+            return 1;
+        }
+
+        auto start = high_resolution_clock::now();
+        BuildMeshlets(mesh);
+        auto buildTime = duration<double, std::milli>(high_resolution_clock::now() - start).count();
+
+        size_t triangleCount = mesh.IndexCount() / 3;
+        size_t vertexTotal = 0;
+        for (const Meshlet& meshlet : mesh.Meshlets)
+        {
+            vertexTotal += meshlet.VertexCount;
+        }
+
+        // Average share of meshlets whose cone rejects them, seen from well outside the bounds along each axis
+        DirectX::XMFLOAT3 center((mesh.BoundsMin.x + mesh.BoundsMax.x) / 2, (mesh.BoundsMin.y + mesh.BoundsMax.y) / 2, (mesh.BoundsMin.z + mesh.BoundsMax.z) / 2);
+        float distance = 4 * std::max({ mesh.BoundsMax.x - mesh.BoundsMin.x, mesh.BoundsMax.y - mesh.BoundsMin.y, mesh.BoundsMax.z - mesh.BoundsMin.z });
+
+        size_t culled = 0;
+        for (int view = 0; view < 6; ++view)
+        {
+            DirectX::XMFLOAT3 camera = center;
+            (&camera.x)[view / 2] += (view & 1) ? distance : -distance;
+
+            for (const Meshlet& meshlet : mesh.Meshlets)
+            {
+                culled += IsMeshletBackfacing(meshlet, camera);
+            }
+        }
+
+        size_t meshletCount = std::max<size_t>(mesh.Meshlets.size(), 1);
+
+        printf("%-32s %10zu %10zu %10.1f %10.1f %9.1f%% %11.1f ms %10.2f\n",
+            files[i], triangleCount, mesh.Meshlets.size(), double(vertexTotal) / meshletCount, double(triangleCount) / meshletCount,
+            100.0 * culled / (6 * meshletCount), buildTime, triangleCount / (buildTime * 1000.0));
+    }
+
+    return 0;
+}
+
+static int RunLods(int fileCount, char** files)
+{
+    for (int i = 0; i < fileCount; ++i)
+    {
+        MeshLoadOptions loadOptions;
+        loadOptions.Optimize = true;
+
+        Mesh mesh;
+
+        HRESULT hr = LoadMesh(files[i], mesh, loadOptions);
+        if (FAILED(hr))
+        {
+            fprintf(stderr, "%s: failed to load (HRESULT %08X)\n", files[i], static_cast<unsigned int>(hr));
+            return 1;
+        }
+
+        size_t triangleCount = mesh.IndexCount() / 3;
+
+        auto start = high_resolution_clock::now();
+        BuildLodChain(mesh);
+        auto buildTime = duration<double, std::milli>(high_resolution_clock::now() - start).count();
+
+        float dx = mesh.BoundsMax.x - mesh.BoundsMin.x, dy = mesh.BoundsMax.y - mesh.BoundsMin.y, dz = mesh.BoundsMax.z - mesh.BoundsMin.z;
+        float diagonal = std::sqrt(dx * dx + dy * dy + dz * dz);
+
+        printf("%s: %zu triangles, chain built in %.1f ms (%.2f Mtri/s)\n", files[i], triangleCount, buildTime, triangleCount / (buildTime * 1000.0));
+
+        // Where the viewer switches each level in - its object scale & 60 degree, 1080 pixel high view with a one pixel
+        // limit. Like lodselect, "beyond" is measured from the bounding sphere; "eye at" adds the scaled radius for the
+        // eye's distance to the sphere's center
+        const float scale       = SceneState().ObjectScale;
+        const float fieldOfView = 60.0f * 3.14159265f / 180.0f;
+
+        VertexBounds bounds;
+        ComputeVertexBounds(mesh.VertexBuffer.data(), mesh.VertexBuffer.size() / 6, 6, bounds);
+
+        printf("  %-5s %10s %8s %12s %12s %12s %12s\n", "level", "triangles", "share", "error", "(of diag)", "beyond", "eye at");
+
+        for (size_t l = 0; l < mesh.Lods.size(); ++l)
+        {
+            size_t lodTriangles = 0;
+            for (const Submesh& submesh : mesh.Lods[l].Submeshes)
+            {
+                lodTriangles += submesh.IndexCount / 3;
+            }
+
+            float beyond = ErrorSwitchDistance(mesh.Lods[l].Error * scale, fieldOfView, 1080.0f, 1.0f);
+
+            printf("  %-5zu %10zu %7.1f%% %12.4g %11.4f%% %12.4g %12.4g\n",
+                l + 1, lodTriangles, 100.0 * lodTriangles / std::max<size_t>(triangleCount, 1), mesh.Lods[l].Error, diagonal > 0 ? 100.0f * mesh.Lods[l].Error / diagonal : 0.0f,
+                beyond, beyond + bounds.SphereRadius * scale);
+        }
+    }
+
+    return 0;
+}
+
+// The loader's bounds loop before ComputeAabb, kept as the baseline
+static void ComputeBoundsSerial(const float* vertices, size_t vertexCount, DirectX::XMFLOAT3& outMin, DirectX::XMFLOAT3& outMax)
+{
+    auto boundsMin = DirectX::XMVectorReplicate(FLT_MAX);
+    auto boundsMax = DirectX::XMVectorReplicate(-FLT_MAX);
+
+    for (size_t i = 0; i < vertexCount * 6; i += 6)
+    {
+        auto position = DirectX::XMLoadFloat3(reinterpret_cast<const DirectX::XMFLOAT3*>(&vertices[i]));
+
+        boundsMax = DirectX::XMVectorMax(boundsMax, position);
+        boundsMin = DirectX::XMVectorMin(boundsMin, position);
+    }
+
+    DirectX::XMStoreFloat3(&outMin, boundsMin);
+    DirectX::XMStoreFloat3(&outMax, boundsMax);
+}
+
+// Classic Ritter - diameter from the axis extremes, then one growth pass in vertex order - to rate the sphere against
+static float RitterRadius(const float* vertices, size_t vertexCount)
+{
+    const float* extremes[6] = { vertices, vertices, vertices, vertices, vertices, vertices };
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        const float* p = vertices + i * 6;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            extremes[axis * 2]     = (p[axis] < extremes[axis * 2][axis]) ? p : extremes[axis * 2];
+            extremes[axis * 2 + 1] = (p[axis] > extremes[axis * 2 + 1][axis]) ? p : extremes[axis * 2 + 1];
+        }
+    }
+
+    float center[3] = {};
+    float radiusSq  = -1.0f;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        const float* a = extremes[axis * 2];
+        const float* b = extremes[axis * 2 + 1];
+
+        float lengthSq = (b[0] - a[0]) * (b[0] - a[0]) + (b[1] - a[1]) * (b[1] - a[1]) + (b[2] - a[2]) * (b[2] - a[2]);
+        if (lengthSq / 4 > radiusSq)
+        {
+            radiusSq = lengthSq / 4;
+            for (int k = 0; k < 3; ++k)
+            {
+                center[k] = (a[k] + b[k]) / 2;
+            }
+        }
+    }
+
+    float radius = std::sqrt(radiusSq);
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        const float* p = vertices + i * 6;
+
+        float dx = p[0] - center[0], dy = p[1] - center[1], dz = p[2] - center[2];
+        float distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+
+        if (distance > radius)
+        {
+            float grownRadius = (radius + distance) / 2;
+            for (int k = 0; k < 3; ++k)
+            {
+                center[k] += (p[k] - center[k]) * (grownRadius - radius) / distance;
+            }
+            radius = grownRadius;
+        }
+    }
+
+    return radius;
+}
+
+// Best of several runs of fn, in milliseconds
+template <class Fn>
+static double TimeBest(int runs, Fn fn)
+{
+    double best = 1e30;
+    for (int run = 0; run < runs; ++run)
+    {
+        auto start = high_resolution_clock::now();
+        fn();
+        best = std::min(best, duration<double, std::milli>(high_resolution_clock::now() - start).count());
+    }
+    return best;
+}
+
+static int RunBounds(int fileCount, char** files)
+{
+    const int runs = 10;
+
+    for (int i = 0; i < fileCount; ++i)
+    {
+        Mesh mesh;
+
+        HRESULT hr = LoadMesh(files[i], mesh);
+        if (FAILED(hr))
+        {
+            fprintf(stderr, "%s: failed to load (HRESULT %08X)\n", files[i], static_cast<unsigned int>(hr));
+            return 1;
+        }
+
+        const float* vertices    = mesh.VertexBuffer.data();
+        size_t       vertexCount = mesh.VertexBuffer.size() / 6;
+
+        DirectX::XMFLOAT3 serialMin, serialMax, aabbMin, aabbMax;
+
+        double serialTime   = TimeBest(runs, [&]() { ComputeBoundsSerial(vertices, vertexCount, serialMin, serialMax); });
+        double aabbTime     = TimeBest(runs, [&]() { ComputeAabb(vertices, vertexCount, 6, 1, aabbMin, aabbMax); });
+        double parallelTime = TimeBest(runs, [&]() { ComputeAabb(vertices, vertexCount, 6, 0, aabbMin, aabbMax); });
+
+        bool matches = std::memcmp(&serialMin, &aabbMin, sizeof(aabbMin)) == 0 && std::memcmp(&serialMax, &aabbMax, sizeof(aabbMax)) == 0;
+
+        VertexBoundsOptions sphereOptions;
+        VertexBoundsOptions boxOptions;
+        boxOptions.Sphere      = false;
+        boxOptions.OrientedBox = true;
+
+        VertexBounds sphere, box;
+        double sphereTime = TimeBest(runs, [&]() { ComputeVertexBounds(vertices, vertexCount, 6, sphere, sphereOptions); });
+        double boxTime    = TimeBest(runs, [&]() { ComputeVertexBounds(vertices, vertexCount, 6, box, boxOptions); });
+
+        float ritterRadius = RitterRadius(vertices, vertexCount);
+
+        float extent[3]    = { aabbMax.x - aabbMin.x, aabbMax.y - aabbMin.y, aabbMax.z - aabbMin.z };
+        float halfDiagonal = std::sqrt(extent[0] * extent[0] + extent[1] * extent[1] + extent[2] * extent[2]) / 2;
+        float aabbVolume   = extent[0] * extent[1] * extent[2];
+        float boxVolume    = 8.0f * box.BoxExtents.x * box.BoxExtents.y * box.BoxExtents.z;
+
+        printf("%s: %zu vertices\n", files[i], vertexCount);
+        printf("  serial XMLoadFloat3 loop  %9.3f ms\n", serialTime);
+        printf("  ComputeAabb, 1 thread     %9.3f ms  %5.2fx  %s\n", aabbTime, serialTime / aabbTime, matches ? "identical" : "MISMATCH");
+        printf("  ComputeAabb, all threads  %9.3f ms  %5.2fx\n", parallelTime, serialTime / parallelTime);
+        printf("  sphere                    %9.3f ms  radius %.5g (Ritter %.5g, AABB %.5g)\n", sphereTime, sphere.SphereRadius, ritterRadius, halfDiagonal);
+        printf("  oriented box              %9.3f ms  volume %.5g (AABB %.5g)\n", boxTime, boxVolume, aabbVolume);
+    }
+
+    return 0;
+}
+
+static int RunRender(int argc, char** argv)
+{
+    const char* filename = argv[0];
+    const char* output   = argv[1];
+
+    SoftwareFrame frame;
+    frame.Width  = (argc >= 4) ? static_cast<uint32_t>(atoi(argv[2])) : 1920;
+    frame.Height = (argc >= 4) ? static_cast<uint32_t>(atoi(argv[3])) : 1080;
+
+    // Loaded like the viewer loads it
+    MeshLoadOptions loadOptions;
+    loadOptions.Optimize = true;
+
+    Mesh mesh;
+
+    HRESULT hr = LoadMesh(filename, mesh, loadOptions);
+    if (FAILED(hr))
+    {
+        fprintf(stderr, "%s: failed to load (HRESULT %08X)\n", filename, static_cast<unsigned int>(hr));
+        return 1;
+    }
+
+    SceneState scene;
+    FocusCamera(scene, mesh.BoundsMin, mesh.BoundsMax);
+
+    AppShaderConstants constants;
+    ComputeShaderConstants(scene, static_cast<float>(frame.Width) / static_cast<float>(frame.Height), constants);
+
+    // The first frame also pays for allocating the targets
+    double renderTime = TimeBest(10, [&]() { hr = RenderMesh(mesh, mesh.Submeshes, constants, frame); });
+    if (FAILED(hr))
+    {
+        fprintf(stderr, "%ux%u: can't render at that size\n", frame.Width, frame.Height);
+        return 1;
+    }
+
+    if (FAILED(WriteFrameBmp(output, frame)))
+    {
+        fprintf(stderr, "%s: failed to write\n", output);
+        return 1;
+    }
+
+    printf("%s: %zu triangles at %ux%u in %.2f ms -> %s\n", filename, mesh.IndexCount() / 3, frame.Width, frame.Height, renderTime, output);
+    return 0;
+}
+
+static int RunRaster(int fileCount, char** files)
+{
+    const int runs = 5;
+
+    const struct
+    {
+        uint32_t Width;
+        uint32_t Height;
+    } resolutions[] = { { 640, 360 }, { 1280, 720 }, { 1920, 1080 }, { 3840, 2160 } };
+
+    for (int i = 0; i < fileCount; ++i)
+    {
+        MeshLoadOptions loadOptions;
+        loadOptions.Optimize = true;
+
+        Mesh mesh;
+
+        HRESULT hr = LoadMesh(files[i], mesh, loadOptions);
+        if (FAILED(hr))
+        {
+            fprintf(stderr, "%s: failed to load (HRESULT %08X)\n", files[i], static_cast<unsigned int>(hr));
+            return 1;
+        }
+
+        SceneState scene;
+        FocusCamera(scene, mesh.BoundsMin, mesh.BoundsMax);
+
+        printf("%s: %zu triangles\n", files[i], mesh.IndexCount() / 3);
+        printf("  %-10s %-8s %10s %10s %9s %9s %12s %9s %9s %8s %12s %9s  %s\n", "", "", "setup", "covered", "rejected", "accepted",
+            "depth only", "Mtri/s", "Mpix/s", "speedup", "shaded", "Mpix/s", "image");
+
+        for (const auto& resolution : resolutions)
+        {
+            AppShaderConstants constants;
+            ComputeShaderConstants(scene, static_cast<float>(resolution.Width) / static_cast<float>(resolution.Height), constants);
+
+            SoftwareFrame reference;
+            double        scalarTime = 0.0;
+
+            for (int level = 0; level <= static_cast<int>(GetSupportedSimdLevel()); ++level)
+            {
+                SoftwareRenderOptions options;
+                options.ThreadCount  = 1;
+                options.MaxSimdLevel = static_cast<SimdLevel>(level);
+
+                SoftwareFrame frame;
+                frame.Width  = resolution.Width;
+                frame.Height = resolution.Height;
+
+                SoftwareRenderStats stats;
+
+                options.DepthOnly = true;
+                double depthTime  = TimeBest(runs, [&]() { RenderMesh(mesh, mesh.Submeshes, constants, frame, options, &stats); });
+
+                options.DepthOnly = false;
+                double shadedTime = TimeBest(runs, [&]() { RenderMesh(mesh, mesh.Submeshes, constants, frame, options); });
+
+                if (level == 0)
+                {
+                    reference  = frame;
+                    scalarTime = depthTime;
+                }
+
+                bool matches = frame.Color == reference.Color && frame.Depth == reference.Depth;
+
+                char name[32];
+                snprintf(name, sizeof(name), "%ux%u", resolution.Width, resolution.Height);
+
+                printf("  %-10s %-8s %10llu %10llu %8.1f%% %8.1f%% %9.3f ms %9.2f %9.1f %7.2fx %9.3f ms %9.1f  %s\n",
+                    name, GetSimdLevelName(stats.Level),
+                    static_cast<unsigned long long>(stats.Triangles), static_cast<unsigned long long>(stats.PixelsCovered),
+                    100.0 * stats.BlocksRejected / std::max<uint64_t>(stats.BlocksTested, 1),
+                    100.0 * stats.BlocksCovered / std::max<uint64_t>(stats.BlocksTested, 1),
+                    depthTime, stats.Triangles / (depthTime * 1e3), stats.PixelsCovered / (depthTime * 1e3), scalarTime / depthTime,
+                    shadedTime, stats.PixelsCovered / (shadedTime * 1e3), matches ? "identical" : "MISMATCH");
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int RunScaling(int argc, char** argv)
+{
+    const int runs = 10;
+
+    const char* filename = argv[0];
+    uint32_t    width    = (argc >= 3) ? static_cast<uint32_t>(atoi(argv[1])) : 1920;
+    uint32_t    height   = (argc >= 3) ? static_cast<uint32_t>(atoi(argv[2])) : 1080;
+
+    MeshLoadOptions loadOptions;
+    loadOptions.Optimize = true;
+
+    Mesh mesh;
+
+    HRESULT hr = LoadMesh(filename, mesh, loadOptions);
+    if (FAILED(hr))
+    {
+        fprintf(stderr, "%s: failed to load (HRESULT %08X)\n", filename, static_cast<unsigned int>(hr));
+        return 1;
+    }
+
+    SceneState scene;
+    FocusCamera(scene, mesh.BoundsMin, mesh.BoundsMax);
+
+    AppShaderConstants constants;
+    ComputeShaderConstants(scene, static_cast<float>(width) / static_cast<float>(height), constants);
+
+    printf("%s: %zu triangles at %ux%u, %u hardware threads\n", filename, mesh.IndexCount() / 3, width, height, ResolveThreadCount(0));
+    printf("  %8s %12s %12s %12s %9s %11s %14s  %s\n", "threads", "geometry", "raster", "frame", "speedup", "efficiency", "steals/frame", "image");
+
+    SoftwareFrame reference;
+    double        singleTime = 0.0;
+
+    for (uint32_t threadCount = 1; threadCount <= 64; threadCount *= 2)
+    {
+        // Kept across frames, as a headless renderer would
+        ThreadPool pool(threadCount);
+
+        SoftwareRenderOptions options;
+        options.Pool = &pool;
+
+        SoftwareFrame frame;
+        frame.Width  = width;
+        frame.Height = height;
+
+        SoftwareRenderStats best;
+        double bestTime = TimeBest(runs, [&]()
+        {
+            SoftwareRenderStats stats;
+            hr = RenderMesh(mesh, mesh.Submeshes, constants, frame, options, &stats);
+
+            if (best.RasterMilliseconds == 0.0 || stats.GeometryMilliseconds + stats.RasterMilliseconds < best.GeometryMilliseconds + best.RasterMilliseconds)
+            {
+                best = stats;
+            }
+        });
+
+        if (FAILED(hr))
+        {
+            fprintf(stderr, "%ux%u: can't render at that size\n", width, height);
+            return 1;
+        }
+
+        if (threadCount == 1)
+        {
+            reference  = frame;
+            singleTime = bestTime;
+        }
+
+        bool matches = frame.Color == reference.Color && frame.Depth == reference.Depth;
+
+        printf("  %8u %9.3f ms %9.3f ms %9.3f ms %8.2fx %10.0f%% %14.1f  %s\n", threadCount, best.GeometryMilliseconds, best.RasterMilliseconds, bestTime,
+            singleTime / bestTime, 100.0 * singleTime / (bestTime * threadCount), static_cast<double>(pool.StealCount()) / runs, matches ? "identical" : "MISMATCH");
+    }
+
+    return 0;
+}
+
+static const char* GetSpecularPowName(SpecularPow pow)
+{
+    switch (pow)
+    {
+    case SpecularPow::Accurate: return "accurate";
+    case SpecularPow::Fast:     return "fast";
+    default:                    return "exact";
+    }
+}
+
+static int RunShading(int fileCount, char** files)
+{
+    const int      runs          = 5;
+    const size_t   fragmentCount = size_t(1) << 20;
+    const uint32_t width         = 1920;
+    const uint32_t height        = 1080;
+
+    const SpecularPow pows[] = { SpecularPow::Exact, SpecularPow::Accurate, SpecularPow::Fast };
+
+    for (int i = 0; i < fileCount; ++i)
+    {
+        MeshLoadOptions loadOptions;
+        loadOptions.Optimize = true;
+
+        Mesh mesh;
+
+        HRESULT hr = LoadMesh(files[i], mesh, loadOptions);
+        if (FAILED(hr) || mesh.IndexCount() < 3)
+        {
+            fprintf(stderr, "%s: failed to load (HRESULT %08X)\n", files[i], static_cast<unsigned int>(hr));
+            return 1;
+        }
+
+        SceneState scene;
+        FocusCamera(scene, mesh.BoundsMin, mesh.BoundsMax);
+
+        AppShaderConstants constants;
+        ComputeShaderConstants(scene, static_cast<float>(width) / static_cast<float>(height), constants);
+
+        // Fragments at random points of random triangles, in world space as the rasterizer would interpolate them
+        std::vector<float> attributes[6];
+        for (auto& attribute : attributes)
+        {
+            attribute.resize(fragmentCount);
+        }
+
+        uint32_t seed = 12345;
+        auto random = [&seed]()
+        {
+            seed = seed * 1664525u + 1013904223u;
+            return static_cast<float>(seed >> 8) / 16777216.0f;
+        };
+
+        const size_t triangleCount = mesh.IndexCount() / 3;
+        for (size_t f = 0; f < fragmentCount; ++f)
+        {
+            size_t triangle = std::min(static_cast<size_t>(random() * triangleCount), triangleCount - 1);
+
+            float u = random();
+            float v = random();
+            if (u + v > 1.0f)
+            {
+                u = 1.0f - u;
+                v = 1.0f - v;
+            }
+            const float weights[3] = { 1.0f - u - v, u, v };
+
+            float vertex[6] = {};
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                size_t       index  = mesh.IndexSize == sizeof(uint16_t) ? mesh.ShortIndexBuffer[triangle * 3 + corner] : mesh.IndexBuffer[triangle * 3 + corner];
+                const float* source = &mesh.VertexBuffer[index * 6];
+                for (int a = 0; a < 6; ++a)
+                {
+                    vertex[a] += weights[corner] * source[a];
+                }
+            }
+
+            for (int r = 0; r < 3; ++r)
+            {
+                const float* row = constants.World.m[r];
+                attributes[r][f]     = row[0] * vertex[0] + row[1] * vertex[1] + row[2] * vertex[2] + row[3];
+                attributes[3 + r][f] = row[0] * vertex[3] + row[1] * vertex[4] + row[2] * vertex[5];
+            }
+        }
+
+        FragmentBatch fragments;
+        for (int c = 0; c < 3; ++c)
+        {
+            fragments.PositionWS[c] = attributes[c].data();
+            fragments.NormalWS[c]   = attributes[3 + c].data();
+        }
+        fragments.Count = fragmentCount;
+
+        std::vector<float> reference[3];
+        for (auto& channel : reference)
+        {
+            channel.resize(fragmentCount);
+        }
+
+        double referenceTime = TimeBest(runs, [&]()
+        {
+            for (size_t f = 0; f < fragmentCount; ++f)
+            {
+                const float positionWS[3] = { attributes[0][f], attributes[1][f], attributes[2][f] };
+                const float normalWS[3]   = { attributes[3][f], attributes[4][f], attributes[5][f] };
+
+                float color[3];
+                ShadeFragmentReference(positionWS, normalWS, constants, color);
+
+                reference[0][f] = color[0];
+                reference[1][f] = color[1];
+                reference[2][f] = color[2];
+            }
+        });
+
+        printf("%s: %zu fragments, shininess %.0f, reference %.1f Mfrag/s\n", files[i], fragmentCount, constants.ObjectShininess, fragmentCount / (referenceTime * 1e3));
+        printf("  %-9s %-8s %9s %8s %12s %12s %10s %8s  %s\n", "pow", "", "Mfrag/s", "speedup", "max abs err", "max rel err", "sRGB8 diff", "max step", "levels");
+
+        for (SpecularPow pow : pows)
+        {
+            std::vector<float> scalarColor[3];
+
+            for (int level = 0; level <= static_cast<int>(GetSupportedSimdLevel()); ++level)
+            {
+                ShadingOptions options;
+                options.Pow          = pow;
+                options.MaxSimdLevel = static_cast<SimdLevel>(level);
+
+                std::vector<float> color[3];
+                for (auto& channel : color)
+                {
+                    channel.resize(fragmentCount);
+                }
+                float* outColor[3] = { color[0].data(), color[1].data(), color[2].data() };
+
+                double time = TimeBest(runs, [&]() { ShadeFragments(fragments, constants, outColor, options); });
+
+                if (level == 0)
+                {
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        scalarColor[c] = color[c];
+                    }
+                }
+
+                bool   matches     = true;
+                double maxAbsolute = 0.0;
+                double maxRelative = 0.0;
+                size_t differing   = 0;
+                int    maxStep     = 0;
+
+                for (size_t f = 0; f < fragmentCount; ++f)
+                {
+                    bool differs = false;
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        float expected = reference[c][f];
+                        float actual   = color[c][f];
+
+                        matches     = matches && (memcmp(&actual, &scalarColor[c][f], sizeof(float)) == 0);
+                        maxAbsolute = std::max(maxAbsolute, static_cast<double>(std::fabs(actual - expected)));
+                        if (expected > 1e-6f)
+                        {
+                            maxRelative = std::max(maxRelative, static_cast<double>(std::fabs(actual - expected) / expected));
+                        }
+
+                        int step = std::abs(static_cast<int>(LinearToSrgb8(actual)) - static_cast<int>(LinearToSrgb8(expected)));
+                        maxStep  = std::max(maxStep, step);
+                        differs  = differs || step != 0;
+                    }
+                    differing += differs ? 1 : 0;
+                }
+
+                printf("  %-9s %-8s %9.1f %7.2fx %12.3g %12.3g %9.3f%% %8d  %s\n", GetSpecularPowName(pow), GetSimdLevelName(static_cast<SimdLevel>(level)),
+                    fragmentCount / (time * 1e3), referenceTime / time, maxAbsolute, maxRelative, 100.0 * differing / fragmentCount, maxStep,
+                    matches ? "identical" : "MISMATCH");
+            }
+        }
+
+        // The approximations alone - relative error over x in (0, 1] where x^shininess is above 1e-6, as smaller
+        // specular terms are lost against diffuse
+        printf("  %-9s", "pow error");
+        for (float shininess : { 8.0f, 64.0f, 256.0f, 2048.0f })
+        {
+            printf(" %9.0f:", shininess);
+            for (SpecularPow pow : { SpecularPow::Accurate, SpecularPow::Fast })
+            {
+                double maxRelative = 0.0;
+                for (uint32_t step = 1; step <= (1u << 20); ++step)
+                {
+                    float x     = static_cast<float>(step) / static_cast<float>(1u << 20);
+                    float exact = std::pow(x, shininess);
+                    if (exact > 1e-6f)
+                    {
+                        maxRelative = std::max(maxRelative, static_cast<double>(std::fabs(SpecularPower(x, shininess, pow) - exact) / exact));
+                    }
+                }
+                printf(" %8.2g", maxRelative);
+            }
+        }
+        printf("   (accurate, fast at each shininess)\n");
+
+        // Whole frames, where the kernel shades each span's visible pixels
+        SoftwareFrame exactFrame;
+        for (SpecularPow pow : pows)
+        {
+            SoftwareRenderOptions options;
+            options.Pow = pow;
+
+            SoftwareFrame frame;
+            frame.Width  = width;
+            frame.Height = height;
+
+            double time = TimeBest(runs, [&]() { RenderMesh(mesh, mesh.Submeshes, constants, frame, options); });
+
+            if (pow == SpecularPow::Exact)
+            {
+                exactFrame = frame;
+            }
+
+            size_t differing = 0;
+            int    maxStep   = 0;
+            for (size_t p = 0; p < frame.Color.size(); ++p)
+            {
+                if (frame.Color[p] != exactFrame.Color[p])
+                {
+                    ++differing;
+                    for (int shift = 0; shift < 24; shift += 8)
+                    {
+                        maxStep = std::max(maxStep, std::abs(static_cast<int>((frame.Color[p] >> shift) & 0xFF) - static_cast<int>((exactFrame.Color[p] >> shift) & 0xFF)));
+                    }
+                }
+            }
+
+            printf("  %-9s %ux%u frame %8.3f ms, %zu pixels differ from exact by up to %d\n", GetSpecularPowName(pow), width, height, time, differing, maxStep);
+        }
+    }
+
+    return 0;
+}
+
+// Scene poses the regression frames are rendered at - each drives the matrix composition differently
+struct Keyframe
+{
+    const char* Name;
+    float       ObjectRotation;  // Degrees
+    float       CameraPhi;
+    float       CameraTheta;
+    float       CameraDistance;
+};
+
+static const Keyframe Keyframes[] =
+{
+    { "startup",    0.0f,   60.0f,  0.0f,   5.0f },
+    { "rotated90",  90.0f,  60.0f,  0.0f,   5.0f },
+    { "rotated225", 225.0f, 60.0f,  0.0f,   5.0f },
+    { "above",      30.0f,  5.0f,   45.0f,  5.0f },
+    { "below",      20.0f,  150.0f, 120.0f, 5.0f },
+    { "orbit",      135.0f, 80.0f,  250.0f, 5.0f },
+    { "close",      160.0f, 70.0f,  30.0f,  2.5f },
+    { "far",        300.0f, 45.0f,  300.0f, 40.0f },
+};
+
+static int RunRegress(int argc, char** argv)
+{
+    using namespace DirectX;
+
+    const int      runs   = 5;
+    const uint32_t width  = 640;
+    const uint32_t height = 360;
+    const double   slower = 1.5;    // Frame time over the golden one's that's reported, as timings vary run to run
+
+    const bool  update    = strcmp(argv[argc - 1], "--update") == 0;
+    const int   operands  = update ? argc - 1 : argc;
+    const char* filename  = argv[0];
+    const char* directory = "MeshTool/golden"; // The checked-in goldens, from the repository root
+
+    if (operands > 2)
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    if (operands == 2)
+    {
+        directory = argv[1];
+    }
+    else if (FILE* probe = fopen("MeshTool/MeshTool.vcxproj", "r"))
+    {
+        fclose(probe);
+    }
+    else
+    {
+        directory = "golden"; // From MeshTool's own directory, as the debugger runs it
+    }
+
+    MeshLoadOptions loadOptions;
+    loadOptions.Optimize = true;
+
+    Mesh mesh;
+
+    HRESULT hr = LoadMesh(filename, mesh, loadOptions);
+    if (FAILED(hr))
+    {
+        fprintf(stderr, "%s: failed to load (HRESULT %08X)\n", filename, static_cast<unsigned int>(hr));
+        return 1;
+    }
+
+    // Frame times of the goldens, one "name milliseconds" line each
+    char timingsPath[1024];
+    snprintf(timingsPath, sizeof(timingsPath), "%s/timings.txt", directory);
+
+    std::vector<std::pair<std::string, double>> goldenTimes;
+    if (!update)
+    {
+        if (FILE* timings = fopen(timingsPath, "r"))
+        {
+            char   name[256];
+            double time;
+            while (fscanf(timings, "%255s %lf", name, &time) == 2)
+            {
+                goldenTimes.emplace_back(name, time);
+            }
+            fclose(timings);
+        }
+    }
+
+    FILE* timings = update ? fopen(timingsPath, "w") : nullptr;
+    if (update && !timings)
+    {
+        fprintf(stderr, "%s: failed to write\n", timingsPath);
+        return 1;
+    }
+
+    printf("%s: %zu triangles at %ux%u, %s %s\n", filename, mesh.IndexCount() / 3, width, height, update ? "updating" : "checking", directory);
+    if (!update)
+    {
+        printf("  %-12s %10s %10s   %9s %9s %10s  %s\n", "", "frame", "golden", "max dE", "mean dE", "differing", "result");
+    }
+
+    // Kept across frames, as a headless renderer would
+    ThreadPool pool;
+
+    SoftwareRenderOptions options;
+    options.Pool = &pool;
+
+    InstancePackOptions packOptions;
+    packOptions.Pool = &pool;
+
+    // The viewer's scene - the one mesh, untinted, placed by each keyframe
+    SceneObjectList objects;
+    uint32_t        objectIndex = objects.Add(XMMatrixIdentity(), mesh.BoundsMin, mesh.BoundsMax);
+    XMFLOAT3        objectColor(1.0f, 1.0f, 1.0f);
+
+    int failures = 0;
+
+    for (const Keyframe& keyframe : Keyframes)
+    {
+        SceneState scene;
+        scene.ObjectRotation = keyframe.ObjectRotation;
+        scene.CameraPhi      = keyframe.CameraPhi;
+        scene.CameraTheta    = keyframe.CameraTheta;
+        scene.CameraDistance = keyframe.CameraDistance;
+        FocusCamera(scene, mesh.BoundsMin, mesh.BoundsMax);
+
+        // Drawn as the viewer draws its objects - the transforms & color come from PackInstances' instance data, which
+        // BasicVS fetches by SV_InstanceID, & only the light, camera & material from the constants
+        float aspectRatio = static_cast<float>(width) / static_cast<float>(height);
+
+        AppShaderConstants sceneConstants;
+        ComputeShaderConstants(scene, aspectRatio, sceneConstants);
+
+        AppFrameConstants    frameConstants;
+        AppMaterialConstants materialConstants;
+        SplitShaderConstants(sceneConstants, frameConstants, materialConstants);
+
+        XMFLOAT4X4 viewProjection;
+        ComputeViewProjection(scene, aspectRatio, viewProjection);
+
+        objects.SetWorld(0, XMMatrixTranspose(XMLoadFloat4x4(&sceneConstants.World)));
+
+        AppInstanceData instance;
+        PackInstances(objects, &objectIndex, 1, viewProjection, &objectColor, &instance, packOptions);
+
+        AppShaderConstants constants;
+        ComposeInstanceConstants(frameConstants, materialConstants, instance, constants);
+
+        SoftwareFrame frame;
+        frame.Width  = width;
+        frame.Height = height;
+
+        double time = TimeBest(runs, [&]() { RenderMesh(mesh, mesh.Submeshes, constants, frame, options); });
+
+        char goldenPath[1024];
+        snprintf(goldenPath, sizeof(goldenPath), "%s/%s.bmp", directory, keyframe.Name);
+
+        if (update)
+        {
+            if (FAILED(WriteFrameBmp(goldenPath, frame)))
+            {
+                fprintf(stderr, "%s: failed to write\n", goldenPath);
+                fclose(timings);
+                return 1;
+            }
+
+            fprintf(timings, "%s %.3f\n", keyframe.Name, time);
+            printf("  %-12s %7.3f ms -> %s\n", keyframe.Name, time, goldenPath);
+            continue;
+        }
+
+        double goldenTime = 0.0;
+        for (const auto& entry : goldenTimes)
+        {
+            goldenTime = (entry.first == keyframe.Name) ? entry.second : goldenTime;
+        }
+
+        char goldenColumn[32] = "-";
+        if (goldenTime > 0.0)
+        {
+            snprintf(goldenColumn, sizeof(goldenColumn), "%7.3f ms", goldenTime);
+        }
+        const char* timing = (goldenTime > 0.0 && time > goldenTime * slower) ? ", slower" : "";
+
+        SoftwareFrame golden;
+        if (FAILED(ReadFrameBmp(goldenPath, golden)))
+        {
+            printf("  %-12s %7.3f ms %10s   no readable golden at %s\n", keyframe.Name, time, goldenColumn, goldenPath);
+            ++failures;
+            continue;
+        }
+
+        FrameDiff     diff;
+        SoftwareFrame diffImage;
+        if (FAILED(CompareFrames(frame, golden, FrameDiffOptions(), diff, &diffImage)))
+        {
+            printf("  %-12s %7.3f ms %10s   golden is %ux%u\n", keyframe.Name, time, goldenColumn, golden.Width, golden.Height);
+            ++failures;
+            continue;
+        }
+
+        printf("  %-12s %7.3f ms %10s   %9.2f %9.4f %9.3f%%  %s%s\n", keyframe.Name, time, goldenColumn, diff.MaxDeltaE, diff.MeanDeltaE,
+            100.0 * diff.DifferingPixels / (size_t(width) * height), diff.Matches ? "match" : "DIFFERENT", timing);
+
+        if (!diff.Matches)
+        {
+            // Next to the golden, for inspection
+            char path[1024];
+            snprintf(path, sizeof(path), "%s/%s.actual.bmp", directory, keyframe.Name);
+            WriteFrameBmp(path, frame);
+            snprintf(path, sizeof(path), "%s/%s.diff.bmp", directory, keyframe.Name);
+            WriteFrameBmp(path, diffImage);
+
+            ++failures;
+        }
+    }
+
+    if (timings)
+    {
+        fclose(timings);
+        return 0;
+    }
+
+    printf("%d of %zu frames differ\n", failures, sizeof(Keyframes) / sizeof(Keyframes[0]));
+    return (failures > 0) ? 1 : 0;
+}
+
+static int RunOcclusion(int argc, char** argv)
+{
+    using namespace DirectX;
+
+    const int      runs            = 10;
+    const uint32_t occluderCount   = 12;
+    const float    occluderSize    = 8.0f;   // World units across the proxy's largest extent
+    const uint32_t referenceWidth  = 1920;
+    const uint32_t referenceHeight = 1080;
+
+    const char* filename = argv[0];
+    size_t      boxCount = (argc >= 2) ? static_cast<size_t>(atoll(argv[1])) : 100000;
+
+    MeshLoadOptions loadOptions;
+    loadOptions.Optimize  = true;
+    loadOptions.BuildLods = true;
+
+    Mesh mesh;
+
+    HRESULT hr = LoadMesh(filename, mesh, loadOptions);
+    if (FAILED(hr))
+    {
+        fprintf(stderr, "%s: failed to load (HRESULT %08X)\n", filename, static_cast<unsigned int>(hr));
+        return 1;
+    }
+
+    // The mesh scaled to unit size, standing on the ground plane
+    XMFLOAT3 extent(mesh.BoundsMax.x - mesh.BoundsMin.x, mesh.BoundsMax.y - mesh.BoundsMin.y, mesh.BoundsMax.z - mesh.BoundsMin.z);
+    float    unit   = 1.0f / std::max(std::max(extent.x, extent.y), std::max(extent.z, FLT_MIN));
+    XMFLOAT3 origin((mesh.BoundsMin.x + mesh.BoundsMax.x) / 2, mesh.BoundsMin.y, (mesh.BoundsMin.z + mesh.BoundsMax.z) / 2);
+
+    // A wall of coarsest LOD proxies across the view, with the field of boxes running from the camera to far behind it
+    const std::vector<Submesh>& proxy = mesh.Lods.empty() ? mesh.Submeshes : mesh.Lods.back().Submeshes;
+
+    Mesh occluders;
+    for (uint32_t i = 0; i < occluderCount; ++i)
+    {
+        XMMATRIX world = XMMatrixTranslation(-origin.x, -origin.y, -origin.z) * XMMatrixScaling(occluderSize * unit, occluderSize * unit, occluderSize * unit) *
+            XMMatrixRotationY(0.7f * i) * XMMatrixTranslation((i - (occluderCount - 1) / 2.0f) * occluderSize * 0.75f, 0.0f, -25.0f);
+        AppendOccluder(mesh, proxy, world, occluders);
+    }
+
+    std::vector<float> boxMin[3];
+    std::vector<float> boxMax[3];
+    for (int a = 0; a < 3; ++a)
+    {
+        boxMin[a].resize(boxCount);
+        boxMax[a].resize(boxCount);
+    }
+
+    const size_t side = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(boxCount))));
+    for (size_t i = 0; i < boxCount; ++i)
+    {
+        // Hashed rather than drawn from <random>, whose distributions differ between standard libraries
+        uint32_t hash   = static_cast<uint32_t>(i) * 2654435761u;
+        float    jitter = (hash >> 8) / 16777216.0f;
+        float    scale  = (0.5f + jitter) * unit;
+
+        float x = -80.0f + 160.0f * ((i % side) + jitter) / side;
+        float z = -200.0f * ((i / side) + 0.5f) / side;
+
+        boxMin[0][i] = x + (mesh.BoundsMin.x - origin.x) * scale;
+        boxMin[1][i] = (mesh.BoundsMin.y - origin.y) * scale;
+        boxMin[2][i] = z + (mesh.BoundsMin.z - origin.z) * scale;
+        boxMax[0][i] = x + (mesh.BoundsMax.x - origin.x) * scale;
+        boxMax[1][i] = (mesh.BoundsMax.y - origin.y) * scale;
+        boxMax[2][i] = z + (mesh.BoundsMax.z - origin.z) * scale;
+    }
+
+    BoxArrays boxes = { { boxMin[0].data(), boxMin[1].data(), boxMin[2].data() }, { boxMax[0].data(), boxMax[1].data(), boxMax[2].data() }, boxCount };
+
+    SceneState scene;
+    const float aspect = 16.0f / 9.0f;
+    XMMATRIX    view   = XMMatrixLookAtRH(XMVectorSet(0.0f, 3.0f, 12.0f, 1.0f), XMVectorSet(0.0f, 2.0f, -50.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+    XMMATRIX    proj   = XMMatrixPerspectiveFovRH(scene.FieldOfViewY * XM_PI / 180.0f, aspect, scene.NearZ, scene.FarZ);
+
+    XMFLOAT4X4 toClip;
+    XMStoreFloat4x4(&toClip, XMMatrixTranspose(view * proj));
+
+    OcclusionOptions options;
+    OcclusionBuffer  buffer;
+
+    double renderTime = TimeBest(runs, [&]() { hr = RenderOccluders(occluders, occluders.Submeshes, toClip, buffer, options); });
+    if (FAILED(hr))
+    {
+        fprintf(stderr, "%ux%u: can't render occluders at that size\n", options.Width, options.Height);
+        return 1;
+    }
+
+    printf("%s: %u occluders of %zu triangles, %zu boxes, depth at %ux%u, %u hardware threads\n", filename, occluderCount, occluders.IndexBuffer.size() / 3 / occluderCount,
+        boxCount, options.Width, options.Height, ResolveThreadCount(0));
+    printf("  occluder depth & %zu level pyramid %.3f ms\n", buffer.Levels.size(), renderTime);
+    printf("  %-8s %8s %10s %12s %11s %10s %10s %10s  %s\n", "level", "threads", "test", "Mboxes/s", "off-screen", "near-clip", "occluded", "refined", "results");
+
+    std::vector<uint8_t> reference(boxCount);
+    std::vector<uint8_t> visible(boxCount);
+    bool                 consistent = true;
+
+    const uint32_t threadCounts[] = { 1, ResolveThreadCount(0) };
+    for (uint32_t t = 0; t < 2 && (t == 0 || threadCounts[t] > 1); ++t)
+    {
+        ThreadPool pool(threadCounts[t]);
+        options.Pool = &pool;
+
+        for (int l = 0; l <= static_cast<int>(GetSupportedSimdLevel()); ++l)
+        {
+            options.MaxSimdLevel = static_cast<SimdLevel>(l);
+
+            OcclusionStats stats;
+            double testTime = TimeBest(runs, [&]() { TestOcclusion(buffer, boxes, toClip, visible.data(), options, &stats); });
+
+            if (t == 0 && l == 0)
+            {
+                reference = visible;
+            }
+
+            bool matches = visible == reference;
+            consistent   = consistent && matches;
+
+            printf("  %-8s %8u %7.3f ms %12.1f %10.1f%% %9.1f%% %9.1f%% %9.1f%%  %s\n", GetSimdLevelName(stats.Level), pool.ThreadCount(), testTime, boxCount / (testTime * 1000.0),
+                100.0 * stats.OffScreen / boxCount, 100.0 * stats.NearClipped / boxCount, 100.0 * stats.Occluded / boxCount, 100.0 * stats.Refined / boxCount, matches ? "identical" : "MISMATCH");
+        }
+    }
+
+    // Every pixel of the box rectangles against occluder depth at full resolution - a box the pyramid culls that this
+    // keeps shows through a gap the low resolution depth closed
+    OcclusionOptions fullOptions;
+    fullOptions.Width  = referenceWidth;
+    fullOptions.Height = referenceHeight;
+
+    OcclusionBuffer full;
+    RenderOccluders(occluders, occluders.Submeshes, toClip, full, fullOptions);
+
+    std::vector<uint8_t> exact(boxCount);
+    TestOcclusionReference(full.Frame, boxes, toClip, exact.data());
+
+    size_t exactCulled = 0;
+    size_t falseCulls  = 0;
+    size_t missed      = 0;
+    for (size_t i = 0; i < boxCount; ++i)
+    {
+        exactCulled += exact[i] ? 0 : 1;
+        falseCulls  += (exact[i] && !reference[i]) ? 1 : 0;
+        missed      += (!exact[i] && reference[i]) ? 1 : 0;
+    }
+
+    printf("  reference at %ux%u culls %.1f%%: %zu false culls (%.3f%%), %.1f%% of boxes hidden but kept\n", referenceWidth, referenceHeight, 100.0 * exactCulled / boxCount,
+        falseCulls, 100.0 * falseCulls / boxCount, 100.0 * missed / boxCount);
+
+    return consistent ? 0 : 1;
+}
+
+// Uniform in [0, 1) from an index & a salt - hashed rather than drawn from <random>, whose distributions differ
+// between standard libraries
+static float HashUnit(uint32_t index, uint32_t salt)
+{
+    uint32_t hash = (index ^ (salt * 0x9E3779B9u)) * 2654435761u;
+    hash ^= hash >> 15;
+    hash *= 0x2C1B3C6Du;
+    hash ^= hash >> 12;
+    return (hash >> 8) / 16777216.0f;
+}
+
+static int RunFrustum()
+{
+    using namespace DirectX;
+
+    const int   runs   = 10;
+    const float extent = 500.0f;   // Objects fill a cube this far either side of the camera
+
+    XMMATRIX view = XMMatrixLookAtRH(XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 0.0f, -1.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+    XMMATRIX proj = XMMatrixPerspectiveFovRH(60.0f * XM_PI / 180.0f, 16.0f / 9.0f, 0.25f, 1000.0f);
+
+    XMFLOAT4X4 viewProjection;
+    XMStoreFloat4x4(&viewProjection, XMMatrixTranspose(view * proj));
+
+    FrustumPlanes planes;
+    ExtractFrustumPlanes(viewProjection, planes);
+
+    printf("Unit boxes scattered through a %.0f unit cube around the camera, %u hardware threads\n", 2 * extent, ResolveThreadCount(0));
+    printf("  %9s %10s %-8s %8s %10s %12s %9s  %s\n", "objects", "refit", "level", "threads", "cull", "Mobjects/s", "visible", "results");
+
+    const SimdLevel levels[] = { SimdLevel::Scalar, SimdLevel::Avx2, SimdLevel::Avx512 };
+
+    for (uint32_t objectCount = 1000; objectCount <= 1000000; objectCount *= 10)
+    {
+        SceneObjectList      objects;
+        std::vector<XMMATRIX> worlds;
+        for (uint32_t i = 0; i < objectCount; ++i)
+        {
+            float scale = 0.5f + 1.5f * HashUnit(i, 0);
+            worlds.push_back(XMMatrixScaling(scale, scale, scale) * XMMatrixRotationY(6.2831853f * HashUnit(i, 1)) *
+                XMMatrixTranslation(extent * (2 * HashUnit(i, 2) - 1), extent * (2 * HashUnit(i, 3) - 1), extent * (2 * HashUnit(i, 4) - 1)));
+            objects.Add(worlds.back(), XMFLOAT3(-0.5f, -0.5f, -0.5f), XMFLOAT3(0.5f, 0.5f, 0.5f));
+        }
+
+        // Every object moving each frame, as in the worst case
+        double refitTime = TimeBest(runs, [&]()
+        {
+            for (uint32_t i = 0; i < objectCount; ++i)
+            {
+                objects.SetWorld(i, worlds[i]);
+            }
+        });
+
+        BoxArrays             boxes = objects.Boxes();
+        std::vector<uint32_t> reference(objectCount);
+        std::vector<uint32_t> visible(objectCount);
+        size_t                referenceCount = 0;
+
+        const uint32_t threadCounts[] = { 1, ResolveThreadCount(0) };
+        for (uint32_t t = 0; t < 2 && (t == 0 || threadCounts[t] > 1); ++t)
+        {
+            ThreadPool pool(threadCounts[t]);
+
+            for (SimdLevel level : levels)
+            {
+                if (level > GetSupportedSimdLevel())
+                {
+                    continue;
+                }
+
+                FrustumCullOptions options;
+                options.Pool         = &pool;
+                options.MaxSimdLevel = level;
+
+                size_t count    = 0;
+                double cullTime = TimeBest(runs, [&]() { count = CullFrustum(planes, boxes, visible.data(), options); });
+
+                if (t == 0 && level == SimdLevel::Scalar)
+                {
+                    reference      = visible;
+                    referenceCount = count;
+                }
+
+                bool matches = count == referenceCount && std::equal(visible.begin(), visible.begin() + count, reference.begin());
+
+                printf("  %9u %7.3f ms %-8s %8u %7.3f ms %12.1f %8.2f%%  %s\n", objectCount, refitTime, GetSimdLevelName(level), pool.ThreadCount(), cullTime,
+                    objectCount / (cullTime * 1000.0), 100.0 * count / objectCount, matches ? "identical" : "MISMATCH");
+            }
+        }
+    }
+
+    return 0;
+}
+
+// Largest component difference between a point taken through the packed world-view-projection and through world then
+// view-projection, relative to the point's largest clip space component
+static float CheckInstance(const AppInstanceData& instance, const DirectX::XMFLOAT4X4& world, DirectX::FXMMATRIX viewProjection, DirectX::FXMVECTOR point)
+{
+    using namespace DirectX;
+
+    XMVECTOR packed   = XMVector4Transform(point, XMMatrixTranspose(XMLoadFloat4x4(&instance.WorldViewProjection)));
+    XMVECTOR composed = XMVector4Transform(XMVector4Transform(point, XMLoadFloat4x4(&world)), viewProjection);
+
+    XMFLOAT4 difference;
+    XMFLOAT4 magnitude;
+    XMStoreFloat4(&difference, XMVectorAbs(packed - composed));
+    XMStoreFloat4(&magnitude, XMVectorAbs(composed));
+
+    float scale = std::max(std::max(std::max(magnitude.x, magnitude.y), std::max(magnitude.z, magnitude.w)), 1.0f);
+    return std::max(std::max(difference.x, difference.y), std::max(difference.z, difference.w)) / scale;
+}
+
+static int RunInstances()
+{
+    using namespace DirectX;
+
+    const int runs = 10;
+
+    printf("AppInstanceData: %u bytes - World at %u, WorldViewProjection at %u, Color at %u, Padding at %u\n",
+        static_cast<uint32_t>(sizeof(AppInstanceData)), static_cast<uint32_t>(offsetof(AppInstanceData, World)),
+        static_cast<uint32_t>(offsetof(AppInstanceData, WorldViewProjection)), static_cast<uint32_t>(offsetof(AppInstanceData, Color)),
+        static_cast<uint32_t>(offsetof(AppInstanceData, Padding)));
+
+    XMMATRIX view = XMMatrixLookAtRH(XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 0.0f, -1.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+    XMMATRIX proj = XMMatrixPerspectiveFovRH(60.0f * XM_PI / 180.0f, 16.0f / 9.0f, 0.25f, 1000.0f);
+
+    XMFLOAT4X4 viewProjection;
+    XMStoreFloat4x4(&viewProjection, XMMatrixTranspose(view * proj));
+
+    printf("Every other object visible, %u hardware threads\n", ResolveThreadCount(0));
+    printf("  %9s %8s %10s %12s %9s %11s  %s\n", "instances", "threads", "pack", "Minstances/s", "GB/s", "max error", "results");
+
+    bool consistent = true;
+
+    for (uint32_t objectCount = 2000; objectCount <= 2000000; objectCount *= 10)
+    {
+        SceneObjectList               objects;
+        std::vector<XMFLOAT3> colors(objectCount);
+        for (uint32_t i = 0; i < objectCount; ++i)
+        {
+            float scale = 0.5f + 1.5f * HashUnit(i, 0);
+            objects.Add(XMMatrixScaling(scale, scale, scale) * XMMatrixRotationY(6.2831853f * HashUnit(i, 1)) *
+                XMMatrixTranslation(500.0f * (2 * HashUnit(i, 2) - 1), 500.0f * (2 * HashUnit(i, 3) - 1), 500.0f * (2 * HashUnit(i, 4) - 1)),
+                XMFLOAT3(-0.5f, -0.5f, -0.5f), XMFLOAT3(0.5f, 0.5f, 0.5f));
+
+            colors[i] = XMFLOAT3(HashUnit(i, 5), HashUnit(i, 6), HashUnit(i, 7));
+        }
+
+        // Gaps in the list, as frustum culling leaves
+        std::vector<uint32_t> indices;
+        for (uint32_t i = 0; i < objectCount; i += 2)
+        {
+            indices.push_back(i);
+        }
+        const size_t count = indices.size();
+
+        std::vector<AppInstanceData> reference(count);
+        std::vector<AppInstanceData> instances(count);
+
+        const uint32_t threadCounts[] = { 1, ResolveThreadCount(0) };
+        for (uint32_t t = 0; t < 2 && (t == 0 || threadCounts[t] > 1); ++t)
+        {
+            ThreadPool pool(threadCounts[t]);
+
+            InstancePackOptions options;
+            options.Pool = &pool;
+
+            std::fill(instances.begin(), instances.end(), AppInstanceData{});
+            double packTime = TimeBest(runs, [&]()
+            {
+                PackInstances(objects, indices.data(), count, viewProjection, colors.data(), instances.data(), options);
+            });
+
+            // The packed transforms against the object's own, & its color in place
+            XMMATRIX viewProjMat = XMMatrixTranspose(XMLoadFloat4x4(&viewProjection));
+            XMVECTOR corner      = XMVectorSet(0.5f, -0.5f, 0.5f, 1.0f);
+            float    maxError    = 0.0f;
+            bool     matches     = true;
+            for (size_t i = 0; i < count; ++i)
+            {
+                const AppInstanceData& instance = instances[i];
+                const XMFLOAT4X4&      world    = objects.World(indices[i]);
+                const XMFLOAT3&        color    = colors[indices[i]];
+
+                maxError = std::max(maxError, CheckInstance(instance, world, viewProjMat, corner));
+                matches  = matches && instance.World.m[0][3] == world.m[3][0] && instance.World.m[1][3] == world.m[3][1] && instance.World.m[2][3] == world.m[3][2] &&
+                           instance.Color.x == color.x && instance.Color.y == color.y && instance.Color.z == color.z && instance.Padding == 0.0f;
+            }
+
+            if (t == 0)
+            {
+                reference = instances;
+            }
+
+            matches = matches && maxError < 1e-5f && memcmp(reference.data(), instances.data(), count * sizeof(AppInstanceData)) == 0;
+            consistent = consistent && matches;
+
+            printf("  %9u %8u %7.3f ms %12.1f %9.2f %11.2e  %s\n", static_cast<uint32_t>(count), pool.ThreadCount(), packTime, count / (packTime * 1000.0),
+                count * sizeof(AppInstanceData) / (packTime * 1e6), maxError, matches ? "identical" : "MISMATCH");
+        }
+    }
+
+    return consistent ? 0 : 1;
+}
+
+// One frame of the viewer's per-object blocks, as Update places them - through the shared block while every draw's is
+// the same, else a ring block per run of equal draws, with the GPU finishing each frame two later
+static void ReplayObjectBlocks(const std::vector<uint32_t>& firstInstances, uint64_t frame, ConstantShadow& shadow, ConstantRing& ring,
+                               UploadStats& stats, uint64_t& ringBytes)
+{
+    ring.Retire(frame - std::min<uint64_t>(frame, 3));
+
+    bool inRing = std::any_of(firstInstances.begin(), firstInstances.end(), [&](uint32_t first) { return first != firstInstances.front(); });
+    if (!inRing)
+    {
+        for (uint32_t first : firstInstances)
+        {
+            AppObjectConstants objectConstants = {};
+            objectConstants.FirstInstance = first;
+            shadow.Update(objectConstants, stats);
+        }
+        return;
+    }
+
+    if (ring.UsedBytes() == 0)
+    {
+        ring.Retire(UINT64_MAX);
+    }
+
+    for (size_t i = 0; i < firstInstances.size(); ++i)
+    {
+        if (i > 0 && firstInstances[i] == firstInstances[i - 1])
+        {
+            ++stats.BlocksSkipped;
+            continue;
+        }
+
+        uint32_t offset;
+        while (!ring.Allocate(sizeof(AppObjectConstants), offset))
+        {
+            ring.Retire(frame - 1);
+        }
+
+        ++stats.BlocksUploaded;
+        stats.ConstantBytes += sizeof(AppObjectConstants);
+        ringBytes           += ConstantRing::Alignment;
+    }
+
+    ring.EndFrame(frame);
+}
+
+// The viewer's Update over 10 seconds at 60 Hz - the object spins every frame, the camera is dragged for the middle
+// two & the light & material never change
+// The draws are replayed as the viewer lists them, each over every instance, & as if each started at an instance of
+// its own
+static int RunUploads(int argc, char** argv)
+{
+    const uint32_t objectCount = (argc >= 1) ? static_cast<uint32_t>(atoi(argv[0])) : 1;
+    const uint32_t drawCount   = (argc >= 2) ? static_cast<uint32_t>(std::min(std::max(atoi(argv[1]), 1), 1024)) : 1;  // The ring holds 4096 blocks
+    const uint32_t frameCount  = 600;
+
+    // Before the split, each object restaged its 256 byte aligned constant buffer every frame
+    const uint64_t restagedBytes = static_cast<uint64_t>(frameCount) * objectCount * ((sizeof(AppShaderConstants) + 255) & ~size_t(255));
+
+    printf("%u objects in %u draws over %u frames\n", objectCount, drawCount, frameCount);
+
+    // A single draw's block is the same either way
+    for (int ranges = 0; ranges < ((drawCount > 1) ? 2 : 1); ++ranges)
+    {
+        std::vector<uint32_t> firstInstances(drawCount);
+        for (uint32_t d = 0; d < drawCount; ++d)
+        {
+            firstInstances[d] = ranges ? d : 0;
+        }
+
+        SceneState scene;
+
+        ConstantShadow frameShadow;
+        ConstantShadow materialShadow;
+        ConstantShadow objectShadow;
+
+        ConstantRing ring;
+        ring.Reset(1024 * 1024);
+
+        UploadStats total;
+        uint64_t    ringBytes     = 0;  // Including the alignment of each block
+        uint64_t    maxFrameBytes = 0;
+        uint32_t    quietFrames   = 0;  // Uploading nothing but the instances
+
+        for (uint32_t frame = 0; frame < frameCount; ++frame)
+        {
+            scene.ObjectRotation += 10.0f / 60.0f;
+            if (frame >= 240 && frame < 360)
+            {
+                scene.CameraTheta += 0.5f;
+            }
+
+            AppShaderConstants constants;
+            ComputeShaderConstants(scene, 16.0f / 9.0f, constants);
+
+            AppFrameConstants    frameConstants;
+            AppMaterialConstants materialConstants;
+            SplitShaderConstants(constants, frameConstants, materialConstants);
+
+            UploadStats stats;
+            frameShadow.Update(frameConstants, stats);
+            materialShadow.Update(materialConstants, stats);
+            ReplayObjectBlocks(firstInstances, frame, objectShadow, ring, stats, ringBytes);
+            stats.InstanceBytes = objectCount * sizeof(AppInstanceData);
+
+            total.ConstantBytes  += stats.ConstantBytes;
+            total.InstanceBytes  += stats.InstanceBytes;
+            total.BlocksUploaded += stats.BlocksUploaded;
+            total.BlocksSkipped  += stats.BlocksSkipped;
+            maxFrameBytes = std::max(maxFrameBytes, stats.ConstantBytes + stats.InstanceBytes);
+            quietFrames  += (stats.ConstantBytes == 0) ? 1 : 0;
+        }
+
+        printf("\n%s\n", ranges ? "Each draw from its own first instance - a ring block each" : "Every draw over every instance, as the viewer draws - one shared block");
+        printf("  constant blocks  %u uploaded, %u unchanged & skipped, %u frames without any\n", total.BlocksUploaded, total.BlocksSkipped, quietFrames);
+        printf("  constant bytes   %10.1f per frame, %.1f of ring\n", static_cast<double>(total.ConstantBytes) / frameCount,
+            static_cast<double>(ringBytes) / frameCount);
+        printf("  instance bytes   %10.1f per frame\n", static_cast<double>(total.InstanceBytes) / frameCount);
+        printf("  total            %10.1f per frame, at most %llu - against %.1f restaging whole constant buffers\n",
+            static_cast<double>(total.ConstantBytes + total.InstanceBytes) / frameCount, static_cast<unsigned long long>(maxFrameBytes),
+            static_cast<double>(restagedBytes) / frameCount);
+    }
+
+    return 0;
+}
+
+// A block the ring handed out, until its frame retires
+struct RingBlock
+{
+    uint64_t Frame;
+    uint32_t Offset;
+    uint32_t Size;
+};
+
+static bool CheckRing(const char* name, bool passed)
+{
+    printf("  %-56s %s\n", name, passed ? "ok" : "FAILED");
+    return passed;
+}
+
+// Runs frames of random block counts & sizes with the GPU a random number of frames behind, checking that each block
+// is aligned, inside the ring & clear of every block of a frame not yet retired
+static bool StressRing(uint32_t capacity, uint32_t frameCount, uint32_t seed)
+{
+    ConstantRing ring;
+    ring.Reset(capacity);
+
+    std::vector<RingBlock> live;
+    uint64_t               retired = 0;  // Frames before this one are done
+
+    for (uint32_t frame = 0; frame < frameCount; ++frame)
+    {
+        // The GPU catches up on some frames, & always keeps within 3 of the CPU
+        while (retired < frame && (frame - retired >= 3 || HashUnit(frame, seed) < 0.5f))
+        {
+            ring.Retire(retired++);
+        }
+
+        uint32_t blockCount = static_cast<uint32_t>(HashUnit(frame, seed + 1) * 9);
+        for (uint32_t b = 0; b < blockCount; ++b)
+        {
+            uint32_t size = 1 + static_cast<uint32_t>(HashUnit(frame * 64 + b, seed + 2) * 700);
+            uint32_t offset;
+            while (!ring.Allocate(size, offset))
+            {
+                if (retired == frame)
+                {
+                    return false; // Nothing left to wait for, yet the frame's blocks take under 7 kB of the ring
+                }
+                ring.Retire(retired++);
+            }
+
+            // Forget the blocks of retired frames
+            live.erase(std::remove_if(live.begin(), live.end(), [&](const RingBlock& block) { return block.Frame < retired; }), live.end());
+
+            if (offset % ConstantRing::Alignment != 0 || offset + size > ring.Capacity())
+            {
+                return false;
+            }
+
+            for (const RingBlock& block : live)
+            {
+                if (offset < block.Offset + block.Size && block.Offset < offset + size)
+                {
+                    return false;
+                }
+            }
+
+            live.push_back({ frame, offset, size });
+        }
+
+        ring.EndFrame(frame);
+    }
+
+    return true;
+}
+
+static int RunRing()
+{
+    bool passed = true;
+    uint32_t offset = 0;
+
+    printf("Checks\n");
+    {
+        ConstantRing ring;
+        ring.Reset(1024 + 100);
+
+        uint32_t first, second, third;
+        bool allocated = ring.Allocate(16, first) && ring.Allocate(256, second) && ring.Allocate(300, third);
+        passed &= CheckRing("rounds the capacity down & sizes up to 256 bytes", ring.Capacity() == 1024 && allocated && first == 0 && second == 256 &&
+                            third == 512 && ring.UsedBytes() == 1024);
+        passed &= CheckRing("fails when full", !ring.Allocate(16, offset));
+        ConstantRing empty;
+        empty.Reset(1024);
+        passed &= CheckRing("rejects empty blocks & blocks over the capacity", !empty.Allocate(0, offset) && !empty.Allocate(1025, offset));
+    }
+    {
+        ConstantRing ring;
+        ring.Reset(1024);
+
+        uint32_t a, b, c, d;
+        ring.Allocate(256, a);
+        ring.Allocate(256, b);
+        ring.EndFrame(0);
+        ring.Allocate(256, c);
+        ring.Allocate(256, d);
+        ring.EndFrame(1);
+
+        bool full = !ring.Allocate(256, offset);
+        ring.Retire(0);
+        passed &= CheckRing("retiring a frame frees its blocks, from the front", full && ring.Allocate(256, offset) && offset == 0 && ring.Allocate(256, offset) &&
+                            offset == 256 && !ring.Allocate(256, offset));
+        ring.EndFrame(2);
+        ring.Retire(5);
+        passed &= CheckRing("retiring later frames than recorded frees all", ring.UsedBytes() == 0 && ring.FramesInFlight() == 0);
+    }
+    {
+        ConstantRing ring;
+        ring.Reset(1024);
+
+        uint32_t a, b, c;
+        ring.Allocate(512, a);
+        ring.EndFrame(0);
+        ring.Allocate(256, b);
+        ring.EndFrame(1);
+        ring.Retire(0);
+
+        // 256 bytes remain at the end, so the 512 byte block wraps to the front & the tail is held until frame 2 retires
+        bool wrapped = ring.Allocate(512, c) && c == 0 && ring.UsedBytes() == 1024;
+        ring.EndFrame(2);
+        passed &= CheckRing("wraps a block that doesn't fit before the end", wrapped && !ring.Allocate(16, offset));
+
+        ring.Retire(1);
+        bool tailHeld = ring.UsedBytes() == 768 && !ring.Allocate(512, offset);
+        ring.Retire(2);
+        passed &= CheckRing("holds the skipped tail until the wrapping frame retires", tailHeld && ring.UsedBytes() == 0 && ring.Allocate(1024, offset) && offset == 0);
+    }
+    {
+        ConstantRing ring;
+        ring.Reset(1024);
+
+        uint32_t a, b;
+        ring.Allocate(256, a);
+        ring.EndFrame(0);
+        ring.Allocate(512, b);
+        ring.EndFrame(1);
+        ring.Retire(0);
+
+        // 256 bytes free at either end, which a 512 byte block can't span
+        passed &= CheckRing("doesn't wrap onto blocks in flight", !ring.Allocate(512, offset) && ring.Allocate(256, offset) && offset == 768);
+    }
+    {
+        ConstantRing ring;
+        ring.Reset(1024);
+
+        uint32_t a;
+        ring.Allocate(768, a);
+        ring.EndFrame(0);
+        ring.Retire(0);
+        passed &= CheckRing("starts over from the front once empty", ring.Allocate(512, offset) && offset == 0);
+    }
+
+    bool stressed = true;
+    for (uint32_t seed = 0; seed < 8; ++seed)
+    {
+        stressed = stressed && StressRing(8192 + seed * 1024, 20000, seed * 16);
+    }
+    passed &= CheckRing("random frames never overlap blocks in flight", stressed);
+
+
+    ////
+    // Rates - frames of 10k draws, each its 256 byte block, with the GPU 2 frames behind
+
+    const uint32_t drawsPerFrame = 10000;
+    const uint32_t frameCount    = 300;
+    const uint32_t blockSize     = sizeof(AppObjectConstants);
+
+    ConstantRing ring;
+    ring.Reset(4 * drawsPerFrame * ConstantRing::Alignment);
+
+    std::vector<uint8_t> mapped(ring.Capacity());  // Stands in for the mapped buffer
+    AppObjectConstants   block = {};
+    uint64_t             checksum = 0;
+
+    printf("Rates over %u frames of %u blocks\n", frameCount, drawsPerFrame);
+
+    for (int write = 0; write < 2; ++write)
+    {
+        uint64_t frame = 0;
+        double time = TimeBest(5, [&]()
+        {
+            for (uint32_t f = 0; f < frameCount; ++f, ++frame)
+            {
+                if (frame >= 2)
+                {
+                    ring.Retire(frame - 2);
+                }
+
+                for (uint32_t d = 0; d < drawsPerFrame; ++d)
+                {
+                    ring.Allocate(blockSize, offset);
+                    checksum += offset;
+
+                    if (write)
+                    {
+                        block.FirstInstance = d;
+                        std::memcpy(mapped.data() + offset, &block, sizeof(block));
+                    }
+                }
+
+                ring.EndFrame(frame);
+            }
+        });
+
+        double blocksPerSecond = static_cast<double>(frameCount) * drawsPerFrame / (time / 1000.0);
+        printf("  %-24s %8.1f Mblocks/s  %6.2f ns per block\n", write ? "allocate & write" : "allocate", blocksPerSecond / 1e6, 1e9 / blocksPerSecond);
+    }
+
+    return (passed && checksum != 0) ? 0 : 1;
+}
+
+// Writes a side x side grid of rippled vertices with normals as an OBJ file, split into shapes of whole rows &
+// alternating between quad & triangle faces, with every position & normal record distinct
+static bool WriteGridObj(const char* filename, uint32_t side, uint32_t shapeCount)
+{
+    FILE* file = fopen(filename, "wb");
+    if (!file)
+    {
+        return false;
+    }
+
+    for (uint32_t y = 0; y < side; ++y)
+    {
+        for (uint32_t x = 0; x < side; ++x)
+        {
+            float u = (x - 0.5f * side) / side;
+            float v = (y - 0.5f * side) / side;
+            fprintf(file, "v %.6f %.6f %.6f\n", u * 100.0f, 2.0f * sinf(20.0f * u) * cosf(17.0f * v) + HashUnit(y * side + x, 1) * 1e-3f, v * 100.0f);
+        }
+    }
+
+    for (uint32_t y = 0; y < side; ++y)
+    {
+        for (uint32_t x = 0; x < side; ++x)
+        {
+            float nx = HashUnit(y * side + x, 2) - 0.5f;
+            float nz = HashUnit(y * side + x, 3) - 0.5f;
+            float ny = 1.0f;
+            float length = sqrtf(nx * nx + ny * ny + nz * nz);
+            fprintf(file, "vn %.6f %.6f %.6f\n", nx / length, ny / length, nz / length);
+        }
+    }
+
+    const uint32_t rowsPerShape = std::max(1u, (side - 1) / shapeCount);
+
+    for (uint32_t y = 0; y + 1 < side; ++y)
+    {
+        if (y % rowsPerShape == 0)
+        {
+            fprintf(file, "o grid%u\n", y / rowsPerShape);
+        }
+
+        for (uint32_t x = 0; x + 1 < side; ++x)
+        {
+            // One-based, as OBJ indices are
+            uint32_t a = y * side + x + 1;
+            uint32_t b = a + 1;
+            uint32_t c = a + side + 1;
+            uint32_t d = a + side;
+
+            if ((x + y) & 1)
+            {
+                fprintf(file, "f %u//%u %u//%u %u//%u %u//%u\n", a, a, b, b, c, c, d, d);
+            }
+            else
+            {
+                fprintf(file, "f %u//%u %u//%u %u//%u\n", a, a, b, b, c, c);
+                fprintf(file, "f %u//%u %u//%u %u//%u\n", a, a, c, c, d, d);
+            }
+        }
+    }
+
+    return fclose(file) == 0;
+}
+
+static size_t GetFileSize(const char* filename)
+{
+    FILE* file = fopen(filename, "rb");
+    if (!file)
+    {
+        return 0;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+
+    return (size > 0) ? static_cast<size_t>(size) : 0;
+}
+
+// Bitwise equality of everything LoadMesh fills in without optional processing
+static bool SameMesh(const Mesh& a, const Mesh& b)
+{
+    if (a.IndexSize != b.IndexSize || a.VertexBuffer.size() != b.VertexBuffer.size() || a.IndexCount() != b.IndexCount() ||
+        a.Submeshes.size() != b.Submeshes.size())
+    {
+        return false;
+    }
+
+    return std::memcmp(a.VertexBuffer.data(), b.VertexBuffer.data(), a.VertexBuffer.size() * sizeof(float)) == 0 &&
+           std::memcmp(a.IndexData(), b.IndexData(), a.IndexCount() * a.IndexSize) == 0 &&
+           std::memcmp(a.Submeshes.data(), b.Submeshes.data(), a.Submeshes.size() * sizeof(Submesh)) == 0 &&
+           std::memcmp(&a.BoundsMin, &b.BoundsMin, sizeof(a.BoundsMin)) == 0 &&
+           std::memcmp(&a.BoundsMax, &b.BoundsMax, sizeof(a.BoundsMax)) == 0;
+}
+
+// Bytes currently & at most held through CountingAllocator
+static size_t s_countedBytes     = 0;
+static size_t s_peakCountedBytes = 0;
+
+template <class T>
+struct CountingAllocator
+{
+    typedef T value_type;
+
+    CountingAllocator() = default;
+
+    template <class U>
+    CountingAllocator(const CountingAllocator<U>&) { }
+
+    T* allocate(size_t count)
+    {
+        s_countedBytes     += count * sizeof(T);
+        s_peakCountedBytes  = std::max(s_peakCountedBytes, s_countedBytes);
+        return static_cast<T*>(::operator new(count * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t count)
+    {
+        s_countedBytes -= count * sizeof(T);
+        ::operator delete(p);
+    }
+
+    template <class U> bool operator==(const CountingAllocator<U>&) const { return true; }
+    template <class U> bool operator!=(const CountingAllocator<U>&) const { return false; }
+};
+
+// The loader's vertex weld before VertexDedupTable replaced it, kept as the baseline
+struct MapVertex
+{
+    float Position[3];
+    float Normal[3];
+};
+
+struct MapVertexHash
+{
+    size_t operator()(const MapVertex& vertex) const noexcept
+    {
+        std::hash<float> hasher;
+
+        size_t seed = 0;
+        for (int i = 0; i < 3; ++i)
+        {
+            seed ^= hasher(vertex.Position[i]) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            seed ^= hasher(vertex.Normal[i]) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        }
+        return seed;
+    }
+};
+
+struct MapVertexEqual
+{
+    bool operator()(const MapVertex& a, const MapVertex& b) const noexcept
+    {
+        return std::memcmp(&a, &b, sizeof(a)) == 0;
+    }
+};
+
+typedef std::unordered_map<MapVertex, size_t, MapVertexHash, MapVertexEqual, CountingAllocator<std::pair<const MapVertex, size_t>>> VertexMap;
+
+static void WeldVerticesMap(const float* positions, const float* normals, const ObjCorner* corners, size_t cornerCount, Mesh& outMesh, size_t& outTableBytes)
+{
+    const size_t baseBytes = s_countedBytes;
+
+    s_peakCountedBytes = baseBytes;
+
+    VertexMap uniqueVertexMap;
+
+    for (size_t c = 0; c < cornerCount; ++c)
+    {
+        MapVertex vertex;
+        std::memcpy(vertex.Position, &positions[3 * corners[c].Position], sizeof(vertex.Position));
+        std::memcpy(vertex.Normal, &normals[3 * corners[c].Normal], sizeof(vertex.Normal));
+
+        // Find, insert & find again, as it did
+        auto it = uniqueVertexMap.find(vertex);
+        if (it == uniqueVertexMap.end())
+        {
+            outMesh.VertexBuffer.insert(outMesh.VertexBuffer.end(), vertex.Position, vertex.Position + 3);
+            outMesh.VertexBuffer.insert(outMesh.VertexBuffer.end(), vertex.Normal, vertex.Normal + 3);
+
+            uniqueVertexMap.insert(std::make_pair(vertex, uniqueVertexMap.size()));
+            it = uniqueVertexMap.find(vertex);
+        }
+
+        outMesh.IndexBuffer.push_back(static_cast<uint32_t>(it->second));
+    }
+
+    outTableBytes = s_peakCountedBytes - baseBytes;
+}
+
+// The loader's VertexDedupTable weld, reporting the table's size
+static void WeldVerticesTable(const float* positions, const float* normals, const ObjCorner* corners, size_t cornerCount, Mesh& outMesh, size_t& outTableBytes)
+{
+    VertexDedupTable uniqueVertices(cornerCount / 3);
+
+    outMesh.IndexBuffer.reserve(outMesh.IndexBuffer.size() + cornerCount);
+
+    for (size_t c = 0; c < cornerCount; ++c)
+    {
+        float vertex[VertexDedupTable::VertexSize];
+        std::memcpy(vertex, &positions[3 * corners[c].Position], 3 * sizeof(float));
+        std::memcpy(vertex + 3, &normals[3 * corners[c].Normal], 3 * sizeof(float));
+
+        outMesh.IndexBuffer.push_back(uniqueVertices.FindOrAppend(vertex, outMesh.VertexBuffer));
+    }
+
+    outTableBytes = uniqueVertices.MemoryUsage();
+}
+
+// Welds every shape of the file through both tables, the way the loader welds each shape on its own & appends it -
+// returns false if they disagree
+static bool CompareWelds(const char* filename, int runs)
+{
+    ObjData obj;
+    if (FAILED(ParseObjFile(filename, 0, true, obj)) || obj.Normals.empty())
+    {
+        printf("  (not welded - ObjParser defers this file to tinyobjloader)\n");
+        return true;
+    }
+
+    // Shapes are welded one after another, so the peak is the largest shape's table - reported with its vertex count
+    struct WeldResult
+    {
+        Mesh   Output;
+        double Time;
+        size_t PeakBytes;
+        size_t PeakVertices;
+    };
+
+    auto weld = [&](void (*weldShape)(const float*, const float*, const ObjCorner*, size_t, Mesh&, size_t&))
+    {
+        WeldResult result = {};
+        result.Time = TimeBest(runs, [&]()
+        {
+            result.Output = Mesh();
+            for (const ObjShape& shape : obj.Shapes)
+            {
+                Mesh   part;
+                size_t bytes = 0;
+
+                weldShape(obj.Positions.data(), obj.Normals.data(), &obj.Corners[shape.FirstCorner], shape.CornerCount, part, bytes);
+
+                if (bytes > result.PeakBytes)
+                {
+                    result.PeakBytes    = bytes;
+                    result.PeakVertices = part.VertexBuffer.size() / 6;
+                }
+
+                const uint32_t vertexBase = static_cast<uint32_t>(result.Output.VertexBuffer.size() / 6);
+                for (uint32_t index : part.IndexBuffer)
+                {
+                    result.Output.IndexBuffer.push_back(vertexBase + index);
+                }
+                result.Output.VertexBuffer.insert(result.Output.VertexBuffer.end(), part.VertexBuffer.begin(), part.VertexBuffer.end());
+            }
+        });
+        return result;
+    };
+
+    WeldResult map   = weld(WeldVerticesMap);
+    WeldResult table = weld(WeldVerticesTable);
+
+    const bool   same    = map.Output.VertexBuffer == table.Output.VertexBuffer && map.Output.IndexBuffer == table.Output.IndexBuffer;
+    const double corners = static_cast<double>(obj.Corners.size());
+
+    printf("  %-24s %10s %10s %12s %12s   %s\n", "weld", "time", "Mcorners/s", "peak bytes", "per vertex", "mesh");
+    printf("  %-24s %7.1f ms %10.1f %12zu %12.1f   reference\n", "std::unordered_map", map.Time, corners / (map.Time * 1000.0),
+        map.PeakBytes, static_cast<double>(map.PeakBytes) / map.PeakVertices);
+    printf("  %-24s %7.1f ms %10.1f %12zu %12.1f   %s\n", "VertexDedupTable", table.Time, corners / (table.Time * 1000.0),
+        table.PeakBytes, static_cast<double>(table.PeakBytes) / table.PeakVertices, same ? "identical" : "DIFFERS");
+
+    return same;
+}
+
+static int RunParse(int fileCount, char** files)
+{
+    // Generated in the working directory & removed afterwards
+    const struct
+    {
+        const char* Name;
+        uint32_t    Side;
+        uint32_t    Shapes;
+    } grids[] =
+    {
+        { "meshtool_grid_256.obj",  256,  4  },
+        { "meshtool_grid_1024.obj", 1024, 16 },
+    };
+
+    std::vector<std::string> inputs(files, files + fileCount);
+    for (const auto& grid : grids)
+    {
+        if (!WriteGridObj(grid.Name, grid.Side, grid.Shapes))
+        {
+            fprintf(stderr, "%s: failed to write\n", grid.Name);
+            return 1;
+        }
+        inputs.push_back(grid.Name);
+    }
+
+    std::vector<uint32_t> threadCounts;
+    const uint32_t        hardwareThreads = ResolveThreadCount(0);
+
+    for (uint32_t threads = 1; threads < hardwareThreads; threads *= 2)
+    {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(hardwareThreads);
+
+    bool identical = true;
+
+    for (const std::string& input : inputs)
+    {
+        const char*  filename = input.c_str();
+        const double fileMB   = GetFileSize(filename) / (1024.0 * 1024.0);
+
+        // The default loader parses with tinyobjloader - every ObjParser configuration must weld to the same mesh
+        Mesh    reference;
+        HRESULT hr = LoadMesh(filename, reference);
+        if (FAILED(hr))
+        {
+            fprintf(stderr, "%s: failed to load (HRESULT %08X)\n", filename, static_cast<unsigned int>(hr));
+            identical = false;
+            continue;
+        }
+
+        // Large files take seconds per parse, so the best of fewer runs
+        const int runs = (fileMB < 16.0) ? 5 : 2;
+
+        printf("%s: %.1f MB, %zu vertices, %zu triangles\n", filename, fileMB, reference.VertexBuffer.size() / 6, reference.IndexCount() / 3);
+        printf("  %-24s %10s %10s %10s   %s\n", "", "parse", "MB/s", "load", "mesh");
+
+        double tinyobjTime = TimeBest(runs, [&]()
+        {
+            tinyobj::attrib_t                attrib;
+            std::vector<tinyobj::shape_t>    shapes;
+            std::vector<tinyobj::material_t> materials;
+            std::string                      warnings;
+            std::string                      errors;
+
+            tinyobj::LoadObj(&attrib, &shapes, &materials, &warnings, &errors, filename);
+        });
+        double tinyobjLoadTime = TimeBest(runs, [&]()
+        {
+            Mesh mesh;
+            LoadMesh(filename, mesh);
+        });
+
+        printf("  %-24s %7.1f ms %10.1f %7.1f ms   reference\n", "tinyobjloader", tinyobjTime, fileMB / (tinyobjTime / 1000.0), tinyobjLoadTime);
+
+        for (int memoryMap = 0; memoryMap < 2; ++memoryMap)
+        {
+            for (uint32_t threads : threadCounts)
+            {
+                MeshLoadOptions options;
+                options.ParallelParse = true;
+                options.MemoryMapped  = (memoryMap != 0);
+                options.ThreadCount   = threads;
+
+                bool parsed = true;
+                double parseTime = TimeBest(runs, [&]()
+                {
+                    ObjData obj;
+                    parsed = SUCCEEDED(ParseObjFile(filename, threads, options.MemoryMapped, obj)) && parsed;
+                });
+
+                Mesh mesh;
+                hr = LoadMesh(filename, mesh, options);
+
+                double loadTime = TimeBest(runs, [&]()
+                {
+                    Mesh timed;
+                    LoadMesh(filename, timed, options);
+                });
+
+                // E_NOTIMPL content goes through tinyobjloader either way, so only the mesh is compared
+                const bool same = SUCCEEDED(hr) && SameMesh(reference, mesh);
+                identical = identical && same;
+
+                char name[32];
+                snprintf(name, sizeof(name), "ObjParser %s %2u threads", options.MemoryMapped ? "mmap" : "read", threads);
+
+                printf("  %-24s %7.1f ms %10.1f %7.1f ms   %s%s\n", name, parseTime, fileMB / (parseTime / 1000.0), loadTime,
+                    same ? "identical" : "DIFFERS", parsed ? "" : " (deferred to tinyobjloader)");
+            }
+        }
+
+        identical = CompareWelds(filename, runs) && identical;
+    }
+
+    for (const auto& grid : grids)
+    {
+        remove(grid.Name);
+    }
+
+    return identical ? 0 : 1;
+}
+
+
+// Appends count digits drawn from index & salt - the first is non-zero when leading is set
+static void AppendDigits(std::string& token, uint32_t index, uint32_t salt, unsigned count, bool leading)
+{
+    for (unsigned i = 0; i < count; ++i)
+    {
+        uint32_t digit = static_cast<uint32_t>(HashUnit(index * 64 + i, salt) * 10.0f);
+        if (i == 0 && leading && digit == 0)
+        {
+            digit = 1;
+        }
+        token += static_cast<char>('0' + digit);
+    }
+}
+
+// One of the shapes of real tinyobjloader accepts or rejects, picked by index
+static std::string MakeRealToken(uint32_t index)
+{
+    static const char* const malformed[] =
+    {
+        "-", "+", ".", "-.", "+.", "1.", "-0", "0", "1..2", "--1", "+-3", "1e", "1e+", "e5", ".e1", "abc", "1.5x",
+        "0x1A", "inf", "nan", "1,5", "12-3", "1.2.3", "9e999", "-1e-999",
+    };
+
+    const float    select = HashUnit(index, 11);
+    const char*    sign   = (select < 0.25f) ? "-" : (select < 0.35f) ? "+" : "";
+    std::string    token  = sign;
+    char           buffer[64];
+
+    switch (index % 8)
+    {
+    case 0:
+        // Typical exported coordinates
+        snprintf(buffer, sizeof(buffer), "%.*f", 1 + static_cast<int>(index / 8 % 9), HashUnit(index, 12) * 2000.0f);
+        token += buffer;
+        break;
+
+    case 1:
+        // Leading dot
+        token += '.';
+        AppendDigits(token, index, 13, 1 + index / 8 % 12, false);
+        break;
+
+    case 2:
+    case 3:
+        // 15 digit integer parts take the SIMD path, 16 digit ones fall back
+        AppendDigits(token, index, 14, (index % 8 == 2) ? 15 : 16, true);
+        if (index / 8 % 2)
+        {
+            token += '.';
+            AppendDigits(token, index, 15, 1 + index / 16 % 10, false);
+        }
+        break;
+
+    case 4:
+        // Exponents, either case & sign
+        snprintf(buffer, sizeof(buffer), (index / 8 % 2) ? "%.*e" : "%.*E", static_cast<int>(index / 16 % 8), (HashUnit(index, 16) + 0.01f) * powf(10.0f, HashUnit(index, 17) * 60.0f - 30.0f));
+        token += buffer;
+        break;
+
+    case 5:
+        // Wider than one or both vector widths
+        token += "0.";
+        AppendDigits(token, index, 18, 12 + index / 8 % 30, false);
+        break;
+
+    case 6:
+        // Short integers
+        AppendDigits(token, index, 19, 1 + index / 8 % 4, false);
+        break;
+
+    default:
+        token = malformed[index / 8 % (sizeof(malformed) / sizeof(malformed[0]))];
+        break;
+    }
+
+    return token;
+}
+
+// The scalar reference ParseObjReal must match - the token up to the next space or tab through TryParseDouble,
+// zero if it doesn't parse
+static float ParseRealReference(const char*& p, const char* lineEnd)
+{
+    while (p < lineEnd && (*p == ' ' || *p == '\t'))
+    {
+        ++p;
+    }
+
+    const char* tokenEnd = p;
+    while (tokenEnd < lineEnd && *tokenEnd != ' ' && *tokenEnd != '\t')
+    {
+        ++tokenEnd;
+    }
+
+    double value = 0.0;
+    TryParseDouble(p, tokenEnd, &value);
+
+    p = tokenEnd;
+    return static_cast<float>(value);
+}
+
+// Parses [p, lineEnd) to the end at the current level & counts reals that differ from the reference in bits or in
+// where they leave p - one extra call past the last token must read a missing value
+static size_t CheckRealLine(const char* p, const char* lineEnd, const char* safeEnd, size_t& outReals)
+{
+    const char* expected   = p;
+    size_t      mismatches = 0;
+
+    for (;;)
+    {
+        const char* start     = p;
+        bool        atEnd     = (p == lineEnd);
+        float       reference = ParseRealReference(expected, lineEnd);
+        float       value     = ParseObjReal(p, lineEnd, safeEnd);
+
+        uint32_t referenceBits, valueBits;
+        std::memcpy(&referenceBits, &reference, sizeof(float));
+        std::memcpy(&valueBits, &value, sizeof(float));
+
+        if (referenceBits != valueBits || p != expected)
+        {
+            if (mismatches++ < 4)
+            {
+                fprintf(stderr, "  %s: \"%.*s\" read %.9g (%08X), expected %.9g (%08X)%s\n", GetSimdLevelName(GetFloatParserLevel()),
+                    static_cast<int>(expected - start), start, value, valueBits, reference, referenceBits, p != expected ? ", stopping elsewhere" : "");
+            }
+            p = expected;
+        }
+
+        ++outReals;
+        if (atEnd)
+        {
+            break;
+        }
+    }
+
+    return mismatches;
+}
+
+static int RunFloats()
+{
+    const uint32_t tokenCount = 200000;
+    const int      runs       = 5;
+
+    ////
+    // Lines of one to four generated tokens, separated by runs of spaces & tabs & sometimes ending in one
+
+    std::vector<std::string> tokens(tokenCount);
+    for (uint32_t i = 0; i < tokenCount; ++i)
+    {
+        tokens[i] = MakeRealToken(i);
+    }
+
+    std::string           text;
+    std::vector<size_t>   lineStarts;
+
+    for (uint32_t i = 0; i < tokenCount;)
+    {
+        lineStarts.push_back(text.size());
+
+        uint32_t perLine = 1 + static_cast<uint32_t>(HashUnit(i, 20) * 4.0f);
+        for (uint32_t k = 0; k < perLine && i < tokenCount; ++k, ++i)
+        {
+            // Malformed tokens can be empty, which would merge with the next
+            if (tokens[i].empty())
+            {
+                continue;
+            }
+
+            text += (HashUnit(i, 21) < 0.8f) ? " " : (HashUnit(i, 22) < 0.5f) ? "\t" : " \t ";
+            text += tokens[i];
+        }
+
+        text += (HashUnit(i, 23) < 0.1f) ? " \n" : "\n";
+    }
+    lineStarts.push_back(text.size());
+
+    bool passed = true;
+
+    printf("%-8s %12s %12s   %s\n", "", "reals", "at the end", "mismatches");
+
+    for (int level = 0; level <= static_cast<int>(GetSupportedSimdLevel()); ++level)
+    {
+        SetFloatParserLevel(static_cast<SimdLevel>(level));
+
+        size_t reals      = 0;
+        size_t mismatches = 0;
+
+        const char* safeEnd = text.data() + text.size();
+        for (size_t line = 0; line + 1 < lineStarts.size(); ++line)
+        {
+            mismatches += CheckRealLine(text.data() + lineStarts[line], text.data() + lineStarts[line + 1] - 1, safeEnd, reals);
+        }
+
+        // Every token alone at the end of its line, with 0 to 40 readable bytes after it - crossing the slack each
+        // level needs before it loads a full vector
+        size_t endReals = 0;
+        for (uint32_t i = 0; i < tokenCount; i += 97)
+        {
+            for (size_t slack = 0; slack <= 40; ++slack)
+            {
+                // Exactly sized, so reading past safeEnd would leave the allocation
+                std::vector<char> buffer(tokens[i].begin(), tokens[i].end());
+                buffer.resize(buffer.size() + slack, '7');
+
+                const char* lineEnd = buffer.data() + tokens[i].size();
+                mismatches += CheckRealLine(buffer.data(), lineEnd, buffer.data() + buffer.size(), endReals);
+            }
+        }
+
+        passed = passed && (mismatches == 0);
+
+        printf("%-8s %12zu %12zu   %zu\n", GetSimdLevelName(static_cast<SimdLevel>(level)), reals, endReals, mismatches);
+    }
+
+
+    ////
+    // Throughput on exported-style "x y z" coordinate lines
+
+    std::string coordinates;
+    size_t      coordinateCount = 0;
+
+    for (uint32_t i = 0; coordinates.size() < (64u << 20); ++i)
+    {
+        char line[96];
+        snprintf(line, sizeof(line), "%.6f %.6f %.6f\n", (HashUnit(i, 24) - 0.5f) * 200.0f, (HashUnit(i, 25) - 0.5f) * 200.0f, (HashUnit(i, 26) - 0.5f) * 200.0f);
+        coordinates += line;
+        coordinateCount += 3;
+    }
+
+    printf("\n%-8s %10s %10s %12s\n", "", "time", "GB/s", "Mreals/s");
+
+    uint32_t referenceSum = 0;
+
+    for (int level = 0; level <= static_cast<int>(GetSupportedSimdLevel()); ++level)
+    {
+        SetFloatParserLevel(static_cast<SimdLevel>(level));
+
+        uint32_t bitSum = 0;
+        double time = TimeBest(runs, [&]()
+        {
+            const char* p       = coordinates.data();
+            const char* safeEnd = p + coordinates.size();
+            uint32_t    sum     = 0;
+
+            while (p < safeEnd)
+            {
+                const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', safeEnd - p));
+                while (p < lineEnd)
+                {
+                    float    value = ParseObjReal(p, lineEnd, safeEnd);
+                    uint32_t bits;
+                    std::memcpy(&bits, &value, sizeof(float));
+                    sum = sum * 31 + bits;
+                }
+                p = lineEnd + 1;
+            }
+
+            bitSum = sum;
+        });
+
+        if (level == 0)
+        {
+            referenceSum = bitSum;
+        }
+        passed = passed && (bitSum == referenceSum);
+
+        printf("%-8s %7.1f ms %10.2f %12.1f%s\n", GetSimdLevelName(static_cast<SimdLevel>(level)), time, coordinates.size() / (time * 1e6),
+            coordinateCount / (time * 1000.0), (bitSum == referenceSum) ? "" : "   DIFFERS");
+    }
+
+    SetFloatParserLevel(GetSupportedSimdLevel());
+
+    return passed ? 0 : 1;
+}
+
+
+static int RunCache(int fileCount, char** files)
+{
+    const int runs = 5;
+
+    // The viewer's load options
+    MeshLoadOptions options;
+    options.Optimize  = true;
+    options.BuildLods = true;
+    options.UseCache  = true;
+
+    MeshLoadOptions uncachedOptions = options;
+    uncachedOptions.UseCache = false;
+
+    MeshLoadOptions verifiedOptions = options;
+    verifiedOptions.VerifyCache = true;
+
+    bool identical = true;
+
+    printf("%-32s %12s %12s %12s %12s %9s   %s\n", "", "uncached", "cold", "warm", "verified", "speedup", "mesh");
+
+    for (int i = 0; i < fileCount; ++i)
+    {
+        const std::string cachePath = std::string(files[i]) + ".meshcache";
+
+        Mesh    reference;
+        HRESULT hr = LoadMesh(files[i], reference, uncachedOptions);
+        if (FAILED(hr))
+        {
+            fprintf(stderr, "%s: failed to load (HRESULT %08X)\n", files[i], static_cast<unsigned int>(hr));
+            return 1;
+        }
+
+        double uncachedTime = TimeBest(runs, [&]()
+        {
+            Mesh mesh;
+            LoadMesh(files[i], mesh, uncachedOptions);
+        });
+
+        // Cold loads parse the source & write the cache, as the viewer's first start does
+        double coldTime = TimeBest(runs, [&]()
+        {
+            remove(cachePath.c_str());
+
+            Mesh mesh;
+            LoadMesh(files[i], mesh, options);
+        });
+
+        Mesh   warm;
+        double warmTime = TimeBest(runs, [&]()
+        {
+            warm = Mesh();
+            hr   = LoadMesh(files[i], warm, options);
+        });
+
+        // Warm loads only stat the source; verified ones also rehash it against the hash the cache recorded
+        bool   verifiedLoaded = true;
+        double verifiedTime   = TimeBest(runs, [&]()
+        {
+            Mesh mesh;
+            verifiedLoaded = verifiedLoaded && SUCCEEDED(LoadMesh(files[i], mesh, verifiedOptions));
+        });
+
+        // The cache holds the LOD chain too, which the viewer draws from
+        bool same = SUCCEEDED(hr) && verifiedLoaded && SameMesh(reference, warm) && reference.Lods.size() == warm.Lods.size();
+        for (size_t level = 0; same && level < reference.Lods.size(); ++level)
+        {
+            const MeshLod& a = reference.Lods[level];
+            const MeshLod& b = warm.Lods[level];
+
+            same = a.Error == b.Error && a.Submeshes.size() == b.Submeshes.size() &&
+                   std::memcmp(a.Submeshes.data(), b.Submeshes.data(), a.Submeshes.size() * sizeof(Submesh)) == 0;
+        }
+        identical = identical && same;
+
+        printf("%-32s %9.2f ms %9.2f ms %9.2f ms %9.2f ms %8.1fx   %s\n", files[i], uncachedTime, coldTime, warmTime, verifiedTime, coldTime / warmTime,
+            same ? "identical" : "DIFFERS");
+
+        remove(cachePath.c_str());
+    }
+
+    return identical ? 0 : 1;
+}
+
+
+static bool CheckLod(const char* name, uint32_t level, uint32_t expected)
+{
+    printf("  %-56s %u  %s\n", name, level, (level == expected) ? "ok" : "FAILED");
+    return level == expected;
+}
+
+static bool CheckLodCondition(const char* name, bool passed)
+{
+    printf("  %-56s %s\n", name, passed ? "ok" : "FAILED");
+    return passed;
+}
+
+// A chain with only errors set, which is all SelectLod reads
+static std::vector<MeshLod> MakeLodChain(std::initializer_list<float> errors)
+{
+    std::vector<MeshLod> lods;
+    for (float error : errors)
+    {
+        MeshLod lod;
+        lod.Error = error;
+        lods.push_back(lod);
+    }
+    return lods;
+}
+
+// Checks SelectLod just inside & outside each level's switch distance against the level the distances alone imply -
+// returns false on any mismatch
+static bool CheckLodThresholds(const std::vector<MeshLod>& lods, float errorScale, const LodView& view, float maxErrorPixels)
+{
+    std::vector<float> switchDistances;
+    for (const MeshLod& lod : lods)
+    {
+        switchDistances.push_back(ErrorSwitchDistance(lod.Error * errorScale, view.FieldOfViewY, view.ViewportHeight, maxErrorPixels));
+    }
+
+    // Levels switch in past their distance, up to the first one that hasn't
+    auto expectedLevel = [&](float distance)
+    {
+        uint32_t level = 0;
+        while (level < switchDistances.size() && switchDistances[level] <= distance)
+        {
+            ++level;
+        }
+        return level;
+    };
+
+    bool passed = true;
+
+    printf("  %-5s %12s %14s %14s\n", "level", "switch at", "0.1% nearer", "0.1% farther");
+
+    for (size_t l = 0; l < lods.size(); ++l)
+    {
+        LodView nearer = view;
+        LodView farther = view;
+        nearer.Distance  = switchDistances[l] * 0.999f;
+        farther.Distance = switchDistances[l] * 1.001f;
+
+        uint32_t nearLevel = SelectLod(lods, errorScale, nearer, maxErrorPixels);
+        uint32_t farLevel  = SelectLod(lods, errorScale, farther, maxErrorPixels);
+        bool     ok        = nearLevel == expectedLevel(nearer.Distance) && farLevel == expectedLevel(farther.Distance) && nearLevel <= l && farLevel > l;
+
+        passed = passed && ok;
+
+        printf("  %-5zu %12.4g %14u %14u   %s\n", l + 1, switchDistances[l], nearLevel, farLevel, ok ? "ok" : "FAILED");
+    }
+
+    return passed;
+}
+
+static int RunLodSelect(int fileCount, char** files)
+{
+    const float rightAngle = 3.14159265f / 2.0f;
+
+    bool passed = true;
+
+    printf("Checks\n");
+    {
+        // A 90 degree view maps 2 * distance world units onto the viewport's height
+        LodView view {};
+        view.Distance       = 5.0f;
+        view.FieldOfViewY   = rightAngle;
+        view.ViewportHeight = 1000.0f;
+
+        float pixels = ProjectedErrorPixels(0.01f, view);
+        passed &= CheckLodCondition("projects 0.01 units at distance 5 onto 1 of 1000 pixels", std::fabs(pixels - 1.0f) < 1e-5f);
+
+        float distance = ErrorSwitchDistance(0.01f, view.FieldOfViewY, view.ViewportHeight, pixels);
+        passed &= CheckLodCondition("switch distance inverts the projection", std::fabs(distance - 5.0f) < 1e-4f);
+
+        view.Distance = 0.0f;
+        passed &= CheckLodCondition("an eye on the bounds sees unbounded error", std::isinf(ProjectedErrorPixels(0.01f, view)));
+    }
+    {
+        // Switches at distances 5, 10, 25 & 50 for a one pixel limit
+        std::vector<MeshLod> lods = MakeLodChain({ 0.01f, 0.02f, 0.05f, 0.1f });
+
+        LodView view {};
+        view.FieldOfViewY   = rightAngle;
+        view.ViewportHeight = 1000.0f;
+
+        const struct
+        {
+            float    Distance;
+            float    ErrorScale;
+            float    MaxErrorPixels;
+            uint32_t Expected;
+            const char* Name;
+        } cases[] =
+        {
+            { 0.0f,    1.0f, 1.0f, 0, "distance 0 - eye on the bounds - is full detail" },
+            { -1.0f,   1.0f, 1.0f, 0, "negative distance - eye inside the bounds - is full detail" },
+            { 4.9f,    1.0f, 1.0f, 0, "4.9 is short of level 1 at 5" },
+            { 5.1f,    1.0f, 1.0f, 1, "5.1 is past level 1" },
+            { 9.9f,    1.0f, 1.0f, 1, "9.9 is short of level 2 at 10" },
+            { 10.1f,   1.0f, 1.0f, 2, "10.1 is past level 2" },
+            { 24.9f,   1.0f, 1.0f, 2, "24.9 is short of level 3 at 25" },
+            { 25.1f,   1.0f, 1.0f, 3, "25.1 is past level 3" },
+            { 49.9f,   1.0f, 1.0f, 3, "49.9 is short of level 4 at 50" },
+            { 50.1f,   1.0f, 1.0f, 4, "50.1 is past level 4" },
+            { 1e6f,    1.0f, 1.0f, 4, "far away is the coarsest level" },
+            { 10.1f,   2.0f, 1.0f, 1, "twice the scale doubles the distances" },
+            { 5.1f,    1.0f, 2.0f, 2, "a two pixel limit halves them" },
+        };
+
+        for (const auto& c : cases)
+        {
+            view.Distance = c.Distance;
+            passed &= CheckLod(c.Name, SelectLod(lods, c.ErrorScale, view, c.MaxErrorPixels), c.Expected);
+        }
+
+        view.Distance = 1e6f;
+        passed &= CheckLod("no levels is full detail", SelectLod(std::vector<MeshLod>(), 1.0f, view, 1.0f), 0);
+
+        // Level 2 is over the limit at 20 units, so level 3 isn't considered even though it's under
+        view.Distance = 20.0f;
+        passed &= CheckLod("the first level over the limit ends the search", SelectLod(MakeLodChain({ 0.01f, 0.5f, 0.02f }), 1.0f, view, 1.0f), 1);
+
+        printf("\nSynthetic chain thresholds\n");
+        view.Distance = 0.0f;
+        passed &= CheckLodThresholds(lods, 1.0f, view, 1.0f);
+    }
+
+    // The viewer's view - 60 degrees, 1080 pixels high & a one pixel limit
+    LodView viewerView {};
+    viewerView.FieldOfViewY   = 60.0f * 3.14159265f / 180.0f;
+    viewerView.ViewportHeight = 1080.0f;
+
+    for (int i = 0; i < fileCount; ++i)
+    {
+        MeshLoadOptions loadOptions;
+        loadOptions.Optimize  = true;
+        loadOptions.BuildLods = true;
+
+        Mesh mesh;
+
+        HRESULT hr = LoadMesh(files[i], mesh, loadOptions);
+        if (FAILED(hr))
+        {
+            fprintf(stderr, "%s: failed to load (HRESULT %08X)\n", files[i], static_cast<unsigned int>(hr));
+            return 1;
+        }
+
+        printf("\n%s thresholds at the viewer's object scale\n", files[i]);
+        passed &= CheckLodThresholds(mesh.Lods, SceneState().ObjectScale, viewerView, 1.0f);
+    }
+
+    return passed ? 0 : 1;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc >= 3 && strcmp(argv[1], "stats") == 0)
+    {
+        return RunStats(argc - 2, argv + 2);
+    }
+
+    if (argc >= 3 && strcmp(argv[1], "quantize") == 0)
+    {
+        return RunQuantize(argc - 2, argv + 2);
+    }
+
+    if (argc >= 3 && strcmp(argv[1], "meshlets") == 0)
+    {
+        return RunMeshlets(argc - 2, argv + 2);
+    }
+
+    if (argc >= 3 && strcmp(argv[1], "lods") == 0)
+    {
+        return RunLods(argc - 2, argv + 2);
+    }
+
+    if (argc >= 3 && strcmp(argv[1], "bounds") == 0)
+    {
+        return RunBounds(argc - 2, argv + 2);
+    }
+
+    if (argc >= 3 && strcmp(argv[1], "raster") == 0)
+    {
+        return RunRaster(argc - 2, argv + 2);
+    }
+
+    if ((argc == 3 || argc == 5) && strcmp(argv[1], "scaling") == 0)
+    {
+        return RunScaling(argc - 2, argv + 2);
+    }
+
+    if (argc >= 3 && strcmp(argv[1], "shading") == 0)
+    {
+        return RunShading(argc - 2, argv + 2);
+    }
+
+    if (argc >= 3 && argc <= 5 && strcmp(argv[1], "regress") == 0)
+    {
+        return RunRegress(argc - 2, argv + 2);
+    }
+
+    if ((argc == 3 || argc == 4) && strcmp(argv[1], "occlusion") == 0)
+    {
+        return RunOcclusion(argc - 2, argv + 2);
+    }
+
+    if (argc == 2 && strcmp(argv[1], "frustum") == 0)
+    {
+        return RunFrustum();
+    }
+
+    if (argc == 2 && strcmp(argv[1], "instances") == 0)
+    {
+        return RunInstances();
+    }
+
+    if ((argc >= 2 && argc <= 4) && strcmp(argv[1], "uploads") == 0)
+    {
+        return RunUploads(argc - 2, argv + 2);
+    }
+
+    if (argc == 2 && strcmp(argv[1], "ring") == 0)
+    {
+        return RunRing();
+    }
+
+    if ((argc == 4 || argc == 6) && strcmp(argv[1], "render") == 0)
+    {
+        return RunRender(argc - 2, argv + 2);
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "parse") == 0)
+    {
+        return RunParse(argc - 2, argv + 2);
+    }
+
+    if (argc == 2 && strcmp(argv[1], "floats") == 0)
+    {
+        return RunFloats();
+    }
+
+    if (argc >= 3 && strcmp(argv[1], "cache") == 0)
+    {
+        return RunCache(argc - 2, argv + 2);
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "lodselect") == 0)
+    {
+        return RunLodSelect(argc - 2, argv + 2);
+    }
+
+    PrintUsage();
+    return 1;
+}